@@ -150,6 +150,8 @@ const GSenum GS_OBJECTTYPE_INPUT          = 7;
 const GSenum GS_OBJECTTYPE_PARAMETERS     = 8;
 const GSenum GS_OBJECTTYPE_RENDERLIST     = 9;
 const GSenum GS_OBJECTTYPE_COMPUTESTATE   = 10;
+const GSenum GS_OBJECTTYPE_QUERY          = 11;
+const GSenum GS_OBJECTTYPE_ATLAS          = 12;
 
 
 // -----------------------------------------------------------------------------
@@ -177,6 +179,18 @@ const GSenum GS_COLOR_RGBA_FLOAT     = 0x050B;     // R32G32B32A32 (128 float)
 const GSenum GS_COLOR_S_RGBX         = 0x0516;     // R8G8B8X8     (32, sRGB)
 const GSenum GS_COLOR_S_RGBA         = 0x0519;     // R8G8B8A8     (32, sRGB)
 
+// block compressed color formats (used for textures only)
+//  image data is stored in 4x4 texel blocks, rows of blocks are tightly packed
+const GSenum GS_COLOR_BC1            = 0x0540;     // RGB, 1-bit A (8 bytes per block)
+const GSenum GS_COLOR_BC3            = 0x0541;     // RGBA         (16 bytes per block)
+const GSenum GS_COLOR_BC4            = 0x0542;     // R            (8 bytes per block)
+const GSenum GS_COLOR_BC5            = 0x0543;     // RG           (16 bytes per block)
+const GSenum GS_COLOR_BC7            = 0x0544;     // RGBA         (16 bytes per block)
+
+const GSenum GS_COLOR_S_BC1          = 0x0550;     // RGB, 1-bit A (8 bytes per block, sRGB)
+const GSenum GS_COLOR_S_BC3          = 0x0551;     // RGBA         (16 bytes per block, sRGB)
+const GSenum GS_COLOR_S_BC7          = 0x0554;     // RGBA         (16 bytes per block, sRGB)
+
 // depth/stencil formats (used for RT and textures)
 const GSenum GS_DEPTH_NONE           = GS_NONE;    // no depth
 const GSenum GS_DEPTH_DEFAULT        = GS_DEFAULT; // default depth format (for FB - from attachment)
@@ -237,7 +251,32 @@ const GSenum GSVD_VEC3      = GSVD_VECTOR3;   // 3 float components
 const GSenum GSVD_VECTOR4   = 6;              // 4 float components
 const GSenum GSVD_VEC4      = GSVD_VECTOR4;   // 4 float components
 
-// TODO: integer components, double, packed components (32-bit 4ub)
+// packed components, converted to float vector in shader
+const GSenum GSVD_HALF2     = 7;              // 2 half float components
+const GSenum GSVD_HALF4     = 8;              // 4 half float components
+const GSenum GSVD_UBYTE4N   = 9;              // 4 unsigned bytes, normalized to [0, 1]
+const GSenum GSVD_BYTE4N    = 10;             // 4 signed bytes, normalized to [-1, 1]
+const GSenum GSVD_USHORT2N  = 11;             // 2 unsigned shorts, normalized to [0, 1]
+const GSenum GSVD_USHORT4N  = 12;             // 4 unsigned shorts, normalized to [0, 1]
+const GSenum GSVD_SHORT2N   = 13;             // 2 signed shorts, normalized to [-1, 1]
+const GSenum GSVD_SHORT4N   = 14;             // 4 signed shorts, normalized to [-1, 1]
+const GSenum GSVD_UDEC4N    = 15;             // unsigned 10_10_10_2 packed xyzw, normalized to [0, 1]
+const GSenum GSVD_DEC4N     = 16;             // signed 10_10_10_2 packed xyzw, normalized to [-1, 1]
+
+// pure integer components, passed to shader as integer vector without conversion
+const GSenum GSVD_INT1      = 17;             // single signed int component
+const GSenum GSVD_INT2      = 18;             // 2 signed int components
+const GSenum GSVD_INT3      = 19;             // 3 signed int components
+const GSenum GSVD_INT4      = 20;             // 4 signed int components
+const GSenum GSVD_UINT1     = 21;             // single unsigned int component
+const GSenum GSVD_UINT2     = 22;             // 2 unsigned int components
+const GSenum GSVD_UINT3     = 23;             // 3 unsigned int components
+const GSenum GSVD_UINT4     = 24;             // 4 unsigned int components
+const GSenum GSVD_UBYTE4    = 25;             // 4 unsigned byte components
+const GSenum GSVD_USHORT2   = 26;             // 2 unsigned short components
+const GSenum GSVD_USHORT4   = 27;             // 4 unsigned short components
+
+// TODO: double components
 
 
 // -----------------------------------------------------------------------------
@@ -266,6 +305,8 @@ const GSenum GSS_7               = 7;
 // wrap for texture sampling
 const GSenum GS_WRAP_REPEAT      = 1;
 const GSenum GS_WRAP_CLAMP       = 2;
+const GSenum GS_WRAP_MIRROR      = 3; // mirrored repeat
+const GSenum GS_WRAP_BORDER      = 4; // clamp to sampler border color
 
 // filter for texture sampling
 const GSenum GS_FILTER_NEAREST   = 1;
@@ -289,6 +330,7 @@ const GSenum GS_GEOMETRY_INDEXBYTES    = GS_OBJECT_FIRST + 5;
 const GSenum GS_GEOMETRY_PATCHVERTICES = GS_OBJECT_FIRST + 6;
 const GSenum GS_GEOMETRY_RESTART       = GS_OBJECT_FIRST + 7;
 const GSenum GS_GEOMETRY_RESTARTINDEX  = GS_OBJECT_FIRST + 8;
+const GSenum GS_GEOMETRY_RESIDENT      = GS_OBJECT_FIRST + 9;
 
 // geometry data sharing
 const GSenum GS_SHARE_ALL              = 1;
@@ -305,6 +347,48 @@ const GSenum GS_PRIM_PATCHES           = 0x0040;
 
 const GSenum GS_PRIM_ADJACENCY         = 0x1000; // FLAG value, should be ored with others
 
+// mesh optimization flags
+const GSuint GS_MESH_VERTEXCACHE       = 0x0001; // reorder triangles for post-transform vertex cache
+const GSuint GS_MESH_OVERDRAW          = 0x0002; // reorder triangle clusters to reduce overdraw
+const GSuint GS_MESH_VERTEXFETCH       = 0x0004; // reorder vertices for vertex fetch locality
+
+// bounds type for geometry culling
+const GSenum GS_BOUNDS_SPHERE          = 1; // sphere - center x, y, z, radius
+const GSenum GS_BOUNDS_BOX             = 2; // axis aligned box - min x, y, z, max x, y, z
+
+// size of single indirect draw command in data buffer
+//      command layout: index count, instance count, first index, base vertex, base instance
+const GSuint GS_DRAWCOMMAND_SIZE       = 20;
+
+// size of single indirect compute dispatch command in data buffer
+//      command layout: group count x, group count y, group count z
+const GSuint GS_DISPATCHCOMMAND_SIZE   = 12;
+
+// memory barrier flags, make data written by compute shaders visible to
+const GSuint GS_BARRIER_VERTEX         = 0x0001; // vertex data fetches
+const GSuint GS_BARRIER_INDEX          = 0x0002; // index data fetches
+const GSuint GS_BARRIER_UNIFORM        = 0x0004; // uniform block reads
+const GSuint GS_BARRIER_TEXTURE        = 0x0008; // texture fetches
+const GSuint GS_BARRIER_IMAGE          = 0x0010; // image loads and stores
+const GSuint GS_BARRIER_COMMAND        = 0x0020; // indirect draw and dispatch commands
+const GSuint GS_BARRIER_UPDATE         = 0x0040; // buffer and texture updates, locks and copies
+const GSuint GS_BARRIER_FRAMEBUFFER    = 0x0080; // rendering into frame buffer
+const GSuint GS_BARRIER_STORAGE        = 0x0100; // storage block reads and writes
+const GSuint GS_BARRIER_ALL            = 0x01FF;
+
+// MIP generation filters
+//      GS_MIPFILTER_BOX           - average of 2x2 texels (odd sized levels take extra row/column)
+//      GS_MIPFILTER_KAISER        - Kaiser windowed sinc, sharper than box, 6x6 texels footprint
+//      GS_MIPFILTER_ALPHACOVERAGE - box filter, alpha of every generated level is scaled, so
+//                                   alpha test with reference value keeps coverage of source level
+const GSenum GS_MIPFILTER_BOX           = 1;
+const GSenum GS_MIPFILTER_KAISER        = 2;
+const GSenum GS_MIPFILTER_ALPHACOVERAGE = 3;
+
+// CPU image upload flags
+//      GS_IMAGEFLAG_RGBORDER - 8-bit source texels are in R, G, B, A order instead of B, G, R, A
+const GSdword GS_IMAGEFLAG_RGBORDER     = 0x0001;
+
 
 // -----------------------------------------------------------------------------
 // xGS GeometryBuffer object specific enums and values
@@ -320,10 +404,24 @@ const GSenum GS_GB_INDEXBYTES        = GS_OBJECT_FIRST + 6;
 const GSenum GS_GB_ACCESS            = GS_OBJECT_FIRST + 7;
 const GSenum GS_GB_VERTICESALLOCATED = GS_OBJECT_FIRST + 8;
 const GSenum GS_GB_INDICESALLOCATED  = GS_OBJECT_FIRST + 9;
+const GSenum GS_GB_PAGESIZE          = GS_OBJECT_FIRST + 10;
+const GSenum GS_GB_COMMITTEDPAGES    = GS_OBJECT_FIRST + 11;
 
 const GSenum GS_GBTYPE_STATIC        = 1;
 const GSenum GS_GBTYPE_GEOMETRYHEAP  = 2;
 const GSenum GS_GBTYPE_IMMEDIATE     = 3;
+
+// geometry buffer flags
+//      GS_GBFLAG_NARROWINDICES - GEOMETRYHEAP with 32-bit indices stores index data of
+//                                geometries with less than 65536 vertices in 16-bit form,
+//                                geometry index data is still locked and written in
+//                                32-bit form and converted on unlock
+const GSdword GS_GBFLAG_NARROWINDICES = 0x0001;
+//      GS_GBFLAG_SPARSE        - GEOMETRYHEAP reserves virtual range only, memory pages backing
+//                                geometries are committed on geometry creation and released
+//                                when no live geometry uses them, geometry pages could also be
+//                                released and committed again with GeometryBufferCommitment
+const GSdword GS_GBFLAG_SPARSE        = 0x0002;
 // TODO: think about feedback buffer type
 
 // TODO: add GB object values
@@ -352,9 +450,11 @@ const GSenum GSU_VEC4   = 4;
 const GSenum GSU_MAT2   = 5;
 const GSenum GSU_MAT3   = 6;
 const GSenum GSU_MAT4   = 7;
+const GSenum GSU_HANDLE = 8; // 64-bit bindless texture handle, sampler or uvec2 uniform
 
 // data buffer type
-const GSenum GSDT_UNIFORM = 1;
+const GSenum GSDT_UNIFORM = 1; // uniform buffer, std140 layout
+const GSenum GSDT_STORAGE = 2; // shader storage buffer, std430 layout
 
 
 // -----------------------------------------------------------------------------
@@ -362,15 +462,20 @@ const GSenum GSDT_UNIFORM = 1;
 // -----------------------------------------------------------------------------
 
 // Texture object get values
-const GSenum GS_TEX_TYPE        = GS_OBJECT_FIRST + 0;
-const GSenum GS_TEX_FORMAT      = GS_OBJECT_FIRST + 1;
-const GSenum GS_TEX_WIDTH       = GS_OBJECT_FIRST + 2;
-const GSenum GS_TEX_HEIGHT      = GS_OBJECT_FIRST + 3;
-const GSenum GS_TEX_DEPTH       = GS_OBJECT_FIRST + 4;
-const GSenum GS_TEX_LAYERS      = GS_OBJECT_FIRST + 5;
-const GSenum GS_TEX_MIN_LEVEL   = GS_OBJECT_FIRST + 6;
-const GSenum GS_TEX_MAX_LEVEL   = GS_OBJECT_FIRST + 7;
-const GSenum GS_TEX_MULTISAMPLE = GS_OBJECT_FIRST + 8;
+const GSenum GS_TEX_TYPE          = GS_OBJECT_FIRST + 0;
+const GSenum GS_TEX_FORMAT        = GS_OBJECT_FIRST + 1;
+const GSenum GS_TEX_WIDTH         = GS_OBJECT_FIRST + 2;
+const GSenum GS_TEX_HEIGHT        = GS_OBJECT_FIRST + 3;
+const GSenum GS_TEX_DEPTH         = GS_OBJECT_FIRST + 4;
+const GSenum GS_TEX_LAYERS        = GS_OBJECT_FIRST + 5;
+const GSenum GS_TEX_MIN_LEVEL     = GS_OBJECT_FIRST + 6;
+const GSenum GS_TEX_MAX_LEVEL     = GS_OBJECT_FIRST + 7;
+const GSenum GS_TEX_MULTISAMPLE   = GS_OBJECT_FIRST + 8;
+const GSenum GS_TEX_FLAGS         = GS_OBJECT_FIRST + 9;
+const GSenum GS_TEX_PAGE_WIDTH    = GS_OBJECT_FIRST + 10;
+const GSenum GS_TEX_PAGE_HEIGHT   = GS_OBJECT_FIRST + 11;
+const GSenum GS_TEX_PAGE_DEPTH    = GS_OBJECT_FIRST + 12;
+const GSenum GS_TEX_SPARSE_LEVELS = GS_OBJECT_FIRST + 13;
 
 // Texture types
 const GSenum GS_TEXTYPE_EMPTY   = 0; // texture is empy (haven't been initialized yet)
@@ -381,6 +486,18 @@ const GSenum GS_TEXTYPE_CUBEMAP = 4; // Cubemap texture (width & height are vali
 const GSenum GS_TEXTYPE_3D      = 5; // 3D texture (width & height & depth are valid)
 const GSenum GS_TEXTYPE_BUFFER  = 6; // Buffer based texture (width is valid)
 
+// texture flags
+//      GS_TEXFLAG_SPARSE - texture is created with virtual (sparse) storage, memory for
+//                          MIP levels is committed explicitly with TextureCommitment
+const GSdword GS_TEXFLAG_SPARSE = 0x0001;
+
+// texture page identifier packing for virtual texture paging and feedback buffers
+//      page = x | (y << GS_TEXPAGE_Y_SHIFT) | (level << GS_TEXPAGE_LEVEL_SHIFT),
+//      x and y are page coordinates within MIP level (texel coordinates divided by page size)
+const GSuint GS_TEXPAGE_COORD_MASK  = 0xfff;
+const GSuint GS_TEXPAGE_Y_SHIFT     = 12;
+const GSuint GS_TEXPAGE_LEVEL_SHIFT = 24;
+
 // locktype for textures
 const GSenum GS_LOCK_TEXTURE    = 1;
 const GSenum GS_LOCK_CUBEMAPPX  = 0x10000;
@@ -457,6 +574,8 @@ const GSenum GSPD_END                = GS_NONE;
 const GSenum GSPD_CONSTANT           = 1;
 const GSenum GSPD_BLOCK              = 2;
 const GSenum GSPD_TEXTURE            = 3;
+const GSenum GSPD_STORAGEBLOCK       = 4;
+const GSenum GSPD_IMAGE              = 5; // image unit, compute states only
 
 // parameter slot within parameter set
 const GSenum GSPS_END                = GS_NONE;
@@ -548,6 +667,36 @@ const GSenum GSIS_6    = 7;
 const GSenum GSIS_7    = 8;
 
 
+// -----------------------------------------------------------------------------
+// xGS Query object specific enums and values
+// -----------------------------------------------------------------------------
+
+// Query object get values
+const GSenum GS_QUERY_TYPE      = GS_OBJECT_FIRST + 0;
+const GSenum GS_QUERY_AVAILABLE = GS_OBJECT_FIRST + 1; // is result available (doesn't wait for GPU)
+
+// Query types
+const GSenum GS_QUERY_SAMPLES_PASSED                  = 1; // count of samples passed depth/stencil tests
+const GSenum GS_QUERY_ANY_SAMPLES_PASSED              = 2; // non zero if any sample passed
+const GSenum GS_QUERY_ANY_SAMPLES_PASSED_CONSERVATIVE = 3; // same as above, but might be less precise and faster
+
+// Conditional rendering modes
+const GSenum GS_CONDITION_WAIT   = 1; // wait for query result before rendering
+const GSenum GS_CONDITION_NOWAIT = 2; // render if query result isn't available yet
+
+
+// -----------------------------------------------------------------------------
+// xGS Atlas object specific enums and values
+// -----------------------------------------------------------------------------
+
+// Atlas object get values
+const GSenum GS_ATLAS_WIDTH   = GS_OBJECT_FIRST + 0;
+const GSenum GS_ATLAS_HEIGHT  = GS_OBJECT_FIRST + 1;
+const GSenum GS_ATLAS_LAYERS  = GS_OBJECT_FIRST + 2;
+const GSenum GS_ATLAS_IMAGES  = GS_OBJECT_FIRST + 3; // number of images in atlas
+const GSenum GS_ATLAS_UNUSED  = GS_OBJECT_FIRST + 4; // area (in texels) of removed images, reclaimed by Repack
+
+
 
 class xGSSystem;
 
@@ -562,6 +711,10 @@ class xGSComputeState;
 class xGSInput;
 class xGSParameters;
 
+class xGSQuery;
+
+class xGSAtlas;
+
 
 // system object
 typedef xGSSystem         *IxGS;
@@ -579,6 +732,12 @@ typedef xGSComputeState   *IxGSComputeState;
 typedef xGSInput          *IxGSInput;
 typedef xGSParameters     *IxGSParameters;
 
+// queries
+typedef xGSQuery          *IxGSQuery;
+
+// atlases
+typedef xGSAtlas          *IxGSAtlas;
+
 typedef InterfacePtr<IxGS>               IxGSRef;
 typedef InterfacePtr<IxGSGeometry>       IxGSGeometryRef;
 typedef InterfacePtr<IxGSGeometryBuffer> IxGSGeometryBufferRef;
@@ -589,6 +748,8 @@ typedef InterfacePtr<IxGSState>          IxGSStateRef;
 typedef InterfacePtr<IxGSComputeState>   IxGSComputeStateRef;
 typedef InterfacePtr<IxGSInput>          IxGSInputRef;
 typedef InterfacePtr<IxGSParameters>     IxGSParametersRef;
+typedef InterfacePtr<IxGSQuery>          IxGSQueryRef;
+typedef InterfacePtr<IxGSAtlas>          IxGSAtlasRef;
 
 
 #pragma pack(push, 1)
@@ -611,12 +772,15 @@ struct GSrendererdescription
     GSenum   stencilformat; // default stencil buffer format
     GSenum   multisample;   // multisample for default buffer
 
+    GSuint   transientsize; // size of per-frame transient uniform data memory (0 - no transient data)
+
     static GSrendererdescription construct(GSwidget _widget = 0)
     {
         GSrendererdescription result = {
             _widget,
             GS_DEFAULT, GS_FALSE, GS_TRUE,
-            GS_DEFAULT, GS_DEFAULT, GS_DEFAULT, GS_DEFAULT
+            GS_DEFAULT, GS_DEFAULT, GS_DEFAULT, GS_DEFAULT,
+            0
         };
         return result;
     }
@@ -700,8 +864,9 @@ struct GSgeometrybufferdescription
 
 struct GSuniform
 {
-    GSenum type;
-    GSuint count;
+    GSenum      type;
+    GSuint      count;
+    const char *name;  // uniform name, used only for layout from state
 };
 
 struct GSuniformblock
@@ -709,6 +874,7 @@ struct GSuniformblock
     GSenum           type;
     const GSuniform *uniforms;
     GSuint           count;
+    const char      *name;     // block name, used only for layout from state
 };
 
 struct GSdatabufferdescription
@@ -716,6 +882,8 @@ struct GSdatabufferdescription
     const GSuniformblock *blocks;
     GSenum                type;
     GSuint                flags;
+    IxGSState             state;  // if not null, block layouts are taken from state shaders,
+                                  // uniform blocks for GSDT_UNIFORM, storage blocks for GSDT_STORAGE
 };
 
 struct GSuniformblockinfo
@@ -745,18 +913,29 @@ struct GStexturedescription
     GSuint minlevel;    //
     GSuint maxlevel;    //
     GSenum multisample; //
+    GSdword flags;      // GS_TEXFLAG_* flags
 
     static GStexturedescription construct()
     {
         GStexturedescription result = {
             GS_NONE, GS_NONE,
             0, 0, 0, 0, 0, 1000,
-            GS_NONE
+            GS_NONE, 0
         };
         return result;
     }
 };
 
+// texture lock layout, filled by Lock when lockdata is not null
+//      for block compressed formats pitch is size of row of blocks
+//      and rows is number of block rows
+struct GStexturelockdata
+{
+    GSuint size;  // locked image size in bytes
+    GSuint pitch; // row size in bytes
+    GSuint rows;  // number of rows in single image slice
+};
+
 struct GSsamplerdescription
 {
     GSenum  wrapu;        //
@@ -767,15 +946,16 @@ struct GSsamplerdescription
     GSint   maxlod;       //
     GSfloat bias;         //
     GSenum  depthcompare; //
-
-    // TODO: anisotropy
+    GSuint  anisotropy;   // max anisotropy, 0 or 1 disables anisotropic filtering
+    GScolor border;       // border color for GS_WRAP_BORDER
 
     static GSsamplerdescription construct()
     {
         GSsamplerdescription result = {
             GS_WRAP_REPEAT, GS_WRAP_REPEAT, GS_WRAP_REPEAT,
             GS_FILTER_NEAREST, -1000, 1000, 0.0f,
-            GS_NONE
+            GS_NONE, 1,
+            { 0.0f, 0.0f, 0.0f, 0.0f }
         };
         return result;
     }
@@ -1008,9 +1188,9 @@ struct GSimagebinding
     GSenum       slot;
     IxGSTexture  texture;
     GSuint       level;
-    GSuint       layer;
-    GSuint       access;
-    GSenum       format;
+    GSuint       layer;   // GS_DEFAULT binds all layers of layered texture
+    GSuint       access;  // GS_READ, GS_WRITE or GS_READWRITE
+    GSenum       format;  // GS_COLOR_DEFAULT for texture own format
 };
 
 
@@ -1071,6 +1251,343 @@ struct GSimmediateprimitive
     GSuint indexcount;
 };
 
+// transient uniform data allocation
+//      memory is valid for writing only until the end of current frame (Display call)
+struct GStransientallocation
+{
+    GSptr  memory; // pointer to allocated memory
+    GSuint offset; // offset of allocated memory inside transient buffer
+    GSuint size;   // size of allocation
+};
+
+// compressed vertex data position dequantization constants
+//      position = quantized * scale + bias
+struct GSvertexquantization
+{
+    GSfloat scale[3];
+    GSfloat bias[3];
+};
+
+// triangle list mesh data for mesh optimization, data is optimized in place
+//      data should be CPU arrays, geometry locks are write-only so optimized
+//      data is written into locked geometry afterwards
+struct GSmeshdescription
+{
+    GSenum indexformat;    // GS_INDEX_16 or GS_INDEX_32
+    GSptr  indices;        // index data
+    GSuint indexcount;     // index count
+    GSptr  vertices;       // vertex data, needed for overdraw and vertex fetch optimization
+    GSuint vertexcount;    // vertex count
+    GSuint vertexsize;     // size of one vertex in bytes
+    GSuint positionoffset; // offset of 3 float position inside vertex, for overdraw optimization
+    GSbool restart;        // index data has special restart index
+    GSuint restartindex;   // restart index value
+
+    static GSmeshdescription construct()
+    {
+        GSmeshdescription result = {
+            GS_INDEX_NONE,
+            nullptr, 0,
+            nullptr, 0, 0, 0,
+            GS_FALSE, 0
+        };
+        return result;
+    }
+};
+
+// meshlet (cluster of triangles) data, layout matches std430 structure
+// of three vec4 values, so meshlets could be uploaded into storage buffer as is
+//      meshlet is backfacing and could be culled when
+//          dot(center - camera, coneaxis) >= conecutoff * length(center - camera) + radius
+//      test is done against whole bounding sphere, so it stays conservative
+//      for any cone apex inside of it
+struct GSmeshlet
+{
+    GSfloat center[3];      // bounding sphere center
+    GSfloat radius;         // bounding sphere radius
+    GSfloat coneaxis[3];    // normal cone axis
+    GSfloat conecutoff;     // sine of normal cone spread angle, 1 if cone is degenerate
+    GSuint  vertexoffset;   // offset of meshlet vertex list in vertices array
+    GSuint  triangleoffset; // offset of meshlet triangle list in triangles array
+    GSuint  vertexcount;    // number of meshlet vertices
+    GSuint  trianglecount;  // number of meshlet triangles
+
+    // backfacing test from camera position, same as in comment above
+    GSbool backfacing(const GSfloat camera[3]) const
+    {
+        GSfloat view[3] = {
+            center[0] - camera[0],
+            center[1] - camera[1],
+            center[2] - camera[2]
+        };
+
+        GSfloat d =
+            view[0] * coneaxis[0] + view[1] * coneaxis[1] + view[2] * coneaxis[2] -
+            radius;
+        GSfloat lengthsq = view[0] * view[0] + view[1] * view[1] + view[2] * view[2];
+
+        // both sides are compared squared, right side is never negative
+        return d >= 0 && d * d >= conecutoff * conecutoff * lengthsq;
+    }
+};
+
+// meshlet build results
+//      arrays could be nullptr, then only counts are returned, otherwise counts
+//      are array capacities on input and actual counts on output
+//      vertices  - mesh vertex indices referenced by meshlets
+//      triangles - meshlet triangles, three 8-bit indices into meshlet vertex list
+//                  packed into one value (i0 | i1 << 8 | i2 << 16)
+struct GSmeshletdata
+{
+    GSmeshlet *meshlets;
+    GSuint     meshletcount;
+    GSuint    *vertices;
+    GSuint     vertexcount;
+    GSuint    *triangles;
+    GSuint     trianglecount;
+};
+
+// geometry culling description, all bounds are in world space
+//      geometries    - lodcount geometries per object, from most to least detailed,
+//                      LOD geometries are expected to share vertices with
+//                      GS_SHARE_VERTICESONLY
+//      lodthresholds - lodcount - 1 decreasing projected size thresholds, object
+//                      with projected size below lodthresholds[n] uses LOD n + 1
+//      lodscale      - projected size is bounding radius * lodscale / clip w,
+//                      e.g. projection[1][1] * viewport height / 2 gives size in pixels
+//      threads       - max number of threads to use, 0 or 1 - cull on calling thread only
+struct GScullingdescription
+{
+    const GSfloat      *viewprojection; // column-major view-projection matrix
+    GSenum              boundstype;     // GS_BOUNDS_SPHERE or GS_BOUNDS_BOX
+    const GSfloat      *bounds;         // 4 (sphere) or 6 (box) floats per object
+    const IxGSGeometry *geometries;     // geometries of every object
+    GSuint              count;          // object count
+    GSuint              lodcount;       // number of LOD geometries per object
+    const GSfloat      *lodthresholds;  // LOD selection thresholds
+    GSfloat             lodscale;       // LOD projected size scale
+    GSuint              threads;        // culling threads limit
+
+    static GScullingdescription construct()
+    {
+        GScullingdescription result = {
+            nullptr, GS_BOUNDS_SPHERE, nullptr, nullptr, 0,
+            1, nullptr, 1.0f, 1
+        };
+        return result;
+    }
+};
+
+// CPU image block compression
+//      source           - GS_COLOR_RGBA image (B, G, R, A bytes per texel)
+//      sourcepitch      - source row size in bytes, 0 for tightly packed rows
+//      destination      - receives (width + 3) / 4 by (height + 3) / 4 blocks,
+//                         partial edge blocks are filled by replicating edge texels
+//      destinationpitch - size of block row in bytes, 0 for tightly packed rows
+//      threads          - max number of threads to use, 0 or 1 - compress on calling thread only
+struct GSimagecompressiondescription
+{
+    GSenum      format;           // one of block compressed GS_COLOR_BC* formats
+    GSuint      width;            // image width
+    GSuint      height;           // image height
+    const void *source;           // source texels
+    GSuint      sourcepitch;      // source row size
+    GSptr       destination;      // destination blocks
+    GSuint      destinationpitch; // destination block row size
+    GSuint      threads;          // compression threads limit
+
+    static GSimagecompressiondescription construct()
+    {
+        GSimagecompressiondescription result = {
+            GS_COLOR_BC1, 0, 0, nullptr, 0, nullptr, 0, 1
+        };
+        return result;
+    }
+};
+
+// CPU image upload with MIP chain generation
+//      source image is converted into texture format and written into texture image given by
+//      locktype, level and layer (as for xGSTexture::Lock), every next level is filtered from
+//      previous one and written the same way, sRGB images are filtered in linear space
+//      format     - source texel format, GS_COLOR_RGBA, GS_COLOR_RGBX, GS_COLOR_S_RGBA,
+//                   GS_COLOR_S_RGBX, GS_COLOR_RGBA_HALFFLOAT or GS_COLOR_RGBA_FLOAT,
+//                   texture format should be one of these formats too
+//      source     - source image texels, image size is the size of texture level
+//      pitch      - source row size in bytes, 0 for tightly packed rows
+//      levelcount - number of written levels, 0 - all levels up to texture max level
+//      filter     - GS_MIPFILTER_BOX or GS_MIPFILTER_KAISER
+//      threads    - max number of threads to use, 0 or 1 - process on calling thread only
+struct GSimageuploaddescription
+{
+    GSenum      format;     // source texel format
+    GSdword     flags;      // GS_IMAGEFLAG_* flags
+    const void *source;     // source texels
+    GSuint      pitch;      // source row size
+    GSenum      locktype;   // GS_LOCK_TEXTURE or one of cubemap faces
+    GSuint      level;      // first written level
+    GSuint      layer;      // array layer
+    GSuint      levelcount; // written level count
+    GSenum      filter;     // MIP filter
+    GSuint      threads;    // threads limit
+
+    static GSimageuploaddescription construct()
+    {
+        GSimageuploaddescription result = {
+            GS_COLOR_RGBA, 0, nullptr, 0,
+            GS_LOCK_TEXTURE, 0, 0, 0,
+            GS_MIPFILTER_BOX, 1
+        };
+        return result;
+    }
+};
+
+// texture streaming set-up
+//      budget      - total size of streamed texture levels in bytes, levels of least
+//                    recently requested textures are evicted to stay under budget
+//      uploadlimit - maximum size of level data uploaded by single UpdateTextureStreaming
+//                    call, at least one level is uploaded regardless of its size
+//      tailsize    - levels not larger than tailsize are always resident
+struct GStexturestreamingdescription
+{
+    GSuint64 budget;      // residency budget in bytes
+    GSuint   uploadlimit; // upload limit per update in bytes
+    GSuint   tailsize;    // size of always resident levels in texels
+
+    static GStexturestreamingdescription construct()
+    {
+        GStexturestreamingdescription result = {
+            256 * 1024 * 1024, 16 * 1024 * 1024, 64
+        };
+        return result;
+    }
+};
+
+// virtual texture paging set-up
+//      budget - total size of committed pages in bytes, least recently requested
+//               pages are released to stay under budget
+struct GStexturepagingdescription
+{
+    GSuint64 budget; // residency budget in bytes
+
+    static GStexturepagingdescription construct()
+    {
+        GStexturepagingdescription result = {
+            128 * 1024 * 1024
+        };
+        return result;
+    }
+};
+
+// committed texture page
+struct GStexturepage
+{
+    IxGSTexture texture; // sparse texture
+    GSuint      page;    // packed page identifier
+};
+
+// texture streaming usage feedback
+struct GStexturestreamingrequest
+{
+    IxGSTexture texture;  // streamed texture
+    GSuint      level;    // finest MIP level needed for rendering
+    GSfloat     priority; // request priority, higher priority levels are uploaded first
+};
+
+// MIP levels generation description
+//      every level is filtered from previous one, sRGB levels are filtered in linear space
+//      firstlevel - first generated level, source is firstlevel - 1 level
+//      levelcount - number of generated levels, 0 - all levels up to texture max level
+//      rect       - area of source level which was changed, only texels of generated levels
+//                   filtered from this area are updated, empty rect - whole level
+//      alpharef   - alpha test reference value for GS_MIPFILTER_ALPHACOVERAGE
+struct GSmipgenerationdescription
+{
+    GSenum  filter;     // one of GS_MIPFILTER_* filters
+    GSuint  firstlevel; // first generated level
+    GSuint  levelcount; // generated level count
+    GSrect  rect;       // changed area of source level
+    GSfloat alpharef;   // alpha test reference value
+
+    static GSmipgenerationdescription construct()
+    {
+        GSmipgenerationdescription result = {
+            GS_MIPFILTER_BOX, 1, 0, { 0, 0, 0, 0 }, 0.5f
+        };
+        return result;
+    }
+};
+
+// query object description
+struct GSquerydescription
+{
+    GSenum type; // one of GS_QUERY_* types
+};
+
+// texture atlas description
+//      atlas owns GS_TEXTYPE_2D array texture with given number of layers,
+//      images are packed into layers with padding texels around every image,
+//      padding replicates image edges, so filtering doesn't bleed neighbours
+//
+//      format  - uncompressed texel format of atlas texture and added images
+//      padding - number of texels added to each side of image
+struct GSatlasdescription
+{
+    GSenum format;  // atlas texture format
+    GSuint width;   // layer width
+    GSuint height;  // layer height
+    GSuint layers;  // number of layers
+    GSuint padding; // image padding
+
+    static GSatlasdescription construct()
+    {
+        GSatlasdescription result = {
+            GS_COLOR_RGBA, 1024, 1024, 1, 1
+        };
+        return result;
+    }
+};
+
+// atlas image
+//      source - image texels in atlas texture format
+//      pitch  - source row size in bytes, 0 for tightly packed rows
+struct GSatlasimage
+{
+    GSuint      width;
+    GSuint      height;
+    const void *source;
+    GSuint      pitch;
+};
+
+// placement of image in atlas
+//      rect - image area of layer in texels, not including padding
+//      uv   - normalized texture coordinates of image area (left, top, right, bottom)
+struct GSatlasentry
+{
+    GSuint  id;    // image identifier
+    GSuint  layer; // texture layer
+    GSrect  rect;  // image area in texels
+    GSfloat uv[4]; // image area in texture coordinates
+};
+
+// GPU occlusion culling description
+//      objects are tested against view frustum and hierarchical depth (Hi-Z) built
+//      from depth of previously rendered frame, results are written into instance
+//      counts of draw commands: 1 for visible objects and 0 for culled ones
+//
+//      depthsource    - frame buffer with non multisampled depth texture attachment
+//      viewprojection - column-major view-projection matrix depthsource was rendered with
+//      bounds         - GSDT_STORAGE data buffer with bounding spheres, 4 floats per object
+//                       (center x, y, z, radius)
+//      commands       - GSDT_STORAGE data buffer with draw commands built by BuildDrawCommands
+struct GSgpucullingdescription
+{
+    IxGSFrameBuffer  depthsource;    // depth source frame buffer
+    const GSfloat   *viewprojection; // column-major view-projection matrix
+    IxGSDataBuffer   bounds;         // object bounds
+    IxGSDataBuffer   commands;       // object draw commands
+    GSuint           count;          // object count
+};
+
 #pragma pack(pop)
 
 
@@ -1127,6 +1644,9 @@ public:
             GS_GEOMETRY_PATCHVERTICES - vertex count in patch, applicable only for GS_PRIM_PATCHES
             GS_GEOMETRY_RESTART       - index data has special primitive restart index value
             GS_GEOMETRY_RESTARTINDEX  - special value for primitive restart
+            GS_GEOMETRY_RESIDENT      - geometry data pages are committed (always true
+                                        for geometries of non sparse buffers), shared
+                                        geometry is resident only with its base geometry
 
         Lock     - lock part of geometry buffer specific to this geometry object
                    following data can be locked for access from CPU side:
@@ -1138,12 +1658,28 @@ public:
                    updates
 
         Unlock   - unlock part of geometry buffer
+
+        CompressVertices - upload vertex data given in float-only source declaration,
+                           converting it into geometry buffer vertex format:
+                                3 float position into USHORT4N, quantized against
+                                geometry bounding box
+                                3 or 4 float direction into SHORT2N, octahedral encoded
+                                2 or 4 float vector into HALF2 or HALF4
+                                components of same type are copied as is
+                           source declaration should have same component count as
+                           geometry buffer declaration
+
+        GetQuantization  - get position dequantization constants computed by last
+                           CompressVertices call
 */
 class xGSGeometry : public xGSObject
 {
 public:
     virtual GSptr  xGSAPI Lock(GSenum locktype, GSdword access, void *lockdata) = 0;
     virtual GSbool xGSAPI Unlock() = 0;
+
+    virtual GSbool xGSAPI CompressVertices(const GSvertexcomponent *sourcedecl, const GSptr source) = 0;
+    virtual GSbool xGSAPI GetQuantization(GSvertexquantization &quantization) = 0;
 };
 
 
@@ -1166,12 +1702,17 @@ public:
             GS_GB_ACCESS            - buffer acces type
             GS_GB_VERTICESALLOCATED - amount of allocated vertices
             GS_GB_INDICESALLOCATED  - amount of allocated indices
+            GS_GB_PAGESIZE          - sparse buffer page size in bytes, 0 for non sparse buffers
+            GS_GB_COMMITTEDPAGES    - number of committed vertex and index pages of sparse buffer
 
         Lock     - lock entire geometry buffer
                    following data can be locked for access from CPU side:
                         GS_LOCK_VERTEXDATA - lock vertex data
                         GS_LOCK_INDEXDATA  - lock index data
 
+                   sparse heap can't be locked entirely, its data is uploaded through
+                   geometry objects
+
         Unlock   - unlock geometry buffer
 */
 class xGSGeometryBuffer : public xGSObject
@@ -1192,6 +1733,15 @@ public:
 
     Following specific values defined for this object type (can be queried with GetValue):
         TODO
+
+        BeginUpdate - start batched update, all following Update* calls only write data to
+                      CPU side copy of buffer data and mark written ranges
+        EndUpdate   - finish batched update, written ranges are merged and uploaded with
+                      minimum number of uploads
+
+        Lock        - map whole buffer memory, reading (GS_READ, GS_READWRITE) is allowed
+                      only for GSDT_STORAGE buffers, so data written by shaders could be
+                      read back
 */
 class xGSDataBuffer : public xGSObject
 {
@@ -1200,6 +1750,9 @@ public:
     virtual GSbool xGSAPI UpdateBlock(GSuint block, GSuint index, const GSptr data) = 0;
     virtual GSbool xGSAPI UpdateValue(GSuint block, GSuint index, GSuint uniform, GSuint uniformindex, GSuint count, const GSptr data) = 0;
 
+    virtual GSbool xGSAPI BeginUpdate() = 0;
+    virtual GSbool xGSAPI EndUpdate() = 0;
+
     virtual GSptr  xGSAPI Lock(GSdword access, void *lockdata) = 0;
     virtual GSbool xGSAPI Unlock() = 0;
 };
@@ -1214,15 +1767,21 @@ public:
     This object holds texture image data. Image data is mutable.
 
         Following specific values defined for this object type (can be queried with GetValue):
-            GS_TEX_TYPE        - texture type (1D, 2D, 3D, Cubemap, etc.)
-            GS_TEX_FORMAT      - image data format (one of GS_COLOR/GS_DEPTH values)
-            GS_TEX_WIDTH       - texture base level width (or size for BUFFER texture)
-            GS_TEX_HEIGHT      - texture base level height
-            GS_TEX_DEPTH       - texture base level depth (only for 3D textures)
-            GS_TEX_LAYERS      - texture layers (if greater than 0 - array texture is created)
-            GS_TEX_MIN_LEVEL   - texture base MIP level
-            GS_TEX_MAX_LEVEL   - texture maximum MIP level
-            GS_TEX_MULTISAMPLE - texture multisampling
+            GS_TEX_TYPE          - texture type (1D, 2D, 3D, Cubemap, etc.)
+            GS_TEX_FORMAT        - image data format (one of GS_COLOR/GS_DEPTH values)
+            GS_TEX_WIDTH         - texture base level width (or size for BUFFER texture)
+            GS_TEX_HEIGHT        - texture base level height
+            GS_TEX_DEPTH         - texture base level depth (only for 3D textures)
+            GS_TEX_LAYERS        - texture layers (if greater than 0 - array texture is created)
+            GS_TEX_MIN_LEVEL     - texture base MIP level
+            GS_TEX_MAX_LEVEL     - texture maximum MIP level
+            GS_TEX_MULTISAMPLE   - texture multisampling
+            GS_TEX_FLAGS         - texture GS_TEXFLAG_* flags
+            GS_TEX_PAGE_WIDTH    - sparse texture page width in texels
+            GS_TEX_PAGE_HEIGHT   - sparse texture page height in texels
+            GS_TEX_PAGE_DEPTH    - sparse texture page depth in texels
+            GS_TEX_SPARSE_LEVELS - number of sparse texture levels committed by pages,
+                                   finer levels form MIP tail committed as a whole
 
         Lock     - lock texture image
                    following data can be locked for access from CPU side:
@@ -1234,8 +1793,9 @@ public:
                         GS_LOCK_CUBEMAPNY - cubemap negative Y face
                         GS_LOCK_CUBEMAPNZ - cubemap negative Z face
 
-                   level - indicates which MIP level to lock
-                   layer - indicates which array layer to lock
+                   level    - indicates which MIP level to lock
+                   layer    - indicates which array layer to lock
+                   lockdata - optional GStexturelockdata, receives layout of locked image
 
         Unlock   - unlock texture image
 */
@@ -1343,6 +1903,68 @@ class xGSParameters : public IUnknownStub
 {};
 
 
+/*
+ -------------------------------------------------------------------------------
+ xGSQuery
+ -------------------------------------------------------------------------------
+    Query xGS object interface
+
+    This object holds GPU query (occlusion) result.
+
+        Following specific values defined for this object type (can be queried with GetValue):
+            GS_QUERY_TYPE      - query type (one of GS_QUERY_* values)
+            GS_QUERY_AVAILABLE - result of last issued query is available, this value
+                                 is polled without waiting for GPU
+
+        GetResult - get result of last issued query
+                    wait - if GS_TRUE, waits for result, otherwise returns GS_FALSE
+                           with GSE_INVALIDSTATE error if result isn't available yet
+*/
+class xGSQuery : public xGSObject
+{
+public:
+    virtual GSbool xGSAPI GetResult(GSuint64 &result, GSbool wait) = 0;
+};
+
+
+/*
+ -------------------------------------------------------------------------------
+ xGSAtlas
+ -------------------------------------------------------------------------------
+    Atlas xGS object interface
+
+    This object packs many small images into single array texture, so they
+    can be used with single texture binding.
+
+        Following specific values defined for this object type (can be queried with GetValue):
+            GS_ATLAS_WIDTH  - layer width
+            GS_ATLAS_HEIGHT - layer height
+            GS_ATLAS_LAYERS - number of layers
+            GS_ATLAS_IMAGES - number of images
+            GS_ATLAS_UNUSED - area of removed images which isn't available for
+                              new images until Repack
+
+        Add        - pack and upload images, all images are added or none of them,
+                     GSE_OUTOFRESOURCES error is set if images don't fit
+                     entries - receives placement of every added image
+        Remove     - remove image, its area can be reused only after Repack
+        GetEntry   - get current placement of image
+        Repack     - pack all images again, so area of removed images can be reused,
+                     images are moved on GPU side, identifiers remain the same, but
+                     placements change and should be queried again with GetEntry
+        GetTexture - get atlas texture, returned texture is referenced
+*/
+class xGSAtlas : public xGSObject
+{
+public:
+    virtual GSbool xGSAPI Add(const GSatlasimage *images, GSuint count, GSatlasentry *entries) = 0;
+    virtual GSbool xGSAPI Remove(GSuint id) = 0;
+    virtual GSbool xGSAPI GetEntry(GSuint id, GSatlasentry &entry) = 0;
+    virtual GSbool xGSAPI Repack() = 0;
+    virtual GSbool xGSAPI GetTexture(IxGSTexture *texture) = 0;
+};
+
+
 class xGSRenderList : public IUnknownStub
 {
 public:
@@ -1359,7 +1981,17 @@ public:
 
     // OBJECTS
     virtual GSbool xGSAPI CreateObject(GSenum type, const void *desc, void **result) = 0;
+
+    // samplers
+    //      samplers are referenced by GSS_* index, samplers with identical descriptions
+    //      share single API sampler object
+    //      CreateSamplers - replace sampler list, n-th description gets GSS_0 + n index,
+    //                       list can't be replaced while its samplers are referenced
+    //      AddSamplers    - add samplers to the end of the list, could be called any time,
+    //                       indices - receives index of every sampler, index of existing sampler
+    //                                 is returned for description which is already in the list
     virtual GSbool xGSAPI CreateSamplers(const GSsamplerdescription *samplers, GSuint count) = 0;
+    virtual GSbool xGSAPI AddSamplers(const GSsamplerdescription *samplers, GSuint count, GSenum *indices) = 0;
 
     // query API
     virtual GSbool xGSAPI GetRenderTargetSize(GSsize &size) = 0;
@@ -1372,12 +2004,24 @@ public:
     virtual GSbool xGSAPI SetState(IxGSState state) = 0;
     virtual GSbool xGSAPI SetInput(IxGSInput input) = 0;
     virtual GSbool xGSAPI SetParameters(IxGSParameters parameters) = 0;
+    // set parameters with uniform block indices overriding GSuniformbinding::index values
+    //      blockindices - block index for every slot of parameters set (GSPS_0 is first),
+    //                     values for non block slots are ignored, GS_DEFAULT keeps binding index
+    virtual GSbool xGSAPI SetParametersOffsets(IxGSParameters parameters, const GSuint *blockindices) = 0;
 
     virtual GSbool xGSAPI SetViewport(const GSrect &viewport) = 0;
     virtual GSbool xGSAPI SetStencilReference(GSuint ref) = 0;
     virtual GSbool xGSAPI SetBlendColor(const GScolor &color) = 0;
     virtual GSbool xGSAPI SetUniformValue(GSenum set, GSenum slot, GSenum type, const void *value) = 0;
 
+    // transient uniform data
+    //      AllocateTransient  - allocate memory for uniform block data for current frame only
+    //      SetTransientBlock  - bind transient allocation to uniform block slot of current state,
+    //                           binding is valid until next SetParameters or SetState call,
+    //                           allocation should be made in current frame
+    virtual GSbool xGSAPI AllocateTransient(GSuint size, GStransientallocation *allocation) = 0;
+    virtual GSbool xGSAPI SetTransientBlock(GSenum set, GSenum slot, const GStransientallocation &allocation) = 0;
+
     virtual GSbool xGSAPI DrawGeometry(IxGSGeometry geometry) = 0;
     virtual GSbool xGSAPI DrawGeometryInstanced(IxGSGeometry geometry, GSuint count) = 0;
     virtual GSbool xGSAPI DrawGeometries(IxGSGeometry *geometries, GSuint count) = 0;
@@ -1386,11 +2030,123 @@ public:
     virtual GSbool xGSAPI BeginCapture(GSenum mode, IxGSGeometryBuffer buffer) = 0;
     virtual GSbool xGSAPI EndCapture(GSuint *elementcount) = 0;
 
+    // occlusion queries, only one query could be active at a time
+    virtual GSbool xGSAPI BeginQuery(IxGSQuery query) = 0;
+    virtual GSbool xGSAPI EndQuery(IxGSQuery query) = 0;
+
+    // conditional rendering, draws are skipped on GPU side if query
+    // passed no samples, query should be issued (ended) before
+    //      mode - GS_CONDITION_WAIT or GS_CONDITION_NOWAIT
+    virtual GSbool xGSAPI BeginConditionalRender(IxGSQuery query, GSenum mode) = 0;
+    virtual GSbool xGSAPI EndConditionalRender() = 0;
+
     virtual GSbool xGSAPI BeginImmediateDrawing(IxGSGeometryBuffer buffer, GSuint flags) = 0;
     virtual GSbool xGSAPI ImmediatePrimitive(GSenum type, GSuint vertexcount, GSuint indexcount, GSuint flags, GSimmediateprimitive *primitive) = 0;
     virtual GSbool xGSAPI EndImmediateDrawing() = 0;
 
+    // MIP levels generation
+    //      BuildMIPs         - generate all levels from base level with default filter
+    //      BuildMIPsFiltered - generate range of levels or their part with compute and given filter,
+    //                          2D, 2D array and cubemap textures of GS_COLOR_RGBA, GS_COLOR_S_RGBA,
+    //                          GS_COLOR_RGBA_HALFFLOAT and GS_COLOR_RGBA_FLOAT formats are supported
+    //      current state and its bindings are kept
     virtual GSbool xGSAPI BuildMIPs(IxGSTexture texture) = 0;
+    virtual GSbool xGSAPI BuildMIPsFiltered(IxGSTexture texture, const GSmipgenerationdescription &desc) = 0;
+
+    // mesh optimization, works on CPU side data only
+    //      flags - combination of GS_MESH_* optimizations, which are performed in order:
+    //              vertex cache, overdraw, vertex fetch
+    //              overdraw optimization works best after vertex cache optimization
+    virtual GSbool xGSAPI OptimizeMesh(const GSmeshdescription &mesh, GSuint flags) = 0;
+
+    // meshlet generation for fine grained culling, works on CPU side data only
+    //      mesh vertices with position are required
+    //      maxvertices  - max vertices per meshlet, up to 256
+    //      maxtriangles - max triangles per meshlet
+    //      meshlets follow triangle order, so vertex cache optimized mesh
+    //      gives meshlets with better locality
+    virtual GSbool xGSAPI BuildMeshlets(const GSmeshdescription &mesh, GSuint maxvertices, GSuint maxtriangles, GSmeshletdata &data) = 0;
+
+    // frustum culling and LOD selection for batch of geometries
+    //      visible      - receives compacted list of visible geometries (selected LODs)
+    //                     ready for DrawGeometries, should have room for desc.count entries
+    //      visiblecount - receives number of visible geometries
+    virtual GSbool xGSAPI CullGeometries(const GScullingdescription &desc, IxGSGeometry *visible, GSuint &visiblecount) = 0;
+
+    // block compression of RGBA image into one of GS_COLOR_BC* formats, works on CPU side data only
+    //      compressed image could be written into locked texture of the same format
+    virtual GSbool xGSAPI CompressImage(const GSimagecompressiondescription &desc) = 0;
+
+    // texture upload from CPU image with MIP chain built on CPU, levels are converted
+    // into texture format and written straight into texture lock memory
+    virtual GSbool xGSAPI UploadImage(IxGSTexture texture, const GSimageuploaddescription &desc) = 0;
+
+    // texture loading from KTX2 or DDS container file
+    //      file is memory mapped and every image is copied from mapping straight into
+    //      texture lock memory, container type is detected from file signature
+    //      texture - receives new texture object with all levels, layers and faces
+    //                stored in file
+    virtual GSbool xGSAPI LoadTexture(const char *filename, IxGSTexture *texture) = 0;
+
+    // progressive texture streaming
+    //      SetTextureStreaming    - set residency budget and upload limits
+    //      StreamTexture          - create texture from KTX2 or DDS container file with only
+    //                               small MIP levels uploaded, file stays mapped while texture exists
+    //      RequestTextureLevels   - report levels needed for rendering of current frame,
+    //                               textures not requested recently are first to be evicted
+    //      UpdateTextureStreaming - upload requested levels and evict levels over the budget,
+    //                               should be called once per frame, texture base level is
+    //                               always set to finest resident level
+    //      sparse textures are used when supported, so only resident levels take memory,
+    //      otherwise memory for all levels is allocated and budget limits only uploads
+    virtual GSbool xGSAPI SetTextureStreaming(const GStexturestreamingdescription &desc) = 0;
+    virtual GSbool xGSAPI StreamTexture(const char *filename, IxGSTexture *texture) = 0;
+    virtual GSbool xGSAPI RequestTextureLevels(const GStexturestreamingrequest *requests, GSuint count) = 0;
+    virtual GSbool xGSAPI UpdateTextureStreaming() = 0;
+
+    // virtual texture paging for sparse textures (2D textures created with GS_TEXFLAG_SPARSE)
+    //      SetTexturePaging            - set budget of committed pages
+    //      RequestTexturePages         - mark pages as used by current frame, pages are given as
+    //                                    packed identifiers (see GS_TEXPAGE_* constants)
+    //      RequestTexturePagesFeedback - the same as RequestTexturePages, but page identifiers are
+    //                                    read from data buffer written by shaders, buffer is read
+    //                                    immediately, so it should be one written by earlier frame
+    //      UpdateTexturePages          - commit memory for requested pages and release least
+    //                                    recently used pages over the budget, all commitment changes
+    //                                    of a frame are batched into as few calls as possible
+    //                                    committed - receives newly committed pages, which content
+    //                                                should be written by application
+    //                                    count     - in: committed array capacity, which also limits
+    //                                                number of commits, out: number of committed pages
+    //      MIP tail of paged texture is committed on first request and always stays resident
+    virtual GSbool xGSAPI SetTexturePaging(const GStexturepagingdescription &desc) = 0;
+    virtual GSbool xGSAPI RequestTexturePages(IxGSTexture texture, const GSuint *pages, GSuint count) = 0;
+    virtual GSbool xGSAPI RequestTexturePagesFeedback(IxGSTexture texture, IxGSDataBuffer feedback, GSuint count) = 0;
+    virtual GSbool xGSAPI UpdateTexturePages(GStexturepage *committed, GSuint &count) = 0;
+
+    // bindless textures
+    //      GetTextureHandle - get 64-bit handle of texture sampled with given sampler (GSS_* value),
+    //                         GS_DEFAULT sampler uses texture own sampling state, which is the only
+    //                         option for buffer textures
+    //                         handle is made resident and stays valid until texture is destroyed,
+    //                         the same handle is returned for the same texture and sampler
+    //      handles could be written into data buffers or set as GSU_HANDLE uniforms, shaders
+    //      use them with ARB_bindless_texture, so textures don't need separate bindings
+    //      texture parameters can't change after handle is created, so streamed textures
+    //      don't have handles, and samplers can't be recreated while handles use them
+    virtual GSbool xGSAPI GetTextureHandle(IxGSTexture texture, GSenum sampler, GSuint64 &handle) = 0;
+
+    // GPU driven drawing
+    //      BuildDrawCommands      - write indirect draw commands of indexed geometries into data buffer,
+    //                               GS_DRAWCOMMAND_SIZE bytes per geometry, geometries should be allocated
+    //                               in the same geometry buffer and have the same type and index format
+    //      CullGeometriesGPU      - cull objects on GPU with compute, current state is reset
+    //                             after culling and should be set again
+    //      DrawGeometriesIndirect - draw count commands from data buffer with single call,
+    //                               geometry is any of geometries commands were built from
+    virtual GSbool xGSAPI BuildDrawCommands(IxGSGeometry *geometries, GSuint count, IxGSDataBuffer commands) = 0;
+    virtual GSbool xGSAPI CullGeometriesGPU(const GSgpucullingdescription &desc) = 0;
+    virtual GSbool xGSAPI DrawGeometriesIndirect(IxGSGeometry geometry, IxGSDataBuffer commands, GSuint count) = 0;
 
     virtual GSbool xGSAPI CopyImage(
         IxGSTexture src, GSuint srclevel, GSuint srcx, GSuint srcy, GSuint srcz,
@@ -1400,12 +2156,24 @@ public:
     virtual GSbool xGSAPI CopyData(xGSObject *src, xGSObject *dst, GSuint readoffset, GSuint writeoffset, GSuint size, GSuint flags) = 0;
 
     // sparse API wip
+    //      GeometryBufferCommitment - release (commit = false) or commit again pages of geometries
+    //                                 of GS_GBFLAG_SPARSE heap, pages shared with other resident
+    //                                 geometries stay committed, geometries which are not resident
+    //                                 can't be locked and shouldn't be drawn
     virtual GSbool xGSAPI BufferCommitment(xGSObject *buffer, GSuint offset, GSuint size, GSbool commit, GSuint flags) = 0;
     virtual GSbool xGSAPI GeometryBufferCommitment(IxGSGeometryBuffer buffer, IxGSGeometry *geometries, GSuint count, GSbool commit) = 0;
     virtual GSbool xGSAPI TextureCommitment(IxGSTexture texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit) = 0;
 
-    // compute API wip
+    // compute API
+    //      Compute         - dispatch x * y * z work groups of compute state program,
+    //                        current state is reset after dispatch and should be set again
+    //      ComputeIndirect - same as Compute, but group counts are read by GPU from data buffer
+    //                        at given offset, GS_DISPATCHCOMMAND_SIZE bytes
+    //      Barrier         - make memory written by preceding dispatches visible to
+    //                        following commands, flags are combination of GS_BARRIER_ values
     virtual GSbool xGSAPI Compute(IxGSComputeState state, GSuint x, GSuint y, GSuint z) = 0;
+    virtual GSbool xGSAPI ComputeIndirect(IxGSComputeState state, IxGSDataBuffer buffer, GSuint offset) = 0;
+    virtual GSbool xGSAPI Barrier(GSuint flags) = 0;
 
     // timer query API wip, for testing only now
     virtual GSbool xGSAPI BeginTimerQuery() = 0;
@@ -17,6 +17,14 @@
 #include "xGStexture.h"
 #include "xGSstate.h"
 #include "xGSparameters.h"
+#include "xGSquery.h"
+#include "xGScomputestate.h"
+#include "xGSmesh.h"
+#include "xGSculling.h"
+#include "xGStexcompress.h"
+#include "xGSmipchain.h"
+#include "xGStextureloader.h"
+#include <algorithm>
 
 
 using namespace xGS;
@@ -36,20 +44,40 @@ IxGSDataBufferImpl::~IxGSDataBufferImpl()
 
 GSbool IxGSDataBufferImpl::allocate(const GSdatabufferdescription &desc)
 {
+    // TODO: refactor caps for all implementations
+    GSuint alignment = 0;
+
+    // uniform buffers are laid out with std140 rules, storage buffers with std430
+    bool std430 = false;
+
     switch (desc.type) {
-        case GSDT_UNIFORM: break;
+        case GSDT_UNIFORM:
+            alignment = p_owner->caps().ubo_alignment;
+            break;
+
+        case GSDT_STORAGE:
+            alignment = p_owner->caps().ssbo_alignment;
+            std430 = true;
+            break;
+
         default:
             return p_owner->error(GSE_INVALIDENUM);
     }
 
+    // zero alignment means buffer type isn't supported by implementation
+    if (alignment == 0) {
+        return p_owner->error(GSE_UNSUPPORTED);
+    }
+
     p_size = 0;
 
     if (!desc.blocks) {
         return p_owner->error(GSE_INVALIDVALUE);
     }
 
-    // TODO: refactor caps for all implementations
-    GSuint alignment = p_owner->caps().ubo_alignment - 1;
+    // if state is given, layout of every block is taken from state's shaders
+    // instead of being computed, so it matches shader layout exactly
+    const xGSStateImpl *state = static_cast<xGSStateImpl*>(desc.state);
 
     const GSuniformblock *block = desc.blocks;
     while (block->type != GSB_END) {
@@ -62,36 +90,61 @@ GSbool IxGSDataBufferImpl::allocate(const GSdatabufferdescription &desc)
             GSuint(p_uniforms.size())  // onepastlastuniform
         };
 
+        const xGSStateBase::UniformBlockLayout *blocklayout = nullptr;
+        if (state) {
+            if (block->name) {
+                blocklayout = state->uniformBlockLayout(block->name, std430);
+            }
+            if (!blocklayout) {
+                return p_owner->error(GSE_INVALIDVALUE);
+            }
+        }
+
+        // block is aligned as structure, std140 rounds structure alignment up to vec4 alignment
+        GSuint blockalignment = std430 ? 4 : 16;
+
         const GSuniform *uniform = block->uniforms;
         GSuint uniformoffset = 0;
         while (uniform->type != GSU_END) {
+            if (uniform->count == 0) {
+                return p_owner->error(GSE_INVALIDVALUE);
+            }
+
+            GSuniformlayout layout;
+            if (!uniform_layout(uniform->type, uniform->count, std430, layout)) {
+                return p_owner->error(GSE_INVALIDENUM);
+            }
+
             Uniform u = {
-                uniform->type, // type
-                uniformoffset, // offset
-                0,             // size
-                0,             // stride
-                0,             // totalsize
-                uniform->count // count
+                uniform->type,                          // type
+                align(uniformoffset, layout.alignment), // offset
+                layout.size,                            // size
+                layout.stride,                          // stride
+                0,                                      // totalsize
+                uniform->count                          // count
             };
 
-            // TODO: check stride values
-            switch (uniform->type) {
-                case GSU_SCALAR: u.size = 4; u.stride = 16; break;
-                case GSU_VEC2:   u.size = 8; u.stride = 16; break;
-                case GSU_VEC3:   u.size = 16; u.stride = 16; break;
-                case GSU_VEC4:   u.size = 16; u.stride = 16; break;
-                case GSU_MAT2:   u.size = 32; u.stride = 32; break;
-                case GSU_MAT3:   u.size = 48; u.stride = 48; break;
-                case GSU_MAT4:   u.size = 64; u.stride = 64; break;
-                default:
-                    return p_owner->error(GSE_INVALIDENUM);
+            if (blocklayout) {
+                const xGSStateBase::UniformLayout *uniformlayout = nullptr;
+                if (uniform->name) {
+                    uniformlayout = state->uniformLayout(*blocklayout, uniform->name);
+                }
+                if (!uniformlayout || uniformlayout->type != uniform->type || uniform->count > uniformlayout->count) {
+                    return p_owner->error(GSE_INVALIDVALUE);
+                }
+
+                u.offset = uniformlayout->offset;
+                if (uniformlayout->matrixstride) {
+                    u.size = uniformlayout->matrixstride * layout.columns;
+                }
+                u.stride = uniformlayout->arraystride ? uniformlayout->arraystride : align(u.size, layout.alignment);
             }
 
-            // TODO: adjust array paddings
-            u.totalsize = u.stride * uniform->count;
-            uniformoffset += u.totalsize;
+            u.totalsize = uniform->count > 1 ? u.stride * uniform->count : u.size;
+            uniformoffset = u.offset + u.totalsize;
 
-            uniformblock.size += u.totalsize;
+            uniformblock.actualsize = umax(uniformblock.actualsize, uniformoffset);
+            blockalignment = umax(blockalignment, layout.alignment);
             ++uniformblock.onepastlastuniform;
 
             p_uniforms.push_back(u);
@@ -99,8 +152,13 @@ GSbool IxGSDataBufferImpl::allocate(const GSdatabufferdescription &desc)
             ++uniform;
         }
 
-        uniformblock.actualsize = uniformblock.size;
-        uniformblock.size = (uniformblock.size + alignment) & ~alignment;
+        if (blocklayout) {
+            uniformblock.actualsize = umax(uniformblock.actualsize, blocklayout->datasize);
+        } else {
+            uniformblock.actualsize = align(uniformblock.actualsize, blockalignment);
+        }
+
+        uniformblock.size = align(uniformblock.actualsize, alignment);
         GSuint blocksize = uniformblock.size * block->count;
 
         p_blocks.push_back(uniformblock);
@@ -133,9 +191,7 @@ GSbool IxGSDataBufferImpl::Update(GSuint offset, GSuint size, const GSptr data)
         return p_owner->error(GSE_INVALIDOPERATION);
     }
 
-    UpdateImpl(offset, size, data);
-
-    return p_owner->error(GS_OK);
+    return update(offset, size, data);
 }
 
 GSbool IxGSDataBufferImpl::UpdateBlock(GSuint block, GSuint index, const GSptr data)
@@ -154,9 +210,7 @@ GSbool IxGSDataBufferImpl::UpdateBlock(GSuint block, GSuint index, const GSptr d
         return p_owner->error(GSE_INVALIDVALUE);
     }
 
-    UpdateImpl(ub.offset + ub.size * index, ub.actualsize, data);
-
-    return p_owner->error(GS_OK);
+    return update(ub.offset + ub.size * index, ub.actualsize, data);
 }
 
 GSbool IxGSDataBufferImpl::UpdateValue(GSuint block, GSuint index, GSuint uniform, GSuint uniformindex, GSuint count, const GSptr data)
@@ -181,26 +235,82 @@ GSbool IxGSDataBufferImpl::UpdateValue(GSuint block, GSuint index, GSuint unifor
 
     const Uniform &u = p_uniforms[ub.firstuniform + uniform];
 
-    if (uniformindex >= u.count) {
+    if (uniformindex >= u.count || count == 0 || count > (u.count - uniformindex)) {
         return p_owner->error(GSE_INVALIDVALUE);
     }
 
     GSuint offset = ub.offset + ub.size * index + u.offset + u.stride * uniformindex;
 
-    UpdateImpl(offset, u.stride * count, data);
+    // last element isn't padded up to stride, so following packed uniforms aren't overwritten
+    return update(offset, u.stride * (count - 1) + u.size, data);
+}
+
+GSbool IxGSDataBufferImpl::BeginUpdate()
+{
+    if (p_size == 0 || p_updating || p_locktype) {
+        return p_owner->error(GSE_INVALIDOPERATION);
+    }
+
+    p_shadow.resize(p_size);
+    p_dirty.clear();
+    p_updating = true;
+
+    return p_owner->error(GS_OK);
+}
+
+GSbool IxGSDataBufferImpl::EndUpdate()
+{
+    if (!p_updating) {
+        return p_owner->error(GSE_INVALIDOPERATION);
+    }
+
+    p_updating = false;
+
+    if (p_dirty.empty()) {
+        return p_owner->error(GS_OK);
+    }
+
+    std::sort(
+        p_dirty.begin(), p_dirty.end(),
+        [](const DirtyRange &a, const DirtyRange &b) { return a.offset < b.offset; }
+    );
+
+    // merge overlapping and adjacent ranges, ranges with gaps can not be merged
+    // because shadow copy data between them doesn't match buffer data
+    DirtyRange current = p_dirty[0];
+    for (size_t n = 1; n < p_dirty.size(); ++n) {
+        const DirtyRange &r = p_dirty[n];
+        if (r.offset <= current.offset + current.size) {
+            current.size = umax(current.offset + current.size, r.offset + r.size) - current.offset;
+        } else {
+            UpdateImpl(current.offset, current.size, &p_shadow[current.offset]);
+            current = r;
+        }
+    }
+    UpdateImpl(current.offset, current.size, &p_shadow[current.offset]);
+
+    p_dirty.clear();
 
     return p_owner->error(GS_OK);
 }
 
 GSptr IxGSDataBufferImpl::Lock(GSdword access, void *lockdata)
 {
-    if (p_locktype) {
+    if (p_locktype || p_updating) {
         p_owner->error(GSE_INVALIDOPERATION);
         return nullptr;
     }
 
-    p_owner->error(GS_OK);
-    return LockImpl(access);
+    if (access == 0 || (access & ~GS_READWRITE)) {
+        p_owner->error(GSE_INVALIDENUM);
+        return nullptr;
+    }
+
+    // buffer could fail to lock for requested access (e.g. reading uniform buffer)
+    GSptr result = LockImpl(access);
+    p_owner->error(result ? GS_OK : GSE_INVALIDOPERATION);
+
+    return result;
 }
 
 GSbool IxGSDataBufferImpl::Unlock()
@@ -214,6 +324,30 @@ GSbool IxGSDataBufferImpl::Unlock()
     return p_owner->error(GS_OK);
 }
 
+GSbool IxGSDataBufferImpl::update(GSuint offset, GSuint size, const GSptr data)
+{
+    if (!p_updating) {
+        UpdateImpl(offset, size, data);
+        return p_owner->error(GS_OK);
+    }
+
+    if (offset >= p_size || size > p_size - offset) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    memcpy(&p_shadow[offset], data, size);
+
+    // extend last range if data is written right after it, which is the most common case
+    if (p_dirty.size() && p_dirty.back().offset + p_dirty.back().size == offset) {
+        p_dirty.back().size += size;
+    } else {
+        DirtyRange range = { offset, size };
+        p_dirty.push_back(range);
+    }
+
+    return p_owner->error(GS_OK);
+}
+
 
 
 IxGSFrameBufferImpl::IxGSFrameBufferImpl(xGSImpl *owner) :
@@ -426,7 +560,9 @@ GSvalue IxGSGeometryBufferImpl::GetValue(GSenum valuetype)
         case GS_GB_INDEXBYTES:        return 0; // TODO
         case GS_GB_ACCESS:            return 0; // TODO
         case GS_GB_VERTICESALLOCATED: return p_currentvertex;
-        case GS_GB_INDICESALLOCATED:  return p_currentindex;
+        case GS_GB_INDICESALLOCATED:  return p_narrowindices ? (p_currentindex + p_currentindex16) / 2 : p_currentindex;
+        case GS_GB_PAGESIZE:          return p_pagesize;
+        case GS_GB_COMMITTEDPAGES:    return p_committedpages;
     }
 
     p_owner->error(GSE_INVALIDENUM);
@@ -450,6 +586,12 @@ GSptr IxGSGeometryBufferImpl::Lock(GSenum locktype, GSdword access, void *lockda
         return nullptr;
     }
 
+    // sparse heap has uncommitted pages, only geometries could be locked
+    if (sparse()) {
+        p_owner->error(GSE_INVALIDOPERATION);
+        return nullptr;
+    }
+
     p_owner->error(GS_OK);
     return LockImpl(
         locktype, 0,
@@ -541,7 +683,10 @@ GSbool IxGSInputImpl::allocate(const GSinputdescription &desc)
 
         xGSGeometryBufferImpl *buffer = static_cast<xGSGeometryBufferImpl*>(binding->buffer);
 
-        // TODO: check layout match
+        if (!buffer->vertexDecl().compatible(state->input(binding->slot - GSIS_0).decl)) {
+            // buffer vertex layout doesn't match slot layout
+            return p_owner->error(GSE_INVALIDVALUE);
+        }
 
         if (buffer->indexFormat() != GS_INDEX_NONE) {
             ++elementbuffers;
@@ -578,6 +723,8 @@ IxGSTextureImpl::IxGSTextureImpl(xGSImpl *owner) :
 
 IxGSTextureImpl::~IxGSTextureImpl()
 {
+    p_owner->textureStreamer().remove(this);
+    p_owner->texturePager().remove(this);
     ReleaseRendererResources();
     p_owner->debug(DebugMessageLevel::Information, "Texture object destroyed\n");
 }
@@ -594,6 +741,11 @@ GSvalue IxGSTextureImpl::GetValue(GSenum valuetype)
         case GS_TEX_MIN_LEVEL:   return p_minlevel;
         case GS_TEX_MAX_LEVEL:   return p_maxlevel;
         case GS_TEX_MULTISAMPLE: return p_multisample;
+        case GS_TEX_FLAGS:       return p_flags;
+        case GS_TEX_PAGE_WIDTH:  return p_pagesize[0];
+        case GS_TEX_PAGE_HEIGHT: return p_pagesize[1];
+        case GS_TEX_PAGE_DEPTH:  return p_pagesize[2];
+        case GS_TEX_SPARSE_LEVELS: return p_sparselevels;
 
         default:
             p_owner->error(GSE_INVALIDENUM);
@@ -633,6 +785,25 @@ GSbool IxGSTextureImpl::Unlock()
 GSbool IxGSTextureImpl::allocate(const GStexturedescription &desc)
 {
     // TODO: check params
+
+    if (desc.flags & ~GS_TEXFLAG_SPARSE) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    if ((desc.flags & GS_TEXFLAG_SPARSE) && !p_owner->SparseTextureSupported(desc)) {
+        return p_owner->error(GSE_UNSUPPORTED);
+    }
+
+    // block compressed images are supported only for 2D and cubemap textures
+    if (texture_block_size(desc.format)) {
+        if (desc.type != GS_TEXTYPE_2D && desc.type != GS_TEXTYPE_CUBEMAP) {
+            return p_owner->error(GSE_INVALIDENUM);
+        }
+        if (desc.multisample != GS_MULTISAMPLE_NONE) {
+            return p_owner->error(GSE_INVALIDVALUE);
+        }
+    }
+
     p_texturetype = desc.type;
     p_format = desc.format;
     p_width = desc.width;
@@ -640,6 +811,7 @@ GSbool IxGSTextureImpl::allocate(const GStexturedescription &desc)
     p_depth = desc.depth;
     p_layers = desc.layers;
     p_multisample = desc.multisample;
+    p_flags = desc.flags;
     if (p_texturetype == GS_TEXTYPE_RECT) {
         p_minlevel = 0;
         p_maxlevel = 0;
@@ -655,6 +827,35 @@ GSbool IxGSTextureImpl::allocate(const GStexturedescription &desc)
     return p_owner->error(GS_OK);
 }
 
+bool IxGSTextureImpl::validCommitment(GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth) const
+{
+    if (level > p_maxlevel || ((p_width >> level) == 0 && (p_height >> level) == 0)) {
+        return false;
+    }
+
+    GSuint levelwidth = umax(p_width >> level, 1u);
+    GSuint levelheight = umax(p_height >> level, 1u);
+    GSuint leveldepth = p_texturetype == GS_TEXTYPE_3D ?
+        umax(p_depth >> level, 1u) :
+        umax(p_layers, 1u) * (p_texturetype == GS_TEXTYPE_CUBEMAP ? 6 : 1);
+
+    if (x + width > levelwidth || y + height > levelheight || z + depth > leveldepth) {
+        return false;
+    }
+
+    // MIP tail is committed as a whole, any region of it commits all tail levels
+    if (level >= p_sparselevels) {
+        return true;
+    }
+
+    // region should consist of whole pages, except pages at level edge
+    GSuint depthpage = p_texturetype == GS_TEXTYPE_3D ? p_pagesize[2] : 1;
+    return
+        x % p_pagesize[0] == 0 && (width % p_pagesize[0] == 0 || x + width == levelwidth) &&
+        y % p_pagesize[1] == 0 && (height % p_pagesize[1] == 0 || y + height == levelheight) &&
+        z % depthpage == 0 && (depth % depthpage == 0 || z + depth == leveldepth);
+}
+
 
 
 IxGSStateImpl::IxGSStateImpl(xGSImpl *owner) :
@@ -707,6 +908,10 @@ GSbool IxGSStateImpl::allocate(const GSstatedescription &desc)
                 xGSGeometryBufferImpl *buffer =
                     static_cast<xGSGeometryBufferImpl*>(inputlayout->buffer);
 
+                if (!buffer->vertexDecl().compatible(slot.decl)) {
+                    return p_owner->error(GSE_INVALIDVALUE);
+                }
+
                 slot.buffer = buffer;
                 buffer->AddRef();
 
@@ -759,6 +964,7 @@ GSbool IxGSStateImpl::allocate(const GSstatedescription &desc)
                     break;
 
                 case GSPD_BLOCK:
+                case GSPD_STORAGEBLOCK:
                     slot.location = param->location;
                     break;
 
@@ -868,145 +1074,667 @@ void IxGSParametersImpl::ReleaseRendererResources()
 
 
 
-IxGSImpl::~IxGSImpl()
+IxGSQueryImpl::IxGSQueryImpl(xGSImpl *owner) :
+    xGSObjectImpl(owner)
 {
-    // TODO: make internal implementation of these End/Destroy funcs
-    //       without some unnecessary checks?
+    p_owner->debug(DebugMessageLevel::Information, "Query object created\n");
+}
 
-    if (p_systemstate == CAPTURE) {
-        EndCapture(nullptr);
-    }
-    if (p_systemstate == RENDERER_READY) {
-        DestroyRenderer(true);
-    }
+IxGSQueryImpl::~IxGSQueryImpl()
+{
+    ReleaseRendererResources();
+    p_owner->debug(DebugMessageLevel::Information, "Query object destroyed\n");
 }
 
-GSbool IxGSImpl::CreateRenderer(const GSrendererdescription &desc)
+GSbool IxGSQueryImpl::allocate(const GSquerydescription &desc)
 {
-    if (!ValidateState(SYSTEM_READY, true, false, false)) {
-        return GS_FALSE;
-    }
+    switch (desc.type) {
+        case GS_QUERY_SAMPLES_PASSED:
+        case GS_QUERY_ANY_SAMPLES_PASSED:
+        case GS_QUERY_ANY_SAMPLES_PASSED_CONSERVATIVE:
+            break;
 
-    CreateRendererImpl(desc);
+        default:
+            return p_owner->error(GSE_INVALIDENUM);
+    }
 
-    if (p_error != GS_OK) {
-        return GS_FALSE;
+    if (!AllocateImpl(desc.type)) {
+        return p_owner->error(GSE_OUTOFRESOURCES);
     }
 
-    p_systemstate = RENDERER_READY;
+    p_querytype = desc.type;
 
-    return GS_TRUE;
+    return p_owner->error(GS_OK);
 }
 
-GSbool IxGSImpl::DestroyRenderer(GSbool restorevideomode)
+GSvalue IxGSQueryImpl::GetValue(GSenum valuetype)
 {
-    if (!ValidateState(RENDERER_READY, true, true, false)) {
-        return GS_FALSE;
-    }
+    switch (valuetype) {
+        case GS_QUERY_TYPE:
+            return p_querytype;
 
-    ::Release(p_state);
-    ::Release(p_input);
-    for (size_t n = 0; n < GS_MAX_PARAMETER_SETS; ++n) {
-        ::Release(p_parameters[n]);
+        case GS_QUERY_AVAILABLE:
+            if (!p_issued || p_active) {
+                p_owner->error(GSE_INVALIDOPERATION);
+                return GS_FALSE;
+            }
+            return ResultAvailableImpl();
+
+        default:
+            p_owner->error(GSE_INVALIDENUM);
+            return 0;
     }
-    ::Release(p_rendertarget);
+}
 
-    ReleaseObjectList(p_statelist, "State");
-    ReleaseObjectList(p_inputlist, "Input");
-    ReleaseObjectList(p_parameterslist, "Parameters");
-    ReleaseObjectList(p_geometrylist, "Geomtery");
-    ReleaseObjectList(p_framebufferlist, "Framebuffer");
-    ReleaseObjectList(p_geometrybufferlist, "GeomteryBuffer");
-    ReleaseObjectList(p_databufferlist, "DataBuffer");
-    ReleaseObjectList(p_texturelist, "Texture");
+GSbool IxGSQueryImpl::GetResult(GSuint64 &result, GSbool wait)
+{
+    if (!p_issued || p_active) {
+        return p_owner->error(GSE_INVALIDOPERATION);
+    }
 
-    DestroyRendererImpl();
+    if (!wait && !ResultAvailableImpl()) {
+        return p_owner->error(GSE_INVALIDSTATE);
+    }
 
-    p_systemstate = SYSTEM_READY;
+    result = ResultImpl();
 
-    return GS_TRUE;
+    return p_owner->error(GS_OK);
 }
 
-#define GS_CREATE_OBJECT(typeconst, impltype, desctype)\
-        case typeconst: {\
-            impltype *object = impltype::create(this, typeconst);\
-            if (object->allocate(*reinterpret_cast<const desctype*>(desc))) {\
-                *result = object;\
-                return error(GS_OK);\
-            } else {\
-                object->Release();\
-                return GS_FALSE;\
-            }\
-        }
 
-GSbool IxGSImpl::CreateObject(GSenum type, const void *desc, void **result)
-{
-    // TODO: make refcounting and adding to object list only after successful creation
-    switch (type) {
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_GEOMETRY, IxGSGeometryImpl, GSgeometrydescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_GEOMETRYBUFFER, IxGSGeometryBufferImpl, GSgeometrybufferdescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_DATABUFFER, IxGSDataBufferImpl, GSdatabufferdescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_TEXTURE, IxGSTextureImpl, GStexturedescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_FRAMEBUFFER, IxGSFrameBufferImpl, GSframebufferdescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_STATE, IxGSStateImpl, GSstatedescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_INPUT, IxGSInputImpl, GSinputdescription)
-        GS_CREATE_OBJECT(GS_OBJECTTYPE_PARAMETERS, IxGSParametersImpl, GSparametersdescription)
-    }
 
-    return error(GSE_INVALIDENUM);
+IxGSComputeStateImpl::IxGSComputeStateImpl(xGSImpl *owner) :
+    xGSObjectImpl(owner)
+{
+    p_owner->debug(DebugMessageLevel::Information, "ComputeState object created\n");
 }
 
-#undef GS_CREATE_OBJECT
+IxGSComputeStateImpl::~IxGSComputeStateImpl()
+{
+    ReleaseRendererResources();
+    p_owner->debug(DebugMessageLevel::Information, "ComputeState object destroyed\n");
+}
 
-GSbool IxGSImpl::CreateSamplers(const GSsamplerdescription *samplers, GSuint count)
+GSbool IxGSComputeStateImpl::allocate(const GScomputestatedescription &desc)
 {
-    GSuint references = 0;
-    for (auto &s : p_samplerlist) {
-        references += s.refcount;
+    if (!desc.shader || !*desc.shader) {
+        return p_owner->error(GSE_INVALIDVALUE);
     }
 
-    if (references) {
-        return error(GSE_INVALIDOPERATION);
+    if (!desc.parameterlayout) {
+        return p_owner->error(GSE_INVALIDVALUE);
     }
 
-    // TODO: input validation
+    // gather parameters info
+    p_parameterslots.clear();
 
-    CreateSamplersImpl(samplers, count);
+    const GScomputeparameterlayout *staticparams = nullptr;
+    GSuint currentimageunit = 0;
 
-    return p_error == GS_OK;
-}
+    // compute state accepts only single static set for now,
+    // all its resources are bound when state is created
+    const GScomputeparameterlayout *paramset = desc.parameterlayout;
+    while (paramset->settype != GSP_END) {
+        if (paramset->settype != GSP_STATIC || staticparams) {
+            return p_owner->error(GSE_INVALIDENUM);
+        }
 
-GSbool IxGSImpl::GetRenderTargetSize(GSsize &size)
-{
-    if (!ValidateState(RENDERER_READY, false, false, false)) {
-        return GS_FALSE;
-    }
+        const GSparameterdecl *param = paramset->parameters;
+        while (param->type != GSPD_END) {
+            ParameterSlot slot = {
+                param->type,
+                GS_DEFAULT,
+                param->index
+            };
 
-    GetRenderTargetSizeImpl(size);
+            switch (param->type) {
+                case GSPD_BLOCK:
+                case GSPD_STORAGEBLOCK:
+                    slot.location = param->location;
+                    break;
 
-    return error(GS_OK);
-}
+                case GSPD_IMAGE:
+                    slot.location = currentimageunit++;
+                    break;
 
-GSbool IxGSImpl::Clear(GSbool color, GSbool depth, GSbool stencil, const GScolor &colorvalue, float depthvalue, GSdword stencilvalue)
-{
-    if (!ValidateState(RENDERER_READY, true, true, false)) {
-        return GS_FALSE;
-    }
+                default:
+                    return p_owner->error(GSE_INVALIDENUM);
+            }
 
-    ClearImpl(color, depth, stencil, colorvalue, depthvalue, stencilvalue);
+            p_parameterslots.push_back(slot);
 
-    return error(GS_OK);
-}
+            ++param;
+        }
 
-GSbool IxGSImpl::Display()
-{
-    if (!ValidateState(RENDERER_READY, true, true, false)) {
-        return GS_FALSE;
-    }
+        staticparams = paramset;
 
-    DisplayImpl();
+        ++paramset;
+    }
 
-    return p_error == GS_OK;
+    return AllocateImpl(desc, staticparams);
+}
+
+
+
+IxGSAtlasImpl::IxGSAtlasImpl(xGSImpl *owner) :
+    xGSObjectImpl(owner)
+{
+    p_owner->debug(DebugMessageLevel::Information, "Atlas object created\n");
+}
+
+IxGSAtlasImpl::~IxGSAtlasImpl()
+{
+    ReleaseRendererResources();
+    p_owner->debug(DebugMessageLevel::Information, "Atlas object destroyed\n");
+}
+
+GSbool IxGSAtlasImpl::allocate(const GSatlasdescription &desc)
+{
+    if (desc.width == 0 || desc.height == 0 || desc.layers == 0) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    // padding texels are copied from image texels, which can't be done for blocks
+    if (texture_block_size(desc.format)) {
+        return p_owner->error(GSE_INVALIDENUM);
+    }
+
+    p_texture = createTexture(desc.format, desc.width, desc.height, desc.layers);
+    if (!p_texture) {
+        return GS_FALSE;
+    }
+
+    p_padding = desc.padding;
+    p_packer.configure(desc.width, desc.height, desc.layers);
+
+    return p_owner->error(GS_OK);
+}
+
+void IxGSAtlasImpl::ReleaseRendererResources()
+{
+    if (p_texture) {
+        p_texture->Release();
+        p_texture = nullptr;
+    }
+
+    p_entries.clear();
+    p_packer.clear();
+    p_unused = 0;
+}
+
+GSvalue IxGSAtlasImpl::GetValue(GSenum valuetype)
+{
+    switch (valuetype) {
+        case GS_ATLAS_WIDTH:
+            return p_texture->width();
+
+        case GS_ATLAS_HEIGHT:
+            return p_texture->height();
+
+        case GS_ATLAS_LAYERS:
+            return p_texture->layers();
+
+        case GS_ATLAS_IMAGES:
+            return GSvalue(p_entries.size());
+
+        case GS_ATLAS_UNUSED:
+            return p_unused;
+
+        default:
+            p_owner->error(GSE_INVALIDENUM);
+            return 0;
+    }
+}
+
+GSbool IxGSAtlasImpl::Add(const GSatlasimage *images, GSuint count, GSatlasentry *entries)
+{
+    if (images == nullptr || count == 0) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    for (GSuint n = 0; n < count; ++n) {
+        if (images[n].width == 0 || images[n].height == 0 || images[n].source == nullptr) {
+            return p_owner->error(GSE_INVALIDVALUE);
+        }
+    }
+
+    // higher images are placed first, they leave less gaps under skyline
+    std::vector<GSuint> order(count);
+    for (GSuint n = 0; n < count; ++n) {
+        order[n] = n;
+    }
+    std::sort(order.begin(), order.end(), [images](GSuint a, GSuint b) {
+        return images[a].height != images[b].height ?
+            images[a].height > images[b].height :
+            images[a].width > images[b].width;
+    });
+
+    // images are added all at once, so packer is restored if any doesn't fit
+    AtlasPacker packer(p_packer);
+
+    std::vector<GStextureregion> regions(count);
+    for (auto n : order) {
+        const GSatlasimage &image = images[n];
+        GStextureregion &region = regions[n];
+
+        if (!p_packer.allocate(image.width + p_padding * 2, image.height + p_padding * 2, region.x, region.y, region.layer)) {
+            p_packer = packer;
+            return p_owner->error(GSE_OUTOFRESOURCES);
+        }
+
+        region.width = image.width;
+        region.height = image.height;
+        region.border = p_padding;
+        region.source = image.source;
+        region.pitch = image.pitch;
+    }
+
+    if (!p_texture->UpdateRegions(regions.data(), count)) {
+        p_packer = packer;
+        return p_owner->error(GSE_OUTOFRESOURCES);
+    }
+
+    for (GSuint n = 0; n < count; ++n) {
+        const GStextureregion &region = regions[n];
+        Entry area = {
+            region.x, region.y, region.layer,
+            region.width + p_padding * 2, region.height + p_padding * 2
+        };
+
+        GSuint id = p_nextid++;
+        p_entries[id] = area;
+
+        if (entries) {
+            fillEntry(id, area, entries[n]);
+        }
+    }
+
+    return p_owner->error(GS_OK);
+}
+
+GSbool IxGSAtlasImpl::Remove(GSuint id)
+{
+    auto entry = p_entries.find(id);
+    if (entry == p_entries.end()) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    p_unused += entry->second.width * entry->second.height;
+    p_entries.erase(entry);
+
+    // empty atlas is reclaimed without repacking
+    if (p_entries.empty()) {
+        p_packer.clear();
+        p_unused = 0;
+    }
+
+    return p_owner->error(GS_OK);
+}
+
+GSbool IxGSAtlasImpl::GetEntry(GSuint id, GSatlasentry &entry)
+{
+    auto area = p_entries.find(id);
+    if (area == p_entries.end()) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    fillEntry(id, area->second, entry);
+
+    return p_owner->error(GS_OK);
+}
+
+GSbool IxGSAtlasImpl::Repack()
+{
+    if (p_unused == 0) {
+        return p_owner->error(GS_OK);
+    }
+
+    std::vector<std::pair<GSuint, Entry>> moved(p_entries.begin(), p_entries.end());
+    std::sort(moved.begin(), moved.end(), [](const std::pair<GSuint, Entry> &a, const std::pair<GSuint, Entry> &b) {
+        return a.second.height != b.second.height ?
+            a.second.height > b.second.height :
+            a.second.width > b.second.width;
+    });
+
+    // nothing is moved until all images are placed, so failed repack keeps atlas as it was
+    AtlasPacker packer(p_packer);
+    p_packer.clear();
+
+    std::vector<Entry> areas(moved.size());
+    for (size_t n = 0; n < moved.size(); ++n) {
+        areas[n] = moved[n].second;
+        if (!p_packer.allocate(areas[n].width, areas[n].height, areas[n].x, areas[n].y, areas[n].layer)) {
+            p_packer = packer;
+            return p_owner->error(GSE_OUTOFRESOURCES);
+        }
+    }
+
+    // moved images are copied out to scratch texture first, so new placement
+    // never overwrites image which hasn't been copied yet, scratch texture
+    // holds only moved images packed together
+    std::vector<size_t> movedindices;
+    std::vector<Entry> scratchareas;
+    AtlasPacker scratchpacker;
+    scratchpacker.configure(p_texture->width(), p_texture->height(), p_texture->layers());
+
+    GSuint scratchwidth = 0;
+    GSuint scratchheight = 0;
+    GSuint scratchlayers = 0;
+    for (size_t n = 0; n < moved.size(); ++n) {
+        const Entry &from = moved[n].second;
+        const Entry &to = areas[n];
+        if (from.x == to.x && from.y == to.y && from.layer == to.layer) {
+            continue;
+        }
+
+        Entry area = from;
+        if (!scratchpacker.allocate(area.width, area.height, area.x, area.y, area.layer)) {
+            p_packer = packer;
+            return p_owner->error(GSE_OUTOFRESOURCES);
+        }
+
+        scratchwidth = umax(scratchwidth, area.x + area.width);
+        scratchheight = umax(scratchheight, area.y + area.height);
+        scratchlayers = umax(scratchlayers, area.layer + 1);
+
+        movedindices.push_back(n);
+        scratchareas.push_back(area);
+    }
+
+    // nothing to move, entries already have their places
+    if (movedindices.empty()) {
+        p_unused = 0;
+        return p_owner->error(GS_OK);
+    }
+
+    IxGSTextureImpl *scratch = createTexture(p_texture->format(), scratchwidth, scratchheight, scratchlayers);
+    if (!scratch) {
+        p_packer = packer;
+        return GS_FALSE;
+    }
+
+    for (size_t n = 0; n < movedindices.size(); ++n) {
+        const Entry &from = moved[movedindices[n]].second;
+        const Entry &temp = scratchareas[n];
+        if (!p_owner->CopyImage(
+            p_texture, 0, from.x, from.y, from.layer,
+            scratch, 0, temp.x, temp.y, temp.layer,
+            from.width, from.height, 1
+        )) {
+            // atlas texture isn't changed yet
+            scratch->Release();
+            p_packer = packer;
+            return GS_FALSE;
+        }
+    }
+
+    for (size_t n = 0; n < movedindices.size(); ++n) {
+        const Entry &temp = scratchareas[n];
+        const Entry &to = areas[movedindices[n]];
+        if (!p_owner->CopyImage(
+            scratch, 0, temp.x, temp.y, temp.layer,
+            p_texture, 0, to.x, to.y, to.layer,
+            temp.width, temp.height, 1
+        )) {
+            // images are put back to their old places, so entries stay valid
+            for (size_t m = 0; m < movedindices.size(); ++m) {
+                const Entry &back = scratchareas[m];
+                const Entry &from = moved[movedindices[m]].second;
+                p_owner->CopyImage(
+                    scratch, 0, back.x, back.y, back.layer,
+                    p_texture, 0, from.x, from.y, from.layer,
+                    back.width, back.height, 1
+                );
+            }
+
+            scratch->Release();
+            p_packer = packer;
+            return p_owner->error(GSE_INVALIDOPERATION);
+        }
+    }
+
+    for (size_t n = 0; n < moved.size(); ++n) {
+        p_entries[moved[n].first] = areas[n];
+    }
+
+    scratch->Release();
+
+    p_unused = 0;
+
+    return p_owner->error(GS_OK);
+}
+
+GSbool IxGSAtlasImpl::GetTexture(IxGSTexture *texture)
+{
+    if (texture == nullptr) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    p_texture->AddRef();
+    *texture = p_texture;
+
+    return p_owner->error(GS_OK);
+}
+
+IxGSTextureImpl* IxGSAtlasImpl::createTexture(GSenum format, GSuint width, GSuint height, GSuint layers) const
+{
+    GStexturedescription desc = GStexturedescription::construct();
+    desc.type = GS_TEXTYPE_2D;
+    desc.format = format;
+    desc.width = width;
+    desc.height = height;
+    desc.layers = layers;
+    desc.maxlevel = 0;
+
+    IxGSTextureImpl *texture = IxGSTextureImpl::create(p_owner, GS_OBJECTTYPE_TEXTURE);
+    if (!texture->allocate(desc)) {
+        texture->Release();
+        return nullptr;
+    }
+
+    return texture;
+}
+
+void IxGSAtlasImpl::fillEntry(GSuint id, const Entry &area, GSatlasentry &entry) const
+{
+    entry.id = id;
+    entry.layer = area.layer;
+    entry.rect.left = GSint(area.x + p_padding);
+    entry.rect.top = GSint(area.y + p_padding);
+    entry.rect.width = GSint(area.width - p_padding * 2);
+    entry.rect.height = GSint(area.height - p_padding * 2);
+
+    GSfloat sx = 1.0f / p_texture->width();
+    GSfloat sy = 1.0f / p_texture->height();
+    entry.uv[0] = entry.rect.left * sx;
+    entry.uv[1] = entry.rect.top * sy;
+    entry.uv[2] = (entry.rect.left + entry.rect.width) * sx;
+    entry.uv[3] = (entry.rect.top + entry.rect.height) * sy;
+}
+
+
+
+IxGSImpl::~IxGSImpl()
+{
+    // TODO: make internal implementation of these End/Destroy funcs
+    //       without some unnecessary checks?
+
+    if (p_systemstate == CAPTURE) {
+        EndCapture(nullptr);
+    }
+    if (p_systemstate == RENDERER_READY) {
+        DestroyRenderer(true);
+    }
+}
+
+GSbool IxGSImpl::CreateRenderer(const GSrendererdescription &desc)
+{
+    if (!ValidateState(SYSTEM_READY, true, false, false)) {
+        return GS_FALSE;
+    }
+
+    CreateRendererImpl(desc);
+
+    if (p_error != GS_OK) {
+        return GS_FALSE;
+    }
+
+    p_systemstate = RENDERER_READY;
+
+    return GS_TRUE;
+}
+
+GSbool IxGSImpl::DestroyRenderer(GSbool restorevideomode)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    ::Release(p_state);
+    ::Release(p_input);
+    for (size_t n = 0; n < GS_MAX_PARAMETER_SETS; ++n) {
+        ::Release(p_parameters[n]);
+    }
+    ::Release(p_rendertarget);
+    ::Release(p_query);
+    ::Release(p_conditionquery);
+
+    // streamed and paged textures are released with texture list
+    p_texturestreamer.clear();
+
+    p_texturepager.clear();
+
+    ReleaseObjectList(p_statelist, "State");
+    ReleaseObjectList(p_computestatelist, "ComputeState");
+    ReleaseObjectList(p_inputlist, "Input");
+    ReleaseObjectList(p_parameterslist, "Parameters");
+    ReleaseObjectList(p_geometrylist, "Geomtery");
+    ReleaseObjectList(p_framebufferlist, "Framebuffer");
+    ReleaseObjectList(p_geometrybufferlist, "GeomteryBuffer");
+    ReleaseObjectList(p_databufferlist, "DataBuffer");
+    ReleaseObjectList(p_atlaslist, "Atlas");
+    ReleaseObjectList(p_texturelist, "Texture");
+    ReleaseObjectList(p_querylist, "Query");
+
+    DestroyRendererImpl();
+
+    p_systemstate = SYSTEM_READY;
+
+    return GS_TRUE;
+}
+
+#define GS_CREATE_OBJECT(typeconst, impltype, desctype)\
+        case typeconst: {\
+            impltype *object = impltype::create(this, typeconst);\
+            if (object->allocate(*reinterpret_cast<const desctype*>(desc))) {\
+                *result = object;\
+                return error(GS_OK);\
+            } else {\
+                object->Release();\
+                return GS_FALSE;\
+            }\
+        }
+
+GSbool IxGSImpl::CreateObject(GSenum type, const void *desc, void **result)
+{
+    // TODO: make refcounting and adding to object list only after successful creation
+    switch (type) {
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_GEOMETRY, IxGSGeometryImpl, GSgeometrydescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_GEOMETRYBUFFER, IxGSGeometryBufferImpl, GSgeometrybufferdescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_DATABUFFER, IxGSDataBufferImpl, GSdatabufferdescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_TEXTURE, IxGSTextureImpl, GStexturedescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_FRAMEBUFFER, IxGSFrameBufferImpl, GSframebufferdescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_STATE, IxGSStateImpl, GSstatedescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_INPUT, IxGSInputImpl, GSinputdescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_PARAMETERS, IxGSParametersImpl, GSparametersdescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_QUERY, IxGSQueryImpl, GSquerydescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_COMPUTESTATE, IxGSComputeStateImpl, GScomputestatedescription)
+        GS_CREATE_OBJECT(GS_OBJECTTYPE_ATLAS, IxGSAtlasImpl, GSatlasdescription)
+    }
+
+    return error(GSE_INVALIDENUM);
+}
+
+#undef GS_CREATE_OBJECT
+
+GSbool IxGSImpl::CreateSamplers(const GSsamplerdescription *samplers, GSuint count)
+{
+    GSuint references = 0;
+    for (auto &s : p_samplerlist) {
+        references += s.refcount;
+    }
+
+    if (references) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    if (count && !samplers) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    for (GSuint n = 0; n < count; ++n) {
+        if (!ValidSampler(samplers[n])) {
+            return error(GSE_INVALIDVALUE);
+        }
+    }
+
+    CreateSamplersImpl(samplers, count);
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::AddSamplers(const GSsamplerdescription *samplers, GSuint count, GSenum *indices)
+{
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    if (!samplers || !indices || count == 0) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    for (GSuint n = 0; n < count; ++n) {
+        if (!ValidSampler(samplers[n])) {
+            return error(GSE_INVALIDVALUE);
+        }
+    }
+
+    AddSamplersImpl(samplers, count, indices);
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::GetRenderTargetSize(GSsize &size)
+{
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    GetRenderTargetSizeImpl(size);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::Clear(GSbool color, GSbool depth, GSbool stencil, const GScolor &colorvalue, float depthvalue, GSdword stencilvalue)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    ClearImpl(color, depth, stencil, colorvalue, depthvalue, stencilvalue);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::Display()
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    DisplayImpl();
+
+    return p_error == GS_OK;
 }
 
 GSbool IxGSImpl::SetRenderTarget(IxGSFrameBuffer rendertarget)
@@ -1015,353 +1743,1214 @@ GSbool IxGSImpl::SetRenderTarget(IxGSFrameBuffer rendertarget)
         return GS_FALSE;
     }
 
-    if (p_rendertarget) {
-        p_rendertarget->unbind();
-        p_rendertarget->Release();
+    if (p_rendertarget) {
+        p_rendertarget->unbind();
+        p_rendertarget->Release();
+    }
+
+    p_rendertarget = static_cast<xGSFrameBufferImpl*>(rendertarget);
+
+    if (p_rendertarget) {
+        p_rendertarget->AddRef();
+        p_rendertarget->bind();
+    }
+
+    SetRenderTargetImpl();
+
+    // reset current state, after RT change any state should be rebound
+    SetStateImpl(static_cast<xGSStateImpl*>(nullptr));
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::SetState(IxGSState state)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!state) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    xGSStateImpl *stateimpl = static_cast<xGSStateImpl*>(state);
+
+    if (!stateimpl->validate(p_colorformats, p_depthstencilformat)) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    SetStateImpl(stateimpl);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::SetInput(IxGSInput input)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    xGSInputImpl *inputimpl = static_cast<xGSInputImpl*>(input);
+    if (inputimpl == nullptr) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    if (p_state == nullptr || inputimpl->state() != p_state) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    AttachObject(p_caps, p_input, inputimpl);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::SetParameters(IxGSParameters parameters)
+{
+    // TODO: ability to change parameters while being in immediate mode
+    //      actually parameters change can be recorded into immediate sequence
+    //      and executed later, when immediate buffer will be flushed
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!parameters) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    xGSParametersImpl *parametersimpl = static_cast<xGSParametersImpl*>(parameters);
+
+    if (p_state == nullptr || parametersimpl->state() != p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+    AttachObject(p_caps, p_parameters[parametersimpl->setindex()], parametersimpl);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::SetParametersOffsets(IxGSParameters parameters, const GSuint *blockindices)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!parameters) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    if (!blockindices) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    xGSParametersImpl *parametersimpl = static_cast<xGSParametersImpl*>(parameters);
+
+    if (p_state == nullptr || parametersimpl->state() != p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+    // parameters object is attached only once, next calls with same
+    // parameters object only re-point uniform block ranges
+    if (p_parameters[parametersimpl->setindex()] != parametersimpl) {
+        AttachObject(p_caps, p_parameters[parametersimpl->setindex()], parametersimpl);
+    }
+
+    return error(parametersimpl->applyblockindices(blockindices));
+}
+
+GSbool IxGSImpl::SetViewport(const GSrect &viewport)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    SetViewportImpl(viewport);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::SetStencilReference(GSuint ref)
+{
+    // TODO: same as SetParameters behaviour
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+    SetStencilReferenceImpl(ref);
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::SetBlendColor(const GScolor &color)
+{
+    // TODO: same as SetParameters behaviour
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+    SetBlendColorImpl(color);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::SetUniformValue(GSenum set, GSenum slot, GSenum type, const void *value)
+{
+    // TODO: same as SetParameters behaviour
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+    GSuint setindex = set - GSPS_0;
+    if (setindex >= p_state->parameterSetCount()) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    const GSParameterSet &paramset = p_state->parameterSet(setindex);
+
+    GSuint slotindex = slot - GSPS_0 + paramset.first;
+    if (slotindex >= paramset.onepastlast) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    const xGSStateImpl::ParameterSlot &paramslot = p_state->parameterSlot(slotindex);
+
+    if (paramslot.type != GSPD_CONSTANT) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    // TODO: check type or remove type parameter?
+    if (paramslot.location != GS_DEFAULT) {
+        switch (type) {
+            case GSU_SCALAR:
+            case GSU_VEC2:
+            case GSU_VEC3:
+            case GSU_VEC4:
+            case GSU_MAT2:
+            case GSU_MAT3:
+            case GSU_MAT4:
+            case GSU_HANDLE:
+                SetUniformValueImpl(type, paramslot.location, value);
+                break;
+
+            default:
+                return error(GSE_INVALIDENUM);
+        }
+    }
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::AllocateTransient(GSuint size, GStransientallocation *allocation)
+{
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    if (!allocation) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    if (size == 0) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    AllocateTransientImpl(size, *allocation);
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::SetTransientBlock(GSenum set, GSenum slot, const GStransientallocation &allocation)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+    GSuint setindex = set - GSPS_0;
+    if (setindex >= p_state->parameterSetCount()) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    const GSParameterSet &paramset = p_state->parameterSet(setindex);
+
+    GSuint slotindex = slot - GSPS_0 + paramset.first;
+    if (slotindex >= paramset.onepastlast) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    const xGSStateImpl::ParameterSlot &paramslot = p_state->parameterSlot(slotindex);
+
+    if (paramslot.type != GSPD_BLOCK) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    // offset and size should stay inside allocated part of current frame region
+    if (!TransientAllocationValid(allocation)) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    if (paramslot.location != GS_DEFAULT) {
+        SetTransientBlockImpl(paramslot.location, allocation);
+    }
+
+    return error(GS_OK);
+}
+
+// NOTE:
+//      following Draw* functions will compile only in "unity build" mode
+//      which is the only build mode now
+//      in order this to work in ordinary build (as a separate translation unit)
+//      *Drawer structs should be made public in each platform implementation
+
+GSbool IxGSImpl::DrawGeometry(IxGSGeometry geometry)
+{
+    SimpleDrawer drawer;
+    return Draw(geometry, drawer);
+}
+
+GSbool IxGSImpl::DrawGeometryInstanced(IxGSGeometry geometry, GSuint count)
+{
+    InstancedDrawer drawer(count);
+    return Draw(geometry, drawer);
+}
+
+GSbool IxGSImpl::DrawGeometries(IxGSGeometry *geometries, GSuint count)
+{
+    SimpleMultiDrawer drawer;
+    return MultiDraw(geometries, count, drawer);
+}
+
+GSbool IxGSImpl::DrawGeometriesInstanced(IxGSGeometry *geometries, GSuint count, GSuint instancecount)
+{
+    InstancedMultiDrawer drawer(instancecount);
+    return MultiDraw(geometries, count, drawer);
+}
+
+GSbool IxGSImpl::BeginCapture(GSenum mode, IxGSGeometryBuffer buffer)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!buffer) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(buffer);
+
+    p_capturebuffer = bufferimpl;
+    p_capturebuffer->AddRef();
+
+    BeginCaptureImpl(mode);
+
+    p_systemstate = CAPTURE;
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::EndCapture(GSuint *elementcount)
+{
+    if (!ValidateState(CAPTURE, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    EndCaptureImpl(elementcount);
+
+    p_capturebuffer->Release();
+    p_capturebuffer = nullptr;
+    p_systemstate = RENDERER_READY;
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::BeginQuery(IxGSQuery query)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!query) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    IxGSQueryImpl *queryimpl = static_cast<IxGSQueryImpl*>(query);
+
+    // query can't be restarted while it's used for conditional rendering
+    if (p_query || queryimpl == p_conditionquery) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    BeginQueryImpl(queryimpl);
+
+    p_query = queryimpl;
+    p_query->AddRef();
+    queryimpl->begin();
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::EndQuery(IxGSQuery query)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!query) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    IxGSQueryImpl *queryimpl = static_cast<IxGSQueryImpl*>(query);
+    if (queryimpl != p_query) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    EndQueryImpl(queryimpl);
+
+    queryimpl->end();
+    p_query->Release();
+    p_query = nullptr;
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::BeginConditionalRender(IxGSQuery query, GSenum mode)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!query) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    if (mode != GS_CONDITION_WAIT && mode != GS_CONDITION_NOWAIT) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    IxGSQueryImpl *queryimpl = static_cast<IxGSQueryImpl*>(query);
+    if (p_conditionquery || !queryimpl->issued() || queryimpl->active()) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    BeginConditionalRenderImpl(queryimpl, mode);
+
+    p_conditionquery = queryimpl;
+    p_conditionquery->AddRef();
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::EndConditionalRender()
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!p_conditionquery) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    EndConditionalRenderImpl();
+
+    p_conditionquery->Release();
+    p_conditionquery = nullptr;
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::BeginImmediateDrawing(IxGSGeometryBuffer buffer, GSuint flags)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!buffer) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(buffer);
+    if (bufferimpl->type() != GS_GBTYPE_IMMEDIATE) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+
+    // TODO: do i need parrallel buffer fill only and then rendering from filled buffer?
+    //          if so, special flag should indicate filling only behaviour and
+    //          in that case current input check isn't needed
+
+    if (!p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
+
+#ifdef _DEBUG
+    size_t primaryslot = p_state->inputPrimarySlot();
+    xGSGeometryBufferImpl *boundbuffer =
+        primaryslot == GS_UNDEFINED ? nullptr : p_state->input(primaryslot).buffer;
+    if (p_input && boundbuffer == nullptr)  {
+        boundbuffer = p_input->primaryBuffer();
+    }
+    if (bufferimpl != boundbuffer) {
+        return error(GSE_INVALIDOBJECT);
+    }
+#endif
+
+    p_immediatebuffer = bufferimpl;
+    p_immediatebuffer->AddRef();
+
+    bufferimpl->BeginImmediateDrawing();
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::ImmediatePrimitive(GSenum type, GSuint vertexcount, GSuint indexcount, GSuint flags, GSimmediateprimitive *primitive)
+{
+    if (!ValidateState(RENDERER_READY, false, true, true)) {
+        return GS_FALSE;
+    }
+
+    bool flushnotneeded = p_immediatebuffer->EmitPrimitive(
+        type, vertexcount, indexcount,
+        flags, primitive
+    );
+
+    if (!flushnotneeded) {
+        // TODO: this cast is not very nice...
+        IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(p_immediatebuffer);
+
+        // requested primitive can not be added, try to flush buffer
+        bufferimpl->EndImmediateDrawing();
+        DrawImmediatePrimitives(p_immediatebuffer);
+        bufferimpl->BeginImmediateDrawing();
+
+        if (!p_immediatebuffer->EmitPrimitive(type, vertexcount, indexcount, flags, primitive)) {
+            // primitive can not be added at all
+            return error(GSE_INVALIDVALUE);
+        }
+    }
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::EndImmediateDrawing()
+{
+    if (!ValidateState(RENDERER_READY, false, true, true)) {
+        return GS_FALSE;
+    }
+
+    // TODO: this cast is not very nice...
+    IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(p_immediatebuffer);
+
+    bufferimpl->EndImmediateDrawing();
+    DrawImmediatePrimitives(p_immediatebuffer);
+
+    p_immediatebuffer->Release();
+    p_immediatebuffer = nullptr;
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::BuildMIPs(IxGSTexture texture)
+{
+    if (!ValidateState(RENDERER_READY, true, false, false)) {
+        return GS_FALSE;
+    }
+
+    xGSTextureImpl *tex = static_cast<xGSTextureImpl*>(texture);
+
+    BuildMIPsImpl(tex);
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::BuildMIPsFiltered(IxGSTexture texture, const GSmipgenerationdescription &desc)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!texture) {
+        return error(GSE_INVALIDOBJECT);
     }
 
-    p_rendertarget = static_cast<xGSFrameBufferImpl*>(rendertarget);
+    if (desc.filter != GS_MIPFILTER_BOX && desc.filter != GS_MIPFILTER_KAISER && desc.filter != GS_MIPFILTER_ALPHACOVERAGE) {
+        return error(GSE_INVALIDENUM);
+    }
 
-    if (p_rendertarget) {
-        p_rendertarget->AddRef();
-        p_rendertarget->bind();
+    xGSTextureImpl *tex = static_cast<xGSTextureImpl*>(texture);
+
+    if ((tex->type() != GS_TEXTYPE_2D && tex->type() != GS_TEXTYPE_CUBEMAP) ||
+        tex->samples() != GS_MULTISAMPLE_NONE || texture_block_size(tex->format()))
+    {
+        return error(GSE_INVALIDOPERATION);
     }
 
-    SetRenderTargetImpl();
+    if (desc.firstlevel == 0 || desc.firstlevel > tex->maxLevel()) {
+        return error(GSE_INVALIDVALUE);
+    }
 
-    // reset current state, after RT change any state should be rebound
-    SetStateImpl(static_cast<xGSStateImpl*>(nullptr));
+    GSmipgenerationdescription range = desc;
+
+    GSuint maxcount = tex->maxLevel() - desc.firstlevel + 1;
+    if (range.levelcount == 0) {
+        range.levelcount = maxcount;
+    } else if (range.levelcount > maxcount) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    GSint sourcewidth = GSint(umax(tex->width() >> (desc.firstlevel - 1), 1u));
+    GSint sourceheight = GSint(umax(tex->height() >> (desc.firstlevel - 1), 1u));
+
+    if (range.rect.width == 0 || range.rect.height == 0) {
+        range.rect.left = 0;
+        range.rect.top = 0;
+        range.rect.width = sourcewidth;
+        range.rect.height = sourceheight;
+    } else if (
+        range.rect.left < 0 || range.rect.top < 0 || range.rect.width < 0 || range.rect.height < 0 ||
+        range.rect.left + range.rect.width > sourcewidth || range.rect.top + range.rect.height > sourceheight)
+    {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    BuildMIPsFilteredImpl(tex, range);
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::OptimizeMesh(const GSmeshdescription &mesh, GSuint flags)
+{
+    if (mesh.indexformat != GS_INDEX_16 && mesh.indexformat != GS_INDEX_32) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    if (!mesh.indices || mesh.indexcount == 0 || mesh.vertexcount == 0) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    bool needvertices = (flags & (GS_MESH_OVERDRAW | GS_MESH_VERTEXFETCH)) != 0;
+    if (needvertices && (!mesh.vertices || mesh.vertexsize == 0)) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    if ((flags & GS_MESH_OVERDRAW) && mesh.positionoffset + sizeof(GSfloat) * 3 > mesh.vertexsize) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    GSmeshindices indices = {
+        mesh.indices, mesh.indexformat, mesh.indexcount, mesh.vertexcount,
+        mesh.restart != GS_FALSE, mesh.restartindex
+    };
+
+    // NOTE: index data is validated by every optimization, so invalid data
+    //       is never partially modified
+    if ((flags & GS_MESH_VERTEXCACHE) && !mesh_optimize_vertexcache(indices)) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    if (flags & GS_MESH_OVERDRAW) {
+        const char *positions = reinterpret_cast<const char*>(mesh.vertices) + mesh.positionoffset;
+        if (!mesh_optimize_overdraw(indices, positions, mesh.vertexsize, 1.05f)) {
+            return error(GSE_INVALIDVALUE);
+        }
+    }
+
+    if ((flags & GS_MESH_VERTEXFETCH) && !mesh_optimize_vertexfetch(indices, mesh.vertices, mesh.vertexsize)) {
+        return error(GSE_INVALIDVALUE);
+    }
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetState(IxGSState state)
+GSbool IxGSImpl::BuildMeshlets(const GSmeshdescription &mesh, GSuint maxvertices, GSuint maxtriangles, GSmeshletdata &data)
 {
-    if (!ValidateState(RENDERER_READY, true, true, false)) {
-        return GS_FALSE;
+    if (mesh.indexformat != GS_INDEX_16 && mesh.indexformat != GS_INDEX_32) {
+        return error(GSE_INVALIDENUM);
     }
 
-    if (!state) {
-        return error(GSE_INVALIDOBJECT);
+    if (!mesh.indices || !mesh.vertices || mesh.indexcount == 0 || mesh.vertexcount == 0) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    xGSStateImpl *stateimpl = static_cast<xGSStateImpl*>(state);
+    if (mesh.positionoffset + sizeof(GSfloat) * 3 > mesh.vertexsize) {
+        return error(GSE_INVALIDVALUE);
+    }
 
-    if (!stateimpl->validate(p_colorformats, p_depthstencilformat)) {
-        return error(GSE_INVALIDOBJECT);
+    GSmeshindices indices = {
+        mesh.indices, mesh.indexformat, mesh.indexcount, mesh.vertexcount,
+        mesh.restart != GS_FALSE, mesh.restartindex
+    };
+
+    std::vector<GSmeshlet> meshlets;
+    std::vector<GSuint> vertices;
+    std::vector<GSuint> triangles;
+
+    const char *positions = reinterpret_cast<const char*>(mesh.vertices) + mesh.positionoffset;
+    if (!mesh_build_meshlets(indices, positions, mesh.vertexsize, maxvertices, maxtriangles, meshlets, vertices, triangles)) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    SetStateImpl(stateimpl);
+    if ((data.meshlets && data.meshletcount < meshlets.size()) ||
+        (data.vertices && data.vertexcount < vertices.size()) ||
+        (data.triangles && data.trianglecount < triangles.size()))
+    {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    if (data.meshlets) {
+        std::copy(meshlets.begin(), meshlets.end(), data.meshlets);
+    }
+    if (data.vertices) {
+        std::copy(vertices.begin(), vertices.end(), data.vertices);
+    }
+    if (data.triangles) {
+        std::copy(triangles.begin(), triangles.end(), data.triangles);
+    }
+
+    data.meshletcount = GSuint(meshlets.size());
+    data.vertexcount = GSuint(vertices.size());
+    data.trianglecount = GSuint(triangles.size());
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetInput(IxGSInput input)
+GSbool IxGSImpl::CullGeometries(const GScullingdescription &desc, IxGSGeometry *visible, GSuint &visiblecount)
 {
-    if (!ValidateState(RENDERER_READY, false, true, false)) {
-        return GS_FALSE;
+    visiblecount = 0;
+
+    if (desc.boundstype != GS_BOUNDS_SPHERE && desc.boundstype != GS_BOUNDS_BOX) {
+        return error(GSE_INVALIDENUM);
     }
 
-    xGSInputImpl *inputimpl = static_cast<xGSInputImpl*>(input);
-    if (inputimpl == nullptr) {
-        return error(GSE_INVALIDOBJECT);
+    if (!desc.viewprojection || !desc.bounds || !desc.geometries || !visible) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    if (p_state == nullptr || inputimpl->state() != p_state) {
-        return error(GSE_INVALIDOPERATION);
+    // LOD index is stored in byte together with visibility
+    if (desc.lodcount == 0 || desc.lodcount > 255 || (desc.lodcount > 1 && !desc.lodthresholds)) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    AttachObject(p_caps, p_input, inputimpl);
+    std::vector<unsigned char> visibility(desc.count);
+    frustum_cull(
+        desc.viewprojection, desc.boundstype, desc.bounds, desc.count,
+        desc.lodcount, desc.lodthresholds, desc.lodscale,
+        desc.threads, p_workers, visibility.data()
+    );
+
+    for (GSuint n = 0; n < desc.count; ++n) {
+        if (visibility[n]) {
+            visible[visiblecount++] = desc.geometries[n * desc.lodcount + visibility[n] - 1];
+        }
+    }
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetParameters(IxGSParameters parameters)
+GSbool IxGSImpl::CompressImage(const GSimagecompressiondescription &desc)
 {
-    // TODO: ability to change parameters while being in immediate mode
-    //      actually parameters change can be recorded into immediate sequence
-    //      and executed later, when immediate buffer will be flushed
-    if (!ValidateState(RENDERER_READY, false, true, false)) {
-        return GS_FALSE;
+    if (texture_block_size(desc.format) == 0) {
+        return error(GSE_INVALIDENUM);
     }
 
-    if (!parameters) {
-        return error(GSE_INVALIDOBJECT);
+    if (!desc.source || !desc.destination || desc.width == 0 || desc.height == 0) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    xGSParametersImpl *parametersimpl = static_cast<xGSParametersImpl*>(parameters);
+    GSuint sourcepitch = desc.sourcepitch ? desc.sourcepitch : desc.width * 4;
+    GSuint blockpitch = texture_image_pitch(desc.format, 0, desc.width);
+    GSuint destinationpitch = desc.destinationpitch ? desc.destinationpitch : blockpitch;
 
-    if (p_state == nullptr || parametersimpl->state() != p_state) {
-        return error(GSE_INVALIDSTATE);
+    if (sourcepitch < desc.width * 4 || destinationpitch < blockpitch) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    AttachObject(p_caps, p_parameters[parametersimpl->setindex()], parametersimpl);
+    image_compress(
+        desc.format, desc.width, desc.height,
+        desc.source, sourcepitch,
+        desc.destination, destinationpitch,
+        desc.threads, p_workers
+    );
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetViewport(const GSrect &viewport)
+GSbool IxGSImpl::UploadImage(IxGSTexture texture, const GSimageuploaddescription &desc)
 {
-    if (!ValidateState(RENDERER_READY, true, true, false)) {
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
         return GS_FALSE;
     }
 
-    SetViewportImpl(viewport);
+    if (!texture) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    if (desc.filter != GS_MIPFILTER_BOX && desc.filter != GS_MIPFILTER_KAISER) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    GSuint texelsize = ImageMipChain::texelSize(desc.format);
+    if (texelsize == 0) {
+        return error(GSE_INVALIDENUM);
+    }
+
+    if (!desc.source || (desc.flags & ~GS_IMAGEFLAG_RGBORDER)) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    IxGSTextureImpl *tex = static_cast<IxGSTextureImpl*>(texture);
+
+    if ((tex->type() != GS_TEXTYPE_2D && tex->type() != GS_TEXTYPE_CUBEMAP) ||
+        tex->samples() != GS_MULTISAMPLE_NONE || ImageMipChain::texelSize(tex->format()) == 0)
+    {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    if (desc.level > tex->maxLevel()) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    GSuint maxcount = tex->maxLevel() - desc.level + 1;
+    GSuint levelcount = desc.levelcount ? desc.levelcount : maxcount;
+    if (levelcount > maxcount) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    GSuint width = umax(tex->width() >> desc.level, 1u);
+    GSuint height = umax(tex->height() >> desc.level, 1u);
+
+    GSuint pitch = desc.pitch ? desc.pitch : width * texelsize;
+    if (pitch < width * texelsize) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    ImageMipChain chain(desc.filter, desc.threads, p_workers);
+    chain.load(desc.format, (desc.flags & GS_IMAGEFLAG_RGBORDER) != 0, width, height, desc.source, pitch);
+
+    for (GSuint level = desc.level; level < desc.level + levelcount; ++level) {
+        if (level != desc.level) {
+            chain.next();
+        }
+
+        GStexturelockdata layout;
+        GSptr memory = tex->Lock(desc.locktype, GS_WRITE, GSint(level), GSint(desc.layer), &layout);
+        if (!memory) {
+            return GS_FALSE;
+        }
+
+        chain.store(tex->format(), memory, layout.pitch);
+
+        if (!tex->Unlock()) {
+            return GS_FALSE;
+        }
+    }
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetStencilReference(GSuint ref)
+GSbool IxGSImpl::LoadTexture(const char *filename, IxGSTexture *texture)
 {
-    // TODO: same as SetParameters behaviour
-    if (!ValidateState(RENDERER_READY, false, true, false)) {
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
         return GS_FALSE;
     }
 
-    if (!p_state) {
-        return error(GSE_INVALIDSTATE);
+    if (!filename || !texture) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    SetStencilReferenceImpl(ref);
+    FileMapping file;
+    if (!file.open(filename)) {
+        return error(GSE_INVALIDVALUE);
+    }
 
-    return p_error == GS_OK;
+    TextureLimits limits;
+    GetTextureLimits(limits);
+
+    TextureContainer container;
+    if (!texture_container_parse(file.data(), file.size(), limits, container)) {
+        return error(GSE_UNSUPPORTED);
+    }
+
+    IxGSTextureImpl *object = IxGSTextureImpl::create(this, GS_OBJECTTYPE_TEXTURE);
+    if (!object->allocate(container.description)) {
+        object->Release();
+        return GS_FALSE;
+    }
+
+    for (GSuint layer = 0; layer < container.layers; ++layer) {
+        for (GSuint face = 0; face < container.faces; ++face) {
+            GSenum locktype = texture_container_locktype(container, face);
+
+            for (GSuint level = 0; level < container.levels; ++level) {
+                GSuint size;
+                const unsigned char *image = texture_container_image(container, level, layer, face, size);
+
+                GStexturelockdata lockdata = { size, 0, 0 };
+                GSptr memory = object->Lock(locktype, GS_WRITE, level, layer, &lockdata);
+                if (!memory || lockdata.size != size) {
+                    object->Release();
+                    return error(p_error == GS_OK ? GSE_OUTOFRESOURCES : p_error);
+                }
+
+                texture_image_copy(memory, image, size, container.swizzle);
+
+                object->Unlock();
+            }
+        }
+    }
+
+    *texture = object;
+
+    return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetBlendColor(const GScolor &color)
+GSbool IxGSImpl::SetTextureStreaming(const GStexturestreamingdescription &desc)
 {
-    // TODO: same as SetParameters behaviour
-    if (!ValidateState(RENDERER_READY, false, true, false)) {
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
         return GS_FALSE;
     }
 
-    if (!p_state) {
-        return error(GSE_INVALIDSTATE);
+    if (desc.budget == 0 || desc.uploadlimit == 0) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    SetBlendColorImpl(color);
+    p_texturestreamer.configure(desc);
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::SetUniformValue(GSenum set, GSenum slot, GSenum type, const void *value)
+GSbool IxGSImpl::StreamTexture(const char *filename, IxGSTexture *texture)
 {
-    // TODO: same as SetParameters behaviour
-    if (!ValidateState(RENDERER_READY, false, true, false)) {
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
         return GS_FALSE;
     }
 
-    if (!p_state) {
-        return error(GSE_INVALIDSTATE);
+    if (!filename || !texture) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    GSuint setindex = set - GSPS_0;
-    if (setindex >= p_state->parameterSetCount()) {
-        return error(GSE_INVALIDENUM);
+    std::unique_ptr<FileMapping> file(new FileMapping());
+    if (!file->open(filename)) {
+        return error(GSE_INVALIDVALUE);
     }
 
-    const GSParameterSet &paramset = p_state->parameterSet(setindex);
+    TextureLimits limits;
+    GetTextureLimits(limits);
 
-    GSuint slotindex = slot - GSPS_0 + paramset.first;
-    if (slotindex >= paramset.onepastlast) {
-        return error(GSE_INVALIDENUM);
+    TextureContainer container;
+    if (!texture_container_parse(file->data(), file->size(), limits, container)) {
+        return error(GSE_UNSUPPORTED);
     }
 
-    const xGSStateImpl::ParameterSlot &paramslot = p_state->parameterSlot(slotindex);
+    // sparse storage is optional, without it all levels take memory
+    GStexturedescription desc = container.description;
+    desc.flags |= GS_TEXFLAG_SPARSE;
+    if (!SparseTextureSupported(desc)) {
+        desc.flags &= ~GS_TEXFLAG_SPARSE;
+    }
 
-    if (paramslot.type != GSPD_CONSTANT) {
-        return error(GSE_INVALIDOPERATION);
+    IxGSTextureImpl *object = IxGSTextureImpl::create(this, GS_OBJECTTYPE_TEXTURE);
+    if (!object->allocate(desc)) {
+        object->Release();
+        return GS_FALSE;
     }
 
-    // TODO: check type or remove type parameter?
-    if (paramslot.location != GS_DEFAULT) {
-        switch (type) {
-            case GSU_SCALAR:
-            case GSU_VEC2:
-            case GSU_VEC3:
-            case GSU_VEC4:
-            case GSU_MAT2:
-            case GSU_MAT3:
-            case GSU_MAT4:
-                SetUniformValueImpl(type, paramslot.location, value);
-                break;
+    GSerror result = p_texturestreamer.add(object, file, container);
+    if (result != GS_OK) {
+        object->Release();
+        return error(result);
+    }
 
-            default:
-                return error(GSE_INVALIDENUM);
+    *texture = object;
+
+    return error(GS_OK);
+}
+
+GSbool IxGSImpl::RequestTextureLevels(const GStexturestreamingrequest *requests, GSuint count)
+{
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    if (!requests && count) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    for (GSuint n = 0; n < count; ++n) {
+        IxGSTextureImpl *texture = static_cast<IxGSTextureImpl*>(requests[n].texture);
+        if (!texture || !p_texturestreamer.request(texture, requests[n].level, requests[n].priority)) {
+            return error(GSE_INVALIDOBJECT);
         }
     }
 
     return error(GS_OK);
 }
 
-// NOTE:
-//      following Draw* functions will compile only in "unity build" mode
-//      which is the only build mode now
-//      in order this to work in ordinary build (as a separate translation unit)
-//      *Drawer structs should be made public in each platform implementation
-
-GSbool IxGSImpl::DrawGeometry(IxGSGeometry geometry)
+GSbool IxGSImpl::UpdateTextureStreaming()
 {
-    SimpleDrawer drawer;
-    return Draw(geometry, drawer);
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    return error(p_texturestreamer.update());
 }
 
-GSbool IxGSImpl::DrawGeometryInstanced(IxGSGeometry geometry, GSuint count)
+GSbool IxGSImpl::SetTexturePaging(const GStexturepagingdescription &desc)
 {
-    InstancedDrawer drawer(count);
-    return Draw(geometry, drawer);
-}
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    if (desc.budget == 0) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    p_texturepager.configure(desc);
 
-GSbool IxGSImpl::DrawGeometries(IxGSGeometry *geometries, GSuint count)
-{
-    SimpleMultiDrawer drawer;
-    return MultiDraw(geometries, count, drawer);
+    return error(GS_OK);
 }
 
-GSbool IxGSImpl::DrawGeometriesInstanced(IxGSGeometry *geometries, GSuint count, GSuint instancecount)
+GSbool IxGSImpl::RequestTexturePages(IxGSTexture texture, const GSuint *pages, GSuint count)
 {
-    InstancedMultiDrawer drawer(instancecount);
-    return MultiDraw(geometries, count, drawer);
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
+        return GS_FALSE;
+    }
+
+    if (!texture) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    if (!pages && count) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    IxGSTextureImpl *tex = static_cast<IxGSTextureImpl*>(texture);
+    if (p_texturestreamer.streamed(tex)) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    return error(p_texturepager.request(tex, pages, count));
 }
 
-GSbool IxGSImpl::BeginCapture(GSenum mode, IxGSGeometryBuffer buffer)
+GSbool IxGSImpl::RequestTexturePagesFeedback(IxGSTexture texture, IxGSDataBuffer feedback, GSuint count)
 {
-    if (!ValidateState(RENDERER_READY, true, true, false)) {
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
         return GS_FALSE;
     }
 
-    if (!buffer) {
+    if (!texture || !feedback) {
         return error(GSE_INVALIDOBJECT);
     }
 
-    IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(buffer);
+    IxGSTextureImpl *tex = static_cast<IxGSTextureImpl*>(texture);
+    if (p_texturestreamer.streamed(tex)) {
+        return error(GSE_INVALIDOPERATION);
+    }
 
-    p_capturebuffer = bufferimpl;
-    p_capturebuffer->AddRef();
+    IxGSDataBufferImpl *buffer = static_cast<IxGSDataBufferImpl*>(feedback);
+    if (count > buffer->size() / sizeof(GSuint)) {
+        return error(GSE_INVALIDVALUE);
+    }
 
-    BeginCaptureImpl(mode);
+    const GSuint *pages = reinterpret_cast<const GSuint*>(buffer->Lock(GS_READ, nullptr));
+    if (!pages) {
+        return GS_FALSE;
+    }
 
-    p_systemstate = CAPTURE;
+    GSerror result = p_texturepager.request(tex, pages, count);
 
-    return error(GS_OK);
+    buffer->Unlock();
+
+    return error(result);
 }
 
-GSbool IxGSImpl::EndCapture(GSuint *elementcount)
+GSbool IxGSImpl::UpdateTexturePages(GStexturepage *committed, GSuint &count)
 {
-    if (!ValidateState(CAPTURE, true, true, false)) {
+    if (!ValidateState(RENDERER_READY, false, false, false)) {
         return GS_FALSE;
     }
 
-    EndCaptureImpl(elementcount);
+    if (!committed && count) {
+        return error(GSE_INVALIDVALUE);
+    }
 
-    p_capturebuffer->Release();
-    p_capturebuffer = nullptr;
-    p_systemstate = RENDERER_READY;
+    count = p_texturepager.update(committed, count);
 
     return error(GS_OK);
 }
 
-GSbool IxGSImpl::BeginImmediateDrawing(IxGSGeometryBuffer buffer, GSuint flags)
+GSbool IxGSImpl::GetTextureHandle(IxGSTexture texture, GSenum sampler, GSuint64 &handle)
 {
-    if (!ValidateState(RENDERER_READY, false, true, false)) {
+    if (!ValidateState(RENDERER_READY, true, false, false)) {
         return GS_FALSE;
     }
 
-    if (!buffer) {
+    if (!texture) {
         return error(GSE_INVALIDOBJECT);
     }
 
-    IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(buffer);
-    if (bufferimpl->type() != GS_GBTYPE_IMMEDIATE) {
-        return error(GSE_INVALIDOBJECT);
+    xGSTextureImpl *tex = static_cast<xGSTextureImpl*>(texture);
+
+    if (sampler != GS_DEFAULT) {
+        if (sampler < GSS_0 || GSuint(sampler - GSS_0) >= samplerCount() || tex->type() == GS_TEXTYPE_BUFFER) {
+            return error(GSE_INVALIDVALUE);
+        }
     }
 
+    // streaming changes base level of texture, which isn't allowed with handles
+    if (p_texturestreamer.streamed(tex)) {
+        return error(GSE_INVALIDOPERATION);
+    }
 
-    // TODO: do i need parrallel buffer fill only and then rendering from filled buffer?
-    //          if so, special flag should indicate filling only behaviour and
-    //          in that case current input check isn't needed
+    GetTextureHandleImpl(tex, sampler, handle);
 
-    if (!p_state) {
-        return error(GSE_INVALIDSTATE);
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::BuildDrawCommands(IxGSGeometry *geometries, GSuint count, IxGSDataBuffer commands)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
     }
 
-#ifdef _DEBUG
-    size_t primaryslot = p_state->inputPrimarySlot();
-    xGSGeometryBufferImpl *boundbuffer =
-        primaryslot == GS_UNDEFINED ? nullptr : p_state->input(primaryslot).buffer;
-    if (p_input && boundbuffer == nullptr)  {
-        boundbuffer = p_input->primaryBuffer();
+    if (!geometries || !commands) {
+        return error(GSE_INVALIDOBJECT);
     }
-    if (bufferimpl != boundbuffer) {
+
+    IxGSDataBufferImpl *commandsimpl = static_cast<IxGSDataBufferImpl*>(commands);
+    if (count == 0 || count > commandsimpl->size() / GS_DRAWCOMMAND_SIZE) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    IxGSGeometryImpl *first = static_cast<IxGSGeometryImpl*>(geometries[0]);
+    if (!first || !first->buffer() || first->indexFormat() == GS_INDEX_NONE) {
         return error(GSE_INVALIDOBJECT);
     }
-#endif
 
-    p_immediatebuffer = bufferimpl;
-    p_immediatebuffer->AddRef();
+    GSuint indexsize = index_buffer_size(first->storedIndexFormat());
 
-    bufferimpl->BeginImmediateDrawing();
+    // count, instance count, first index, base vertex, base instance
+    std::vector<GSuint> data(count * 5);
+    GSuint *command = data.data();
 
-    return error(GS_OK);
+    for (GSuint n = 0; n < count; ++n, command += 5) {
+        IxGSGeometryImpl *geometry = static_cast<IxGSGeometryImpl*>(geometries[n]);
+
+        // all commands are drawn with single call, so everything but ranges should match
+        if (!geometry ||
+            geometry->buffer() != first->buffer() ||
+            geometry->type() != first->type() ||
+            geometry->storedIndexFormat() != first->storedIndexFormat())
+        {
+            return error(GSE_INVALIDOBJECT);
+        }
+
+        command[0] = geometry->indexCount();
+        command[1] = 1;
+        command[2] = GSuint(reinterpret_cast<size_t>(geometry->indexPtr())) / indexsize;
+        command[3] = geometry->baseVertex();
+        command[4] = 0;
+    }
+
+    return commandsimpl->Update(0, count * GS_DRAWCOMMAND_SIZE, data.data());
 }
 
-GSbool IxGSImpl::ImmediatePrimitive(GSenum type, GSuint vertexcount, GSuint indexcount, GSuint flags, GSimmediateprimitive *primitive)
+GSbool IxGSImpl::CullGeometriesGPU(const GSgpucullingdescription &desc)
 {
-    if (!ValidateState(RENDERER_READY, false, true, true)) {
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
         return GS_FALSE;
     }
 
-    bool flushnotneeded = p_immediatebuffer->EmitPrimitive(
-        type, vertexcount, indexcount,
-        flags, primitive
-    );
-
-    if (!flushnotneeded) {
-        // TODO: this cast is not very nice...
-        IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(p_immediatebuffer);
+    if (!desc.depthsource || !desc.bounds || !desc.commands) {
+        return error(GSE_INVALIDOBJECT);
+    }
 
-        // requested primitive can not be added, try to flush buffer
-        bufferimpl->EndImmediateDrawing();
-        DrawImmediatePrimitives(p_immediatebuffer);
-        bufferimpl->BeginImmediateDrawing();
+    if (!desc.viewprojection) {
+        return error(GSE_INVALIDVALUE);
+    }
 
-        if (!p_immediatebuffer->EmitPrimitive(type, vertexcount, indexcount, flags, primitive)) {
-            // primitive can not be added at all
-            return error(GSE_INVALIDVALUE);
-        }
+    xGSFrameBufferImpl *depthsource = static_cast<xGSFrameBufferImpl*>(desc.depthsource);
+    xGSTextureImpl *depth = depthsource->depthTexture();
+    if (!depth || depth->samples() != GS_MULTISAMPLE_NONE) {
+        return error(GSE_INVALIDOBJECT);
     }
 
-    return error(GS_OK);
-}
+    xGSDataBufferImpl *bounds = static_cast<xGSDataBufferImpl*>(desc.bounds);
+    xGSDataBufferImpl *commands = static_cast<xGSDataBufferImpl*>(desc.commands);
 
-GSbool IxGSImpl::EndImmediateDrawing()
-{
-    if (!ValidateState(RENDERER_READY, false, true, true)) {
-        return GS_FALSE;
+    // sphere is 4 floats
+    if (desc.count > bounds->size() / (sizeof(GSfloat) * 4) ||
+        desc.count > commands->size() / GS_DRAWCOMMAND_SIZE)
+    {
+        return error(GSE_INVALIDVALUE);
     }
 
-    // TODO: this cast is not very nice...
-    IxGSGeometryBufferImpl *bufferimpl = static_cast<IxGSGeometryBufferImpl*>(p_immediatebuffer);
+    if (desc.count == 0) {
+        return error(GS_OK);
+    }
 
-    bufferimpl->EndImmediateDrawing();
-    DrawImmediatePrimitives(p_immediatebuffer);
+    CullGeometriesGPUImpl(depthsource, desc.viewprojection, bounds, commands, desc.count);
 
-    p_immediatebuffer->Release();
-    p_immediatebuffer = nullptr;
+    // culling replaces current program and bindings, so state should be set again
+    SetStateImpl(static_cast<xGSStateImpl*>(nullptr));
 
-    return error(GS_OK);
+    return p_error == GS_OK;
 }
 
-GSbool IxGSImpl::BuildMIPs(IxGSTexture texture)
+GSbool IxGSImpl::DrawGeometriesIndirect(IxGSGeometry geometry, IxGSDataBuffer commands, GSuint count)
 {
-    if (!ValidateState(RENDERER_READY, true, false, false)) {
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
         return GS_FALSE;
     }
 
-    xGSTextureImpl *tex = static_cast<xGSTextureImpl*>(texture);
+    if (!geometry || !commands) {
+        return error(GSE_INVALIDOBJECT);
+    }
 
-    BuildMIPsImpl(tex);
+    if (!p_state) {
+        return error(GSE_INVALIDSTATE);
+    }
 
-    return error(GS_OK);
+    IxGSGeometryImpl *geometryimpl = static_cast<IxGSGeometryImpl*>(geometry);
+    if (geometryimpl->indexFormat() == GS_INDEX_NONE) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+#ifdef _DEBUG
+    xGSGeometryBufferImpl *buffer = geometryimpl->buffer();
+    size_t primaryslot = p_state->inputPrimarySlot();
+    xGSGeometryBufferImpl *boundbuffer =
+        primaryslot == GS_UNDEFINED ? nullptr : p_state->input(primaryslot).buffer;
+    if (p_input && boundbuffer == nullptr)  {
+        boundbuffer = p_input->primaryBuffer();
+    }
+    if (buffer != boundbuffer) {
+        return error(GSE_INVALIDOBJECT);
+    }
+#endif
+
+    xGSDataBufferImpl *commandsimpl = static_cast<xGSDataBufferImpl*>(commands);
+    if (count > commandsimpl->size() / GS_DRAWCOMMAND_SIZE) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    SetupGeometryImpl(geometryimpl);
+    DrawGeometriesIndirectImpl(geometryimpl, commandsimpl, count);
+
+    return p_error == GS_OK;
 }
 
 GSbool IxGSImpl::CopyImage(
@@ -1411,8 +3000,12 @@ GSbool IxGSImpl::BufferCommitment(xGSObject *buffer, GSuint offset, GSuint size,
         return error(GSE_INVALIDOBJECT);
     }
 
+    // pages of sparse geometry heap are managed by its geometries
+    if (static_cast<xGSUnknownObjectImpl*>(buffer)->objecttype() == GS_OBJECTTYPE_GEOMETRYBUFFER) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
     // TODO: check for support, check for buffer is sparse
-    //       check type
 
     BufferCommitmentImpl(buffer, offset, size, commit, flags);
 
@@ -1430,22 +3023,24 @@ GSbool IxGSImpl::GeometryBufferCommitment(IxGSGeometryBuffer buffer, IxGSGeometr
     }
 
     xGSGeometryBufferImpl *impl = static_cast<xGSGeometryBufferImpl*>(buffer);
+    if (!impl->sparse()) {
+        return error(GSE_INVALIDOBJECT);
+    }
 
-    GSuint vertexsize = impl->vertexDecl().buffer_size();
-    GSuint indexsize = index_buffer_size(impl->indexFormat());
-
-    GeometryBufferCommitmentImpl(impl);
+    if (!geometries && count) {
+        return error(GSE_INVALIDVALUE);
+    }
 
+    // nothing is changed if any of geometries doesn't belong to buffer
     for (GSuint n = 0; n < count; ++n) {
-        IxGSGeometryImpl *geom = static_cast<IxGSGeometryImpl*>(*geometries++);
-
-        if (geom->buffer() != impl) {
-            // skip
-            // TODO: think about skipping or error...
-            continue;
+        IxGSGeometryImpl *geom = static_cast<IxGSGeometryImpl*>(geometries[n]);
+        if (!geom || geom->buffer() != impl) {
+            return error(GSE_INVALIDOBJECT);
         }
+    }
 
-        GeometryBufferCommitmentGeometry(geom, vertexsize, indexsize, commit);
+    for (GSuint n = 0; n < count; ++n) {
+        static_cast<IxGSGeometryImpl*>(geometries[n])->setResident(commit != GS_FALSE);
     }
 
     return error(GS_OK);
@@ -1461,7 +3056,19 @@ GSbool IxGSImpl::TextureCommitment(IxGSTexture texture, GSuint level, GSuint x,
         return error(GSE_INVALIDOBJECT);
     }
 
-    xGSTextureImpl *tex = static_cast<xGSTextureImpl*>(texture);
+    IxGSTextureImpl *tex = static_cast<IxGSTextureImpl*>(texture);
+    if (!tex->sparse()) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    // pages of paged and streamed textures are managed by xGS
+    if (p_texturepager.managed(tex) || p_texturestreamer.streamed(tex)) {
+        return error(GSE_INVALIDOPERATION);
+    }
+
+    if (!tex->validCommitment(level, x, y, z, width, height, depth)) {
+        return error(GSE_INVALIDVALUE);
+    }
 
     TextureCommitmentImpl(tex, level, x, y, z, width, height, depth, commit);
 
@@ -1470,8 +3077,67 @@ GSbool IxGSImpl::TextureCommitment(IxGSTexture texture, GSuint level, GSuint x,
 
 GSbool IxGSImpl::Compute(IxGSComputeState state, GSuint x, GSuint y, GSuint z)
 {
-    // TODO:
-    return GS_FALSE;
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!state) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    if (x == 0 || y == 0 || z == 0) {
+        return error(GS_OK);
+    }
+
+    ComputeImpl(static_cast<IxGSComputeStateImpl*>(state), x, y, z);
+
+    // compute program replaces current program and bindings, so state should be set again
+    SetStateImpl(static_cast<xGSStateImpl*>(nullptr));
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::ComputeIndirect(IxGSComputeState state, IxGSDataBuffer buffer, GSuint offset)
+{
+    if (!ValidateState(RENDERER_READY, true, true, false)) {
+        return GS_FALSE;
+    }
+
+    if (!state || !buffer) {
+        return error(GSE_INVALIDOBJECT);
+    }
+
+    xGSDataBufferImpl *bufferimpl = static_cast<xGSDataBufferImpl*>(buffer);
+
+    // group counts are read as 32 bit integers
+    if ((offset & 3) != 0 || offset > bufferimpl->size() || bufferimpl->size() - offset < GS_DISPATCHCOMMAND_SIZE) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    ComputeIndirectImpl(static_cast<IxGSComputeStateImpl*>(state), bufferimpl, offset);
+
+    SetStateImpl(static_cast<xGSStateImpl*>(nullptr));
+
+    return p_error == GS_OK;
+}
+
+GSbool IxGSImpl::Barrier(GSuint flags)
+{
+    if (!ValidateState(RENDERER_READY, false, true, false)) {
+        return GS_FALSE;
+    }
+
+    if ((flags & ~GS_BARRIER_ALL) != 0) {
+        return error(GSE_INVALIDVALUE);
+    }
+
+    if (flags == 0) {
+        return error(GS_OK);
+    }
+
+    BarrierImpl(flags);
+
+    return p_error == GS_OK;
 }
 
 GSbool IxGSImpl::BeginTimerQuery()
@@ -1560,9 +3226,9 @@ GSbool IxGSImpl::Draw(IxGSGeometry geometry_to_draw, const T &drawer)
     }
 
     IxGSGeometryImpl *geometry = static_cast<IxGSGeometryImpl*>(geometry_to_draw);
-    xGSGeometryBufferImpl *buffer = geometry->buffer();
 
 #ifdef _DEBUG
+    xGSGeometryBufferImpl *buffer = geometry->buffer();
     size_t primaryslot = p_state->inputPrimarySlot();
     xGSGeometryBufferImpl *boundbuffer =
         primaryslot == GS_UNDEFINED ? nullptr : p_state->input(primaryslot).buffer;
@@ -1581,7 +3247,7 @@ GSbool IxGSImpl::Draw(IxGSGeometry geometry_to_draw, const T &drawer)
     } else {
         drawer.DrawElementsBaseVertex(
             geometry->type(),
-            geometry->indexCount(), buffer->indexFormat(),
+            geometry->indexCount(), geometry->storedIndexFormat(),
             geometry->indexPtr(), geometry->baseVertex()
         );
     }
@@ -1613,15 +3279,39 @@ GSbool IxGSImpl::MultiDraw(IxGSGeometry *geometries_to_draw, GSuint count, const
     }
 #endif
 
-    GSenum primtype = GS_NONE;
-    GSenum indextype = GS_NONE;
-    int first[4096];
-    int counts[4096];
-    GSptr indices[4096];
+    // geometries are drawn in batches of consecutive geometries which share
+    // primitive type, index format and geometry set-up
+    const size_t batchsize = 256;
+    int first[batchsize];
+    int counts[batchsize];
+    GSptr indices[batchsize];
     size_t current = 0;
+    IxGSGeometryImpl *batch = nullptr;
+
+    auto flush = [&]() {
+        if (current == 0) {
+            return;
+        }
+
+        SetupGeometryImpl(batch);
+
+        if (batch->indexFormat() == GS_INDEX_NONE) {
+            drawer.MultiDrawArrays(batch->type(), first, counts, GSuint(current));
+        } else {
+            drawer.MultiDrawElementsBaseVertex(
+                batch->type(), counts,
+                batch->storedIndexFormat(), indices, GSuint(current), first
+            );
+        }
+
+        current = 0;
+    };
 
     for (GSuint n = 0; n < count; ++n) {
         IxGSGeometryImpl *geometry = static_cast<IxGSGeometryImpl*>(geometries_to_draw[n]);
+        if (!geometry) {
+            return error(GSE_INVALIDOBJECT);
+        }
 
 #ifdef _DEBUG
         xGSGeometryBufferImpl *buffer = geometry->buffer();
@@ -1630,23 +3320,29 @@ GSbool IxGSImpl::MultiDraw(IxGSGeometry *geometries_to_draw, GSuint count, const
         }
 #endif
 
+        bool compatible =
+            batch != nullptr && current < batchsize &&
+            geometry->type() == batch->type() &&
+            geometry->indexFormat() == batch->indexFormat() &&
+            geometry->storedIndexFormat() == batch->storedIndexFormat() &&
+            geometry->restart() == batch->restart() &&
+            (!geometry->restart() || geometry->storedRestartIndex() == batch->storedRestartIndex()) &&
+            (geometry->type() != GS_PRIM_PATCHES || geometry->patchvertices() == batch->patchvertices());
+
+        if (!compatible) {
+            flush();
+            batch = geometry;
+        }
+
+        // first is base vertex for indexed geometries
+        bool indexed = geometry->indexFormat() != GS_INDEX_NONE;
         first[current] = geometry->baseVertex();
-        counts[current] = geometry->vertexCount(); // TODO: index count for indexed
-        indices[current] = geometry->indexPtr(); // TODO: only for indexed
+        counts[current] = indexed ? geometry->indexCount() : geometry->vertexCount();
+        indices[current] = indexed ? geometry->indexPtr() : nullptr;
         ++current;
-
-        // TODO: geometry setup, geometry type, index type
-        //geometry->setup();
     }
 
-    if (indextype == GS_INDEX_NONE) {
-        drawer.MultiDrawArrays(primtype, first, counts, count);
-    } else {
-        drawer.MultiDrawElementsBaseVertex(
-            primtype, counts,
-            indextype, indices, count, first
-        );
-    }
+    flush();
 
     return error(GS_OK);
 }
@@ -1678,6 +3374,21 @@ GSbool IxGSImpl::ValidateState(SystemState requiredstate, bool exactmatch, bool
     return GS_TRUE;
 }
 
+bool IxGSImpl::ValidSampler(const GSsamplerdescription &desc)
+{
+    const GSenum wraps[3] = { desc.wrapu, desc.wrapv, desc.wrapw };
+    for (auto wrap : wraps) {
+        if (wrap < GS_WRAP_REPEAT || wrap > GS_WRAP_BORDER) {
+            return false;
+        }
+    }
+
+    return
+        desc.filter >= GS_FILTER_NEAREST && desc.filter <= GS_FILTER_TRILINEAR &&
+        desc.depthcompare >= GS_DEPTHTEST_NONE && desc.depthcompare <= GS_DEPTHTEST_ALWAYS &&
+        desc.anisotropy <= 16;
+}
+
 template <typename T>
 void IxGSImpl::CheckObjectList(const T &list, const std::string &listname)
 {
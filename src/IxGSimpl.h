@@ -41,8 +41,14 @@ namespace xGS
         GSbool xGSAPI UpdateBlock(GSuint block, GSuint index, const GSptr data) override;
         GSbool xGSAPI UpdateValue(GSuint block, GSuint index, GSuint uniform, GSuint uniformindex, GSuint count, const GSptr data) override;
 
+        GSbool xGSAPI BeginUpdate() override;
+        GSbool xGSAPI EndUpdate() override;
+
         GSptr  xGSAPI Lock(GSdword access, void *lockdata) override;
         GSbool xGSAPI Unlock() override;
+
+    private:
+        GSbool update(GSuint offset, GSuint size, const GSptr data);
     };
 
     // framebuffer object
@@ -106,6 +112,8 @@ namespace xGS
 
     public:
         GSbool allocate(const GStexturedescription &desc);
+
+        bool validCommitment(GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth) const;
     };
 
     // state object
@@ -132,6 +140,62 @@ namespace xGS
         void ReleaseRendererResources();
     };
 
+    // query object
+    class IxGSQueryImpl : public xGSObjectImpl<xGSQueryImpl, IxGSQueryImpl>
+    {
+    public:
+        IxGSQueryImpl(xGSImpl *owner);
+        ~IxGSQueryImpl() override;
+
+    public:
+        GSbool allocate(const GSquerydescription &desc);
+
+        void begin() { p_active = true; }
+        void end() { p_active = false; p_issued = true; }
+
+    public:
+        GSvalue xGSAPI GetValue(GSenum valuetype) override;
+
+        GSbool  xGSAPI GetResult(GSuint64 &result, GSbool wait) override;
+    };
+
+    // compute state object
+    class IxGSComputeStateImpl : public xGSObjectImpl<xGSComputeStateImpl, IxGSComputeStateImpl>
+    {
+    public:
+        IxGSComputeStateImpl(xGSImpl *owner);
+        ~IxGSComputeStateImpl() override;
+
+    public:
+        GSbool allocate(const GScomputestatedescription &desc);
+    };
+
+    // atlas object
+    class IxGSAtlasImpl : public xGSObjectImpl<xGSObjectBase<xGSAtlasBase, xGSImpl>, IxGSAtlasImpl>
+    {
+    public:
+        IxGSAtlasImpl(xGSImpl *owner);
+        ~IxGSAtlasImpl() override;
+
+    public:
+        GSbool allocate(const GSatlasdescription &desc);
+
+        void ReleaseRendererResources();
+
+    public:
+        GSvalue xGSAPI GetValue(GSenum valuetype) override;
+
+        GSbool  xGSAPI Add(const GSatlasimage *images, GSuint count, GSatlasentry *entries) override;
+        GSbool  xGSAPI Remove(GSuint id) override;
+        GSbool  xGSAPI GetEntry(GSuint id, GSatlasentry &entry) override;
+        GSbool  xGSAPI Repack() override;
+        GSbool  xGSAPI GetTexture(IxGSTexture *texture) override;
+
+    private:
+        IxGSTextureImpl* createTexture(GSenum format, GSuint width, GSuint height, GSuint layers) const;
+        void fillEntry(GSuint id, const Entry &area, GSatlasentry &entry) const;
+    };
+
     // system object
     class IxGSImpl : public xGSImpl
     {
@@ -143,6 +207,7 @@ namespace xGS
 
         GSbool xGSAPI CreateObject(GSenum type, const void *desc, void **result) override;
         GSbool xGSAPI CreateSamplers(const GSsamplerdescription *samplers, GSuint count) override;
+        GSbool xGSAPI AddSamplers(const GSsamplerdescription *samplers, GSuint count, GSenum *indices) override;
 
         GSbool xGSAPI GetRenderTargetSize(GSsize &size) override;
 
@@ -153,12 +218,16 @@ namespace xGS
         GSbool xGSAPI SetState(IxGSState state) override;
         GSbool xGSAPI SetInput(IxGSInput input) override;
         GSbool xGSAPI SetParameters(IxGSParameters parameters) override;
+        GSbool xGSAPI SetParametersOffsets(IxGSParameters parameters, const GSuint *blockindices) override;
 
         GSbool xGSAPI SetViewport(const GSrect &viewport) override;
         GSbool xGSAPI SetStencilReference(GSuint ref) override;
         GSbool xGSAPI SetBlendColor(const GScolor &color) override;
         GSbool xGSAPI SetUniformValue(GSenum set, GSenum slot, GSenum type, const void *value) override;
 
+        GSbool xGSAPI AllocateTransient(GSuint size, GStransientallocation *allocation) override;
+        GSbool xGSAPI SetTransientBlock(GSenum set, GSenum slot, const GStransientallocation &allocation) override;
+
         GSbool xGSAPI DrawGeometry(IxGSGeometry geometry) override;
         GSbool xGSAPI DrawGeometryInstanced(IxGSGeometry geometry, GSuint count) override;
         GSbool xGSAPI DrawGeometries(IxGSGeometry *geometries, GSuint count) override;
@@ -167,11 +236,40 @@ namespace xGS
         GSbool xGSAPI BeginCapture(GSenum mode, IxGSGeometryBuffer buffer) override;
         GSbool xGSAPI EndCapture(GSuint *elementcount) override;
 
+        GSbool xGSAPI BeginQuery(IxGSQuery query) override;
+        GSbool xGSAPI EndQuery(IxGSQuery query) override;
+        GSbool xGSAPI BeginConditionalRender(IxGSQuery query, GSenum mode) override;
+        GSbool xGSAPI EndConditionalRender() override;
+
         GSbool xGSAPI BeginImmediateDrawing(IxGSGeometryBuffer buffer, GSuint flags) override;
         GSbool xGSAPI ImmediatePrimitive(GSenum type, GSuint vertexcount, GSuint indexcount, GSuint flags, GSimmediateprimitive *primitive) override;
         GSbool xGSAPI EndImmediateDrawing() override;
 
         GSbool xGSAPI BuildMIPs(IxGSTexture texture) override;
+        GSbool xGSAPI BuildMIPsFiltered(IxGSTexture texture, const GSmipgenerationdescription &desc) override;
+
+        GSbool xGSAPI OptimizeMesh(const GSmeshdescription &mesh, GSuint flags) override;
+        GSbool xGSAPI BuildMeshlets(const GSmeshdescription &mesh, GSuint maxvertices, GSuint maxtriangles, GSmeshletdata &data) override;
+        GSbool xGSAPI CullGeometries(const GScullingdescription &desc, IxGSGeometry *visible, GSuint &visiblecount) override;
+        GSbool xGSAPI CompressImage(const GSimagecompressiondescription &desc) override;
+        GSbool xGSAPI UploadImage(IxGSTexture texture, const GSimageuploaddescription &desc) override;
+        GSbool xGSAPI LoadTexture(const char *filename, IxGSTexture *texture) override;
+
+        GSbool xGSAPI SetTextureStreaming(const GStexturestreamingdescription &desc) override;
+        GSbool xGSAPI StreamTexture(const char *filename, IxGSTexture *texture) override;
+        GSbool xGSAPI RequestTextureLevels(const GStexturestreamingrequest *requests, GSuint count) override;
+        GSbool xGSAPI UpdateTextureStreaming() override;
+
+        GSbool xGSAPI SetTexturePaging(const GStexturepagingdescription &desc) override;
+        GSbool xGSAPI RequestTexturePages(IxGSTexture texture, const GSuint *pages, GSuint count) override;
+        GSbool xGSAPI RequestTexturePagesFeedback(IxGSTexture texture, IxGSDataBuffer feedback, GSuint count) override;
+        GSbool xGSAPI UpdateTexturePages(GStexturepage *committed, GSuint &count) override;
+
+        GSbool xGSAPI GetTextureHandle(IxGSTexture texture, GSenum sampler, GSuint64 &handle) override;
+
+        GSbool xGSAPI BuildDrawCommands(IxGSGeometry *geometries, GSuint count, IxGSDataBuffer commands) override;
+        GSbool xGSAPI CullGeometriesGPU(const GSgpucullingdescription &desc) override;
+        GSbool xGSAPI DrawGeometriesIndirect(IxGSGeometry geometry, IxGSDataBuffer commands, GSuint count) override;
 
         GSbool xGSAPI CopyImage(
             IxGSTexture src, GSuint srclevel, GSuint srcx, GSuint srcy, GSuint srcz,
@@ -185,6 +283,8 @@ namespace xGS
         GSbool xGSAPI TextureCommitment(IxGSTexture texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit) override;
 
         GSbool xGSAPI Compute(IxGSComputeState state, GSuint x, GSuint y, GSuint z) override;
+        GSbool xGSAPI ComputeIndirect(IxGSComputeState state, IxGSDataBuffer buffer, GSuint offset) override;
+        GSbool xGSAPI Barrier(GSuint flags) override;
 
         GSbool xGSAPI BeginTimerQuery() override;
         GSbool xGSAPI EndTimerQuery() override;
@@ -205,6 +305,8 @@ namespace xGS
     private:
         GSbool ValidateState(SystemState requiredstate, bool exactmatch, bool matchimmediate, bool requiredimmediate);
 
+        static bool ValidSampler(const GSsamplerdescription &desc);
+
         template <typename T>
         inline void CheckObjectList(const T &list, const std::string &listname);
 
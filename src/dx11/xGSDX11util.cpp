@@ -157,6 +157,7 @@ GSerror GSParametersState::allocate(xGSImpl *impl, xGSStateImpl *state, const GS
                     case GSU_MAT2: size = sizeof(float) * 4; break;
                     case GSU_MAT3: size = sizeof(float) * 9; break;
                     case GSU_MAT4: size = sizeof(float) * 16; break;
+                    case GSU_HANDLE: size = sizeof(GSuint64); break;
 
                     default:
                         return GSE_INVALIDENUM;
@@ -208,6 +209,13 @@ void GSParametersState::apply(const GScaps &caps, xGSImpl *impl, xGSStateImpl *s
 #endif
 }
 
+GSerror GSParametersState::applyblockindices(const GSuint *blockindices)
+{
+    // TODO: GSParametersState::applyblockindices
+
+    return GSE_UNIMPLEMENTED;
+}
+
 void GSParametersState::ReleaseRendererResources(xGSImpl *impl)
 {
     for (auto &u : p_uniformblockdata) {
@@ -37,9 +37,47 @@ namespace xGS
 
         // TODO: this is temp. field for DataBuffer implementation
         GSuint ubo_alignment;
+        GSuint ssbo_alignment;
     };
 
 
+    inline DXGI_FORMAT dx11_vertex_format(const GSvertexcomponent &c)
+    {
+        switch (c.type) {
+            case GSVD_VECTOR1:   return DXGI_FORMAT_R32_FLOAT;
+            case GSVD_VECTOR2:   return DXGI_FORMAT_R32G32_FLOAT;
+            case GSVD_POSITION:
+            case GSVD_VECTOR3:   return DXGI_FORMAT_R32G32B32_FLOAT;
+            case GSVD_POSITIONW:
+            case GSVD_VECTOR4:   return DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+            case GSVD_HALF2:     return DXGI_FORMAT_R16G16_FLOAT;
+            case GSVD_HALF4:     return DXGI_FORMAT_R16G16B16A16_FLOAT;
+            case GSVD_UBYTE4N:   return DXGI_FORMAT_R8G8B8A8_UNORM;
+            case GSVD_BYTE4N:    return DXGI_FORMAT_R8G8B8A8_SNORM;
+            case GSVD_USHORT2N:  return DXGI_FORMAT_R16G16_UNORM;
+            case GSVD_USHORT4N:  return DXGI_FORMAT_R16G16B16A16_UNORM;
+            case GSVD_SHORT2N:   return DXGI_FORMAT_R16G16_SNORM;
+            case GSVD_SHORT4N:   return DXGI_FORMAT_R16G16B16A16_SNORM;
+            case GSVD_UDEC4N:    return DXGI_FORMAT_R10G10B10A2_UNORM;
+            // NOTE: there's no signed 10_10_10_2 format in DXGI
+
+            case GSVD_INT1:      return DXGI_FORMAT_R32_SINT;
+            case GSVD_INT2:      return DXGI_FORMAT_R32G32_SINT;
+            case GSVD_INT3:      return DXGI_FORMAT_R32G32B32_SINT;
+            case GSVD_INT4:      return DXGI_FORMAT_R32G32B32A32_SINT;
+            case GSVD_UINT1:     return DXGI_FORMAT_R32_UINT;
+            case GSVD_UINT2:     return DXGI_FORMAT_R32G32_UINT;
+            case GSVD_UINT3:     return DXGI_FORMAT_R32G32B32_UINT;
+            case GSVD_UINT4:     return DXGI_FORMAT_R32G32B32A32_UINT;
+            case GSVD_UBYTE4:    return DXGI_FORMAT_R8G8B8A8_UINT;
+            case GSVD_USHORT2:   return DXGI_FORMAT_R16G16_UINT;
+            case GSVD_USHORT4:   return DXGI_FORMAT_R16G16B16A16_UINT;
+        }
+
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
     inline DXGI_FORMAT dx11_index_type(GSenum type)
     {
         switch (type) {
@@ -70,6 +108,8 @@ namespace xGS
         switch (wrap) {
             case GS_WRAP_CLAMP:  return D3D11_TEXTURE_ADDRESS_CLAMP;
             case GS_WRAP_REPEAT: return D3D11_TEXTURE_ADDRESS_WRAP;
+            case GS_WRAP_MIRROR: return D3D11_TEXTURE_ADDRESS_MIRROR;
+            case GS_WRAP_BORDER: return D3D11_TEXTURE_ADDRESS_BORDER;
         }
 
         return D3D11_TEXTURE_ADDRESS_MODE(0);
@@ -159,6 +199,7 @@ namespace xGS
 
         GSerror allocate(xGSImpl *impl, xGSStateImpl *state, const GSParameterSet &set, const GSuniformbinding *uniforms, const GStexturebinding *textures, const GSconstantvalue *constants);
         void apply(const GScaps &caps, xGSImpl *impl, xGSStateImpl *state);
+        GSerror applyblockindices(const GSuint *blockindices);
 
         void ReleaseRendererResources(xGSImpl *impl);
 
@@ -0,0 +1,37 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    dx11/xGScomputestate.cpp
+        Compute state object implementation class
+*/
+
+#include "xGScomputestate.h"
+#include "xGSimpl.h"
+
+
+using namespace xGS;
+
+
+xGSComputeStateImpl::xGSComputeStateImpl(xGSImpl *owner) :
+    xGSObjectBase(owner)
+{}
+
+xGSComputeStateImpl::~xGSComputeStateImpl()
+{}
+
+GSbool xGSComputeStateImpl::AllocateImpl(const GScomputestatedescription &desc, const GScomputeparameterlayout *staticparams)
+{
+    // TODO: xGSComputeStateImpl::AllocateImpl
+    return p_owner->error(GSE_UNIMPLEMENTED);
+}
+
+void xGSComputeStateImpl::ReleaseRendererResources()
+{
+    // TODO: xGSComputeStateImpl::ReleaseRendererResources
+}
@@ -28,6 +28,11 @@ xGSDataBufferImpl::~xGSDataBufferImpl()
 
 GSbool xGSDataBufferImpl::AllocateImpl(const GSdatabufferdescription &desc, GSuint totalsize)
 {
+    // TODO: structured buffers for GSDT_STORAGE
+    if (desc.type != GSDT_UNIFORM) {
+        return GS_FALSE;
+    }
+
     // TODO: allocate DX11 data buffer
     D3D11_BUFFER_DESC bufferdesc = {};
     bufferdesc.Usage = D3D11_USAGE_DYNAMIC;
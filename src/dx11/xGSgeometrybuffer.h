@@ -40,6 +40,8 @@ namespace xGS
         GSptr LockImpl(GSenum locktype, size_t offset, size_t size);
         void UnlockImpl();
 
+        void CommitPagesImpl(GSenum locktype, GSuint offset, GSuint size, bool commit);
+
         void BeginImmediateDrawingImpl();
         void EndImmediateDrawingImpl();
 
@@ -19,6 +19,8 @@
 #include "xGSstate.h"
 #include "xGSinput.h"
 #include "xGSparameters.h"
+#include "xGSquery.h"
+#include "xGScomputestate.h"
 
 #include <Windows.h>
 #include <d3d11.h>
@@ -157,6 +159,16 @@ void xGSImpl::CreateSamplersImpl(const GSsamplerdescription *samplers, GSuint co
                 break;
         }
 
+        if (samplers->anisotropy > 1) {
+            desc.Filter = D3D11_FILTER_ANISOTROPIC;
+        }
+        desc.MaxAnisotropy = samplers->anisotropy;
+
+        desc.BorderColor[0] = samplers->border.r;
+        desc.BorderColor[1] = samplers->border.g;
+        desc.BorderColor[2] = samplers->border.b;
+        desc.BorderColor[3] = samplers->border.a;
+
         desc.AddressU = dx11_texture_wrap(samplers->wrapu);
         desc.AddressV = dx11_texture_wrap(samplers->wrapv);
         desc.AddressW = dx11_texture_wrap(samplers->wrapw);
@@ -178,6 +190,12 @@ void xGSImpl::CreateSamplersImpl(const GSsamplerdescription *samplers, GSuint co
     p_error = GS_OK;
 }
 
+void xGSImpl::AddSamplersImpl(const GSsamplerdescription *samplers, GSuint count, GSenum *indices)
+{
+    // TODO: xGSImpl::AddSamplersImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
 void xGSImpl::GetRenderTargetSizeImpl(GSsize &size)
 {
     if (p_rendertarget) {
@@ -261,6 +279,18 @@ void xGSImpl::SetUniformValueImpl(GSenum type, GSint location, const void *value
     // TODO: xGSImpl::SetUniformValueImpl
 }
 
+void xGSImpl::AllocateTransientImpl(GSuint size, GStransientallocation &allocation)
+{
+    // TODO: xGSImpl::AllocateTransientImpl
+
+    error(GSE_UNIMPLEMENTED);
+}
+
+void xGSImpl::SetTransientBlockImpl(GSint location, const GStransientallocation &allocation)
+{
+    // TODO: xGSImpl::SetTransientBlockImpl
+}
+
 void xGSImpl::SetupGeometryImpl(IxGSGeometryImpl *geometry)
 {
     // TODO: xGSImpl::SetupGeometryImpl
@@ -344,6 +374,41 @@ void xGSImpl::EndCaptureImpl(GSuint *elementcount)
     // TODO: xGSImpl::EndCaptureImpl
 }
 
+void xGSImpl::BeginQueryImpl(xGSQueryImpl *query)
+{
+    // TODO: xGSImpl::BeginQueryImpl
+}
+
+void xGSImpl::EndQueryImpl(xGSQueryImpl *query)
+{
+    // TODO: xGSImpl::EndQueryImpl
+}
+
+void xGSImpl::BeginConditionalRenderImpl(xGSQueryImpl *query, GSenum mode)
+{
+    // TODO: xGSImpl::BeginConditionalRenderImpl
+}
+
+void xGSImpl::EndConditionalRenderImpl()
+{
+    // TODO: xGSImpl::EndConditionalRenderImpl
+}
+
+void xGSImpl::DrawGeometriesIndirectImpl(IxGSGeometryImpl *geometry, xGSDataBufferImpl *commands, GSuint count)
+{
+    // TODO: xGSImpl::DrawGeometriesIndirectImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
+void xGSImpl::CullGeometriesGPUImpl(
+    xGSFrameBufferImpl *depthsource, const GSfloat *viewprojection,
+    xGSDataBufferImpl *bounds, xGSDataBufferImpl *commands, GSuint count
+)
+{
+    // TODO: xGSImpl::CullGeometriesGPUImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
 void xGSImpl::DrawImmediatePrimitives(xGSGeometryBufferImpl *buffer)
 {
     // TODO: xGSImpl::DrawImmediatePrimitives
@@ -358,11 +423,35 @@ void xGSImpl::DrawImmediatePrimitives(xGSGeometryBufferImpl *buffer)
     }
 }
 
+void xGSImpl::ComputeImpl(xGSComputeStateImpl *state, GSuint x, GSuint y, GSuint z)
+{
+    // TODO: xGSImpl::ComputeImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
+void xGSImpl::ComputeIndirectImpl(xGSComputeStateImpl *state, xGSDataBufferImpl *buffer, GSuint offset)
+{
+    // TODO: xGSImpl::ComputeIndirectImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
+void xGSImpl::BarrierImpl(GSuint flags)
+{
+    // TODO: xGSImpl::BarrierImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
 void xGSImpl::BuildMIPsImpl(xGSTextureImpl *texture)
 {
     p_context->GenerateMips(texture->view());
 }
 
+void xGSImpl::BuildMIPsFilteredImpl(xGSTextureImpl *texture, const GSmipgenerationdescription &desc)
+{
+    // TODO: xGSImpl::BuildMIPsFilteredImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
 void xGSImpl::CopyImageImpl(
     xGSTextureImpl *src, GSuint srclevel, GSuint srcx, GSuint srcy, GSuint srcz,
     xGSTextureImpl *dst, GSuint dstlevel, GSuint dstx, GSuint dsty, GSuint dstz,
@@ -386,16 +475,6 @@ void xGSImpl::BufferCommitmentImpl(xGSObject *buffer, GSuint offset, GSuint size
     p_error = GS_OK;
 }
 
-void xGSImpl::GeometryBufferCommitmentImpl(xGSGeometryBufferImpl *buffer)
-{
-    // TODO: xGSImpl::GeometryBufferCommitmentImpl
-}
-
-void xGSImpl::GeometryBufferCommitmentGeometry(IxGSGeometryImpl *geometry, GSuint vertexsize, GSuint indexsize, GSbool commit)
-{
-    // TODO: xGSImpl::GeometryBufferCommitmentGeometry
-}
-
 void xGSImpl::TextureCommitmentImpl(xGSTextureImpl *texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit)
 {
     // TODO: xGSImpl::TextureCommitmentImpl
@@ -403,6 +482,12 @@ void xGSImpl::TextureCommitmentImpl(xGSTextureImpl *texture, GSuint level, GSuin
     p_error = GS_OK;
 }
 
+void xGSImpl::GetTextureHandleImpl(xGSTextureImpl *texture, GSenum sampler, GSuint64 &handle)
+{
+    // TODO: xGSImpl::GetTextureHandleImpl
+    error(GSE_UNIMPLEMENTED);
+}
+
 void xGSImpl::BeginTimerQueryImpl()
 {
     // TODO: xGSImpl::BeginTimerQueryImpl
@@ -440,6 +525,24 @@ GSbool xGSImpl::GetTextureFormatDescriptor(GSvalue format, TextureFormatDescript
     return GS_TRUE;
 }
 
+GSbool xGSImpl::SparseTextureSupported(const GStexturedescription &desc)
+{
+    // TODO: xGSImpl::SparseTextureSupported
+    return GS_FALSE;
+}
+
+GSbool xGSImpl::TransientAllocationValid(const GStransientallocation &allocation)
+{
+    // TODO: xGSImpl::TransientAllocationValid
+    return GS_FALSE;
+}
+
+void xGSImpl::GetTextureLimits(TextureLimits &limits)
+{
+    // TODO: xGSImpl::GetTextureLimits
+    limits = TextureLimits();
+}
+
 const GSpixelformat& xGSImpl::DefaultRenderTargetFormat()
 {
     // TODO
@@ -55,29 +55,8 @@ GSbool xGSStateImpl::AllocateImpl(const GSstatedescription &desc, GSuint statici
                     el.AlignedByteOffset =
                         inputelementscount == 0 ? 0 : D3D11_APPEND_ALIGNED_ELEMENT;
 
-                    switch (comp->type) {
-                        case GSVD_POS:
-                        case GSVD_VEC3:
-                            el.Format = DXGI_FORMAT_R32G32B32_FLOAT;
-                            break;
-
-                        case GSVD_FLOAT:
-                            el.Format = DXGI_FORMAT_R32_FLOAT;
-                            break;
-
-                        case GSVD_VEC2:
-                            el.Format = DXGI_FORMAT_R32G32_FLOAT;
-                            break;
-
-                        case GSVD_POSW:
-                        case GSVD_VEC4:
-                            el.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-                            break;
-
-                        default:
-                            // TODO: handle error
-                            break;
-                    }
+                    // TODO: handle error for unsupported format
+                    el.Format = dx11_vertex_format(*comp);
 
                     el.InputSlot = 0;
                     el.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -0,0 +1,38 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    dx12/xGScomputestate.h
+        Compute state object implementation class header
+            compute state object holds compute shader program
+            and its static resource bindings
+*/
+
+#pragma once
+
+#include "xGSimplbase.h"
+#include "xGSDX12util.h"
+
+
+namespace xGS
+{
+
+    // compute program object
+    class xGSComputeStateImpl : public xGSObjectBase<xGSComputeStateBase, xGSImpl>
+    {
+    public:
+        xGSComputeStateImpl(xGSImpl *owner);
+        ~xGSComputeStateImpl() override;
+
+    public:
+        GSbool AllocateImpl(const GScomputestatedescription &desc, const GScomputeparameterlayout *staticparams);
+
+        void ReleaseRendererResources();
+    };
+
+} // namespace xGS
@@ -28,6 +28,11 @@ xGSDataBufferImpl::~xGSDataBufferImpl()
 
 GSbool xGSDataBufferImpl::AllocateImpl(const GSdatabufferdescription &desc, GSuint totalsize)
 {
+    // TODO: structured buffers for GSDT_STORAGE
+    if (desc.type != GSDT_UNIFORM) {
+        return GS_FALSE;
+    }
+
     D3D12_HEAP_PROPERTIES heapprops = {
         D3D12_HEAP_TYPE_UPLOAD,
         D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
@@ -32,6 +32,11 @@ xGSGeometryBufferImpl::~xGSGeometryBufferImpl()
 
 GSbool xGSGeometryBufferImpl::allocate(const GSgeometrybufferdescription &desc)
 {
+    // TODO: sparse geometry heap with tiled resources
+    if (desc.flags & GS_GBFLAG_SPARSE) {
+        return p_owner->error(GSE_UNSUPPORTED);
+    }
+
     p_type = desc.type;
 
     p_vertexdecl = GSvertexdecl(desc.vertexdecl);
@@ -113,6 +118,11 @@ GSptr xGSGeometryBufferImpl::LockImpl(GSenum locktype, size_t offset, size_t siz
     return p_lockmemory;
 }
 
+void xGSGeometryBufferImpl::CommitPagesImpl(GSenum locktype, GSuint offset, GSuint size, bool commit)
+{
+    // TODO: xGSGeometryBufferImpl::CommitPagesImpl
+}
+
 void xGSGeometryBufferImpl::UnlockImpl()
 {
     p_lockbuffer->Unmap(0, nullptr);
@@ -54,6 +54,7 @@ namespace xGS
         void DestroyRendererImpl();
 
         void CreateSamplersImpl(const GSsamplerdescription *samplers, GSuint count);
+        void AddSamplersImpl(const GSsamplerdescription *samplers, GSuint count, GSenum *indices);
 
         void GetRenderTargetSizeImpl(GSsize &size);
 
@@ -67,14 +68,33 @@ namespace xGS
         void SetBlendColorImpl(const GScolor &color);
         void SetUniformValueImpl(GSenum type, GSint location, const void *value);
 
+        void AllocateTransientImpl(GSuint size, GStransientallocation &allocation);
+        void SetTransientBlockImpl(GSint location, const GStransientallocation &allocation);
+
         void SetupGeometryImpl(IxGSGeometryImpl *geometry);
 
         void BeginCaptureImpl(GSenum mode);
         void EndCaptureImpl(GSuint *elementcount);
 
+        void BeginQueryImpl(xGSQueryImpl *query);
+        void EndQueryImpl(xGSQueryImpl *query);
+        void BeginConditionalRenderImpl(xGSQueryImpl *query, GSenum mode);
+        void EndConditionalRenderImpl();
+
         void DrawImmediatePrimitives(xGSGeometryBufferImpl *buffer);
 
+        void DrawGeometriesIndirectImpl(IxGSGeometryImpl *geometry, xGSDataBufferImpl *commands, GSuint count);
+        void CullGeometriesGPUImpl(
+            xGSFrameBufferImpl *depthsource, const GSfloat *viewprojection,
+            xGSDataBufferImpl *bounds, xGSDataBufferImpl *commands, GSuint count
+        );
+
+        void ComputeImpl(xGSComputeStateImpl *state, GSuint x, GSuint y, GSuint z);
+        void ComputeIndirectImpl(xGSComputeStateImpl *state, xGSDataBufferImpl *buffer, GSuint offset);
+        void BarrierImpl(GSuint flags);
+
         void BuildMIPsImpl(xGSTextureImpl *texture);
+        void BuildMIPsFilteredImpl(xGSTextureImpl *texture, const GSmipgenerationdescription &desc);
 
         void CopyImageImpl(
             xGSTextureImpl *src, GSuint srclevel, GSuint srcx, GSuint srcy, GSuint srcz,
@@ -85,10 +105,10 @@ namespace xGS
         void CopyDataImpl(xGSObject *src, xGSObject *dst, GSuint readoffset, GSuint writeoffset, GSuint size, GSuint flags);
 
         void BufferCommitmentImpl(xGSObject *buffer, GSuint offset, GSuint size, GSbool commit, GSuint flags);
-        void GeometryBufferCommitmentImpl(xGSGeometryBufferImpl *buffer);
-        void GeometryBufferCommitmentGeometry(IxGSGeometryImpl *geometry, GSuint vertexsize, GSuint indexsize, GSbool commit);
         void TextureCommitmentImpl(xGSTextureImpl *texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit);
 
+        void GetTextureHandleImpl(xGSTextureImpl *texture, GSenum sampler, GSuint64 &handle);
+
         void BeginTimerQueryImpl();
         void EndTimerQueryImpl();
         void TimestampQueryImpl();
@@ -113,6 +133,9 @@ namespace xGS
         };
 
         GSbool GetTextureFormatDescriptor(GSvalue format, TextureFormatDescriptor &descriptor);
+        GSbool SparseTextureSupported(const GStexturedescription &desc);
+        GSbool TransientAllocationValid(const GStransientallocation &allocation);
+        void GetTextureLimits(TextureLimits &limits);
         const GSpixelformat& DefaultRenderTargetFormat();
 
         void UploadBufferData(ID3D12Resource *source, ID3D12Resource *dest, size_t destoffset, size_t destsize);
@@ -0,0 +1,49 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    dx12/xGSquery.cpp
+        Query object implementation class
+*/
+
+#include "xGSquery.h"
+#include "xGSimpl.h"
+
+
+using namespace xGS;
+
+
+xGSQueryImpl::xGSQueryImpl(xGSImpl *owner) :
+    xGSObjectBase(owner)
+{}
+
+xGSQueryImpl::~xGSQueryImpl()
+{}
+
+GSbool xGSQueryImpl::AllocateImpl(GSenum type)
+{
+    // TODO: xGSQueryImpl::AllocateImpl
+    return GS_FALSE;
+}
+
+GSbool xGSQueryImpl::ResultAvailableImpl()
+{
+    // TODO: xGSQueryImpl::ResultAvailableImpl
+    return GS_FALSE;
+}
+
+GSuint64 xGSQueryImpl::ResultImpl()
+{
+    // TODO: xGSQueryImpl::ResultImpl
+    return 0;
+}
+
+void xGSQueryImpl::ReleaseRendererResources()
+{
+    // TODO: xGSQueryImpl::ReleaseRendererResources
+}
@@ -0,0 +1,40 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    dx12/xGSquery.h
+        Query object implementation class header
+            this object wraps GPU occlusion query
+*/
+
+#pragma once
+
+#include "xGSimplbase.h"
+#include "xGSDX12util.h"
+
+
+namespace xGS
+{
+
+    // query object
+    class xGSQueryImpl : public xGSObjectBase<xGSQueryBase, xGSImpl>
+    {
+    public:
+        xGSQueryImpl(xGSImpl *owner);
+        ~xGSQueryImpl() override;
+
+    public:
+        GSbool AllocateImpl(GSenum type);
+
+        GSbool ResultAvailableImpl();
+        GSuint64 ResultImpl();
+
+        void ReleaseRendererResources();
+    };
+
+} // namespace xGS
@@ -194,6 +194,28 @@ void xGSTextureImpl::UnlockImpl()
     p_locktype = GS_NONE;
 }
 
+bool xGSTextureImpl::UpdateRegions(const GStextureregion *regions, GSuint count)
+{
+    // TODO: xGSTextureImpl::UpdateRegions
+    return false;
+}
+
+void xGSTextureImpl::SetBaseLevel(GSuint level)
+{
+    // TODO: xGSTextureImpl::SetBaseLevel
+    p_minlevel = level;
+}
+
+void xGSTextureImpl::CommitLevel(GSuint level, GSbool commit)
+{
+    // TODO: xGSTextureImpl::CommitLevel
+}
+
+void xGSTextureImpl::CommitRegion(GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit)
+{
+    // TODO: xGSTextureImpl::CommitRegion
+}
+
 void xGSTextureImpl::bindNullTexture()
 {
     // TODO: xGSTextureImpl::bindNullTexture
@@ -39,6 +39,12 @@ namespace xGS
         GSptr LockImpl(GSenum locktype, GSdword access, GSint level, GSint layer, void *lockdata);
         void UnlockImpl();
 
+        bool UpdateRegions(const GStextureregion *regions, GSuint count);
+
+        void SetBaseLevel(GSuint level);
+        void CommitLevel(GSuint level, GSbool commit);
+        void CommitRegion(GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit);
+
         static void bindNullTexture();
 
         void ReleaseRendererResources();
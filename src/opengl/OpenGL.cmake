@@ -14,6 +14,7 @@
 # OpenGL implementation specific headers
 set(HEADERS
 	${HEADERS}
+	opengl/xGScomputestate.h
 	opengl/xGScontext.h
 	opengl/xGSdatabuffer.h
 	opengl/xGSframebuffer.h
@@ -21,7 +22,10 @@ set(HEADERS
 	opengl/xGSGLutil.h
 	opengl/xGSimpl.h
 	opengl/xGSinput.h
+	opengl/xGSmipgenerator.h
+	opengl/xGSocclusion.h
 	opengl/xGSparameters.h
+	opengl/xGSquery.h
 	opengl/xGSstate.h
 	opengl/xGStexture.h
 )
@@ -31,13 +35,17 @@ set(SOURCES
 	${SOURCES}
 	xGSmain.cpp
 
+	# opengl/xGScomputestate.cpp
 	# opengl/xGSdatabuffer.cpp
 	# opengl/xGSframebuffer.cpp
 	# opengl/xGSgeometrybuffer.cpp
 	# opengl/xGSGLutil.cpp
 	# opengl/xGSimpl.cpp
 	# opengl/xGSinput.cpp
+	# opengl/xGSmipgenerator.cpp
+	# opengl/xGSocclusion.cpp
 	# opengl/xGSparameters.cpp
+	# opengl/xGSquery.cpp
     # opengl/xGSplatform.cpp
 	# opengl/xGSstate.cpp
 	# opengl/xGStexture.cpp
@@ -21,6 +21,14 @@
 #define GS_CONFIG_MAP_BUFFER_RANGE
 //#define GS_CONFIG_FRAMEBUFFER_EXT // not supported
 //#define GS_CONFIG_SEPARATE_VERTEX_FORMAT // not supported
+//#define GS_CONFIG_STORAGE_BUFFER // not supported
+//#define GS_CONFIG_CONSERVATIVE_QUERY // not supported
+//#define GS_CONFIG_COMPUTE_SHADER // not supported
+//#define GS_CONFIG_MULTI_DRAW_INDIRECT // not supported
+//#define GS_CONFIG_TEXTURE_S3TC // not supported
+//#define GS_CONFIG_TEXTURE_BPTC // not supported
+//#define GS_CONFIG_BINDLESS_TEXTURE // not supported
+//#define GS_CONFIG_ANISOTROPIC_FILTER // not supported
 
 #define GS_CAPS_MULTI_BIND           false
 #define GS_CAPS_MULTI_BLEND          true // core
@@ -29,6 +37,16 @@
 #define GS_CAPS_TEXTURE_FLOAT        true // core
 #define GS_CAPS_TEXTURE_DEPTH        true // core
 #define GS_CAPS_TEXTURE_DEPTHSTENCIL true // core
+#define GS_CAPS_STORAGE_BUFFER       false // not supported
+#define GS_CAPS_CONSERVATIVE_QUERY   false // not supported
+#define GS_CAPS_COMPUTE_SHADER       false // not supported
+#define GS_CAPS_MULTI_DRAW_INDIRECT  false // not supported
+#define GS_CAPS_TEXTURE_VIEW         false // not supported
+#define GS_CAPS_TEXTURE_S3TC         false // not supported
+#define GS_CAPS_TEXTURE_RGTC         true // core
+#define GS_CAPS_TEXTURE_BPTC         false // not supported
+#define GS_CAPS_BINDLESS_TEXTURE     false // not supported
+#define GS_CAPS_ANISOTROPIC_FILTER   false // not supported
 
 // TODO: think about this
 #define glBindTextures(...)
@@ -23,6 +23,14 @@
 #define GS_CONFIG_SEPARATE_VERTEX_FORMAT
 #define GS_CONFIG_SPARSE_TEXTURE
 #define GS_CONFIG_SPARSE_BUFFER
+#define GS_CONFIG_STORAGE_BUFFER
+#define GS_CONFIG_CONSERVATIVE_QUERY
+#define GS_CONFIG_COMPUTE_SHADER
+#define GS_CONFIG_MULTI_DRAW_INDIRECT
+#define GS_CONFIG_TEXTURE_S3TC
+#define GS_CONFIG_TEXTURE_BPTC
+#define GS_CONFIG_BINDLESS_TEXTURE
+#define GS_CONFIG_ANISOTROPIC_FILTER
 
 #define GS_CAPS_MULTI_BIND           (GLEW_ARB_multi_bind != 0)
 #define GS_CAPS_MULTI_BLEND          true // core
@@ -34,3 +42,13 @@
 #define GS_CAPS_COPY_IMAGE           (GLEW_ARB_copy_image != 0)
 #define GS_CAPS_SPARSE_TEXTURE       (GLEW_ARB_sparse_texture != 0)
 #define GS_CAPS_SPARSE_BUFFER        (GLEW_ARB_sparse_buffer != 0)
+#define GS_CAPS_STORAGE_BUFFER       (GLEW_ARB_shader_storage_buffer_object != 0)
+#define GS_CAPS_CONSERVATIVE_QUERY   (GLEW_ARB_ES3_compatibility != 0)
+#define GS_CAPS_COMPUTE_SHADER       (GLEW_ARB_compute_shader != 0)
+#define GS_CAPS_MULTI_DRAW_INDIRECT  (GLEW_ARB_multi_draw_indirect != 0)
+#define GS_CAPS_TEXTURE_VIEW         (GLEW_ARB_texture_view != 0)
+#define GS_CAPS_TEXTURE_S3TC         (GLEW_EXT_texture_compression_s3tc != 0)
+#define GS_CAPS_TEXTURE_RGTC         true // core
+#define GS_CAPS_TEXTURE_BPTC         (GLEW_ARB_texture_compression_bptc != 0)
+#define GS_CAPS_BINDLESS_TEXTURE     (GLEW_ARB_bindless_texture != 0)
+#define GS_CAPS_ANISOTROPIC_FILTER   (GLEW_EXT_texture_filter_anisotropic != 0)
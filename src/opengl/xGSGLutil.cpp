@@ -16,9 +16,11 @@
 #include "xGSstate.h"
 #include "xGStexture.h"
 #include "xGSdatabuffer.h"
+#include "kcommon/c_util.h"
 
 
 using namespace xGS;
+using namespace c_util;
 
 
 #ifdef _DEBUG
@@ -70,6 +72,36 @@ const char* xGS::uniform_type(GLenum type)
 }
 #endif
 
+#ifdef GS_CONFIG_COMPUTE_SHADER
+GLuint xGS::gl_compute_program(const char *source)
+{
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status == GL_FALSE) {
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDetachShader(program, shader);
+    glDeleteShader(shader);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+#endif
+
 
 GSParametersState::GSParametersState() :
     p_uniformblockdata(),
@@ -104,7 +136,7 @@ GSerror GSParametersState::allocate(xGSImpl *impl, xGSStateImpl *state, const GS
             }
 
             const xGSStateImpl::ParameterSlot &slot = state->parameterSlot(slotindex + set.first);
-            if (slot.type != GSPD_BLOCK) {
+            if (slot.type != GSPD_BLOCK && slot.type != GSPD_STORAGEBLOCK) {
                 return GSE_INVALIDENUM;
             }
 
@@ -115,12 +147,17 @@ GSerror GSParametersState::allocate(xGSImpl *impl, xGSStateImpl *state, const GS
                     return GSE_INVALIDVALUE;
                 }
 
+                // storage blocks accept only storage buffers and uniform blocks only uniform buffers
+                if ((slot.type == GSPD_STORAGEBLOCK) != (buffer->target() != GL_UNIFORM_BUFFER)) {
+                    return GSE_INVALIDOBJECT;
+                }
+
                 const xGSDataBufferImpl::UniformBlock &block = buffer->block(binding->block);
 
                 UniformBlockData ub = {
                     GLuint(slot.location),
                     block.offset + block.size * binding->index, block.size,
-                    buffer
+                    buffer, slotindex, binding->block
                 };
                 p_uniformblockdata.push_back(ub);
             }
@@ -193,7 +230,8 @@ GSerror GSParametersState::allocate(xGSImpl *impl, xGSStateImpl *state, const GS
                 ConstantValue cv = {
                     constval->type,
                     slot.location,
-                    memoffset
+                    memoffset,
+                    state->samplerUniform(slot.location)
                 };
 
                 size_t size = 0;
@@ -205,6 +243,7 @@ GSerror GSParametersState::allocate(xGSImpl *impl, xGSStateImpl *state, const GS
                     case GSU_MAT2: size = sizeof(float) * 4; break;
                     case GSU_MAT3: size = sizeof(float) * 9; break;
                     case GSU_MAT4: size = sizeof(float) * 16; break;
+                    case GSU_HANDLE: size = sizeof(GSuint64); break;
 
                     default:
                         return GSE_INVALIDENUM;
@@ -238,7 +277,7 @@ void GSParametersState::apply(const GScaps &caps, xGSImpl *impl, xGSStateImpl *s
 {
     // set up uniform blocks
     for (auto u : p_uniformblockdata) {
-        glBindBufferRange(GL_UNIFORM_BUFFER, u.index, u.buffer->getID(), u.offset, u.size);
+        glBindBufferRange(u.buffer->target(), u.index, u.buffer->getID(), u.offset, u.size);
     }
 
     if (p_textures.size()) {
@@ -297,6 +336,17 @@ void GSParametersState::apply(const GScaps &caps, xGSImpl *impl, xGSStateImpl *s
             case GSU_MAT4:
                 glUniformMatrix4fv(c.location, 1, GL_FALSE, value);
                 break;
+
+            case GSU_HANDLE:
+#ifdef GS_CONFIG_BINDLESS_TEXTURE
+                // sampler declared with bindless_sampler layout accepts only 64-bit handle
+                if (c.sampler) {
+                    glUniformHandleui64ARB(c.location, *reinterpret_cast<const GLuint64*>(value));
+                    break;
+                }
+#endif
+                glUniform2uiv(c.location, 1, reinterpret_cast<const GLuint*>(value));
+                break;
         }
     }
 
@@ -318,6 +368,29 @@ void GSParametersState::apply(const GScaps &caps, xGSImpl *impl, xGSStateImpl *s
 #endif
 }
 
+GSerror GSParametersState::applyblockindices(const GSuint *blockindices)
+{
+    // check all indices first, so nothing is bound in case of invalid index
+    for (auto &u : p_uniformblockdata) {
+        GSuint index = blockindices[u.slot];
+        if (index != GSuint(GS_DEFAULT) && index >= u.buffer->block(u.block).count) {
+            return GSE_INVALIDVALUE;
+        }
+    }
+
+    for (auto &u : p_uniformblockdata) {
+        GSuint index = blockindices[u.slot];
+        if (index == GSuint(GS_DEFAULT)) {
+            glBindBufferRange(u.buffer->target(), u.index, u.buffer->getID(), u.offset, u.size);
+        } else {
+            const xGSDataBufferImpl::UniformBlock &block = u.buffer->block(u.block);
+            glBindBufferRange(u.buffer->target(), u.index, u.buffer->getID(), block.offset + block.size * index, u.size);
+        }
+    }
+
+    return GS_OK;
+}
+
 void GSParametersState::ReleaseRendererResources(xGSImpl *impl)
 {
     for (auto &u : p_uniformblockdata) {
@@ -334,3 +407,175 @@ void GSParametersState::ReleaseRendererResources(xGSImpl *impl)
     }
 }
 
+
+
+GSTransientBuffer::GSTransientBuffer() :
+    p_target(0),
+    p_buffer(0),
+    p_memory(nullptr),
+    p_framesize(0),
+    p_alignment(0),
+    p_frame(0),
+    p_current(0)
+{
+    for (auto &f : p_fences) {
+        f = 0;
+    }
+}
+
+GSerror GSTransientBuffer::allocate(GLenum target, GSuint framesize, GSuint alignment)
+{
+#ifdef GS_CONFIG_BUFFER_STORAGE
+    p_target = target;
+    p_alignment = alignment;
+    p_framesize = align(framesize, alignment);
+    p_frame = 0;
+    p_current = 0;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &p_buffer);
+    glBindBuffer(p_target, p_buffer);
+    glBufferStorage(p_target, p_framesize * FRAMES, nullptr, flags);
+
+    p_memory = glMapBufferRange(p_target, 0, p_framesize * FRAMES, flags);
+    if (p_memory == nullptr) {
+        ReleaseRendererResources();
+        return GSE_OUTOFRESOURCES;
+    }
+
+    return GS_OK;
+#else
+    return GSE_UNSUPPORTED;
+#endif
+}
+
+GSerror GSTransientBuffer::suballocate(GSuint size, GStransientallocation &allocation)
+{
+    if (p_memory == nullptr) {
+        return GSE_INVALIDOPERATION;
+    }
+
+    if (size > p_framesize - p_current) {
+        return GSE_OUTOFRESOURCES;
+    }
+
+    // first allocation in frame region - wait until GPU is done with it
+    if (p_fences[p_frame]) {
+        while (glClientWaitSync(p_fences[p_frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(p_fences[p_frame]);
+        p_fences[p_frame] = 0;
+    }
+
+    allocation.offset = p_framesize * p_frame + p_current;
+    allocation.size = size;
+    allocation.memory = ptr_offset(p_memory, allocation.offset);
+
+    p_current = umin(align(p_current + size, p_alignment), p_framesize);
+
+    return GS_OK;
+}
+
+void GSTransientBuffer::nextframe()
+{
+    if (p_memory == nullptr) {
+        return;
+    }
+
+    // fence only regions which were actually used
+    if (p_current) {
+        p_fences[p_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    p_frame = (p_frame + 1) % FRAMES;
+    p_current = 0;
+}
+
+GSbool GSTransientBuffer::valid(const GStransientallocation &allocation) const
+{
+    if (p_memory == nullptr || allocation.size == 0) {
+        return GS_FALSE;
+    }
+
+    // only already suballocated part of current frame region is valid
+    GSuint start = p_framesize * p_frame;
+    if (allocation.offset < start || allocation.offset - start > p_current) {
+        return GS_FALSE;
+    }
+
+    return
+        allocation.size <= p_current - (allocation.offset - start) &&
+        allocation.memory == ptr_offset(p_memory, allocation.offset);
+}
+
+void GSTransientBuffer::ReleaseRendererResources()
+{
+    for (auto &f : p_fences) {
+        if (f) {
+            glDeleteSync(f);
+            f = 0;
+        }
+    }
+
+    if (p_buffer) {
+        if (p_memory) {
+            glBindBuffer(p_target, p_buffer);
+            glUnmapBuffer(p_target);
+            p_memory = nullptr;
+        }
+        glDeleteBuffers(1, &p_buffer);
+        p_buffer = 0;
+    }
+
+    p_framesize = 0;
+    p_current = 0;
+}
+
+
+GLuint GSStagingPool::acquire(GLenum target, GSuint size, GLenum usage)
+{
+    // smallest free buffer which already had enough storage
+    size_t best = p_buffers.size();
+    for (size_t n = 0; n < p_buffers.size(); ++n) {
+        if (p_buffers[n].size >= size && (best == p_buffers.size() || p_buffers[n].size < p_buffers[best].size)) {
+            best = n;
+        }
+    }
+
+    if (best == p_buffers.size() && !p_buffers.empty()) {
+        best = p_buffers.size() - 1;
+    }
+
+    GLuint buffer = 0;
+    if (best < p_buffers.size()) {
+        buffer = p_buffers[best].buffer;
+        p_buffers.erase(p_buffers.begin() + best);
+    } else {
+        glGenBuffers(1, &buffer);
+    }
+
+    // storage is always respecified, so previous contents are orphaned
+    // and mapping doesn't wait for pending uploads from this buffer
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, nullptr, usage);
+
+    return buffer;
+}
+
+void GSStagingPool::release(GLuint buffer, GSuint size)
+{
+    if (p_buffers.size() < MAX_BUFFERS) {
+        Buffer entry = { buffer, size };
+        p_buffers.push_back(entry);
+    } else {
+        glDeleteBuffers(1, &buffer);
+    }
+}
+
+void GSStagingPool::ReleaseRendererResources()
+{
+    for (auto &b : p_buffers) {
+        glDeleteBuffers(1, &b.buffer);
+    }
+    p_buffers.clear();
+}
@@ -37,6 +37,9 @@ namespace xGS
         GLint  max_texture_units;
         GLint  max_ubo_size;
         GLint  ubo_alignment;
+        GSbool storage_buffer;
+        GLint  max_ssbo_size;
+        GLint  ssbo_alignment;
         GSbool multi_bind;
         GSbool multi_blend;
         GSbool vertex_format;
@@ -44,6 +47,9 @@ namespace xGS
         GSbool texture_float;
         GSbool texture_depth;
         GSbool texture_depthstencil;
+        GSbool texture_s3tc;
+        GSbool texture_rgtc;
+        GSbool texture_bptc;
         GLint  max_draw_buffers;
         GLint  max_texture_size;
         GLint  max_3d_texture_size;
@@ -58,6 +64,13 @@ namespace xGS
         GLint  max_sparse_texture_layers;
         GSbool sparse_buffer;
         GLint  sparse_buffer_pagesize;
+        GSbool conservative_query;
+        GSbool compute_shader;
+        GSbool multi_draw_indirect;
+        GSbool texture_view;
+        GSbool bindless_texture;
+        GSbool anisotropic_filter;
+        GLfloat max_anisotropy;
     };
 
 
@@ -71,6 +84,51 @@ namespace xGS
         return 0;
     }
 
+    inline GLenum gl_vertex_component_type(const GSvertexcomponent &c)
+    {
+        switch (c.type) {
+            case GSVD_POSITION:
+            case GSVD_POSITIONW:
+            case GSVD_VECTOR1:
+            case GSVD_VECTOR2:
+            case GSVD_VECTOR3:
+            case GSVD_VECTOR4:  return GL_FLOAT;
+
+            case GSVD_HALF2:
+            case GSVD_HALF4:    return GL_HALF_FLOAT;
+
+            case GSVD_UBYTE4N:
+            case GSVD_UBYTE4:   return GL_UNSIGNED_BYTE;
+            case GSVD_BYTE4N:   return GL_BYTE;
+
+            case GSVD_USHORT2N:
+            case GSVD_USHORT4N:
+            case GSVD_USHORT2:
+            case GSVD_USHORT4:  return GL_UNSIGNED_SHORT;
+            case GSVD_SHORT2N:
+            case GSVD_SHORT4N:  return GL_SHORT;
+
+            case GSVD_UDEC4N:   return GL_UNSIGNED_INT_2_10_10_10_REV;
+            case GSVD_DEC4N:    return GL_INT_2_10_10_10_REV;
+
+            case GSVD_INT1:
+            case GSVD_INT2:
+            case GSVD_INT3:
+            case GSVD_INT4:     return GL_INT;
+            case GSVD_UINT1:
+            case GSVD_UINT2:
+            case GSVD_UINT3:
+            case GSVD_UINT4:    return GL_UNSIGNED_INT;
+        }
+
+        return 0;
+    }
+
+    inline GLboolean gl_vertex_component_normalized(const GSvertexcomponent &c)
+    {
+        return c.type >= GSVD_UBYTE4N && c.type <= GSVD_DEC4N ? GL_TRUE : GL_FALSE;
+    }
+
     inline GLenum gl_primitive_type(GSenum type)
     {
         switch (type) {
@@ -115,11 +173,47 @@ namespace xGS
         return 0;
     }
 
+    inline GLenum gl_texture_binding(GLenum target)
+    {
+        switch (target) {
+            case GL_TEXTURE_1D:                   return GL_TEXTURE_BINDING_1D;
+            case GL_TEXTURE_1D_ARRAY:             return GL_TEXTURE_BINDING_1D_ARRAY;
+            case GL_TEXTURE_2D:                   return GL_TEXTURE_BINDING_2D;
+            case GL_TEXTURE_2D_ARRAY:             return GL_TEXTURE_BINDING_2D_ARRAY;
+            case GL_TEXTURE_2D_MULTISAMPLE:       return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+            case GL_TEXTURE_2D_MULTISAMPLE_ARRAY: return GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY;
+            case GL_TEXTURE_RECTANGLE:            return GL_TEXTURE_BINDING_RECTANGLE;
+            case GL_TEXTURE_3D:                   return GL_TEXTURE_BINDING_3D;
+            case GL_TEXTURE_CUBE_MAP:             return GL_TEXTURE_BINDING_CUBE_MAP;
+            case GL_TEXTURE_CUBE_MAP_ARRAY:       return GL_TEXTURE_BINDING_CUBE_MAP_ARRAY;
+            case GL_TEXTURE_BUFFER:               return GL_TEXTURE_BINDING_BUFFER;
+        }
+
+        return 0;
+    }
+
+    // cubemap face target for cubemap face lock type
+    inline GLenum gl_cubemap_face(GSenum locktype)
+    {
+        switch (locktype) {
+            case GS_LOCK_CUBEMAPPX: return GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+            case GS_LOCK_CUBEMAPNX: return GL_TEXTURE_CUBE_MAP_NEGATIVE_X;
+            case GS_LOCK_CUBEMAPPY: return GL_TEXTURE_CUBE_MAP_POSITIVE_Y;
+            case GS_LOCK_CUBEMAPNY: return GL_TEXTURE_CUBE_MAP_NEGATIVE_Y;
+            case GS_LOCK_CUBEMAPPZ: return GL_TEXTURE_CUBE_MAP_POSITIVE_Z;
+            case GS_LOCK_CUBEMAPNZ: return GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
+        }
+
+        return 0;
+    }
+
     inline GLenum gl_texture_wrap(GSenum wrap)
     {
         switch (wrap) {
             case GS_WRAP_CLAMP:  return GL_CLAMP_TO_EDGE;
             case GS_WRAP_REPEAT: return GL_REPEAT;
+            case GS_WRAP_MIRROR: return GL_MIRRORED_REPEAT;
+            case GS_WRAP_BORDER: return GL_CLAMP_TO_BORDER;
         }
 
         return 0;
@@ -196,6 +290,60 @@ namespace xGS
         return 0;
     }
 
+    // image unit format for compute shader writes into texture of given internal format,
+    // sRGB texture is written through linear view, 0 - texture can't be written as image
+    inline GLenum gl_image_format(GLenum internalformat)
+    {
+        switch (internalformat) {
+            case GL_RGBA8:        return GL_RGBA8;
+            case GL_SRGB8_ALPHA8: return GL_RGBA8;
+            case GL_RGBA16F:      return GL_RGBA16F;
+            case GL_RGBA32F:      return GL_RGBA32F;
+        }
+
+        return 0;
+    }
+
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    inline GLbitfield gl_barrier_bits(GSuint flags)
+    {
+        GLbitfield result = 0;
+
+        if (flags & GS_BARRIER_VERTEX) {
+            result |= GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_INDEX) {
+            result |= GL_ELEMENT_ARRAY_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_UNIFORM) {
+            result |= GL_UNIFORM_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_TEXTURE) {
+            result |= GL_TEXTURE_FETCH_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_IMAGE) {
+            result |= GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_COMMAND) {
+            result |= GL_COMMAND_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_UPDATE) {
+            result |= GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_FRAMEBUFFER) {
+            result |= GL_FRAMEBUFFER_BARRIER_BIT;
+        }
+        if (flags & GS_BARRIER_STORAGE) {
+            result |= GL_SHADER_STORAGE_BARRIER_BIT;
+        }
+
+        return result;
+    }
+
+    // builds program of single compute shader for internal use, 0 on failure
+    GLuint gl_compute_program(const char *source);
+#endif
+
 #ifdef _DEBUG
     const char* uniform_type(GLenum type);
 #endif
@@ -209,6 +357,7 @@ namespace xGS
 
         GSerror allocate(xGSImpl *impl, xGSStateImpl *state, const GSParameterSet &set, const GSuniformbinding *uniforms, const GStexturebinding *textures, const GSconstantvalue *constants);
         void apply(const GScaps &caps, xGSImpl *impl, xGSStateImpl *state);
+        GSerror applyblockindices(const GSuint *blockindices);
 
         void ReleaseRendererResources(xGSImpl *impl);
 
@@ -219,6 +368,8 @@ namespace xGS
             GSuint             offset;
             GSuint             size;
             xGSDataBufferImpl *buffer;
+            GSuint             slot;   // slot index inside parameter set
+            GSuint             block;  // block index inside data buffer
         };
 
         struct TextureSlot
@@ -232,6 +383,7 @@ namespace xGS
             GSenum type;
             GSenum location;
             size_t offset;
+            GSbool sampler;  // handle is set into bindless sampler uniform
         };
 
         typedef std::vector<UniformBlockData> UniformBlockDataSet;
@@ -251,4 +403,69 @@ namespace xGS
         ConstantMemory      p_constantmemory;
     };
 
+
+    // transient data ring buffer
+    //      persistently mapped buffer divided into several per-frame regions
+    //      memory is suballocated linearly from current frame region, every region
+    //      is fenced at frame end and waited for before its memory is reused
+    class GSTransientBuffer
+    {
+    public:
+        GSTransientBuffer();
+
+        GSerror allocate(GLenum target, GSuint framesize, GSuint alignment);
+        GSerror suballocate(GSuint size, GStransientallocation &allocation);
+        void nextframe();
+
+        GSbool valid(const GStransientallocation &allocation) const;
+
+        GLuint getID() const { return p_buffer; }
+        GLenum target() const { return p_target; }
+
+        void ReleaseRendererResources();
+
+    private:
+        enum
+        {
+            FRAMES = 3
+        };
+
+    private:
+        GLenum p_target;
+        GLuint p_buffer;
+        GSptr  p_memory;
+        GSuint p_framesize;
+        GSuint p_alignment;
+        GSuint p_frame;
+        GSuint p_current;
+        GLsync p_fences[FRAMES];
+    };
+
+
+    // pixel buffers for texture image locks, buffer objects are kept
+    // between locks instead of being created and deleted for every lock
+    class GSStagingPool
+    {
+    public:
+        GLuint acquire(GLenum target, GSuint size, GLenum usage);
+        void release(GLuint buffer, GSuint size);
+
+        void ReleaseRendererResources();
+
+    private:
+        enum
+        {
+            MAX_BUFFERS = 8
+        };
+
+        struct Buffer
+        {
+            GLuint buffer;
+            GSuint size;
+        };
+
+    private:
+        std::vector<Buffer> p_buffers;
+    };
+
 } // namespace xGS
@@ -0,0 +1,363 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGScomputestate.cpp
+        Compute state object implementation class
+*/
+
+#include "xGScomputestate.h"
+#include "xGSimpl.h"
+#include "xGSdatabuffer.h"
+#include "xGStexture.h"
+
+
+using namespace xGS;
+using namespace std;
+
+
+static GLenum gl_image_access(GSuint access)
+{
+    switch (access) {
+        case GS_READ:      return GL_READ_ONLY;
+        case GS_WRITE:     return GL_WRITE_ONLY;
+        case GS_READWRITE: return GL_READ_WRITE;
+    }
+
+    return 0;
+}
+
+
+xGSComputeStateImpl::xGSComputeStateImpl(xGSImpl *owner) :
+    xGSObjectBase(owner),
+    p_program(0)
+{
+    p_groupsize[0] = p_groupsize[1] = p_groupsize[2] = 0;
+}
+
+xGSComputeStateImpl::~xGSComputeStateImpl()
+{}
+
+GSbool xGSComputeStateImpl::AllocateImpl(const GScomputestatedescription &desc, const GScomputeparameterlayout *staticparams)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    if (!p_owner->caps().compute_shader) {
+        return p_owner->error(GSE_UNSUPPORTED);
+    }
+
+    std::vector<GLuint> shaders;
+    GSerror result = AttachShaders(desc.shader, shaders);
+
+    if (result != GS_OK) {
+        for (auto s : shaders) {
+            glDeleteShader(s);
+        }
+        return p_owner->error(result);
+    }
+
+    p_program = glCreateProgram();
+
+    for (auto s : shaders) {
+        glAttachShader(p_program, s);
+    }
+
+    glLinkProgram(p_program);
+
+    for (auto s : shaders) {
+        glDetachShader(p_program, s);
+        glDeleteShader(s);
+    }
+
+#ifdef _DEBUG
+    {
+        GLsizei loglen = 0;
+        char infoLog[1024];
+        glGetProgramInfoLog(p_program, 1024, &loglen, infoLog);
+        infoLog[loglen] = 0;
+        p_owner->debug(DebugMessageLevel::Information, "Compute program info log:\n%s\n\n", infoLog);
+    }
+
+    p_owner->debugTrackGLError("xGSComputeStateImpl::Allocate");
+#endif
+
+    GLint status = 0;
+    glGetProgramiv(p_program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        p_owner->debug(DebugMessageLevel::Error, "Compute program failed to link!\n");
+        return p_owner->error(GSE_INVALIDOPERATION);
+    }
+
+    glGetProgramiv(p_program, GL_COMPUTE_WORK_GROUP_SIZE, p_groupsize);
+    p_owner->debug(
+        DebugMessageLevel::Information,
+        "Compute program work group size: %i x %i x %i\n",
+        p_groupsize[0], p_groupsize[1], p_groupsize[2]
+    );
+
+    if (staticparams) {
+        ResolveParameters(staticparams->parameters);
+
+        result = BindStaticParameters(staticparams);
+        if (result != GS_OK) {
+            // nothing was referenced yet
+            p_blocks.clear();
+            p_images.clear();
+            return p_owner->error(result);
+        }
+    }
+
+    return p_owner->error(GS_OK);
+#else
+    return p_owner->error(GSE_UNSUPPORTED);
+#endif
+}
+
+void xGSComputeStateImpl::apply()
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    glUseProgram(p_program);
+
+    for (auto &b : p_blocks) {
+        glBindBufferRange(b.target, b.index, b.buffer->getID(), b.offset, b.size);
+    }
+
+    for (auto &i : p_images) {
+        glBindImageTexture(
+            i.unit, i.texture->getID(), i.level,
+            i.layered, i.layer, i.access, i.format
+        );
+    }
+#endif
+}
+
+void xGSComputeStateImpl::ReleaseRendererResources()
+{
+    if (p_program) {
+        glDeleteProgram(p_program);
+        p_program = 0;
+    }
+
+    for (auto &b : p_blocks) {
+        b.buffer->Release();
+    }
+    p_blocks.clear();
+
+    for (auto &i : p_images) {
+        i.texture->Release();
+    }
+    p_images.clear();
+}
+
+GSerror xGSComputeStateImpl::AttachShaders(const char **source, vector<GLuint> &shaders)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    while (*source) {
+        GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, source, nullptr);
+        glCompileShader(shader);
+
+#ifdef _DEBUG
+        GLsizei loglen = 0;
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, 1024, &loglen, infoLog);
+        infoLog[loglen] = 0;
+        if (loglen) {
+            p_owner->debug(DebugMessageLevel::Information, "Shader info log:\n%s\n", infoLog);
+        }
+#endif
+
+        GLint status = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status == GL_FALSE) {
+            p_owner->debug(DebugMessageLevel::Error, "Compute shader failed to compile!\n");
+            glDeleteShader(shader);
+            return GSE_INVALIDOPERATION;
+        }
+
+        shaders.push_back(shader);
+
+        ++source;
+    }
+#endif
+
+    return GS_OK;
+}
+
+void xGSComputeStateImpl::ResolveParameters(const GSparameterdecl *params)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    // blocks found by name get binding points equal to their indices,
+    // so they're bound by index without relying on shader layout qualifiers
+    GSuint currentslot = 0;
+
+    const GSparameterdecl *param = params;
+    while (param->type != GSPD_END) {
+        auto &slot = p_parameterslots[currentslot++];
+        switch (slot.type) {
+            case GSPD_BLOCK:
+                if (slot.location == GS_DEFAULT) {
+                    slot.location = glGetUniformBlockIndex(p_program, param->name);
+                    if (slot.location != GS_DEFAULT) {
+                        glUniformBlockBinding(p_program, slot.location, slot.location);
+                    }
+                }
+                break;
+
+            case GSPD_STORAGEBLOCK:
+                if (slot.location == GS_DEFAULT) {
+                    slot.location = glGetProgramResourceIndex(p_program, GL_SHADER_STORAGE_BLOCK, param->name);
+                    if (slot.location != GS_DEFAULT) {
+                        glShaderStorageBlockBinding(p_program, slot.location, slot.location);
+                    }
+                }
+                break;
+
+            case GSPD_IMAGE: {
+                // slot location holds image unit allocated for this slot
+                GSint location = param->location == GS_DEFAULT ?
+                    glGetUniformLocation(p_program, param->name) : param->location;
+                if (location != GS_DEFAULT) {
+                    glProgramUniform1i(p_program, location + param->index, slot.location);
+
+                    p_owner->debug(
+                        DebugMessageLevel::Information,
+                        "Compute program image \"%s\" with location %i got image unit #%i\n",
+                        param->name, location + param->index, slot.location
+                    );
+                } else {
+                    slot.location = GS_DEFAULT;
+                }
+                break;
+            }
+        }
+
+        if (slot.location == GS_DEFAULT) {
+            p_owner->debug(DebugMessageLevel::Warning, "Requested parameter \"%s\" not found in compute program parameters\n", param->name);
+        }
+
+        ++param;
+    }
+#endif
+}
+
+GSerror xGSComputeStateImpl::BindStaticParameters(const GScomputeparameterlayout *params)
+{
+    GSuint slotcount = parameterSlotCount();
+
+    // bind uniform and storage blocks
+    if (params->uniforms) {
+        const GSuniformbinding *binding = params->uniforms;
+        while (binding->slot != GSPS_END) {
+            GSuint slotindex = binding->slot - GSPS_0;
+            if (slotindex >= slotcount) {
+                return GSE_INVALIDVALUE;
+            }
+
+            const ParameterSlot &slot = parameterSlot(slotindex);
+            if (slot.type != GSPD_BLOCK && slot.type != GSPD_STORAGEBLOCK) {
+                return GSE_INVALIDENUM;
+            }
+
+            if (binding->buffer == nullptr) {
+                return GSE_INVALIDOBJECT;
+            }
+
+            if (slot.location != GS_DEFAULT) {
+                xGSDataBufferImpl *buffer = static_cast<xGSDataBufferImpl*>(binding->buffer);
+
+                if (binding->block >= buffer->blockCount()) {
+                    return GSE_INVALIDVALUE;
+                }
+
+                // storage blocks accept only storage buffers and uniform blocks only uniform buffers
+                if ((slot.type == GSPD_STORAGEBLOCK) != (buffer->target() != GL_UNIFORM_BUFFER)) {
+                    return GSE_INVALIDOBJECT;
+                }
+
+                const xGSDataBufferImpl::UniformBlock &block = buffer->block(binding->block);
+
+                BlockBinding b = {
+                    buffer->target(), GLuint(slot.location),
+                    block.offset + block.size * binding->index, block.size,
+                    buffer
+                };
+                p_blocks.push_back(b);
+            }
+
+            ++binding;
+        }
+    }
+
+    // bind images
+    if (params->images) {
+        const GSimagebinding *binding = params->images;
+        while (binding->slot != GSPS_END) {
+            GSuint slotindex = binding->slot - GSPS_0;
+            if (slotindex >= slotcount) {
+                return GSE_INVALIDVALUE;
+            }
+
+            const ParameterSlot &slot = parameterSlot(slotindex);
+            if (slot.type != GSPD_IMAGE) {
+                return GSE_INVALIDENUM;
+            }
+
+            if (binding->texture == nullptr) {
+                return GSE_INVALIDOBJECT;
+            }
+
+            if (slot.location != GS_DEFAULT) {
+                xGSTextureImpl *texture = static_cast<xGSTextureImpl*>(binding->texture);
+
+                GLenum access = gl_image_access(binding->access);
+                if (access == 0) {
+                    return GSE_INVALIDENUM;
+                }
+
+                if (binding->level > texture->maxLevel()) {
+                    return GSE_INVALIDVALUE;
+                }
+
+                xGSImpl::TextureFormatDescriptor descriptor;
+                GSenum format = binding->format == GS_COLOR_DEFAULT ? texture->format() : binding->format;
+                if (!p_owner->GetTextureFormatDescriptor(format, descriptor)) {
+                    return GSE_INVALIDENUM;
+                }
+
+                // not every texture format could be bound as image
+                GLenum imageformat = gl_image_format(descriptor.GLIntFormat);
+                if (imageformat == 0) {
+                    return GSE_INVALIDENUM;
+                }
+
+                bool layered = binding->layer == GSuint(GS_DEFAULT);
+
+                ImageBinding i = {
+                    GLuint(slot.location), texture,
+                    GLint(binding->level),
+                    GLboolean(layered ? GL_TRUE : GL_FALSE),
+                    layered ? 0 : GLint(binding->layer),
+                    access, imageformat
+                };
+                p_images.push_back(i);
+            }
+
+            ++binding;
+        }
+    }
+
+    for (auto &b : p_blocks) {
+        b.buffer->AddRef();
+    }
+
+    for (auto &i : p_images) {
+        i.texture->AddRef();
+    }
+
+    return GS_OK;
+}
@@ -0,0 +1,77 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGScomputestate.h
+        Compute state object implementation class header
+            compute state object holds compute shader program
+            and its static resource bindings
+*/
+
+#pragma once
+
+#include "xGSimplbase.h"
+#include "xGSGLutil.h"
+#include <vector>
+
+
+namespace xGS
+{
+
+    // compute program object
+    class xGSComputeStateImpl : public xGSObjectBase<xGSComputeStateBase, xGSImpl>
+    {
+    public:
+        xGSComputeStateImpl(xGSImpl *owner);
+        ~xGSComputeStateImpl() override;
+
+    public:
+        GSbool AllocateImpl(const GScomputestatedescription &desc, const GScomputeparameterlayout *staticparams);
+
+        void apply();
+
+        void ReleaseRendererResources();
+
+    private:
+        GSerror AttachShaders(const char **source, std::vector<GLuint> &shaders);
+        void ResolveParameters(const GSparameterdecl *params);
+        GSerror BindStaticParameters(const GScomputeparameterlayout *params);
+
+    private:
+        struct BlockBinding
+        {
+            GLenum             target;
+            GLuint             index;
+            GSuint             offset;
+            GSuint             size;
+            xGSDataBufferImpl *buffer;
+        };
+
+        struct ImageBinding
+        {
+            GLuint          unit;
+            xGSTextureImpl *texture;
+            GLint           level;
+            GLboolean       layered;
+            GLint           layer;
+            GLenum          access;
+            GLenum          format;
+        };
+
+        typedef std::vector<BlockBinding> BlockBindingList;
+        typedef std::vector<ImageBinding> ImageBindingList;
+
+    private:
+        GLuint           p_program;
+        GLint            p_groupsize[3];
+
+        BlockBindingList p_blocks;
+        ImageBindingList p_images;
+    };
+
+} // namespace xGS
@@ -30,14 +30,31 @@ GSbool xGSDataBufferImpl::AllocateImpl(const GSdatabufferdescription &desc, GSui
 {
     switch (desc.type) {
         case GSDT_UNIFORM: p_target = GL_UNIFORM_BUFFER; break;
+
+        case GSDT_STORAGE:
+#ifdef GS_CONFIG_STORAGE_BUFFER
+            if (!p_owner->caps().storage_buffer) {
+                return GS_FALSE;
+            }
+            p_target = GL_SHADER_STORAGE_BUFFER;
+            break;
+#else
+            return GS_FALSE;
+#endif
     }
 
     glGenBuffers(1, &p_buffer);
     glBindBuffer(p_target, p_buffer);
+    // storage buffer could be written by shaders and read back
 #ifdef GS_CONFIG_BUFFER_STORAGE
-    glBufferStorage(p_target, p_size, nullptr, GL_MAP_WRITE_BIT | GL_DYNAMIC_STORAGE_BIT);
+    GLbitfield storageflags = GL_MAP_WRITE_BIT | GL_DYNAMIC_STORAGE_BIT;
+    if (desc.type == GSDT_STORAGE) {
+        storageflags |= GL_MAP_READ_BIT;
+    }
+    glBufferStorage(p_target, p_size, nullptr, storageflags);
 #else
-    glBufferData(p_target, p_size, nullptr, GL_STREAM_DRAW);
+    GLenum usage = desc.type == GSDT_STORAGE ? GL_DYNAMIC_COPY : GL_STREAM_DRAW;
+    glBufferData(p_target, p_size, nullptr, usage);
 #endif
 
     return GS_TRUE;
@@ -51,12 +68,27 @@ void xGSDataBufferImpl::UpdateImpl(GSuint offset, GSuint size, const GSptr data)
 
 GSptr xGSDataBufferImpl::LockImpl(GSdword access)
 {
-    p_locktype = GS_LOCKED;
+    GLenum glaccess = GL_WRITE_ONLY;
+    switch (access) {
+        case GS_READ:      glaccess = GL_READ_ONLY; break;
+        case GS_READWRITE: glaccess = GL_READ_WRITE; break;
+    }
 
-    // TODO: access
+#ifdef GS_CONFIG_STORAGE_BUFFER
+    // make shader writes visible before reading buffer data back
+    if ((access & GS_READ) && p_target == GL_SHADER_STORAGE_BUFFER) {
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+#endif
 
     glBindBuffer(p_target, p_buffer);
-    return glMapBuffer(p_target, GL_WRITE_ONLY);
+    GSptr result = glMapBuffer(p_target, glaccess);
+
+    if (result) {
+        p_locktype = GS_LOCKED;
+    }
+
+    return result;
 }
 
 void xGSDataBufferImpl::UnlockImpl()
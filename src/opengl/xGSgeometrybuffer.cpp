@@ -23,7 +23,10 @@ using namespace c_util;
 xGSGeometryBufferImpl::xGSGeometryBufferImpl(xGSImpl *owner) :
     xGSObjectBase(owner),
     p_vertexbuffer(0),
-    p_indexbuffer(0)
+    p_indexbuffer(0),
+    p_lockoffset(0),
+    p_locksize(0),
+    p_lockmemory(nullptr)
 {}
 
 xGSGeometryBufferImpl::~xGSGeometryBufferImpl()
@@ -91,32 +94,68 @@ GSbool xGSGeometryBufferImpl::allocate(const GSgeometrybufferdescription &desc)
     }
 #endif
 
+    if ((desc.flags & (GS_GBFLAG_NARROWINDICES | GS_GBFLAG_SPARSE)) && desc.type != GS_GBTYPE_GEOMETRYHEAP) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    // sparse heap needs immutable storage, its pages are committed by geometries,
+    // sparse storage can't be mapped, so data is updated with glBufferSubData
+    if (desc.flags & GS_GBFLAG_SPARSE) {
+#if defined(GS_CONFIG_BUFFER_STORAGE) && defined(GS_CONFIG_SPARSE_BUFFER)
+        if (!glBufferStorage || !p_owner->caps().sparse_buffer) {
+            return p_owner->error(GSE_UNSUPPORTED);
+        }
+
+        usage = GL_SPARSE_STORAGE_BIT_ARB | GL_DYNAMIC_STORAGE_BIT;
+        p_pagesize = p_owner->caps().sparse_buffer_pagesize;
+#else
+        return p_owner->error(GSE_UNSUPPORTED);
+#endif
+    }
+
     p_type = desc.type;
 
     p_vertexdecl = GSvertexdecl(desc.vertexdecl);
     p_indexformat = desc.indexformat;
 
+    // narrowing makes sense only for 32-bit heap
+    p_narrowindices = (desc.flags & GS_GBFLAG_NARROWINDICES) && p_indexformat == GS_INDEX_32;
+
     p_vertexcount = desc.vertexcount;
     p_indexcount = p_indexformat != GS_INDEX_NONE ? desc.indexcount : 0;
 
+    GSuint vertexbytes = p_vertexdecl.buffer_size(p_vertexcount);
+    GSuint indexbytes = index_buffer_size(p_indexformat, p_indexcount);
+
+    // sparse buffer size is rounded up to whole pages
+    if (p_pagesize) {
+        vertexbytes = align(vertexbytes, p_pagesize);
+        indexbytes = align(indexbytes, p_pagesize);
+        p_vertexpages.assign(vertexbytes / p_pagesize, 0);
+        p_indexpages.assign(indexbytes / p_pagesize, 0);
+    }
+
     glGenBuffers(1, &p_vertexbuffer);
     glBindBuffer(GL_ARRAY_BUFFER, p_vertexbuffer);
 
 #ifdef GS_CONFIG_BUFFER_STORAGE
     if (glBufferStorage) {
         glBufferStorage(
-            GL_ARRAY_BUFFER, p_vertexdecl.buffer_size(p_vertexcount),
+            GL_ARRAY_BUFFER, vertexbytes,
             nullptr, usage
         );
+        if (!immutableStorage(GL_ARRAY_BUFFER)) {
+            return p_owner->error(GSE_OUTOFRESOURCES);
+        }
     } else {
         glBufferData(
-            GL_ARRAY_BUFFER, p_vertexdecl.buffer_size(p_vertexcount),
+            GL_ARRAY_BUFFER, vertexbytes,
             nullptr, usage
         );
     }
 #else
     glBufferData(
-        GL_ARRAY_BUFFER, p_vertexdecl.buffer_size(p_vertexcount),
+        GL_ARRAY_BUFFER, vertexbytes,
         nullptr, usage
     );
 #endif
@@ -128,18 +167,21 @@ GSbool xGSGeometryBufferImpl::allocate(const GSgeometrybufferdescription &desc)
 #ifdef GS_CONFIG_BUFFER_STORAGE
         if (glBufferStorage) {
             glBufferStorage(
-                GL_ELEMENT_ARRAY_BUFFER, index_buffer_size(p_indexformat, p_indexcount),
+                GL_ELEMENT_ARRAY_BUFFER, indexbytes,
                 nullptr, usage
             );
+            if (!immutableStorage(GL_ELEMENT_ARRAY_BUFFER)) {
+                return p_owner->error(GSE_OUTOFRESOURCES);
+            }
         } else {
             glBufferData(
-                GL_ELEMENT_ARRAY_BUFFER, index_buffer_size(p_indexformat, p_indexcount),
+                GL_ELEMENT_ARRAY_BUFFER, indexbytes,
                 nullptr, usage
             );
         }
 #else
         glBufferData(
-            GL_ELEMENT_ARRAY_BUFFER, index_buffer_size(p_indexformat, p_indexcount),
+            GL_ELEMENT_ARRAY_BUFFER, indexbytes,
             nullptr, usage
         );
 #endif
@@ -153,6 +195,15 @@ GSptr xGSGeometryBufferImpl::LockImpl(GSenum locktype, size_t offset, size_t siz
     // NOTE: locktype must be valid here and all checks should be passed
     p_locktype = locktype;
 
+    // sparse buffer can't be mapped, locked data is written into
+    // system memory and copied into buffer on unlock
+    if (sparse()) {
+        p_lockoffset = offset;
+        p_locksize = size;
+        p_lockmemory = p_owner->allocate(GSuint(size));
+        return p_lockmemory;
+    }
+
     switch (locktype) {
         case GS_LOCK_VERTEXDATA:
             glBindBuffer(GL_ARRAY_BUFFER, p_vertexbuffer);
@@ -176,8 +227,29 @@ GSptr xGSGeometryBufferImpl::LockImpl(GSenum locktype, size_t offset, size_t siz
     return nullptr;
 }
 
+void xGSGeometryBufferImpl::CommitPagesImpl(GSenum locktype, GSuint offset, GSuint size, bool commit)
+{
+#ifdef GS_CONFIG_SPARSE_BUFFER
+    // copy target is used, so index buffer binding of current input is left intact
+    glBindBuffer(GL_COPY_WRITE_BUFFER, locktype == GS_LOCK_VERTEXDATA ? p_vertexbuffer : p_indexbuffer);
+    glBufferPageCommitmentARB(GL_COPY_WRITE_BUFFER, offset, size, commit);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+#endif
+}
+
 void xGSGeometryBufferImpl::UnlockImpl()
 {
+    if (p_lockmemory) {
+        // copy target is used, so index buffer binding of current input is left intact
+        glBindBuffer(GL_COPY_WRITE_BUFFER, p_locktype == GS_LOCK_VERTEXDATA ? p_vertexbuffer : p_indexbuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, p_lockoffset, p_locksize, p_lockmemory);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        p_owner->free(p_lockmemory);
+        p_locktype = GS_NONE;
+        return;
+    }
+
     switch (p_locktype) {
         case GS_LOCK_VERTEXDATA:
             glBindBuffer(GL_ARRAY_BUFFER, p_vertexbuffer);
@@ -214,8 +286,22 @@ void xGSGeometryBufferImpl::EndImmediateDrawingImpl()
      }
 }
 
+#ifdef GS_CONFIG_BUFFER_STORAGE
+bool xGSGeometryBufferImpl::immutableStorage(GLenum target)
+{
+    // glBufferStorage leaves buffer mutable and empty when it fails
+    GLint immutable = GL_FALSE;
+    glGetBufferParameteriv(target, GL_BUFFER_IMMUTABLE_STORAGE, &immutable);
+    return immutable != GL_FALSE;
+}
+#endif
+
 void xGSGeometryBufferImpl::ReleaseRendererResources()
 {
+    if (p_lockmemory) {
+        p_owner->free(p_lockmemory);
+    }
+
     if (p_vertexbuffer) {
         glDeleteBuffers(1, &p_vertexbuffer);
         p_vertexbuffer = 0;
@@ -37,14 +37,26 @@ namespace xGS
         GSptr LockImpl(GSenum locktype, size_t offset, size_t size);
         void UnlockImpl();
 
+        void CommitPagesImpl(GSenum locktype, GSuint offset, GSuint size, bool commit);
+
         void BeginImmediateDrawingImpl();
         void EndImmediateDrawingImpl();
 
         void ReleaseRendererResources();
 
+    private:
+#ifdef GS_CONFIG_BUFFER_STORAGE
+        static bool immutableStorage(GLenum target);
+#endif
+
     private:
         GLuint p_vertexbuffer;
         GLuint p_indexbuffer;
+
+        // sparse buffer lock data
+        size_t p_lockoffset;
+        size_t p_locksize;
+        GSptr  p_lockmemory;
     };
 
 } // namespace xGS
@@ -20,6 +20,8 @@
 #include "xGSstate.h"
 #include "xGSinput.h"
 #include "xGSparameters.h"
+#include "xGSquery.h"
+#include "xGScomputestate.h"
 
 #ifdef _DEBUG
     #ifdef WIN32
@@ -176,6 +178,9 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
     p_caps.texture_float        = GS_CAPS_TEXTURE_FLOAT;
     p_caps.texture_depth        = GS_CAPS_TEXTURE_DEPTH;
     p_caps.texture_depthstencil = GS_CAPS_TEXTURE_DEPTHSTENCIL;
+    p_caps.texture_s3tc         = GS_CAPS_TEXTURE_S3TC;
+    p_caps.texture_rgtc         = GS_CAPS_TEXTURE_RGTC;
+    p_caps.texture_bptc         = GS_CAPS_TEXTURE_BPTC;
     glGetIntegerv(GL_MAX_DRAW_BUFFERS, &p_caps.max_draw_buffers);
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &p_caps.max_texture_size);
     glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE,  &p_caps.max_3d_texture_size);
@@ -196,6 +201,27 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
 #endif
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &p_caps.ubo_alignment);
     glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &p_caps.max_ubo_size);
+    p_caps.storage_buffer       = GS_CAPS_STORAGE_BUFFER;
+    p_caps.ssbo_alignment       = 0;
+    p_caps.max_ssbo_size        = 0;
+    p_caps.conservative_query   = GS_CAPS_CONSERVATIVE_QUERY;
+    p_caps.compute_shader       = GS_CAPS_COMPUTE_SHADER;
+    p_caps.multi_draw_indirect  = GS_CAPS_MULTI_DRAW_INDIRECT;
+    p_caps.texture_view         = GS_CAPS_TEXTURE_VIEW;
+    p_caps.bindless_texture     = GS_CAPS_BINDLESS_TEXTURE;
+    p_caps.anisotropic_filter   = GS_CAPS_ANISOTROPIC_FILTER;
+    p_caps.max_anisotropy       = 1.0f;
+#ifdef GS_CONFIG_ANISOTROPIC_FILTER
+    if (p_caps.anisotropic_filter) {
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &p_caps.max_anisotropy);
+    }
+#endif
+#ifdef GS_CONFIG_STORAGE_BUFFER
+    if (p_caps.storage_buffer) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &p_caps.ssbo_alignment);
+        glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &p_caps.max_ssbo_size);
+    }
+#endif
 
 #ifdef _DEBUG
     debug(DebugMessageLevel::Information, "CAPS: max_active_attribs:        %i\n", p_caps.max_active_attribs);
@@ -205,10 +231,16 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
     debug(DebugMessageLevel::Information, "CAPS: vertex format:             %s\n", p_caps.vertex_format ? "Yes" : "No");
     debug(DebugMessageLevel::Information, "CAPS: ubo_alignment:             %i\n", p_caps.ubo_alignment);
     debug(DebugMessageLevel::Information, "CAPS: max_ubo_size:              %i\n", p_caps.max_ubo_size);
+    debug(DebugMessageLevel::Information, "CAPS: storage buffer:            %s\n", p_caps.storage_buffer ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: ssbo_alignment:            %i\n", p_caps.ssbo_alignment);
+    debug(DebugMessageLevel::Information, "CAPS: max_ssbo_size:             %i\n", p_caps.max_ssbo_size);
     debug(DebugMessageLevel::Information, "CAPS: texture sRGB:              %s\n", p_caps.texture_srgb ? "Yes" : "No");
     debug(DebugMessageLevel::Information, "CAPS: texture float:             %s\n", p_caps.texture_float ? "Yes" : "No");
     debug(DebugMessageLevel::Information, "CAPS: texture depth:             %s\n", p_caps.texture_depth ? "Yes" : "No");
     debug(DebugMessageLevel::Information, "CAPS: texture depthstencil:      %s\n", p_caps.texture_depthstencil ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: texture S3TC:              %s\n", p_caps.texture_s3tc ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: texture RGTC:              %s\n", p_caps.texture_rgtc ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: texture BPTC:              %s\n", p_caps.texture_bptc ? "Yes" : "No");
     debug(DebugMessageLevel::Information, "CAPS: max_draw_buffers:          %i\n", p_caps.max_draw_buffers);
     debug(DebugMessageLevel::Information, "CAPS: max_texture_size:          %i\n", p_caps.max_texture_size);
     debug(DebugMessageLevel::Information, "CAPS: max_3d_texture_size:       %i\n", p_caps.max_3d_texture_size);
@@ -223,6 +255,13 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
     debug(DebugMessageLevel::Information, "CAPS: max_sparse_texture_layers: %i\n", p_caps.max_sparse_texture_layers);
     debug(DebugMessageLevel::Information, "CAPS: sparse buffer:             %s\n", p_caps.sparse_buffer ? "Yes" : "No");
     debug(DebugMessageLevel::Information, "CAPS: sparse_buffer_pagesize:    %i\n", p_caps.sparse_buffer_pagesize);
+    debug(DebugMessageLevel::Information, "CAPS: conservative query:        %s\n", p_caps.conservative_query ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: compute shader:            %s\n", p_caps.compute_shader ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: multi draw indirect:       %s\n", p_caps.multi_draw_indirect ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: texture view:              %s\n", p_caps.texture_view ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: bindless texture:          %s\n", p_caps.bindless_texture ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: anisotropic filter:        %s\n", p_caps.anisotropic_filter ? "Yes" : "No");
+    debug(DebugMessageLevel::Information, "CAPS: max_anisotropy:            %f\n", p_caps.max_anisotropy);
 #endif
 
     AddTextureFormatDescriptor(GS_COLOR_RGBX, 4, GL_RGB8, GL_BGRA, GL_UNSIGNED_BYTE);
@@ -244,6 +283,27 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
     if (p_caps.texture_depthstencil) {
         AddTextureFormatDescriptor(GS_DEPTHSTENCIL_D24S8, 4, GL_DEPTH24_STENCIL8, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
     }
+    // block compressed formats have no bytes per pixel, image size is computed from blocks
+#ifdef GS_CONFIG_TEXTURE_S3TC
+    if (p_caps.texture_s3tc) {
+        AddTextureFormatDescriptor(GS_COLOR_BC1, 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_RGBA, GL_UNSIGNED_BYTE);
+        AddTextureFormatDescriptor(GS_COLOR_BC3, 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, GL_UNSIGNED_BYTE);
+        if (p_caps.texture_srgb) {
+            AddTextureFormatDescriptor(GS_COLOR_S_BC1, 0, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, GL_RGBA, GL_UNSIGNED_BYTE);
+            AddTextureFormatDescriptor(GS_COLOR_S_BC3, 0, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_RGBA, GL_UNSIGNED_BYTE);
+        }
+    }
+#endif
+    if (p_caps.texture_rgtc) {
+        AddTextureFormatDescriptor(GS_COLOR_BC4, 0, GL_COMPRESSED_RED_RGTC1, GL_RED, GL_UNSIGNED_BYTE);
+        AddTextureFormatDescriptor(GS_COLOR_BC5, 0, GL_COMPRESSED_RG_RGTC2, GL_RG, GL_UNSIGNED_BYTE);
+    }
+#ifdef GS_CONFIG_TEXTURE_BPTC
+    if (p_caps.texture_bptc) {
+        AddTextureFormatDescriptor(GS_COLOR_BC7, 0, GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA, GL_UNSIGNED_BYTE);
+        AddTextureFormatDescriptor(GS_COLOR_S_BC7, 0, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, GL_RGBA, GL_UNSIGNED_BYTE);
+    }
+#endif
 
     // turn sRGB for default frame buffer if framebuffer was created with sRGB support
     if (p_context->RenderTargetFormat().pfSRGB) {
@@ -261,6 +321,15 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
     p_opentimerqueries = 0;
     p_timerscount = 0;
 
+    if (desc.transientsize) {
+        p_error = p_transientbuffer.allocate(GL_UNIFORM_BUFFER, desc.transientsize, p_caps.ubo_alignment);
+        if (p_error != GS_OK) {
+            glDeleteQueries(1, &p_capturequery);
+            p_context->DestroyRenderer();
+            return;
+        }
+    }
+
 
 #ifdef _DEBUG
     debugTrackGLError("xGSImpl::CreateRenderer");
@@ -271,61 +340,64 @@ void xGSImpl::CreateRendererImpl(const GSrendererdescription &desc)
 
 void xGSImpl::DestroyRendererImpl()
 {
-    for (auto &sampler : p_samplerlist) {
-        glDeleteSamplers(1, &sampler.sampler);
+    for (auto &cached : p_samplercache) {
+        glDeleteSamplers(1, &cached.second.sampler);
     }
+    p_samplercache.clear();
+    p_samplerlist.clear();
     glDeleteQueries(1, &p_capturequery);
     glDeleteQueries(p_timerscount, p_timerqueries);
+    p_occlusionculler.ReleaseRendererResources();
+    p_mipgenerator.ReleaseRendererResources();
+
+    p_transientbuffer.ReleaseRendererResources();
+    p_stagingpool.ReleaseRendererResources();
 
     p_context->DestroyRenderer();
 }
 
 void xGSImpl::CreateSamplersImpl(const GSsamplerdescription *samplers, GSuint count)
 {
-    for (auto &s : p_samplerlist) {
-        glDeleteSamplers(1, &s.sampler);
-    }
-
-    p_samplerlist.resize(count);
+    // new samplers are cached before old ones are released, so sampler
+    // objects with descriptions present in both lists are kept
+    SamplerList list(count);
     for (size_t n = 0; n < count; ++n) {
-        Sampler &s = p_samplerlist[n];
+        Sampler &s = list[n];
 
-        glGenSamplers(1, &s.sampler);
+        s.sampler = CacheSampler(samplers[n]);
         s.refcount = 0;
+    }
 
-        // TODO: check values
-
-        glSamplerParameteri(s.sampler, GL_TEXTURE_WRAP_S, gl_texture_wrap(samplers->wrapu));
-        glSamplerParameteri(s.sampler, GL_TEXTURE_WRAP_T, gl_texture_wrap(samplers->wrapv));
-        glSamplerParameteri(s.sampler, GL_TEXTURE_WRAP_R, gl_texture_wrap(samplers->wrapw));
-
-        glSamplerParameteri(s.sampler, GL_TEXTURE_MIN_LOD, samplers->minlod);
-        glSamplerParameteri(s.sampler, GL_TEXTURE_MAX_LOD, samplers->maxlod);
-        glSamplerParameterf(s.sampler, GL_TEXTURE_LOD_BIAS, samplers->bias);
+    for (auto &s : p_samplerlist) {
+        ReleaseSampler(s.sampler);
+    }
 
-        switch (samplers->filter) {
-            case GS_FILTER_NEAREST:
-                glSamplerParameteri(s.sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glSamplerParameteri(s.sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                break;
+    p_samplerlist.swap(list);
 
-            case GS_FILTER_LINEAR:
-                glSamplerParameteri(s.sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glSamplerParameteri(s.sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                break;
+    p_error = GS_OK;
+}
 
-            case GS_FILTER_TRILINEAR:
-                glSamplerParameteri(s.sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glSamplerParameteri(s.sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                break;
+void xGSImpl::AddSamplersImpl(const GSsamplerdescription *samplers, GSuint count, GSenum *indices)
+{
+    for (GSuint n = 0; n < count; ++n) {
+        GLuint sampler = CacheSampler(samplers[n]);
+
+        // identical descriptions get the same index, so bindings with them
+        // don't need to rebind samplers
+        size_t index = 0;
+        while (index < p_samplerlist.size() && p_samplerlist[index].sampler != sampler) {
+            ++index;
         }
 
-        if (samplers->depthcompare) {
-            glSamplerParameteri(s.sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-            glSamplerParameteri(s.sampler, GL_TEXTURE_COMPARE_FUNC, gl_compare_func(samplers->depthcompare));
+        if (index == p_samplerlist.size()) {
+            Sampler s = { sampler, 0 };
+            p_samplerlist.push_back(s);
+        } else {
+            // existing slot already holds reference to sampler
+            ReleaseSampler(sampler);
         }
 
-        ++samplers;
+        indices[n] = GSS_0 + GSenum(index);
     }
 
     p_error = GS_OK;
@@ -363,6 +435,8 @@ void xGSImpl::ClearImpl(GSbool color, GSbool depth, GSbool stencil, const GScolo
 
 void xGSImpl::DisplayImpl()
 {
+    p_transientbuffer.nextframe();
+
     error(p_context->Display() ? GS_OK : GSE_SUBSYSTEMFAILED);
 }
 
@@ -439,11 +513,40 @@ void xGSImpl::SetUniformValueImpl(GSenum type, GSint location, const void *value
             glUniformMatrix4fv(location, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(value));
             break;
 
+        case GSU_HANDLE:
+#ifdef GS_CONFIG_BINDLESS_TEXTURE
+            // sampler declared with bindless_sampler layout accepts only 64-bit handle
+            if (p_state && p_state->samplerUniform(location)) {
+                glUniformHandleui64ARB(location, *reinterpret_cast<const GLuint64*>(value));
+                break;
+            }
+#endif
+            glUniform2uiv(location, 1, reinterpret_cast<const GLuint*>(value));
+            break;
+
         default:
             break;
     }
 }
 
+void xGSImpl::AllocateTransientImpl(GSuint size, GStransientallocation &allocation)
+{
+    if (size > GSuint(p_caps.max_ubo_size)) {
+        error(GSE_INVALIDVALUE);
+        return;
+    }
+
+    error(p_transientbuffer.suballocate(size, allocation));
+}
+
+void xGSImpl::SetTransientBlockImpl(GSint location, const GStransientallocation &allocation)
+{
+    glBindBufferRange(
+        GL_UNIFORM_BUFFER, GLuint(location), p_transientbuffer.getID(),
+        GLintptr(allocation.offset), GLsizeiptr(allocation.size)
+    );
+}
+
 void xGSImpl::SetupGeometryImpl(IxGSGeometryImpl *geometry)
 {
     // set up patch parameters
@@ -456,7 +559,7 @@ void xGSImpl::SetupGeometryImpl(IxGSGeometryImpl *geometry)
         glDisable(GL_PRIMITIVE_RESTART);
     } else {
         glEnable(GL_PRIMITIVE_RESTART);
-        glPrimitiveRestartIndex(geometry->restartindex());
+        glPrimitiveRestartIndex(geometry->storedRestartIndex());
     }
 }
 
@@ -512,14 +615,23 @@ struct InstancedMultiDrawer
         p_count(count)
     {}
 
+    // there's no instanced multi draw without indirect buffer,
+    // so every geometry is drawn with separate call
     void MultiDrawArrays(GSenum mode, int *first, int *count, GSuint drawcount) const
     {
-        // TODO
+        for (GSuint n = 0; n < drawcount; ++n) {
+            glDrawArraysInstanced(gl_primitive_type(mode), first[n], count[n], p_count);
+        }
     }
 
     void MultiDrawElementsBaseVertex(GSenum mode, int *count, GSenum type, void **indices, GSuint primcount, int *basevertex) const
     {
-        // TODO
+        for (GSuint n = 0; n < primcount; ++n) {
+            glDrawElementsInstancedBaseVertex(
+                gl_primitive_type(mode), count[n], gl_index_type(type),
+                indices[n], p_count, basevertex[n]
+            );
+        }
     }
 
 private:
@@ -550,6 +662,76 @@ void xGSImpl::EndCaptureImpl(GSuint *elementcount)
     }
 }
 
+void xGSImpl::BeginQueryImpl(xGSQueryImpl *query)
+{
+    glBeginQuery(query->target(), query->query());
+}
+
+void xGSImpl::EndQueryImpl(xGSQueryImpl *query)
+{
+    glEndQuery(query->target());
+}
+
+void xGSImpl::BeginConditionalRenderImpl(xGSQueryImpl *query, GSenum mode)
+{
+    glBeginConditionalRender(
+        query->query(),
+        mode == GS_CONDITION_WAIT ? GL_QUERY_WAIT : GL_QUERY_NO_WAIT
+    );
+}
+
+void xGSImpl::EndConditionalRenderImpl()
+{
+    glEndConditionalRender();
+}
+
+void xGSImpl::DrawGeometriesIndirectImpl(IxGSGeometryImpl *geometry, xGSDataBufferImpl *commands, GSuint count)
+{
+#ifdef GS_CONFIG_MULTI_DRAW_INDIRECT
+    if (!p_caps.multi_draw_indirect) {
+        error(GSE_UNSUPPORTED);
+        return;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->getID());
+    glMultiDrawElementsIndirect(
+        gl_primitive_type(geometry->type()),
+        gl_index_type(geometry->storedIndexFormat()),
+        nullptr, GLsizei(count), 0
+    );
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    p_error = GS_OK;
+#else
+    error(GSE_UNSUPPORTED);
+#endif
+}
+
+void xGSImpl::CullGeometriesGPUImpl(
+    xGSFrameBufferImpl *depthsource, const GSfloat *viewprojection,
+    xGSDataBufferImpl *bounds, xGSDataBufferImpl *commands, GSuint count
+)
+{
+    if (!p_caps.compute_shader) {
+        error(GSE_UNSUPPORTED);
+        return;
+    }
+
+#ifdef GS_CONFIG_STORAGE_BUFFER
+    if (bounds->target() != GL_SHADER_STORAGE_BUFFER || commands->target() != GL_SHADER_STORAGE_BUFFER) {
+        error(GSE_INVALIDOBJECT);
+        return;
+    }
+#endif
+
+    GSsize size = depthsource->size();
+    p_error = p_occlusionculler.cull(
+        depthsource->depthTexture(), depthsource->depthLevel(),
+        GSuint(size.width), GSuint(size.height),
+        viewprojection, bounds, commands, count
+    );
+}
+
 void xGSImpl::DrawImmediatePrimitives(xGSGeometryBufferImpl *buffer)
 {
     // TODO: think about MultiDraw implementation for this
@@ -570,11 +752,68 @@ void xGSImpl::DrawImmediatePrimitives(xGSGeometryBufferImpl *buffer)
     }
 }
 
+void xGSImpl::ComputeImpl(xGSComputeStateImpl *state, GSuint x, GSuint y, GSuint z)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    state->apply();
+    glDispatchCompute(x, y, z);
+
+    p_error = GS_OK;
+#else
+    error(GSE_UNSUPPORTED);
+#endif
+}
+
+void xGSImpl::ComputeIndirectImpl(xGSComputeStateImpl *state, xGSDataBufferImpl *buffer, GSuint offset)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    state->apply();
+
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer->getID());
+    glDispatchComputeIndirect(GLintptr(offset));
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    p_error = GS_OK;
+#else
+    error(GSE_UNSUPPORTED);
+#endif
+}
+
+void xGSImpl::BarrierImpl(GSuint flags)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    if (!p_caps.compute_shader) {
+        error(GSE_UNSUPPORTED);
+        return;
+    }
+
+    glMemoryBarrier(gl_barrier_bits(flags));
+
+    p_error = GS_OK;
+#else
+    error(GSE_UNSUPPORTED);
+#endif
+}
+
 void xGSImpl::BuildMIPsImpl(xGSTextureImpl *texture)
 {
-    // TODO: fix state break-up with MIP level generation
+    // texture is bound to active unit for generation only, so previous binding is restored
+    GLint current = 0;
+    glGetIntegerv(gl_texture_binding(texture->target()), &current);
+
     glBindTexture(texture->target(), texture->getID());
     glGenerateMipmap(texture->target());
+    glBindTexture(texture->target(), GLuint(current));
+}
+
+void xGSImpl::BuildMIPsFilteredImpl(xGSTextureImpl *texture, const GSmipgenerationdescription &desc)
+{
+    if (!p_caps.compute_shader || !p_caps.texture_view) {
+        error(GSE_UNSUPPORTED);
+        return;
+    }
+
+    p_error = p_mipgenerator.generate(texture, desc);
 }
 
 void xGSImpl::CopyImageImpl(
@@ -653,15 +892,6 @@ void xGSImpl::BufferCommitmentImpl(xGSObject *buffer, GSuint offset, GSuint size
     GLuint objectid = 0;
     GLenum target = 0;
     switch (type) {
-        // TODO: do we really need to commit geometry buffers separate from their geometries?
-        case GS_OBJECTTYPE_GEOMETRYBUFFER: {
-            xGSGeometryBufferImpl *impl = static_cast<xGSGeometryBufferImpl*>(buffer);
-            // TODO: consider flags to index buffer commit
-            objectid = impl->vertexbuffer();
-            target = GL_ARRAY_BUFFER;
-            break;
-        }
-
         case GS_OBJECTTYPE_DATABUFFER: {
             xGSDataBufferImpl *impl = static_cast<xGSDataBufferImpl*>(buffer);
             objectid = impl->getID();
@@ -691,42 +921,28 @@ void xGSImpl::BufferCommitmentImpl(xGSObject *buffer, GSuint offset, GSuint size
     p_error = GS_OK;
 }
 
-void xGSImpl::GeometryBufferCommitmentImpl(xGSGeometryBufferImpl *buffer)
-{
-    // TODO: this breaks current input binding, resolve it
-    glBindBuffer(GL_ARRAY_BUFFER, buffer->vertexbuffer());
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->indexbuffer());
-}
-
-void xGSImpl::GeometryBufferCommitmentGeometry(IxGSGeometryImpl *geometry, GSuint vertexsize, GSuint indexsize, GSbool commit)
+void xGSImpl::TextureCommitmentImpl(xGSTextureImpl *texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit)
 {
-    glBufferPageCommitmentARB(
-        GL_ARRAY_BUFFER, GLintptr(geometry->vertexPtr()),
-        geometry->vertexCount() * vertexsize, commit
-    );
-
-    if (geometry->indexCount() == 0) {
+    if (texture->target() == GL_TEXTURE_BUFFER) {
+        error(GSE_INVALIDOBJECT);
         return;
     }
 
-    glBufferPageCommitmentARB(
-        GL_ELEMENT_ARRAY_BUFFER, GLintptr(geometry->indexPtr()),
-        geometry->indexCount() * indexsize, commit
-    );
+    texture->CommitRegion(level, x, y, z, width, height, depth, commit);
+
+    p_error = GS_OK;
 }
 
-void xGSImpl::TextureCommitmentImpl(xGSTextureImpl *texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit)
+void xGSImpl::GetTextureHandleImpl(xGSTextureImpl *texture, GSenum sampler, GSuint64 &handle)
 {
-    if (texture->target() == GL_TEXTURE_BUFFER) {
-        error(GSE_INVALIDOBJECT);
+    if (!p_caps.bindless_texture) {
+        error(GSE_UNSUPPORTED);
         return;
     }
 
-    // TODO: this breaks state, resolve
-    glBindTexture(texture->target(), texture->getID());
-    glTexPageCommitmentARB(texture->target(), level, x, y, z, width, height, depth, commit);
+    handle = texture->handle(sampler);
 
-    p_error = GS_OK;
+    error(handle ? GS_OK : GSE_OUTOFRESOURCES);
 }
 
 void xGSImpl::BeginTimerQueryImpl()
@@ -820,6 +1036,76 @@ GSbool xGSImpl::GetTextureFormatDescriptor(GSvalue format, TextureFormatDescript
     return GS_TRUE;
 }
 
+GSbool xGSImpl::SparseTextureSupported(const GStexturedescription &desc)
+{
+#if defined(GS_CONFIG_TEXTURE_STORAGE) && defined(GS_CONFIG_SPARSE_TEXTURE)
+    if (!p_caps.sparse_texture || desc.multisample != GS_MULTISAMPLE_NONE) {
+        return GS_FALSE;
+    }
+
+    GSuint maxsize = 0;
+    switch (desc.type) {
+        case GS_TEXTYPE_2D:
+        case GS_TEXTYPE_CUBEMAP:
+            maxsize = p_caps.max_sparse_texture_size;
+            break;
+
+        case GS_TEXTYPE_3D:
+            maxsize = p_caps.max_sparse_3dtexture_size;
+            break;
+
+        default:
+            return GS_FALSE;
+    }
+
+    if (desc.width > maxsize || desc.height > maxsize || desc.depth > maxsize ||
+        desc.layers > GSuint(p_caps.max_sparse_texture_layers))
+    {
+        return GS_FALSE;
+    }
+
+    TextureFormatDescriptor texdesc;
+    if (!GetTextureFormatDescriptor(desc.format, texdesc)) {
+        return GS_FALSE;
+    }
+
+    GLenum target = gl_texture_bind_target(desc.type, desc.layers > 0, false);
+
+    GLint pagesizes = 0;
+    glGetInternalformativ(target, texdesc.GLIntFormat, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &pagesizes);
+    if (pagesizes == 0) {
+        return GS_FALSE;
+    }
+
+    // base level should consist of whole pages of the first page size
+    GLint pagex = 1;
+    GLint pagey = 1;
+    GLint pagez = 1;
+    glGetInternalformativ(target, texdesc.GLIntFormat, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pagex);
+    glGetInternalformativ(target, texdesc.GLIntFormat, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &pagey);
+    glGetInternalformativ(target, texdesc.GLIntFormat, GL_VIRTUAL_PAGE_SIZE_Z_ARB, 1, &pagez);
+
+    return
+        desc.width % pagex == 0 && desc.height % pagey == 0 &&
+        (desc.type != GS_TEXTYPE_3D || desc.depth % pagez == 0);
+#else
+    return GS_FALSE;
+#endif
+}
+
+GSbool xGSImpl::TransientAllocationValid(const GStransientallocation &allocation)
+{
+    return p_transientbuffer.valid(allocation);
+}
+
+void xGSImpl::GetTextureLimits(TextureLimits &limits)
+{
+    limits.size = p_caps.max_texture_size;
+    limits.size3d = p_caps.max_3d_texture_size;
+    limits.cubemapsize = p_caps.max_cube_map_texture_size;
+    limits.layers = p_caps.max_array_texture_layers;
+}
+
 const GSpixelformat& xGSImpl::DefaultRenderTargetFormat()
 {
     return p_context->RenderTargetFormat();
@@ -846,3 +1132,82 @@ void xGSImpl::DefaultRTFormats()
     p_colorformats[0] = ColorFormatFromPixelFormat(fmt);
     p_depthstencilformat = DepthFormatFromPixelFormat(fmt);
 }
+
+GLuint xGSImpl::CacheSampler(const GSsamplerdescription &desc)
+{
+    size_t hash = sampler_hash(desc);
+
+    auto range = p_samplercache.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (sampler_equal(it->second.desc, desc)) {
+            ++it->second.users;
+            return it->second.sampler;
+        }
+    }
+
+    GLuint sampler = 0;
+    glGenSamplers(1, &sampler);
+
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, gl_texture_wrap(desc.wrapu));
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, gl_texture_wrap(desc.wrapv));
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, gl_texture_wrap(desc.wrapw));
+
+    if (desc.wrapu == GS_WRAP_BORDER || desc.wrapv == GS_WRAP_BORDER || desc.wrapw == GS_WRAP_BORDER) {
+        glSamplerParameterfv(sampler, GL_TEXTURE_BORDER_COLOR, &desc.border.r);
+    }
+
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_LOD, desc.minlod);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAX_LOD, desc.maxlod);
+    glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, desc.bias);
+
+    switch (desc.filter) {
+        case GS_FILTER_NEAREST:
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            break;
+
+        case GS_FILTER_LINEAR:
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            break;
+
+        case GS_FILTER_TRILINEAR:
+            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            break;
+    }
+
+#ifdef GS_CONFIG_ANISOTROPIC_FILTER
+    // anisotropy above supported maximum is clamped
+    if (p_caps.anisotropic_filter && desc.anisotropy > 1) {
+        GLfloat anisotropy = GLfloat(desc.anisotropy);
+        if (anisotropy > p_caps.max_anisotropy) {
+            anisotropy = p_caps.max_anisotropy;
+        }
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    }
+#endif
+
+    if (desc.depthcompare) {
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_FUNC, gl_compare_func(desc.depthcompare));
+    }
+
+    CachedSampler cached = { desc, sampler, 1 };
+    p_samplercache.insert(std::make_pair(hash, cached));
+
+    return sampler;
+}
+
+void xGSImpl::ReleaseSampler(GLuint sampler)
+{
+    for (auto it = p_samplercache.begin(); it != p_samplercache.end(); ++it) {
+        if (it->second.sampler == sampler) {
+            if (--it->second.users == 0) {
+                glDeleteSamplers(1, &sampler);
+                p_samplercache.erase(it);
+            }
+            return;
+        }
+    }
+}
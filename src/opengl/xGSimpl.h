@@ -17,6 +17,8 @@
 #include "xGS/xGS.h"
 #include "xGSimplbase.h"
 #include "xGSGLutil.h"
+#include "xGSocclusion.h"
+#include "xGSmipgenerator.h"
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -37,6 +39,9 @@ namespace xGS
         // cpas
         const GScaps& caps() const { return p_caps; }
 
+        // texture lock buffers
+        GSStagingPool& stagingPool() { return p_stagingpool; }
+
         // samplers
         GSuint samplerCount() const { return GSuint(p_samplerlist.size()); }
         GLuint sampler(GSuint index) const { return p_samplerlist[index].sampler; }
@@ -53,6 +58,7 @@ namespace xGS
         void DestroyRendererImpl();
 
         void CreateSamplersImpl(const GSsamplerdescription *samplers, GSuint count);
+        void AddSamplersImpl(const GSsamplerdescription *samplers, GSuint count, GSenum *indices);
 
         void GetRenderTargetSizeImpl(GSsize &size);
 
@@ -66,14 +72,33 @@ namespace xGS
         void SetBlendColorImpl(const GScolor &color);
         void SetUniformValueImpl(GSenum type, GSint location, const void *value);
 
+        void AllocateTransientImpl(GSuint size, GStransientallocation &allocation);
+        void SetTransientBlockImpl(GSint location, const GStransientallocation &allocation);
+
         void SetupGeometryImpl(IxGSGeometryImpl *geometry);
 
         void BeginCaptureImpl(GSenum mode);
         void EndCaptureImpl(GSuint *elementcount);
 
+        void BeginQueryImpl(xGSQueryImpl *query);
+        void EndQueryImpl(xGSQueryImpl *query);
+        void BeginConditionalRenderImpl(xGSQueryImpl *query, GSenum mode);
+        void EndConditionalRenderImpl();
+
         void DrawImmediatePrimitives(xGSGeometryBufferImpl *buffer);
 
+        void DrawGeometriesIndirectImpl(IxGSGeometryImpl *geometry, xGSDataBufferImpl *commands, GSuint count);
+        void CullGeometriesGPUImpl(
+            xGSFrameBufferImpl *depthsource, const GSfloat *viewprojection,
+            xGSDataBufferImpl *bounds, xGSDataBufferImpl *commands, GSuint count
+        );
+
+        void ComputeImpl(xGSComputeStateImpl *state, GSuint x, GSuint y, GSuint z);
+        void ComputeIndirectImpl(xGSComputeStateImpl *state, xGSDataBufferImpl *buffer, GSuint offset);
+        void BarrierImpl(GSuint flags);
+
         void BuildMIPsImpl(xGSTextureImpl *texture);
+        void BuildMIPsFilteredImpl(xGSTextureImpl *texture, const GSmipgenerationdescription &desc);
 
         void CopyImageImpl(
             xGSTextureImpl *src, GSuint srclevel, GSuint srcx, GSuint srcy, GSuint srcz,
@@ -84,10 +109,10 @@ namespace xGS
         void CopyDataImpl(xGSObject *src, xGSObject *dst, GSuint readoffset, GSuint writeoffset, GSuint size, GSuint flags);
 
         void BufferCommitmentImpl(xGSObject *buffer, GSuint offset, GSuint size, GSbool commit, GSuint flags);
-        void GeometryBufferCommitmentImpl(xGSGeometryBufferImpl *buffer);
-        void GeometryBufferCommitmentGeometry(IxGSGeometryImpl *geometry, GSuint vertexsize, GSuint indexsize, GSbool commit);
         void TextureCommitmentImpl(xGSTextureImpl *texture, GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit);
 
+        void GetTextureHandleImpl(xGSTextureImpl *texture, GSenum sampler, GSuint64 &handle);
+
         void BeginTimerQueryImpl();
         void EndTimerQueryImpl();
         void TimestampQueryImpl();
@@ -117,6 +142,9 @@ namespace xGS
         };
 
         GSbool GetTextureFormatDescriptor(GSvalue format, TextureFormatDescriptor &descriptor);
+        GSbool SparseTextureSupported(const GStexturedescription &desc);
+        GSbool TransientAllocationValid(const GStransientallocation &allocation);
+        void GetTextureLimits(TextureLimits &limits);
         const GSpixelformat& DefaultRenderTargetFormat();
 
     private:
@@ -124,6 +152,12 @@ namespace xGS
 
         void DefaultRTFormats();
 
+        // returns sampler object for description, creates new one only
+        // if there's no sampler with identical description, every call
+        // adds reference which should be released with ReleaseSampler
+        GLuint CacheSampler(const GSsamplerdescription &desc);
+        void ReleaseSampler(GLuint sampler);
+
     protected:
         struct Sampler
         {
@@ -133,8 +167,18 @@ namespace xGS
 
         typedef std::vector<Sampler> SamplerList;
 
-        SamplerList p_samplerlist;
-        GScaps      p_caps;
+        struct CachedSampler
+        {
+            GSsamplerdescription desc;
+            GLuint               sampler;
+            GSuint               users;   // number of sampler list slots using sampler
+        };
+
+        typedef std::unordered_multimap<size_t, CachedSampler> SamplerCache;
+
+        SamplerList  p_samplerlist;  // GSS_* indexed samplers, identical ones share sampler object
+        SamplerCache p_samplercache; // sampler objects used by sampler list
+        GScaps       p_caps;
 
     private:
         typedef std::unique_ptr<xGScontext> ContextPtr;
@@ -144,6 +188,12 @@ namespace xGS
 
         TextureDescriptorsMap p_texturedescs;
 
+        GSTransientBuffer     p_transientbuffer;
+
+        GSOcclusionCuller     p_occlusionculler;
+        GSMipGenerator        p_mipgenerator;
+        GSStagingPool         p_stagingpool;
+
         GLuint                p_capturequery;
 
         GLuint                p_timerqueries[1024];
@@ -0,0 +1,451 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGSmipgenerator.cpp
+        MIP levels generator class
+*/
+
+#include "xGSmipgenerator.h"
+#include "xGStexture.h"
+#include "kcommon/c_util.h"
+
+
+using namespace xGS;
+using namespace c_util;
+
+
+#ifdef GS_CONFIG_COMPUTE_SHADER
+
+static const GSuint MIP_GROUP_SIZE = 8;
+
+// alpha coverage candidate scales per layer, scale k is exp2((k - 16) / 8)
+static const GSuint MIP_COVERAGE_SCALES = 32;
+
+// generation passes
+static const GSint MIP_PASS_FILTER = 0;    // filter and store level
+static const GSint MIP_PASS_REFERENCE = 1; // count source texels passing alpha test
+static const GSint MIP_PASS_COVERAGE = 2;  // count filtered texels passing alpha test for every scale
+static const GSint MIP_PASS_SCALED = 3;    // filter and store level with alpha scaled to reference coverage
+
+// coverage buffer holds reference texel count for every layer, followed by
+// counters of texels which pass alpha test starting from scale k for every layer
+static const char *mip_shader =
+    "#version 430\n"
+    "layout(local_size_x = 8, local_size_y = 8) in;\n"
+    "layout(binding = 0) uniform sampler2DArray source;\n"
+    "layout(binding = 0) uniform writeonly image2DArray destination;\n"
+    "layout(std430, binding = 0) buffer Coverage { uint coverage[]; };\n"
+    "uniform int sourcelevel;\n"
+    "uniform int mode;\n"
+    "uniform int kaiser;\n"
+    "uniform int srgb;\n"
+    "uniform ivec2 origin;\n"
+    "uniform ivec2 extent;\n"
+    "uniform float alpharef;\n"
+    "uniform vec2 texels;\n"
+    "const int SCALES = 32;\n"
+    "vec4 fetch(ivec2 p, int layer, ivec2 last) {\n"
+    "    return texelFetch(source, ivec3(clamp(p, ivec2(0), last), layer), sourcelevel);\n"
+    "}\n"
+    "vec4 box(ivec2 p, int layer, ivec2 sourcesize, ivec2 size) {\n"
+    "    ivec2 last = sourcesize - 1;\n"
+    "    ivec2 s = p * 2;\n"
+    "    int w = (sourcesize.x & 1) != 0 && p.x == size.x - 1 ? 3 : 2;\n"
+    "    int h = (sourcesize.y & 1) != 0 && p.y == size.y - 1 ? 3 : 2;\n"
+    "    vec4 sum = vec4(0.0);\n"
+    "    for (int y = 0; y < h; ++y) {\n"
+    "        for (int x = 0; x < w; ++x) {\n"
+    "            sum += fetch(s + ivec2(x, y), layer, last);\n"
+    "        }\n"
+    "    }\n"
+    "    return sum / float(w * h);\n"
+    "}\n"
+    "float bessel0(float x) {\n"
+    "    float sum = 1.0;\n"
+    "    float term = 1.0;\n"
+    "    for (int k = 1; k < 8; ++k) {\n"
+    "        float t = x / float(2 * k);\n"
+    "        term *= t * t;\n"
+    "        sum += term;\n"
+    "    }\n"
+    "    return sum;\n"
+    "}\n"
+    "float kaiserweight(float x) {\n"
+    "    float r = x / 3.0;\n"
+    "    if (abs(r) >= 1.0) {\n"
+    "        return 0.0;\n"
+    "    }\n"
+    "    float window = bessel0(4.0 * sqrt(1.0 - r * r)) / bessel0(4.0);\n"
+    "    float s = 1.5707963 * x;\n"
+    "    return (abs(s) < 1e-4 ? 1.0 : sin(s) / s) * window;\n"
+    "}\n"
+    "vec4 kaiserfilter(ivec2 p, int layer, ivec2 sourcesize, ivec2 size) {\n"
+    "    ivec2 last = sourcesize - 1;\n"
+    "    vec2 center = (vec2(p) + 0.5) * vec2(sourcesize) / vec2(size);\n"
+    "    ivec2 first = ivec2(floor(center - 0.5)) - 2;\n"
+    "    float wx[6];\n"
+    "    float wy[6];\n"
+    "    float sx = 0.0;\n"
+    "    float sy = 0.0;\n"
+    "    for (int n = 0; n < 6; ++n) {\n"
+    "        wx[n] = kaiserweight(float(first.x + n) + 0.5 - center.x);\n"
+    "        wy[n] = kaiserweight(float(first.y + n) + 0.5 - center.y);\n"
+    "        sx += wx[n];\n"
+    "        sy += wy[n];\n"
+    "    }\n"
+    "    vec4 sum = vec4(0.0);\n"
+    "    for (int y = 0; y < 6; ++y) {\n"
+    "        for (int x = 0; x < 6; ++x) {\n"
+    "            sum += fetch(first + ivec2(x, y), layer, last) * (wx[x] * wy[y]);\n"
+    "        }\n"
+    "    }\n"
+    "    return max(sum / (sx * sy), vec4(0.0));\n"
+    "}\n"
+    "int scaleindex(float alpha) {\n"
+    "    if (alpha <= 0.0) {\n"
+    "        return SCALES;\n"
+    "    }\n"
+    "    return int(clamp(floor(16.0 + 8.0 * log2(alpharef / alpha)) + 1.0, 0.0, float(SCALES)));\n"
+    "}\n"
+    "float coveragescale(int layer) {\n"
+    "    int layers = int(gl_NumWorkGroups.z);\n"
+    "    float reference = float(coverage[layer]) / texels.x;\n"
+    "    float scale = 1.0;\n"
+    "    float best = 2.0;\n"
+    "    uint passed = 0u;\n"
+    "    for (int k = 0; k < SCALES; ++k) {\n"
+    "        passed += coverage[layers + layer * SCALES + k];\n"
+    "        float difference = abs(float(passed) / texels.y - reference);\n"
+    "        if (difference < best) {\n"
+    "            best = difference;\n"
+    "            scale = exp2(float(k - 16) / 8.0);\n"
+    "        }\n"
+    "    }\n"
+    "    return scale;\n"
+    "}\n"
+    "vec3 encode(vec3 c) {\n"
+    "    c = clamp(c, 0.0, 1.0);\n"
+    "    return mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, greaterThan(c, vec3(0.0031308)));\n"
+    "}\n"
+    "void main() {\n"
+    "    if (any(greaterThanEqual(gl_GlobalInvocationID.xy, uvec2(extent)))) {\n"
+    "        return;\n"
+    "    }\n"
+    "    ivec2 p = origin + ivec2(gl_GlobalInvocationID.xy);\n"
+    "    int layer = int(gl_GlobalInvocationID.z);\n"
+    "    if (mode == 1) {\n"
+    "        if (texelFetch(source, ivec3(p, layer), sourcelevel).a > alpharef) {\n"
+    "            atomicAdd(coverage[layer], 1u);\n"
+    "        }\n"
+    "        return;\n"
+    "    }\n"
+    "    ivec2 sourcesize = textureSize(source, sourcelevel).xy;\n"
+    "    ivec2 size = imageSize(destination).xy;\n"
+    "    vec4 color = kaiser != 0 ? kaiserfilter(p, layer, sourcesize, size) : box(p, layer, sourcesize, size);\n"
+    "    if (mode == 2) {\n"
+    "        int k = scaleindex(color.a);\n"
+    "        if (k < SCALES) {\n"
+    "            atomicAdd(coverage[int(gl_NumWorkGroups.z) + layer * SCALES + k], 1u);\n"
+    "        }\n"
+    "        return;\n"
+    "    }\n"
+    "    if (mode == 3) {\n"
+    "        color.a = clamp(color.a * coveragescale(layer), 0.0, 1.0);\n"
+    "    }\n"
+    "    if (srgb != 0) {\n"
+    "        color.rgb = encode(color.rgb);\n"
+    "    }\n"
+    "    imageStore(destination, ivec3(p, layer), color);\n"
+    "}\n";
+
+
+// GL bindings which are changed by MIP generation
+class GSMipBindings
+{
+public:
+    GSMipBindings()
+    {
+        glGetIntegerv(GL_CURRENT_PROGRAM, &p_program);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &p_activetexture);
+
+        glActiveTexture(GL_TEXTURE0);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &p_texture);
+        glGetIntegerv(GL_SAMPLER_BINDING, &p_sampler);
+
+        glGetIntegeri_v(GL_IMAGE_BINDING_NAME, 0, &p_image);
+        glGetIntegeri_v(GL_IMAGE_BINDING_LEVEL, 0, &p_imagelevel);
+        glGetIntegeri_v(GL_IMAGE_BINDING_LAYERED, 0, &p_imagelayered);
+        glGetIntegeri_v(GL_IMAGE_BINDING_LAYER, 0, &p_imagelayer);
+        glGetIntegeri_v(GL_IMAGE_BINDING_ACCESS, 0, &p_imageaccess);
+        glGetIntegeri_v(GL_IMAGE_BINDING_FORMAT, 0, &p_imageformat);
+
+        glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, 0, &p_storage);
+        glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, 0, &p_storagestart);
+        glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, 0, &p_storagesize);
+    }
+
+    ~GSMipBindings()
+    {
+        if (p_storagesize) {
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, p_storage, GLintptr(p_storagestart), GLsizeiptr(p_storagesize));
+        } else {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, p_storage);
+        }
+
+        glBindImageTexture(
+            0, p_image, p_imagelevel, GLboolean(p_imagelayered), p_imagelayer,
+            GLenum(p_imageaccess), GLenum(p_imageformat)
+        );
+
+        glBindSampler(0, p_sampler);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, p_texture);
+        glActiveTexture(GLenum(p_activetexture));
+
+        glUseProgram(p_program);
+    }
+
+private:
+    GLint   p_program;
+    GLint   p_activetexture;
+    GLint   p_texture;
+    GLint   p_sampler;
+    GLint   p_image;
+    GLint   p_imagelevel;
+    GLint   p_imagelayered;
+    GLint   p_imagelayer;
+    GLint   p_imageaccess;
+    GLint   p_imageformat;
+    GLint   p_storage;
+    GLint64 p_storagestart;
+    GLint64 p_storagesize;
+};
+
+#endif
+
+GSMipGenerator::GSMipGenerator() :
+    p_program(0),
+    p_sampler(0),
+    p_coverage(0),
+    p_coveragesize(0),
+    p_sourcelevel(-1),
+    p_mode(-1),
+    p_kaiser(-1),
+    p_srgb(-1),
+    p_origin(-1),
+    p_extent(-1),
+    p_alpharef(-1),
+    p_texels(-1)
+{}
+
+GSerror GSMipGenerator::generate(xGSTextureImpl *texture, const GSmipgenerationdescription &desc)
+{
+#if defined(GS_CONFIG_COMPUTE_SHADER) && defined(GS_CONFIG_TEXTURE_STORAGE)
+    GLenum imageformat = gl_image_format(texture->internalFormat());
+    if (imageformat == 0) {
+        return GSE_UNSUPPORTED;
+    }
+
+    GSerror result = allocateProgram();
+    if (result != GS_OK) {
+        return result;
+    }
+
+    GSuint layers = umax(texture->layers(), 1u) * (texture->type() == GS_TEXTYPE_CUBEMAP ? 6 : 1);
+
+    bool coverage = desc.filter == GS_MIPFILTER_ALPHACOVERAGE;
+    if (coverage) {
+        result = allocateCoverage(layers);
+        if (result != GS_OK) {
+            return result;
+        }
+    }
+
+    GSMipBindings bindings;
+
+    // source view decodes sRGB texels on fetch, destination view of sRGB texture
+    // has linear format of the same size, so encoded values are stored as is
+    bool srgb = imageformat != texture->internalFormat();
+    GLuint views[2] = { 0, 0 };
+    glGenTextures(srgb ? 2 : 1, views);
+    glTextureView(
+        views[0], GL_TEXTURE_2D_ARRAY, texture->getID(), texture->internalFormat(),
+        0, texture->maxLevel() + 1, 0, layers
+    );
+    if (srgb) {
+        glTextureView(
+            views[1], GL_TEXTURE_2D_ARRAY, texture->getID(), imageformat,
+            0, texture->maxLevel() + 1, 0, layers
+        );
+    }
+    GLuint destination = srgb ? views[1] : views[0];
+
+    glUseProgram(p_program);
+    glUniform1i(p_kaiser, desc.filter == GS_MIPFILTER_KAISER ? 1 : 0);
+    glUniform1i(p_srgb, srgb ? 1 : 0);
+    glUniform1f(p_alpharef, desc.alpharef);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, views[0]);
+    glBindSampler(0, p_sampler);
+
+    GSint left = desc.rect.left;
+    GSint top = desc.rect.top;
+    GSint right = desc.rect.left + desc.rect.width;
+    GSint bottom = desc.rect.top + desc.rect.height;
+
+    GSuint referencetexels = GSuint(desc.rect.width * desc.rect.height);
+
+    if (coverage) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, p_coverage);
+        glClearBufferSubData(
+            GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, layers * sizeof(GSuint),
+            GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr
+        );
+
+        glUniform1i(p_sourcelevel, GLint(desc.firstlevel - 1));
+        dispatch(MIP_PASS_REFERENCE, left, top, right - left, bottom - top, layers);
+    }
+
+    // Kaiser filter footprint reaches 2 texels beyond 2x2 block,
+    // so changed area affects one more texel on every side
+    GSint margin = desc.filter == GS_MIPFILTER_KAISER ? 1 : 0;
+
+    for (GSuint level = desc.firstlevel; level < desc.firstlevel + desc.levelcount; ++level) {
+        GSint width = GSint(umax(texture->width() >> level, 1u));
+        GSint height = GSint(umax(texture->height() >> level, 1u));
+
+        left = umax(left / 2 - margin, 0);
+        top = umax(top / 2 - margin, 0);
+        right = umin((right + 1) / 2 + margin, width);
+        bottom = umin((bottom + 1) / 2 + margin, height);
+
+        // previous level should be written before it's fetched
+        if (level != desc.firstlevel) {
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+
+        glBindImageTexture(0, destination, GLint(level), GL_TRUE, 0, GL_WRITE_ONLY, imageformat);
+        glUniform1i(p_sourcelevel, GLint(level - 1));
+
+        if (coverage) {
+            glClearBufferSubData(
+                GL_SHADER_STORAGE_BUFFER, GL_R32UI,
+                layers * sizeof(GSuint), layers * MIP_COVERAGE_SCALES * sizeof(GSuint),
+                GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr
+            );
+
+            glUniform2f(p_texels, GSfloat(referencetexels), GSfloat((right - left) * (bottom - top)));
+
+            dispatch(MIP_PASS_COVERAGE, left, top, right - left, bottom - top, layers);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            dispatch(MIP_PASS_SCALED, left, top, right - left, bottom - top, layers);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        } else {
+            dispatch(MIP_PASS_FILTER, left, top, right - left, bottom - top, layers);
+        }
+    }
+
+    glDeleteTextures(srgb ? 2 : 1, views);
+
+    // generated levels could be sampled, rendered into or read back next
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+    return GS_OK;
+#else
+    return GSE_UNSUPPORTED;
+#endif
+}
+
+void GSMipGenerator::ReleaseRendererResources()
+{
+    if (p_program) {
+        glDeleteProgram(p_program);
+        p_program = 0;
+    }
+    if (p_sampler) {
+        glDeleteSamplers(1, &p_sampler);
+        p_sampler = 0;
+    }
+    if (p_coverage) {
+        glDeleteBuffers(1, &p_coverage);
+        p_coverage = 0;
+    }
+
+    p_coveragesize = 0;
+}
+
+#ifdef GS_CONFIG_COMPUTE_SHADER
+
+GSerror GSMipGenerator::allocateProgram()
+{
+    // program is built on first use only
+    if (p_program) {
+        return GS_OK;
+    }
+
+    p_program = gl_compute_program(mip_shader);
+    if (p_program == 0) {
+        return GSE_INVALIDOPERATION;
+    }
+
+    p_sourcelevel = glGetUniformLocation(p_program, "sourcelevel");
+    p_mode = glGetUniformLocation(p_program, "mode");
+    p_kaiser = glGetUniformLocation(p_program, "kaiser");
+    p_srgb = glGetUniformLocation(p_program, "srgb");
+    p_origin = glGetUniformLocation(p_program, "origin");
+    p_extent = glGetUniformLocation(p_program, "extent");
+    p_alpharef = glGetUniformLocation(p_program, "alpharef");
+    p_texels = glGetUniformLocation(p_program, "texels");
+
+    // sampler makes every level fetchable regardless of texture own filtering
+    glGenSamplers(1, &p_sampler);
+    glSamplerParameteri(p_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glSamplerParameteri(p_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    return GS_OK;
+}
+
+GSerror GSMipGenerator::allocateCoverage(GSuint layers)
+{
+    if (p_coverage && p_coveragesize >= layers) {
+        return GS_OK;
+    }
+
+    if (p_coverage) {
+        glDeleteBuffers(1, &p_coverage);
+        p_coverage = 0;
+    }
+
+    p_coveragesize = layers;
+
+    glGenBuffers(1, &p_coverage);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, p_coverage);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, layers * (MIP_COVERAGE_SCALES + 1) * sizeof(GSuint),
+        nullptr, GL_DYNAMIC_COPY
+    );
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return p_coverage ? GS_OK : GSE_OUTOFRESOURCES;
+}
+
+void GSMipGenerator::dispatch(GSint mode, GSint left, GSint top, GSint width, GSint height, GSuint layers)
+{
+    glUniform1i(p_mode, mode);
+    glUniform2i(p_origin, left, top);
+    glUniform2i(p_extent, width, height);
+
+    glDispatchCompute(
+        (GSuint(width) + MIP_GROUP_SIZE - 1) / MIP_GROUP_SIZE,
+        (GSuint(height) + MIP_GROUP_SIZE - 1) / MIP_GROUP_SIZE,
+        layers
+    );
+}
+
+#endif
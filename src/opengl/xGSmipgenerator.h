@@ -0,0 +1,62 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGSmipgenerator.h
+        MIP levels generator class header
+            filters MIP levels with compute shader
+*/
+
+#pragma once
+
+#include "xGSGLutil.h"
+
+
+namespace xGS
+{
+
+    class xGSTextureImpl;
+
+
+    // compute MIP levels generator
+    //      every level is filtered from previous one by single dispatch over all layers,
+    //      texture is accessed through 2D array views, so 2D, array and cubemap textures
+    //      are handled the same way, sRGB levels are fetched decoded and encoded by shader
+    //      GL bindings used by generator are restored after generation
+    class GSMipGenerator
+    {
+    public:
+        GSMipGenerator();
+
+        GSerror generate(xGSTextureImpl *texture, const GSmipgenerationdescription &desc);
+
+        void ReleaseRendererResources();
+
+    private:
+        GSerror allocateProgram();
+        GSerror allocateCoverage(GSuint layers);
+
+        void dispatch(GSint mode, GSint left, GSint top, GSint width, GSint height, GSuint layers);
+
+    private:
+        GLuint p_program;
+        GLuint p_sampler;       // point sampler for source level fetches
+        GLuint p_coverage;      // alpha coverage counters buffer
+        GSuint p_coveragesize;  // alpha coverage counters buffer size in layers
+
+        GLint  p_sourcelevel;   // source level uniform
+        GLint  p_mode;          // generation pass uniform
+        GLint  p_kaiser;        // Kaiser or box filter uniform
+        GLint  p_srgb;          // sRGB encoding uniform
+        GLint  p_origin;        // processed area origin uniform
+        GLint  p_extent;        // processed area size uniform
+        GLint  p_alpharef;      // alpha reference value uniform
+        GLint  p_texels;        // reference and destination area texel counts uniform
+    };
+
+} // namespace xGS
@@ -0,0 +1,318 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGSocclusion.cpp
+        GPU occlusion culling helper class
+*/
+
+#include "xGSocclusion.h"
+#include "xGStexture.h"
+#include "xGSdatabuffer.h"
+#include "kcommon/c_util.h"
+
+
+using namespace xGS;
+using namespace c_util;
+
+
+#ifdef GS_CONFIG_COMPUTE_SHADER
+
+static const GSuint PYRAMID_GROUP_SIZE = 8;
+static const GSuint CULL_GROUP_SIZE = 64;
+
+// builds single Hi-Z level, level 0 is copied from depth texture,
+// odd sized source levels take extra row/column, so coarser texel
+// always covers all source texels it overlaps
+static const char *pyramid_shader =
+    "#version 430\n"
+    "layout(local_size_x = 8, local_size_y = 8) in;\n"
+    "layout(binding = 0) uniform sampler2D source;\n"
+    "layout(r32f, binding = 0) uniform writeonly image2D destination;\n"
+    "uniform int sourcelevel;\n"
+    "uniform int reduce;\n"
+    "float fetch(ivec2 p, ivec2 last) {\n"
+    "    return texelFetch(source, min(p, last), sourcelevel).r;\n"
+    "}\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+    "    ivec2 size = imageSize(destination);\n"
+    "    if (p.x >= size.x || p.y >= size.y) {\n"
+    "        return;\n"
+    "    }\n"
+    "    ivec2 sourcesize = textureSize(source, sourcelevel);\n"
+    "    ivec2 last = sourcesize - 1;\n"
+    "    float depth;\n"
+    "    if (reduce == 0) {\n"
+    "        depth = fetch(p, last);\n"
+    "    } else {\n"
+    "        ivec2 s = p * 2;\n"
+    "        depth = max(\n"
+    "            max(fetch(s, last), fetch(s + ivec2(1, 0), last)),\n"
+    "            max(fetch(s + ivec2(0, 1), last), fetch(s + ivec2(1, 1), last))\n"
+    "        );\n"
+    "        bool oddx = (sourcesize.x & 1) != 0 && p.x == size.x - 1;\n"
+    "        bool oddy = (sourcesize.y & 1) != 0 && p.y == size.y - 1;\n"
+    "        if (oddx) {\n"
+    "            depth = max(depth, max(fetch(s + ivec2(2, 0), last), fetch(s + ivec2(2, 1), last)));\n"
+    "        }\n"
+    "        if (oddy) {\n"
+    "            depth = max(depth, max(fetch(s + ivec2(0, 2), last), fetch(s + ivec2(1, 2), last)));\n"
+    "        }\n"
+    "        if (oddx && oddy) {\n"
+    "            depth = max(depth, fetch(s + ivec2(2, 2), last));\n"
+    "        }\n"
+    "    }\n"
+    "    imageStore(destination, p, vec4(depth));\n"
+    "}\n";
+
+// tests bounding sphere box against frustum and Hi-Z, writes instance count
+// of draw command (5 uints per command, instance count is the second one)
+static const char *cull_shader =
+    "#version 430\n"
+    "layout(local_size_x = 64) in;\n"
+    "layout(std430, binding = 0) readonly buffer Bounds { vec4 bounds[]; };\n"
+    "layout(std430, binding = 1) buffer Commands { uint commands[]; };\n"
+    "layout(binding = 0) uniform sampler2D pyramid;\n"
+    "uniform mat4 viewprojection;\n"
+    "uniform uint count;\n"
+    "void main() {\n"
+    "    uint index = gl_GlobalInvocationID.x;\n"
+    "    if (index >= count) {\n"
+    "        return;\n"
+    "    }\n"
+    "    vec4 sphere = bounds[index];\n"
+    "    vec3 bmin = sphere.xyz - sphere.w;\n"
+    "    vec3 bmax = sphere.xyz + sphere.w;\n"
+    "    vec3 ndcmin = vec3(1.0);\n"
+    "    vec3 ndcmax = vec3(-1.0);\n"
+    "    uint outside = 63u;\n"
+    "    bool nearclip = false;\n"
+    "    for (int n = 0; n < 8; ++n) {\n"
+    "        vec3 corner = mix(bmin, bmax, vec3(n & 1, (n >> 1) & 1, (n >> 2) & 1));\n"
+    "        vec4 clip = viewprojection * vec4(corner, 1.0);\n"
+    "        uint code =\n"
+    "            (clip.x < -clip.w ? 1u : 0u) | (clip.x > clip.w ? 2u : 0u) |\n"
+    "            (clip.y < -clip.w ? 4u : 0u) | (clip.y > clip.w ? 8u : 0u) |\n"
+    "            (clip.z < -clip.w ? 16u : 0u) | (clip.z > clip.w ? 32u : 0u);\n"
+    "        outside &= code;\n"
+    "        if (clip.w <= 0.0) {\n"
+    "            nearclip = true;\n"
+    "        } else {\n"
+    "            vec3 ndc = clip.xyz / clip.w;\n"
+    "            ndcmin = min(ndcmin, ndc);\n"
+    "            ndcmax = max(ndcmax, ndc);\n"
+    "        }\n"
+    "    }\n"
+    "    bool visible = outside == 0u;\n"
+    "    if (visible && !nearclip) {\n"
+    "        vec2 uvmin = clamp(ndcmin.xy * 0.5 + 0.5, 0.0, 1.0);\n"
+    "        vec2 uvmax = clamp(ndcmax.xy * 0.5 + 0.5, 0.0, 1.0);\n"
+    "        ivec2 size = textureSize(pyramid, 0);\n"
+    "        vec2 extent = (uvmax - uvmin) * vec2(size);\n"
+    "        int levels = textureQueryLevels(pyramid);\n"
+    "        int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, levels - 1);\n"
+    "        ivec2 levelsize = textureSize(pyramid, level);\n"
+    "        ivec2 last = levelsize - 1;\n"
+    "        ivec2 t0 = min(ivec2(uvmin * vec2(levelsize)), last);\n"
+    "        ivec2 t1 = min(ivec2(uvmax * vec2(levelsize)), last);\n"
+    "        float depth = max(\n"
+    "            max(texelFetch(pyramid, t0, level).r, texelFetch(pyramid, ivec2(t1.x, t0.y), level).r),\n"
+    "            max(texelFetch(pyramid, ivec2(t0.x, t1.y), level).r, texelFetch(pyramid, t1, level).r)\n"
+    "        );\n"
+    "        visible = ndcmin.z * 0.5 + 0.5 <= depth;\n"
+    "    }\n"
+    "    commands[index * 5u + 1u] = visible ? 1u : 0u;\n"
+    "}\n";
+
+#endif
+
+GSOcclusionCuller::GSOcclusionCuller() :
+    p_pyramidprogram(0),
+    p_cullprogram(0),
+    p_pyramid(0),
+    p_sampler(0),
+    p_width(0),
+    p_height(0),
+    p_levels(0),
+    p_sourcelevel(-1),
+    p_reduce(-1),
+    p_viewprojection(-1),
+    p_count(-1)
+{}
+
+GSerror GSOcclusionCuller::cull(
+    xGSTextureImpl *depth, GSuint depthlevel, GSuint width, GSuint height,
+    const GSfloat *viewprojection,
+    xGSDataBufferImpl *bounds, xGSDataBufferImpl *commands, GSuint count
+)
+{
+#ifdef GS_CONFIG_COMPUTE_SHADER
+    GSerror result = allocatePrograms();
+    if (result != GS_OK) {
+        return result;
+    }
+
+    result = allocatePyramid(width, height);
+    if (result != GS_OK) {
+        return result;
+    }
+
+    buildPyramid(depth, depthlevel);
+
+    // Hi-Z image writes should be visible for culling fetches
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    glUseProgram(p_cullprogram);
+    glUniformMatrix4fv(p_viewprojection, 1, GL_FALSE, viewprojection);
+    glUniform1ui(p_count, count);
+
+    glBindTexture(GL_TEXTURE_2D, p_pyramid);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bounds->getID());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commands->getID());
+
+    glDispatchCompute((count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    glBindSampler(0, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+
+    // commands written by culling are consumed by indirect draws
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+    return GS_OK;
+#else
+    return GSE_UNSUPPORTED;
+#endif
+}
+
+void GSOcclusionCuller::ReleaseRendererResources()
+{
+    if (p_pyramidprogram) {
+        glDeleteProgram(p_pyramidprogram);
+        p_pyramidprogram = 0;
+    }
+    if (p_cullprogram) {
+        glDeleteProgram(p_cullprogram);
+        p_cullprogram = 0;
+    }
+    if (p_pyramid) {
+        glDeleteTextures(1, &p_pyramid);
+        p_pyramid = 0;
+    }
+    if (p_sampler) {
+        glDeleteSamplers(1, &p_sampler);
+        p_sampler = 0;
+    }
+
+    p_width = 0;
+    p_height = 0;
+    p_levels = 0;
+}
+
+#ifdef GS_CONFIG_COMPUTE_SHADER
+
+GSerror GSOcclusionCuller::allocatePrograms()
+{
+    // programs are built on first use only
+    if (p_cullprogram) {
+        return GS_OK;
+    }
+
+    p_pyramidprogram = gl_compute_program(pyramid_shader);
+    p_cullprogram = gl_compute_program(cull_shader);
+
+    if (p_pyramidprogram == 0 || p_cullprogram == 0) {
+        ReleaseRendererResources();
+        return GSE_INVALIDOPERATION;
+    }
+
+    p_sourcelevel = glGetUniformLocation(p_pyramidprogram, "sourcelevel");
+    p_reduce = glGetUniformLocation(p_pyramidprogram, "reduce");
+    p_viewprojection = glGetUniformLocation(p_cullprogram, "viewprojection");
+    p_count = glGetUniformLocation(p_cullprogram, "count");
+
+    // sampler also makes depth texture complete for fetches
+    // regardless of its own filtering and compare setup
+    glGenSamplers(1, &p_sampler);
+    glSamplerParameteri(p_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(p_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(p_sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    return GS_OK;
+}
+
+GSerror GSOcclusionCuller::allocatePyramid(GSuint width, GSuint height)
+{
+    if (p_pyramid && p_width == width && p_height == height) {
+        return GS_OK;
+    }
+
+    if (p_pyramid) {
+        glDeleteTextures(1, &p_pyramid);
+        p_pyramid = 0;
+    }
+
+    p_width = width;
+    p_height = height;
+    p_levels = 1;
+    for (GSuint size = umax(width, height); size > 1; size >>= 1) {
+        ++p_levels;
+    }
+
+    glGenTextures(1, &p_pyramid);
+    glBindTexture(GL_TEXTURE_2D, p_pyramid);
+    glTexStorage2D(GL_TEXTURE_2D, p_levels, GL_R32F, p_width, p_height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return p_pyramid ? GS_OK : GSE_OUTOFRESOURCES;
+}
+
+void GSOcclusionCuller::buildPyramid(xGSTextureImpl *depth, GSuint depthlevel)
+{
+    glUseProgram(p_pyramidprogram);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindSampler(0, p_sampler);
+
+    // level 0 - copy of depth
+    glBindTexture(GL_TEXTURE_2D, depth->getID());
+    glBindImageTexture(0, p_pyramid, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glUniform1i(p_sourcelevel, GLint(depthlevel));
+    glUniform1i(p_reduce, 0);
+    glDispatchCompute(
+        (p_width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+        (p_height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+        1
+    );
+
+    // every next level is reduced from previous one
+    glBindTexture(GL_TEXTURE_2D, p_pyramid);
+    glUniform1i(p_reduce, 1);
+
+    for (GSuint level = 1; level < p_levels; ++level) {
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        GSuint width = umax(p_width >> level, 1u);
+        GSuint height = umax(p_height >> level, 1u);
+
+        glBindImageTexture(0, p_pyramid, GLint(level), GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glUniform1i(p_sourcelevel, GLint(level - 1));
+        glDispatchCompute(
+            (width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+            (height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+            1
+        );
+    }
+
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+}
+
+#endif
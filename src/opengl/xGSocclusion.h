@@ -0,0 +1,64 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGSocclusion.h
+        GPU occlusion culling helper class header
+            builds hierarchical depth from depth texture and culls
+            objects against it with compute shaders
+*/
+
+#pragma once
+
+#include "xGSGLutil.h"
+
+
+namespace xGS
+{
+
+    class xGSTextureImpl;
+    class xGSDataBufferImpl;
+
+
+    // GPU occlusion culling
+    //      Hi-Z pyramid level 0 is a copy of source depth, every next level holds
+    //      max depth of 2x2 (up to 3x3 for odd sizes) texels of previous level
+    class GSOcclusionCuller
+    {
+    public:
+        GSOcclusionCuller();
+
+        GSerror cull(
+            xGSTextureImpl *depth, GSuint depthlevel, GSuint width, GSuint height,
+            const GSfloat *viewprojection,
+            xGSDataBufferImpl *bounds, xGSDataBufferImpl *commands, GSuint count
+        );
+
+        void ReleaseRendererResources();
+
+    private:
+        GSerror allocatePrograms();
+        GSerror allocatePyramid(GSuint width, GSuint height);
+        void buildPyramid(xGSTextureImpl *depth, GSuint depthlevel);
+
+    private:
+        GLuint p_pyramidprogram;
+        GLuint p_cullprogram;
+        GLuint p_pyramid;       // Hi-Z texture
+        GLuint p_sampler;       // point sampler for depth and Hi-Z fetches
+        GSuint p_width;         // Hi-Z level 0 width
+        GSuint p_height;        // Hi-Z level 0 height
+        GSuint p_levels;        // Hi-Z level count
+
+        GLint  p_sourcelevel;   // pyramid program: source level uniform
+        GLint  p_reduce;        // pyramid program: reduce or copy uniform
+        GLint  p_viewprojection; // cull program: view-projection uniform
+        GLint  p_count;         // cull program: object count uniform
+    };
+
+} // namespace xGS
@@ -13,3 +13,5 @@
 
 #include "xGSGLutil.cpp"
 #include "xGScontextplatform.cpp"
+#include "xGSocclusion.cpp"
+#include "xGSmipgenerator.cpp"
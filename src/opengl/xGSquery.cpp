@@ -0,0 +1,82 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGSquery.cpp
+        Query object implementation class
+*/
+
+#include "xGSquery.h"
+#include "xGSimpl.h"
+
+
+using namespace xGS;
+
+
+static GLenum gl_query_target(GSenum type, const GScaps &caps)
+{
+    switch (type) {
+        case GS_QUERY_SAMPLES_PASSED:     return GL_SAMPLES_PASSED;
+        case GS_QUERY_ANY_SAMPLES_PASSED: return GL_ANY_SAMPLES_PASSED;
+
+        case GS_QUERY_ANY_SAMPLES_PASSED_CONSERVATIVE:
+#ifdef GS_CONFIG_CONSERVATIVE_QUERY
+            if (caps.conservative_query) {
+                return GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+            }
+#endif
+            // precise query gives valid result for conservative one
+            return GL_ANY_SAMPLES_PASSED;
+    }
+
+    return 0;
+}
+
+
+xGSQueryImpl::xGSQueryImpl(xGSImpl *owner) :
+    xGSObjectBase(owner),
+    p_query(0),
+    p_target(0)
+{}
+
+xGSQueryImpl::~xGSQueryImpl()
+{}
+
+GSbool xGSQueryImpl::AllocateImpl(GSenum type)
+{
+    p_target = gl_query_target(type, p_owner->caps());
+    if (p_target == 0) {
+        return GS_FALSE;
+    }
+
+    glGenQueries(1, &p_query);
+
+    return p_query != 0;
+}
+
+GSbool xGSQueryImpl::ResultAvailableImpl()
+{
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(p_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available != GL_FALSE;
+}
+
+GSuint64 xGSQueryImpl::ResultImpl()
+{
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(p_query, GL_QUERY_RESULT, &result);
+    return result;
+}
+
+void xGSQueryImpl::ReleaseRendererResources()
+{
+    if (p_query) {
+        glDeleteQueries(1, &p_query);
+        p_query = 0;
+    }
+}
@@ -0,0 +1,47 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    opengl/xGSquery.h
+        Query object implementation class header
+            this object wraps GPU occlusion query
+*/
+
+#pragma once
+
+#include "xGSimplbase.h"
+#include "xGSGLutil.h"
+
+
+namespace xGS
+{
+
+    // query object
+    class xGSQueryImpl : public xGSObjectBase<xGSQueryBase, xGSImpl>
+    {
+    public:
+        xGSQueryImpl(xGSImpl *owner);
+        ~xGSQueryImpl() override;
+
+    public:
+        GLuint query() const { return p_query; }
+        GLenum target() const { return p_target; }
+
+        GSbool AllocateImpl(GSenum type);
+
+        GSbool ResultAvailableImpl();
+        GSuint64 ResultImpl();
+
+        void ReleaseRendererResources();
+
+    private:
+        GLuint p_query;
+        GLenum p_target;
+    };
+
+} // namespace xGS
@@ -21,6 +21,21 @@ using namespace xGS;
 using namespace std;
 
 
+// members of named block instances are reported with block name prefix
+// and arrays are reported with [0] suffix, strip them both to match
+// names in data buffer description
+static void block_member_name(string &name, const string &blockname)
+{
+    if (name.compare(0, blockname.length(), blockname) == 0 && name[blockname.length()] == '.') {
+        name.erase(0, blockname.length() + 1);
+    }
+    size_t bracket = name.rfind("[0]");
+    if (bracket != string::npos && bracket + 3 == name.length()) {
+        name.erase(bracket);
+    }
+}
+
+
 xGSStateImpl::xGSStateImpl(xGSImpl *owner) :
     xGSObjectBase(owner),
     p_program(0),
@@ -120,6 +135,7 @@ GSbool xGSStateImpl::AllocateImpl(const GSstatedescription &desc, GSuint statici
     EnumAttributes();
     EnumUniforms();
     EnumUniformBlocks();
+    EnumStorageBlocks();
 
 
     // gather parameters info
@@ -144,6 +160,14 @@ GSbool xGSStateImpl::AllocateImpl(const GSstatedescription &desc, GSuint statici
                     }
                     break;
 
+                case GSPD_STORAGEBLOCK:
+#ifdef GS_CONFIG_STORAGE_BUFFER
+                    if (slot.location == GS_DEFAULT && p_owner->caps().storage_buffer) {
+                        slot.location = glGetProgramResourceIndex(p_program, GL_SHADER_STORAGE_BLOCK, param->name);
+                    }
+#endif
+                    break;
+
                 case GSPD_TEXTURE: {
                     GSint location = param->location == GS_DEFAULT ?
                         glGetUniformLocation(p_program, param->name) : param->location;
@@ -262,40 +286,55 @@ GLint xGSStateImpl::attribLocation(const char *name) const
 void xGSStateImpl::setarrays(const GSvertexdecl &decl, GSuint divisor, GSptr vertexptr) const
 {
     GSint stride = decl.buffer_size();
-    GSint offset = 0;
+    const std::vector<GSvertexcomponent> &components = decl.declaration();
 
-    for (auto const &i : decl.declaration())
+    for (size_t n = 0; n < components.size(); ++n)
     {
+        const GSvertexcomponent &i = components[n];
+        GSuint offset = decl.offset(n);
+
         GLint attrib = attribLocation(i.name);
         if (attrib != -1) {
             glEnableVertexAttribArray(attrib);
-            glVertexAttribPointer(
-                attrib, vertex_component_count(i), GL_FLOAT, GL_FALSE,
-                stride, ptr_offset(vertexptr, offset)
-            );
+            if (vertex_component_integer(i)) {
+                glVertexAttribIPointer(
+                    attrib, vertex_component_count(i), gl_vertex_component_type(i),
+                    stride, ptr_offset(vertexptr, offset)
+                );
+            } else {
+                glVertexAttribPointer(
+                    attrib, vertex_component_count(i), gl_vertex_component_type(i),
+                    gl_vertex_component_normalized(i), stride, ptr_offset(vertexptr, offset)
+                );
+            }
             glVertexAttribDivisor(attrib, divisor);
         }
-
-        offset += vertex_component_size(i);
     }
 }
 
 void xGSStateImpl::setformat(const GSvertexdecl &decl, GSuint binding, GSuint divisor) const
 {
 #ifdef GS_CONFIG_SEPARATE_VERTEX_FORMAT
-    //GSint stride = decl.buffer_size();
-    GSint offset = 0;
+    const std::vector<GSvertexcomponent> &components = decl.declaration();
 
-    for (auto const &i : decl.declaration())
+    for (size_t n = 0; n < components.size(); ++n)
     {
+        const GSvertexcomponent &i = components[n];
+        GSuint offset = decl.offset(n);
+
         GLint attrib = i.index == GS_DEFAULT ? attribLocation(i.name) : i.index;
         if (attrib != -1) {
             glEnableVertexAttribArray(attrib);
-            glVertexAttribFormat(attrib, vertex_component_count(i), GL_FLOAT, GL_FALSE, offset);
+            if (vertex_component_integer(i)) {
+                glVertexAttribIFormat(attrib, vertex_component_count(i), gl_vertex_component_type(i), offset);
+            } else {
+                glVertexAttribFormat(
+                    attrib, vertex_component_count(i), gl_vertex_component_type(i),
+                    gl_vertex_component_normalized(i), offset
+                );
+            }
             glVertexAttribBinding(attrib, binding);
         }
-
-        offset += vertex_component_size(i);
     }
 
     glVertexBindingDivisor(binding, divisor);
@@ -429,6 +468,38 @@ GSbool xGSStateImpl::uniformIsSampler(GLenum type) const
            (type == GL_SAMPLER_BUFFER);
 }
 
+GSbool xGSStateImpl::samplerUniform(GLint location) const
+{
+    for (auto &u : p_uniforms) {
+        if (u.location == location) {
+            return u.sampler;
+        }
+    }
+
+    return GS_FALSE;
+}
+
+GSenum xGSStateImpl::uniformLayoutType(GLenum type) const
+{
+    switch (type) {
+        case GL_FLOAT:      return GSU_SCALAR;
+        case GL_FLOAT_VEC2: return GSU_VEC2;
+        case GL_FLOAT_VEC3: return GSU_VEC3;
+        case GL_FLOAT_VEC4: return GSU_VEC4;
+        case GL_FLOAT_MAT2: return GSU_MAT2;
+        case GL_FLOAT_MAT3: return GSU_MAT3;
+        case GL_FLOAT_MAT4: return GSU_MAT4;
+
+    }
+
+    // bindless handles inside blocks are declared as samplers
+    if (uniformIsSampler(type)) {
+        return GSU_HANDLE;
+    }
+
+    return GSU_END;
+}
+
 void xGSStateImpl::AttachShaders(GLenum type, const char **source, vector<GLuint> &shaders)
 {
     if (source == nullptr) {
@@ -568,6 +639,8 @@ void xGSStateImpl::EnumUniformBlocks()
     p_owner->debug(DebugMessageLevel::Information, "Program active uniform blocks:\n");
 #endif
     p_uniformblocks.clear();
+    p_uniformblocklayouts.clear();
+    p_uniformlayouts.clear();
     for (int n = 0; n < uniformblockcount; ++n) {
         char name[256];
         GLsizei len = 0;
@@ -584,6 +657,35 @@ void xGSStateImpl::EnumUniformBlocks()
 
         p_uniformblocks.push_back(u);
 
+        UniformBlockLayout blocklayout = {
+            name,                            // name
+            false,                           // storage
+            u.datasize,                      // datasize
+            GSuint(p_uniformlayouts.size()), // firstuniform
+            GSuint(p_uniformlayouts.size())  // onepastlastuniform
+        };
+
+        for (auto const &uniform : p_uniforms) {
+            if (uniform.blockindex != GSuint(n)) {
+                continue;
+            }
+
+            UniformLayout layout;
+            layout.name = uniform.name;
+            layout.type = uniformLayoutType(uniform.type);
+            layout.offset = uniform.offset;
+            layout.arraystride = uniform.arraystride;
+            layout.matrixstride = uniform.matrixstride;
+            layout.count = uniform.size;
+
+            block_member_name(layout.name, blocklayout.name);
+
+            p_uniformlayouts.push_back(layout);
+            ++blocklayout.onepastlastuniform;
+        }
+
+        p_uniformblocklayouts.push_back(blocklayout);
+
         // 1:1 index to binding point mapping
         //glUniformBlockBinding(p_program, n, n);
 
@@ -623,6 +725,85 @@ void xGSStateImpl::EnumUniformBlocks()
     }
 }
 
+void xGSStateImpl::EnumStorageBlocks()
+{
+#ifdef GS_CONFIG_STORAGE_BUFFER
+    if (!p_owner->caps().storage_buffer) {
+        return;
+    }
+
+    // storage blocks aren't reported by uniform queries, their layouts
+    // are taken from program interface of buffer variables
+    GLint storageblockcount = 0;
+    glGetProgramInterfaceiv(p_program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &storageblockcount);
+#ifdef _DEBUG
+    p_owner->debug(DebugMessageLevel::Information, "Program active storage blocks:\n");
+#endif
+    for (int n = 0; n < storageblockcount; ++n) {
+        char name[256];
+        GLsizei len = 0;
+        glGetProgramResourceName(p_program, GL_SHADER_STORAGE_BLOCK, n, 255, &len, name);
+        name[len] = 0;
+
+        static const GLenum blockprops[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+        GLint blockvalues[2] = { 0, 0 };
+        glGetProgramResourceiv(p_program, GL_SHADER_STORAGE_BLOCK, n, 2, blockprops, 2, nullptr, blockvalues);
+
+        UniformBlockLayout blocklayout = {
+            name,                            // name
+            true,                            // storage
+            GSuint(blockvalues[0]),          // datasize
+            GSuint(p_uniformlayouts.size()), // firstuniform
+            GSuint(p_uniformlayouts.size())  // onepastlastuniform
+        };
+
+        std::vector<GLint> variables(blockvalues[1]);
+        if (blockvalues[1]) {
+            static const GLenum activevariables = GL_ACTIVE_VARIABLES;
+            glGetProgramResourceiv(
+                p_program, GL_SHADER_STORAGE_BLOCK, n, 1, &activevariables,
+                blockvalues[1], nullptr, variables.data()
+            );
+        }
+
+        for (auto variable : variables) {
+            glGetProgramResourceName(p_program, GL_BUFFER_VARIABLE, variable, 255, &len, name);
+            name[len] = 0;
+
+            static const GLenum props[] = {
+                GL_TYPE, GL_OFFSET, GL_ARRAY_SIZE, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE
+            };
+            GLint values[5] = { 0, 0, 0, 0, 0 };
+            glGetProgramResourceiv(p_program, GL_BUFFER_VARIABLE, variable, 5, props, 5, nullptr, values);
+
+            UniformLayout layout;
+            layout.name = name;
+            layout.type = uniformLayoutType(values[0]);
+            layout.offset = values[1];
+            layout.arraystride = values[3];
+            layout.matrixstride = values[4];
+            // zero array size is reported for last runtime sized array of block
+            layout.count = values[2] ? values[2] : GS_UNDEFINED;
+
+            block_member_name(layout.name, blocklayout.name);
+
+            p_uniformlayouts.push_back(layout);
+            ++blocklayout.onepastlastuniform;
+        }
+
+#ifdef _DEBUG
+        p_owner->debug(
+            DebugMessageLevel::Information,
+            "    Storage block #%i: %s, datasize: %i, variables: %i\n",
+            n, blocklayout.name.c_str(), blockvalues[0], blockvalues[1]
+        );
+#endif
+
+        p_uniformblocklayouts.push_back(blocklayout);
+    }
+#endif
+}
+
 template<typename T>
 void xGSStateImpl::CreateElementIndex(ElementIndexMap &map, const T &elementlist) const
 {
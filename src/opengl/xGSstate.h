@@ -40,6 +40,10 @@ namespace xGS
 
         bool depthMask() const { return p_depthmask; }
 
+        // uniform at location is sampler, bindless handles for such uniforms
+        // are set as 64-bit handles
+        GSbool samplerUniform(GLint location) const;
+
         void setarrays(const GSvertexdecl &decl, GSuint divisor, GSptr vertexptr) const;
         void setformat(const GSvertexdecl &decl, GSuint binding, GSuint divisor) const;
 
@@ -53,12 +57,14 @@ namespace xGS
         typedef std::unordered_map<std::string, GSint> ElementIndexMap;
 
         GSbool uniformIsSampler(GLenum type) const;
+        GSenum uniformLayoutType(GLenum type) const;
 
         void AttachShaders(GLenum type, const char **source, std::vector<GLuint> &shaders);
 
         void EnumAttributes();
         void EnumUniforms();
         void EnumUniformBlocks();
+        void EnumStorageBlocks();
 
         template<typename T>
         void CreateElementIndex(ElementIndexMap &map, const T &elementlist) const;
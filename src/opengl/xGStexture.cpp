@@ -22,7 +22,10 @@ using namespace c_util;
 xGSTextureImpl::xGSTextureImpl(xGSImpl *owner) :
     xGSObjectBase(owner),
     p_texture(0),
-    p_buffer(0)
+    p_buffer(0),
+    p_lockbuffer(0),
+    p_locksize(0),
+    p_handles()
 {}
 
 xGSTextureImpl::~xGSTextureImpl()
@@ -41,6 +44,7 @@ GSbool xGSTextureImpl::AllocateImpl()
     p_GLIntFormat = texdesc.GLIntFormat;
     p_GLFormat = texdesc.GLFormat;
     p_GLType = texdesc.GLType;
+    p_compressed = texture_block_size(p_format) != 0;
 
     p_target = gl_texture_bind_target(p_texturetype, p_layers > 0, p_multisample > 0);
 
@@ -58,7 +62,36 @@ GSbool xGSTextureImpl::AllocateImpl()
         glTexParameteri(p_target, GL_TEXTURE_BASE_LEVEL, p_minlevel);
         glTexParameteri(p_target, GL_TEXTURE_MAX_LEVEL, p_maxlevel);
 
+#ifdef GS_CONFIG_SPARSE_TEXTURE
+        // sparse storage uses first virtual page size of the format,
+        // support for it has been checked before texture allocation
+        if (sparse()) {
+            glTexParameteri(p_target, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+            glTexParameteri(p_target, GL_VIRTUAL_PAGE_SIZE_INDEX_ARB, 0);
+        }
+#endif
+
         SetImage(p_target, (p_maxlevel - p_minlevel) > 0 && p_texturetype != GS_TEXTYPE_RECT);
+
+#ifdef GS_CONFIG_SPARSE_TEXTURE
+        if (sparse()) {
+            GLint levels = 0;
+            glGetTexParameteriv(p_target, GL_NUM_SPARSE_LEVELS_ARB, &levels);
+            p_sparselevels = levels;
+
+            GLint pagesize[3] = { 1, 1, 1 };
+            glGetInternalformativ(p_target, p_GLIntFormat, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pagesize[0]);
+            glGetInternalformativ(p_target, p_GLIntFormat, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &pagesize[1]);
+            glGetInternalformativ(p_target, p_GLIntFormat, GL_VIRTUAL_PAGE_SIZE_Z_ARB, 1, &pagesize[2]);
+            for (int n = 0; n < 3; ++n) {
+                p_pagesize[n] = pagesize[n];
+            }
+
+            p_pagebytes =
+                texture_image_pitch(p_format, p_bpp, p_pagesize[0]) *
+                texture_image_rows(p_format, p_pagesize[1]) * p_pagesize[2];
+        }
+#endif
     }
 
     return p_owner->error(GS_OK);
@@ -68,6 +101,8 @@ GSptr xGSTextureImpl::LockImpl(GSenum locktype, GSdword access, GSint level, GSi
 {
     GLenum buffer_target = 0;
     GLenum buffer_usage = 0;
+    GLintptr read_offset = 0;
+    GLsizeiptr read_size = 0;
 
     if (p_texturetype == GS_TEXTYPE_BUFFER) {
         buffer_target = GL_TEXTURE_BUFFER;
@@ -85,24 +120,51 @@ GSptr xGSTextureImpl::LockImpl(GSenum locktype, GSdword access, GSint level, GSi
                 break;
         }
 
-        glGenBuffers(1, &p_lockbuffer);
-        glBindBuffer(buffer_target, p_lockbuffer);
-
-        GLsizeiptr size = 0;
-        switch (p_texturetype) {
-            case GS_TEXTYPE_1D:      size = p_width >> level; break;
-            case GS_TEXTYPE_2D:      size = umax(p_width >> level, 1u) * umax(p_height >> level, 1u); break;
-            case GS_TEXTYPE_3D:      size = umax(p_width >> level, 1u) * umax(p_height >> level, 1u) * umax(p_depth >> level, 1u); break;
-            case GS_TEXTYPE_CUBEMAP: size = umax(p_width >> level, 1u) * umax(p_height >> level, 1u); break;
+        GSuint pitch;
+        GSuint rows;
+        GSuint size = ImageSize(level, pitch, rows);
+
+        // level of array texture is read back with all its layers and faces,
+        // so staging buffer holds all of them and only requested image is mapped
+        bool cubemap = p_texturetype == GS_TEXTYPE_CUBEMAP;
+        GLenum face = gl_cubemap_face(locktype);
+        GSuint images = 1;
+        GSuint image = 0;
+        if (access == GS_READ && p_layers > 0) {
+            images = p_layers * (cubemap ? 6 : 1);
+            image = cubemap ?
+                layer * 6 + (face ? face - GL_TEXTURE_CUBE_MAP_POSITIVE_X : 0) :
+                layer;
         }
-        size *= p_bpp;
 
-        // TODO: immutable buffer
-        glBufferData(buffer_target, size, nullptr, buffer_usage);
+        p_lockbuffer = p_owner->stagingPool().acquire(buffer_target, size * images, buffer_usage);
+        p_locksize = size * images;
 
         if (access == GS_READ) {
+            // single cubemap face is read with its face target
+            GLenum target = cubemap && p_layers == 0 && face ? face : p_target;
+
+            GLint current = 0;
+            glGetIntegerv(gl_texture_binding(p_target), &current);
             glBindTexture(p_target, p_texture);
-            glGetTexImage(p_target, level, p_GLFormat, p_GLType, nullptr);
+
+            if (p_compressed) {
+                glGetCompressedTexImage(target, level, nullptr);
+            } else {
+                glGetTexImage(target, level, p_GLFormat, p_GLType, nullptr);
+            }
+
+            glBindTexture(p_target, GLuint(current));
+
+            read_offset = GLintptr(size) * image;
+            read_size = size;
+        }
+
+        if (lockdata) {
+            GStexturelockdata *layout = reinterpret_cast<GStexturelockdata*>(lockdata);
+            layout->size = size;
+            layout->pitch = pitch;
+            layout->rows = rows;
         }
     }
 
@@ -113,6 +175,10 @@ GSptr xGSTextureImpl::LockImpl(GSenum locktype, GSdword access, GSint level, GSi
 
     p_owner->error(GS_OK);
 
+    if (read_size) {
+        return glMapBufferRange(buffer_target, read_offset, read_size, GL_MAP_READ_BIT);
+    }
+
     return glMapBuffer(buffer_target, GL_WRITE_ONLY);
 }
 
@@ -151,8 +217,9 @@ void xGSTextureImpl::UnlockImpl()
                 break;
         }
 
-        glDeleteBuffers(1, &p_lockbuffer);
+        p_owner->stagingPool().release(p_lockbuffer, p_locksize);
         p_lockbuffer = 0;
+        p_locksize = 0;
     }
 
     p_lockaccess = 0;
@@ -160,6 +227,131 @@ void xGSTextureImpl::UnlockImpl()
     p_locktype = GS_NONE;
 }
 
+bool xGSTextureImpl::UpdateRegions(const GStextureregion *regions, GSuint count)
+{
+    // region rows are packed tightly, renderer sets unpack alignment to 1
+    GSuint size = 0;
+    for (GSuint n = 0; n < count; ++n) {
+        const GStextureregion &r = regions[n];
+        size += (r.width + r.border * 2) * p_bpp * (r.height + r.border * 2);
+    }
+
+    GLuint buffer = p_owner->stagingPool().acquire(GL_PIXEL_UNPACK_BUFFER, size, GL_STREAM_DRAW);
+
+    unsigned char *memory = reinterpret_cast<unsigned char*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+    if (!memory) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        p_owner->stagingPool().release(buffer, size);
+        return false;
+    }
+
+    GSuint offset = 0;
+    for (GSuint n = 0; n < count; ++n) {
+        const GStextureregion &r = regions[n];
+        GSuint pitch = (r.width + r.border * 2) * p_bpp;
+        texture_region_copy(memory + offset, pitch, r, p_bpp);
+        offset += pitch * (r.height + r.border * 2);
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // texture is bound to active unit for upload only, so previous binding is restored
+    GLint current = 0;
+    glGetIntegerv(gl_texture_binding(p_target), &current);
+    glBindTexture(p_target, p_texture);
+
+    offset = 0;
+    for (GSuint n = 0; n < count; ++n) {
+        const GStextureregion &r = regions[n];
+        GSuint width = r.width + r.border * 2;
+        GSuint height = r.height + r.border * 2;
+        const GLvoid *data = reinterpret_cast<const GLvoid*>(size_t(offset));
+
+        if (p_layers > 0) {
+            glTexSubImage3D(p_target, 0, r.x, r.y, r.layer, width, height, 1, p_GLFormat, p_GLType, data);
+        } else {
+            glTexSubImage2D(p_target, 0, r.x, r.y, width, height, p_GLFormat, p_GLType, data);
+        }
+
+        offset += width * p_bpp * height;
+    }
+
+    glBindTexture(p_target, GLuint(current));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    p_owner->stagingPool().release(buffer, size);
+
+    return true;
+}
+
+void xGSTextureImpl::SetBaseLevel(GSuint level)
+{
+    p_minlevel = level;
+
+    // texture is bound to active unit for parameter change only, so previous binding is restored
+    GLint current = 0;
+    glGetIntegerv(gl_texture_binding(p_target), &current);
+    glBindTexture(p_target, p_texture);
+    glTexParameteri(p_target, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(p_target, GLuint(current));
+}
+
+void xGSTextureImpl::CommitLevel(GSuint level, GSbool commit)
+{
+    // whole level of every layer and face, cubemap faces are layers for commitment
+    GSuint width = umax(p_width >> level, 1u);
+    GSuint height = umax(p_height >> level, 1u);
+    GSuint depth = p_texturetype == GS_TEXTYPE_3D ?
+        umax(p_depth >> level, 1u) :
+        umax(p_layers, 1u) * (p_texturetype == GS_TEXTYPE_CUBEMAP ? 6 : 1);
+
+    CommitRegion(level, 0, 0, 0, width, height, depth, commit);
+}
+
+void xGSTextureImpl::CommitRegion(GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit)
+{
+#ifdef GS_CONFIG_SPARSE_TEXTURE
+    // texture is bound to active unit for commitment only, so previous binding is restored
+    GLint current = 0;
+    glGetIntegerv(gl_texture_binding(p_target), &current);
+    glBindTexture(p_target, p_texture);
+    glTexPageCommitmentARB(p_target, level, x, y, z, width, height, depth, commit);
+    glBindTexture(p_target, GLuint(current));
+#endif
+}
+
+GLuint64 xGSTextureImpl::handle(GSenum sampler)
+{
+#ifdef GS_CONFIG_BINDLESS_TEXTURE
+    for (auto &h : p_handles) {
+        if (h.sampler == sampler) {
+            return h.handle;
+        }
+    }
+
+    GLuint64 result = sampler == GS_DEFAULT ?
+        glGetTextureHandleARB(p_texture) :
+        glGetTextureSamplerHandleARB(p_texture, p_owner->sampler(sampler - GSS_0));
+    if (result == 0) {
+        return 0;
+    }
+
+    glMakeTextureHandleResidentARB(result);
+
+    // sampler state used by handle can't change, so it's kept referenced
+    if (sampler != GS_DEFAULT) {
+        p_owner->referenceSampler(sampler - GSS_0);
+    }
+
+    Handle h = { sampler, result };
+    p_handles.push_back(h);
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
 void xGSTextureImpl::bindNullTexture()
 {
     const GSuint target_count = 10;
@@ -191,6 +383,16 @@ void xGSTextureImpl::ReleaseRendererResources()
         UnlockImpl();
     }
 
+#ifdef GS_CONFIG_BINDLESS_TEXTURE
+    for (auto &h : p_handles) {
+        glMakeTextureHandleNonResidentARB(h.handle);
+        if (h.sampler != GS_DEFAULT) {
+            p_owner->dereferenceSampler(h.sampler - GSS_0);
+        }
+    }
+#endif
+    p_handles.clear();
+
     if (p_texture) {
         glDeleteTextures(1, &p_texture);
         p_texture = 0;
@@ -388,6 +590,29 @@ void xGSTextureImpl::SetImage3D(GLenum gltarget, bool mipcascade)
 
 void xGSTextureImpl::UpdateImage(GLenum gltarget, int level, GSptr data)
 {
+    if (p_compressed) {
+        // block compressed images are 2D only, see IxGSTextureImpl::allocate
+        GSuint pitch;
+        GSuint rows;
+        GLsizei size = ImageSize(level, pitch, rows);
+
+        if (gltarget == GL_TEXTURE_2D_ARRAY) {
+            glCompressedTexSubImage3D(
+                gltarget, level, 0, 0, p_locklayer,
+                umax(p_width >> level, 1u), umax(p_height >> level, 1u), 1,
+                p_GLIntFormat, size, data
+            );
+        } else {
+            glCompressedTexSubImage2D(
+                gltarget, level, 0, 0,
+                umax(p_width >> level, 1u), umax(p_height >> level, 1u),
+                p_GLIntFormat, size, data
+            );
+        }
+
+        return;
+    }
+
     switch (gltarget) {
         case GL_TEXTURE_1D:
             glTexSubImage1D(gltarget, level, 0, p_width >> level, p_GLFormat, p_GLType, data);
@@ -420,3 +645,15 @@ void xGSTextureImpl::UpdateImage(GLenum gltarget, int level, GSptr data)
             break;
     }
 }
+
+GSuint xGSTextureImpl::ImageSize(int level, GSuint &pitch, GSuint &rows) const
+{
+    GSuint width = umax(p_width >> level, 1u);
+    GSuint height = p_texturetype == GS_TEXTYPE_1D ? 1 : umax(p_height >> level, 1u);
+    GSuint depth = p_texturetype == GS_TEXTYPE_3D ? umax(p_depth >> level, 1u) : 1;
+
+    pitch = texture_image_pitch(p_format, p_bpp, width);
+    rows = texture_image_rows(p_format, height);
+
+    return pitch * rows * depth;
+}
@@ -33,10 +33,23 @@ namespace xGS
         GLuint getID() const { return p_texture; }
         GLuint getBufferID() const { return p_buffer; }
         GLenum target() const { return p_target; }
+        GLenum internalFormat() const { return p_GLIntFormat; }
 
         GSptr LockImpl(GSenum locktype, GSdword access, GSint level, GSint layer, void *lockdata);
         void UnlockImpl();
 
+        // uploads regions of level 0 through single staging buffer
+        bool UpdateRegions(const GStextureregion *regions, GSuint count);
+
+        // streaming: defined levels range and level memory commitment for sparse texture
+        void SetBaseLevel(GSuint level);
+        void CommitLevel(GSuint level, GSbool commit);
+        void CommitRegion(GSuint level, GSuint x, GSuint y, GSuint z, GSuint width, GSuint height, GSuint depth, GSbool commit);
+
+        // bindless: resident handle for given sampler (GS_DEFAULT for texture own state),
+        // handles are kept until texture is released
+        GLuint64 handle(GSenum sampler);
+
         static void bindNullTexture();
 
         void ReleaseRendererResources();
@@ -50,17 +63,29 @@ namespace xGS
 
         void UpdateImage(GLenum gltarget, int level, GSptr data);
 
+        GSuint ImageSize(int level, GSuint &pitch, GSuint &rows) const;
+
     private:
         GSint   p_bpp;          // format: BYTES per pixel
         GLenum  p_target;       // format: GL texture target
         GLenum  p_GLIntFormat;  // format: GL internal format
         GLenum  p_GLFormat;     // format: GL format for TexImage/TexSubImage
         GLenum  p_GLType;       // format: GL type for TexImage/TexSubImage
+        bool    p_compressed;   // format: block compressed image data
 
         GLuint  p_texture;      // GL texture ID
         GLuint  p_buffer;       // GL buffer ID for texture
 
-        GLuint  p_lockbuffer;   // LOCK: GL pixel buffer ID
+        GLuint  p_lockbuffer;   // LOCK: GL pixel buffer ID from staging pool
+        GSuint  p_locksize;     // LOCK: locked image size
+
+        struct Handle
+        {
+            GSenum   sampler;
+            GLuint64 handle;
+        };
+
+        std::vector<Handle> p_handles; // BINDLESS: resident texture handles
     };
 
 } // namespace xGS
@@ -0,0 +1,133 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSatlas.cpp
+        Texture atlas packer class
+*/
+
+#include "xGSatlas.h"
+
+
+using namespace xGS;
+
+
+AtlasPacker::AtlasPacker() :
+    p_width(0),
+    p_height(0)
+{}
+
+void AtlasPacker::configure(GSuint width, GSuint height, GSuint layers)
+{
+    p_width = width;
+    p_height = height;
+    p_layers.resize(layers);
+
+    clear();
+}
+
+bool AtlasPacker::allocate(GSuint width, GSuint height, GSuint &x, GSuint &y, GSuint &layer)
+{
+    if (width == 0 || height == 0 || width > p_width || height > p_height) {
+        return false;
+    }
+
+    for (size_t l = 0; l < p_layers.size(); ++l) {
+        Skyline &skyline = p_layers[l];
+
+        // lowest top edge, the leftmost one for equal edges
+        size_t best = skyline.size();
+        GSuint besttop = 0;
+        GSuint besty = 0;
+
+        for (size_t n = 0; n < skyline.size(); ++n) {
+            GSuint top;
+            if (fit(skyline, n, width, height, top) && (best == skyline.size() || top + height < besttop)) {
+                best = n;
+                besttop = top + height;
+                besty = top;
+            }
+        }
+
+        if (best < skyline.size()) {
+            x = skyline[best].x;
+            y = besty;
+            layer = GSuint(l);
+
+            place(skyline, best, width, height, besty);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AtlasPacker::clear()
+{
+    for (auto &skyline : p_layers) {
+        Segment segment = { 0, 0, p_width };
+        skyline.assign(1, segment);
+    }
+}
+
+bool AtlasPacker::fit(const Skyline &skyline, size_t index, GSuint width, GSuint height, GSuint &y) const
+{
+    GSuint x = skyline[index].x;
+    if (x + width > p_width) {
+        return false;
+    }
+
+    // rectangle rests on the highest segment it spans
+    y = 0;
+    GSuint remaining = width;
+    for (size_t n = index; remaining > 0; ++n) {
+        const Segment &segment = skyline[n];
+
+        if (segment.y > y) {
+            y = segment.y;
+        }
+        if (y + height > p_height) {
+            return false;
+        }
+
+        remaining = segment.width < remaining ? remaining - segment.width : 0;
+    }
+
+    return true;
+}
+
+void AtlasPacker::place(Skyline &skyline, size_t index, GSuint width, GSuint height, GSuint y)
+{
+    Segment segment = { skyline[index].x, y + height, width };
+    skyline.insert(skyline.begin() + index, segment);
+
+    // cut segments covered by new one
+    GSuint right = segment.x + width;
+    size_t n = index + 1;
+    while (n < skyline.size() && skyline[n].x < right) {
+        GSuint cut = right - skyline[n].x;
+        if (cut >= skyline[n].width) {
+            skyline.erase(skyline.begin() + n);
+        } else {
+            skyline[n].x += cut;
+            skyline[n].width -= cut;
+            break;
+        }
+    }
+
+    // merge neighbour segments of the same height
+    for (n = 1; n < skyline.size();) {
+        if (skyline[n - 1].y == skyline[n].y) {
+            skyline[n - 1].width += skyline[n].width;
+            skyline.erase(skyline.begin() + n);
+        } else {
+            ++n;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSatlas.h
+        Texture atlas packer class header
+            allocates rectangles for atlas images across texture layers
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include <vector>
+
+
+namespace xGS
+{
+
+    // skyline rectangle packer
+    //      every layer keeps its skyline - top edge of occupied area as list of
+    //      horizontal segments, rectangle is placed at the lowest position where
+    //      it fits on top of the skyline, layers are filled in order
+    //      area under skyline is never reused, so freed rectangles are reclaimed
+    //      only by clearing packer and allocating remaining rectangles again
+    class AtlasPacker
+    {
+    public:
+        AtlasPacker();
+
+        void configure(GSuint width, GSuint height, GSuint layers);
+
+        bool allocate(GSuint width, GSuint height, GSuint &x, GSuint &y, GSuint &layer);
+        void clear();
+
+    private:
+        struct Segment
+        {
+            GSuint x;
+            GSuint y;
+            GSuint width;
+        };
+
+        typedef std::vector<Segment> Skyline;
+
+        bool fit(const Skyline &skyline, size_t index, GSuint width, GSuint height, GSuint &y) const;
+        void place(Skyline &skyline, size_t index, GSuint width, GSuint height, GSuint y);
+
+    private:
+        std::vector<Skyline> p_layers;
+        GSuint               p_width;
+        GSuint               p_height;
+    };
+
+} // namespace xGS
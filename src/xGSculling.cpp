@@ -0,0 +1,277 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSculling.cpp
+        Frustum culling and LOD selection functions
+*/
+
+#include "xGSculling.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #define GS_CULLING_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+using namespace xGS;
+
+
+// minimal number of objects worth running on separate thread
+static const GSuint CULL_THREAD_BATCH = 1024;
+
+// LOD selection distance limit, objects closer than this get LOD 0
+static const GSfloat CULL_MIN_W = 1e-5f;
+
+
+// culling input, bounds are converted into center, extents and
+// LOD radius for both sphere and box objects
+struct CullBounds
+{
+    const GSfloat *planes;
+    const GSfloat *wrow;          // 4th row of view-projection matrix (w component)
+    GSenum         type;
+    const GSfloat *bounds;
+    GSuint         lodcount;
+    const GSfloat *lodthresholds;
+    GSfloat        lodscale;
+};
+
+static inline void object_bounds(const CullBounds &cull, GSuint object, GSfloat *center, GSfloat *extents, GSfloat &radius)
+{
+    if (cull.type == GS_BOUNDS_SPHERE) {
+        const GSfloat *sphere = cull.bounds + object * 4;
+        center[0] = sphere[0];
+        center[1] = sphere[1];
+        center[2] = sphere[2];
+        extents[0] = extents[1] = extents[2] = radius = sphere[3];
+    } else {
+        const GSfloat *box = cull.bounds + object * 6;
+        for (int c = 0; c < 3; ++c) {
+            center[c] = (box[c] + box[c + 3]) * 0.5f;
+            extents[c] = (box[c + 3] - box[c]) * 0.5f;
+        }
+        radius = sqrtf(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]);
+    }
+}
+
+static unsigned char cull_object(const CullBounds &cull, GSuint object)
+{
+    GSfloat center[3];
+    GSfloat extents[3];
+    GSfloat radius;
+    object_bounds(cull, object, center, extents, radius);
+
+    for (int p = 0; p < 6; ++p) {
+        const GSfloat *plane = cull.planes + p * 4;
+        GSfloat distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+        GSfloat effective = cull.type == GS_BOUNDS_SPHERE ?
+            radius :
+            fabsf(plane[0]) * extents[0] + fabsf(plane[1]) * extents[1] + fabsf(plane[2]) * extents[2];
+        if (distance < -effective) {
+            return 0;
+        }
+    }
+
+    GSuint lod = 0;
+    if (cull.lodcount > 1) {
+        GSfloat w =
+            cull.wrow[0] * center[0] + cull.wrow[1] * center[1] +
+            cull.wrow[2] * center[2] + cull.wrow[3];
+
+        if (w > CULL_MIN_W) {
+            GSfloat size = radius * cull.lodscale / w;
+            for (GSuint n = 0; n < cull.lodcount - 1; ++n) {
+                lod += size < cull.lodthresholds[n];
+            }
+        }
+    }
+
+    return static_cast<unsigned char>(lod + 1);
+}
+
+#ifdef GS_CULLING_SSE2
+static inline __m128 abs_ps(__m128 value)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+// culls 4 objects at once, bounds are transposed into SoA form
+static void cull_objects4(const CullBounds &cull, GSuint object, unsigned char *visible)
+{
+    __m128 cx, cy, cz;
+    __m128 ex, ey, ez;
+    __m128 radius;
+
+    if (cull.type == GS_BOUNDS_SPHERE) {
+        const GSfloat *sphere = cull.bounds + object * 4;
+        cx = _mm_loadu_ps(sphere);
+        cy = _mm_loadu_ps(sphere + 4);
+        cz = _mm_loadu_ps(sphere + 8);
+        radius = _mm_loadu_ps(sphere + 12);
+        _MM_TRANSPOSE4_PS(cx, cy, cz, radius);
+        ex = ey = ez = radius;
+    } else {
+        GSfloat c[3][4];
+        GSfloat e[3][4];
+        GSfloat r[4];
+        for (int n = 0; n < 4; ++n) {
+            GSfloat center[3];
+            GSfloat extents[3];
+            object_bounds(cull, object + n, center, extents, r[n]);
+            for (int i = 0; i < 3; ++i) {
+                c[i][n] = center[i];
+                e[i][n] = extents[i];
+            }
+        }
+        cx = _mm_loadu_ps(c[0]);
+        cy = _mm_loadu_ps(c[1]);
+        cz = _mm_loadu_ps(c[2]);
+        ex = _mm_loadu_ps(e[0]);
+        ey = _mm_loadu_ps(e[1]);
+        ez = _mm_loadu_ps(e[2]);
+        radius = _mm_loadu_ps(r);
+    }
+
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    for (int p = 0; p < 6; ++p) {
+        const GSfloat *plane = cull.planes + p * 4;
+        __m128 a = _mm_set1_ps(plane[0]);
+        __m128 b = _mm_set1_ps(plane[1]);
+        __m128 c = _mm_set1_ps(plane[2]);
+
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a, cx), _mm_mul_ps(b, cy)),
+            _mm_add_ps(_mm_mul_ps(c, cz), _mm_set1_ps(plane[3]))
+        );
+
+        __m128 effective = cull.type == GS_BOUNDS_SPHERE ?
+            radius :
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(abs_ps(a), ex), _mm_mul_ps(abs_ps(b), ey)),
+                _mm_mul_ps(abs_ps(c), ez)
+            );
+
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_sub_ps(_mm_setzero_ps(), effective)));
+    }
+
+    int mask = _mm_movemask_ps(inside);
+    if (mask == 0) {
+        visible[0] = visible[1] = visible[2] = visible[3] = 0;
+        return;
+    }
+
+    // LOD index is number of thresholds projected size is below,
+    // compare masks are -1 so they're subtracted
+    __m128i lod = _mm_set1_epi32(1);
+    if (cull.lodcount > 1) {
+        __m128 w = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cull.wrow[0]), cx), _mm_mul_ps(_mm_set1_ps(cull.wrow[1]), cy)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cull.wrow[2]), cz), _mm_set1_ps(cull.wrow[3]))
+        );
+        __m128 farenough = _mm_cmpgt_ps(w, _mm_set1_ps(CULL_MIN_W));
+        __m128 size = _mm_div_ps(
+            _mm_mul_ps(radius, _mm_set1_ps(cull.lodscale)),
+            _mm_max_ps(w, _mm_set1_ps(CULL_MIN_W))
+        );
+
+        for (GSuint n = 0; n < cull.lodcount - 1; ++n) {
+            __m128 below = _mm_and_ps(farenough, _mm_cmplt_ps(size, _mm_set1_ps(cull.lodthresholds[n])));
+            lod = _mm_sub_epi32(lod, _mm_castps_si128(below));
+        }
+    }
+
+    int lods[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lods), lod);
+
+    for (int n = 0; n < 4; ++n) {
+        visible[n] = (mask & (1 << n)) ? static_cast<unsigned char>(lods[n]) : 0;
+    }
+}
+#endif
+
+static void cull_range(const CullBounds &cull, GSuint first, GSuint last, unsigned char *visible)
+{
+    GSuint object = first;
+
+#ifdef GS_CULLING_SSE2
+    for (; object + 4 <= last; object += 4) {
+        cull_objects4(cull, object, visible + object);
+    }
+#endif
+
+    for (; object < last; ++object) {
+        visible[object] = cull_object(cull, object);
+    }
+}
+
+
+void xGS::frustum_planes(const GSfloat *viewprojection, GSfloat *planes)
+{
+    // matrix element at row r, column c
+    auto m = [viewprojection](int r, int c) { return viewprojection[c * 4 + r]; };
+
+    // left, right, bottom, top, near, far
+    for (int p = 0; p < 6; ++p) {
+        int row = p / 2;
+        GSfloat sign = (p & 1) ? -1.0f : 1.0f;
+
+        GSfloat *plane = planes + p * 4;
+        for (int c = 0; c < 4; ++c) {
+            plane[c] = m(3, c) + sign * m(row, c);
+        }
+
+        GSfloat length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0) {
+            for (int c = 0; c < 4; ++c) {
+                plane[c] /= length;
+            }
+        }
+    }
+}
+
+void xGS::frustum_cull(
+    const GSfloat *viewprojection, GSenum boundstype, const GSfloat *bounds, GSuint count,
+    GSuint lodcount, const GSfloat *lodthresholds, GSfloat lodscale,
+    GSuint threads, WorkerPool &workers, unsigned char *visible
+)
+{
+    GSfloat planes[6 * 4];
+    frustum_planes(viewprojection, planes);
+
+    GSfloat wrow[4] = {
+        viewprojection[3], viewprojection[7], viewprojection[11], viewprojection[15]
+    };
+
+    CullBounds cull = {
+        planes, wrow, boundstype, bounds,
+        lodcount, lodthresholds, lodscale
+    };
+
+    // split objects between threads, keeping batches multiple of 4
+    GSuint maxthreads = count / CULL_THREAD_BATCH;
+    if (threads > maxthreads) {
+        threads = maxthreads;
+    }
+
+    if (threads <= 1) {
+        cull_range(cull, 0, count, visible);
+        return;
+    }
+
+    GSuint batch = ((count + threads - 1) / threads + 3) & ~3u;
+    GSuint batches = (count + batch - 1) / batch;
+
+    workers.run(batches, [&](GSuint index) {
+        GSuint first = index * batch;
+        GSuint last = first + batch < count ? first + batch : count;
+        cull_range(cull, first, last, visible);
+    });
+}
@@ -0,0 +1,41 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSculling.h
+        Frustum culling and LOD selection functions
+            bounds are culled in batches of 4 with SSE2 kernels
+            and could be split between threads of worker pool
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include "xGSworkers.h"
+
+
+namespace xGS
+{
+
+    // extracts 6 normalized frustum planes (a, b, c, d) from column-major
+    // view-projection matrix, OpenGL clip space convention
+    void frustum_planes(const GSfloat *viewprojection, GSfloat *planes);
+
+    // computes visibility of every object, visible[n] is set to LOD index + 1
+    // for visible objects and 0 for culled ones
+    //      bounds       - spheres (x, y, z, radius) for GS_BOUNDS_SPHERE or
+    //                     boxes (minx, miny, minz, maxx, maxy, maxz) for GS_BOUNDS_BOX
+    //      lodthresholds - lodcount - 1 decreasing projected size thresholds,
+    //                      may be nullptr if lodcount is 1
+    void frustum_cull(
+        const GSfloat *viewprojection, GSenum boundstype, const GSfloat *bounds, GSuint count,
+        GSuint lodcount, const GSfloat *lodthresholds, GSfloat lodscale,
+        GSuint threads, WorkerPool &workers, unsigned char *visible
+    );
+
+} // namespace xGS
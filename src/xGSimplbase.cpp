@@ -19,6 +19,7 @@
 #include "xGSstate.h"
 #include "xGSinput.h"
 #include "xGSparameters.h"
+#include "xGSvertexcompress.h"
 #include <cstdlib>
 
 #ifdef _DEBUG
@@ -44,7 +45,8 @@ using namespace xGS;
 
 xGSDataBufferBase::xGSDataBufferBase() :
     p_size(0),
-    p_locktype(GS_NONE)
+    p_locktype(GS_NONE),
+    p_updating(false)
 {}
 
 
@@ -118,6 +120,7 @@ IxGSGeometryImpl::IxGSGeometryImpl(xGSBase *owner) :
 
     p_type(GS_NONE),
     p_indexformat(GS_NONE),
+    p_storedindexformat(GS_NONE),
     p_vertexcount(0),
     p_indexcount(0),
     p_patch_vertices(0),
@@ -132,7 +135,10 @@ IxGSGeometryImpl::IxGSGeometryImpl(xGSBase *owner) :
     p_indexmemory(nullptr),
 
     p_sharedgeometry(nullptr),
-    p_buffer(nullptr)
+    p_buffer(nullptr),
+    p_resident(false),
+
+    p_quantization()
 {
     p_owner->debug(DebugMessageLevel::Information, "Geometry object created\n");
 }
@@ -143,15 +149,18 @@ IxGSGeometryImpl::~IxGSGeometryImpl()
         doUnlock();
     }
 
-    if (p_sharedgeometry) {
-        p_sharedgeometry->Release();
-    }
-
+    // pages are released while shared geometry is still alive,
+    // its data ranges are needed to tell which pages are own
     if (p_buffer) {
-        p_buffer->freeGeometry(p_vertexcount, p_indexcount, p_vertexmemory, p_indexmemory);
+        setResident(false);
+        p_buffer->freeGeometry(p_vertexcount, p_indexcount, p_storedindexformat, p_vertexmemory, p_indexmemory);
         p_buffer->Release();
     }
 
+    if (p_sharedgeometry) {
+        p_sharedgeometry->Release();
+    }
+
     p_owner->debug(DebugMessageLevel::Information, "Geometry object destroyed\n");
 }
 
@@ -167,6 +176,7 @@ GSvalue IxGSGeometryImpl::GetValue(GSenum valuetype)
         case GS_GEOMETRY_PATCHVERTICES: return p_patch_vertices;
         case GS_GEOMETRY_RESTART:       return p_restart;
         case GS_GEOMETRY_RESTARTINDEX:  return p_restartindex;
+        case GS_GEOMETRY_RESIDENT:      return resident();
         default:
             p_owner->error(GSE_INVALIDENUM);
             return GS_NONE;
@@ -202,7 +212,13 @@ GSbool IxGSGeometryImpl::allocate(const GSgeometrydescription &desc)
             p_indexcount = 0;
         }
 
-        if (!bufferimpl->allocateGeometry(p_vertexcount, p_indexcount, p_vertexmemory, p_indexmemory, p_basevertex)) {
+        p_storedindexformat = p_indexformat == GS_INDEX_NONE ?
+            GS_INDEX_NONE : bufferimpl->geometryIndexFormat(p_vertexcount, p_restart, p_restartindex);
+
+        if (!bufferimpl->allocateGeometry(
+            p_vertexcount, p_indexcount, p_storedindexformat,
+            p_vertexmemory, p_indexmemory, p_basevertex
+        )) {
             return p_owner->error(GSE_OUTOFRESOURCES);
         }
 
@@ -249,6 +265,7 @@ GSbool IxGSGeometryImpl::allocate(const GSgeometrydescription &desc)
             case GS_SHARE_ALL:
                 // indices from base geometry
                 p_indexmemory = geometryimpl->p_indexmemory;
+                p_storedindexformat = geometryimpl->p_storedindexformat;
                 break;
 
             case GS_SHARE_VERTICESONLY:
@@ -257,7 +274,11 @@ GSbool IxGSGeometryImpl::allocate(const GSgeometrydescription &desc)
                 } else {
                     GSptr vertexmemory = nullptr;
                     GSuint basevertex = 0;
-                    if (!geometryimpl->p_buffer->allocateGeometry(0, p_indexcount, vertexmemory, p_indexmemory, basevertex)) {
+                    p_storedindexformat = p_buffer->geometryIndexFormat(p_vertexcount, p_restart, p_restartindex);
+                    if (!geometryimpl->p_buffer->allocateGeometry(
+                        0, p_indexcount, p_storedindexformat,
+                        vertexmemory, p_indexmemory, basevertex
+                    )) {
                         return p_owner->error(GSE_OUTOFRESOURCES);
                     }
                 }
@@ -268,6 +289,8 @@ GSbool IxGSGeometryImpl::allocate(const GSgeometrydescription &desc)
         p_sharedgeometry->AddRef();
     }
 
+    setResident(true);
+
     return p_owner->error(GS_OK);
 }
 
@@ -283,6 +306,12 @@ GSptr IxGSGeometryImpl::Lock(GSenum locktype, GSdword access, void *lockdata)
         return nullptr;
     }
 
+    // released pages of sparse heap can't be written
+    if (!resident()) {
+        p_owner->error(GSE_INVALIDOPERATION);
+        return nullptr;
+    }
+
     switch (locktype) {
         case GS_LOCK_VERTEXDATA:
             p_locktype = locktype;
@@ -294,12 +323,23 @@ GSptr IxGSGeometryImpl::Lock(GSenum locktype, GSdword access, void *lockdata)
             break;
 
         case GS_LOCK_INDEXDATA:
-            p_locktype = locktype;
-            p_lockpointer = p_buffer->LockImpl(
-                locktype,
-                size_t(p_indexmemory),
-                index_buffer_size(p_indexformat, p_indexcount)
-            );
+            if (p_storedindexformat != p_indexformat) {
+                // narrowed indices are written into temporary memory
+                // and converted into buffer on unlock, so they can't be read
+                if (access & GS_READ) {
+                    p_owner->error(GSE_INVALIDOPERATION);
+                    return nullptr;
+                }
+                p_locktype = locktype;
+                p_lockpointer = p_owner->allocate(index_buffer_size(p_indexformat, p_indexcount));
+            } else {
+                p_locktype = locktype;
+                p_lockpointer = p_buffer->LockImpl(
+                    locktype,
+                    size_t(p_indexmemory),
+                    index_buffer_size(p_indexformat, p_indexcount)
+                );
+            }
             break;
 
         default:
@@ -307,6 +347,11 @@ GSptr IxGSGeometryImpl::Lock(GSenum locktype, GSdword access, void *lockdata)
             return nullptr;
     }
 
+    // failed lock leaves geometry unlocked
+    if (!p_lockpointer) {
+        p_locktype = GS_NONE;
+    }
+
     return p_lockpointer;
 }
 
@@ -321,6 +366,47 @@ GSbool IxGSGeometryImpl::Unlock()
     return p_owner->error(GS_OK);
 }
 
+GSbool IxGSGeometryImpl::CompressVertices(const GSvertexcomponent *sourcedecl, const GSptr source)
+{
+    if (!sourcedecl || !source) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    if (p_locktype) {
+        return p_owner->error(GSE_INVALIDOPERATION);
+    }
+
+    GSvertexdecl decl(sourcedecl);
+    const GSvertexdecl &dest = p_buffer->vertexDecl();
+
+    if (!vertex_compression_supported(decl, dest)) {
+        return p_owner->error(GSE_INVALIDVALUE);
+    }
+
+    GSvertexquantization quantization;
+    vertex_quantization(decl, dest, source, p_vertexcount, quantization);
+
+    // compressed data goes straight into locked buffer memory
+    GSptr memory = Lock(GS_LOCK_VERTEXDATA, GS_WRITE, nullptr);
+    if (!memory) {
+        return p_owner->error(GSE_INVALIDOPERATION);
+    }
+
+    vertex_compress(decl, dest, source, memory, p_vertexcount, quantization);
+
+    doUnlock();
+
+    p_quantization = quantization;
+
+    return p_owner->error(GS_OK);
+}
+
+GSbool IxGSGeometryImpl::GetQuantization(GSvertexquantization &quantization)
+{
+    quantization = p_quantization;
+    return p_owner->error(GS_OK);
+}
+
 bool IxGSGeometryImpl::checkAlloc(GSenum indexformat)
 {
     if (!p_type) {
@@ -342,9 +428,40 @@ bool IxGSGeometryImpl::checkAlloc(GSenum indexformat)
     return p_owner->error(GS_OK);
 }
 
+void IxGSGeometryImpl::setResident(bool resident)
+{
+    if (p_resident == resident) {
+        return;
+    }
+
+    p_resident = resident;
+
+    if (!p_buffer->sparse()) {
+        return;
+    }
+
+    // shared geometry references only pages of data allocated for it
+    if (!p_sharedgeometry) {
+        referencePages(GS_LOCK_VERTEXDATA, p_vertexmemory, p_buffer->vertexDecl().buffer_size(p_vertexcount), resident);
+    }
+
+    if (p_indexcount && (!p_sharedgeometry || p_indexmemory != p_sharedgeometry->p_indexmemory)) {
+        referencePages(GS_LOCK_INDEXDATA, p_indexmemory, index_buffer_size(p_storedindexformat, p_indexcount), resident);
+    }
+}
+
+GSuint IxGSGeometryImpl::storedRestartIndex() const
+{
+    // restart index of narrowed geometry is always max 16-bit value,
+    // it can't be valid vertex index
+    return p_storedindexformat != p_indexformat ? 0xffff : p_restartindex;
+}
+
 void IxGSGeometryImpl::doUnlock()
 {
-    if (p_buffer) {
+    if (p_locktype == GS_LOCK_INDEXDATA && p_storedindexformat != p_indexformat) {
+        narrowIndices();
+    } else if (p_buffer) {
         p_buffer->UnlockImpl();
     }
 
@@ -353,6 +470,45 @@ void IxGSGeometryImpl::doUnlock()
 }
 
 
+void IxGSGeometryImpl::referencePages(GSenum locktype, GSptr memory, GSuint size, bool reference)
+{
+    xGSGeometryBufferBase::PageRange range = p_buffer->referencePages(locktype, memory, size, reference);
+    if (range.count) {
+        p_buffer->CommitPagesImpl(
+            locktype, range.first * p_buffer->pageSize(),
+            range.count * p_buffer->pageSize(), reference
+        );
+    }
+}
+
+void IxGSGeometryImpl::narrowIndices()
+{
+    if (!p_lockpointer) {
+        return;
+    }
+
+    GSptr memory = p_buffer->LockImpl(
+        GS_LOCK_INDEXDATA,
+        size_t(p_indexmemory),
+        index_buffer_size(p_storedindexformat, p_indexcount)
+    );
+
+    if (memory) {
+        const GSuint *source = reinterpret_cast<const GSuint*>(p_lockpointer);
+        unsigned short *dest = reinterpret_cast<unsigned short*>(memory);
+
+        for (GSint n = 0; n < p_indexcount; ++n) {
+            GSuint index = source[n];
+            dest[n] = p_restart && index == p_restartindex ?
+                0xffff : static_cast<unsigned short>(index);
+        }
+
+        p_buffer->UnlockImpl();
+    }
+
+    p_owner->free(p_lockpointer);
+}
+
 
 xGSGeometryBufferBase::xGSGeometryBufferBase() :
     p_locktype(GS_NONE),
@@ -360,8 +516,12 @@ xGSGeometryBufferBase::xGSGeometryBufferBase() :
     p_indexcount(0),
     p_currentvertex(0),
     p_currentindex(0),
+    p_currentindex16(0),
     p_vertexgranularity(256),
     p_indexgranularity(256),
+    p_narrowindices(false),
+    p_pagesize(0),
+    p_committedpages(0),
     p_vertexptr(nullptr),
     p_indexptr(nullptr)
 {}
@@ -372,7 +532,7 @@ bool xGSGeometryBufferBase::EmitPrimitive(GSenum type, GSuint vertexcount, GSuin
         return false;
     }
 
-    primitive->stride = p_vertexdecl.buffer_size(); // TODO: optimize stride calcs
+    primitive->stride = p_vertexdecl.buffer_size();
     primitive->vertexdata = getp(p_vertexptr, p_currentvertex * primitive->stride);
     primitive->vertexcount = vertexcount;
     primitive->indexdata = getp(p_indexptr, index_buffer_size(p_indexformat, p_currentindex));
@@ -391,11 +551,22 @@ bool xGSGeometryBufferBase::EmitPrimitive(GSenum type, GSuint vertexcount, GSuin
     return true;
 }
 
-GSbool xGSGeometryBufferBase::allocateGeometry(GSuint vertexcount, GSuint indexcount, GSptr &vertexmemory, GSptr &indexmemory, GSuint &basevertex)
+GSenum xGSGeometryBufferBase::geometryIndexFormat(GSuint vertexcount, GSbool restart, GSuint restartindex) const
+{
+    // 0xffff is left for restart index, so narrowed indices never collide with it,
+    // restart index itself should not be valid vertex index
+    bool fits = vertexcount < 0xffff && (!restart || restartindex >= vertexcount);
+
+    return p_narrowindices && fits ? GS_INDEX_16 : p_indexformat;
+}
+
+GSbool xGSGeometryBufferBase::allocateGeometry(GSuint vertexcount, GSuint indexcount, GSenum indexformat, GSptr &vertexmemory, GSptr &indexmemory, GSuint &basevertex)
 {
     if (p_type == GS_GBTYPE_GEOMETRYHEAP) {
         vertexcount = align(vertexcount, p_vertexgranularity);
-        indexcount = align(indexcount, p_indexgranularity);
+        indexcount = align(indexUnits(indexcount, indexformat), p_indexgranularity);
+
+        GSuint indextotal = indexUnits(p_indexcount, p_indexformat);
 
         size_t commitVertexBlock = GS_UNDEFINED;
         size_t commitIndexBlock = GS_UNDEFINED;
@@ -408,10 +579,17 @@ GSbool xGSGeometryBufferBase::allocateGeometry(GSuint vertexcount, GSuint indexc
             return GS_FALSE;
         }
 
-        if (!allocateBlock(
-            indexcount, index_buffer_size(p_indexformat), p_indexcount, indexmemory,
-            p_currentindex, p_freeindices, commitIndexBlock
-        )) {
+        bool indicesallocated = indexformat == p_indexformat ?
+            allocateBlock(
+                indexcount, indexUnitSize(), indextotal - p_currentindex16, indexmemory,
+                p_currentindex, p_freeindices, commitIndexBlock
+            ) :
+            allocateBlock(
+                indexcount, indexUnitSize(), indextotal - p_currentindex, indexmemory,
+                p_currentindex16, p_freeindices16, commitIndexBlock, indextotal
+            );
+
+        if (!indicesallocated) {
             // restore vertex top if it was allocated at top
             p_currentvertex = currentvertex;
             return GS_FALSE;
@@ -420,7 +598,7 @@ GSbool xGSGeometryBufferBase::allocateGeometry(GSuint vertexcount, GSuint indexc
         basevertex = buffercast(vertexmemory) / p_vertexdecl.buffer_size();
 
         commitFreeBlock(commitVertexBlock, p_freevertices);
-        commitFreeBlock(commitIndexBlock, p_freeindices);
+        commitFreeBlock(commitIndexBlock, indexformat == p_indexformat ? p_freeindices : p_freeindices16);
     } else {
         if ((p_currentvertex + vertexcount) > p_vertexcount) {
             return GS_FALSE;
@@ -439,7 +617,7 @@ GSbool xGSGeometryBufferBase::allocateGeometry(GSuint vertexcount, GSuint indexc
     return GS_TRUE;
 }
 
-void xGSGeometryBufferBase::freeGeometry(GSuint vertexcount, GSuint indexcount, GSptr vertexmemory, GSptr indexmemory)
+void xGSGeometryBufferBase::freeGeometry(GSuint vertexcount, GSuint indexcount, GSenum indexformat, GSptr vertexmemory, GSptr indexmemory)
 {
     // freeGeometry can be issued only with heap buffers
     if (p_type != GS_GBTYPE_GEOMETRYHEAP) {
@@ -450,13 +628,53 @@ void xGSGeometryBufferBase::freeGeometry(GSuint vertexcount, GSuint indexcount,
         vertexmemory, align(vertexcount, p_vertexgranularity),
         p_vertexdecl.buffer_size(), p_currentvertex, p_freevertices
     );
-    freeBlock(
-        indexmemory, align(indexcount, p_indexgranularity),
-        index_buffer_size(p_indexformat), p_currentindex, p_freeindices
-    );
+    GSuint indexunits = align(indexUnits(indexcount, indexformat), p_indexgranularity);
+    if (indexformat == p_indexformat) {
+        freeBlock(indexmemory, indexunits, indexUnitSize(), p_currentindex, p_freeindices);
+    } else {
+        freeBlock(
+            indexmemory, indexunits, indexUnitSize(), p_currentindex16, p_freeindices16,
+            indexUnits(p_indexcount, p_indexformat)
+        );
+    }
 }
 
-bool xGSGeometryBufferBase::allocateBlock(GSuint count, GSuint elementsize, GSuint maxcount, GSptr &memory, GSuint &current, FreeBlockList &list, size_t &block)
+xGSGeometryBufferBase::PageRange xGSGeometryBufferBase::referencePages(GSenum locktype, GSptr memory, GSuint size, bool reference)
+{
+    PageRange result = { 0, 0 };
+
+    if (size == 0) {
+        return result;
+    }
+
+    PageReferenceList &pages = locktype == GS_LOCK_VERTEXDATA ? p_vertexpages : p_indexpages;
+
+    GSuint offset = buffercast(memory);
+    GSuint first = offset / p_pagesize;
+    GSuint last = (offset + size - 1) / p_pagesize;
+
+    // inner pages of the range belong only to its geometry, only boundary pages
+    // could be shared, so changed pages always form single range
+    for (GSuint n = first; n <= last; ++n) {
+        bool changed = reference ? pages[n]++ == 0 : --pages[n] == 0;
+        if (changed) {
+            if (result.count == 0) {
+                result.first = n;
+            }
+            result.count = n - result.first + 1;
+        }
+    }
+
+    if (reference) {
+        p_committedpages += result.count;
+    } else {
+        p_committedpages -= result.count;
+    }
+
+    return result;
+}
+
+bool xGSGeometryBufferBase::allocateBlock(GSuint count, GSuint elementsize, GSuint maxcount, GSptr &memory, GSuint &current, FreeBlockList &list, size_t &block, GSuint end)
 {
     // TODO: test option with allocating at top first, and then free block search
 
@@ -475,7 +693,8 @@ bool xGSGeometryBufferBase::allocateBlock(GSuint count, GSuint elementsize, GSui
     if (block == GS_UNDEFINED) {
         // free block of required sized haven't been found, try to allocate at top
         if ((current + count) <= maxcount) {
-            memory = buffercast(current * elementsize);
+            GSuint offset = end == GS_UNDEFINED ? current : end - current - count;
+            memory = buffercast(offset * elementsize);
             current += count;
         } else {
             return false;
@@ -503,21 +722,24 @@ void xGSGeometryBufferBase::commitFreeBlock(size_t block, FreeBlockList &list)
     }
 }
 
-void xGSGeometryBufferBase::freeBlock(GSptr memory, GSuint count, GSuint elementsize, GSuint &current, FreeBlockList &list)
+void xGSGeometryBufferBase::freeBlock(GSptr memory, GSuint count, GSuint elementsize, GSuint &current, FreeBlockList &list, GSuint end)
 {
     if (count == 0) {
         return;
     }
 
-    GSptr top = buffercast(current * elementsize);
-    if (top == getp(memory, count * elementsize)) {
+    // for space allocated from end top is the lowest allocated element
+    bool fromend = end != GS_UNDEFINED;
+
+    GSptr top = buffercast((fromend ? end - current : current) * elementsize);
+    if (top == (fromend ? memory : getp(memory, count * elementsize))) {
         // freeing data at top, just return current pointer back
         current -= count;
 
         // find free block ending and current top and remove it, lowering top
-        GSptr newtop = buffercast(current * elementsize);
+        GSptr newtop = buffercast((fromend ? end - current : current) * elementsize);
         for (size_t n = 0; n < list.size(); ++n) {
-            if (newtop == getp(list[n].memory, list[n].count * elementsize)) {
+            if (newtop == (fromend ? list[n].memory : getp(list[n].memory, list[n].count * elementsize))) {
                 current -= list[n].count;
                 commitFreeBlock(n, list);
                 break;
@@ -581,8 +803,15 @@ xGSTextureBase::xGSTextureBase() :
     p_multisample(GS_MULTISAMPLE_NONE),
     p_minlevel(0),
     p_maxlevel(1000),
+    p_flags(0),
+    p_sparselevels(0),
+    p_pagebytes(0),
     p_locktype(GS_NONE)
 {
+    for (size_t n = 0; n < 3; ++n) {
+        p_pagesize[n] = 0;
+    }
+
 #ifdef _DEBUG
     p_boundasrt = 0;
 #endif
@@ -595,6 +824,26 @@ xGSStateBase::xGSStateBase() :
     p_inputavail(0)
 {}
 
+const xGSStateBase::UniformBlockLayout* xGSStateBase::uniformBlockLayout(const char *name, bool storage) const
+{
+    for (auto &b : p_uniformblocklayouts) {
+        if (b.storage == storage && b.name == name) {
+            return &b;
+        }
+    }
+    return nullptr;
+}
+
+const xGSStateBase::UniformLayout* xGSStateBase::uniformLayout(const UniformBlockLayout &block, const char *name) const
+{
+    for (GSuint n = block.firstuniform; n < block.onepastlastuniform; ++n) {
+        if (p_uniformlayouts[n].name == name) {
+            return &p_uniformlayouts[n];
+        }
+    }
+    return nullptr;
+}
+
 bool xGSStateBase::validate(const GSenum *colorformats, GSenum depthstencilformat)
 {
     // TODO: check possibility to NULL rendering destination, if so
@@ -629,6 +878,31 @@ xGSParametersBase::xGSParametersBase() :
 
 
 
+xGSQueryBase::xGSQueryBase() :
+    p_querytype(GS_NONE),
+    p_active(false),
+    p_issued(false)
+{}
+
+
+
+xGSComputeStateBase::xGSComputeStateBase() :
+    p_parameterslots()
+{}
+
+
+
+xGSAtlasBase::xGSAtlasBase() :
+    p_texture(nullptr),
+    p_packer(),
+    p_entries(),
+    p_padding(0),
+    p_nextid(1),
+    p_unused(0)
+{}
+
+
+
 // xGS system object instance
 IxGS xGSBase::gs = nullptr;
 
@@ -644,12 +918,20 @@ xGSBase::xGSBase() :
     p_statelist(),
     p_inputlist(),
     p_parameterslist(),
+    p_querylist(),
+    p_computestatelist(),
+    p_atlaslist(),
 
     p_rendertarget(nullptr),
     p_state(nullptr),
     p_input(nullptr),
     p_capturebuffer(nullptr),
-    p_immediatebuffer(nullptr)
+    p_immediatebuffer(nullptr),
+    p_query(nullptr),
+    p_conditionquery(nullptr),
+
+    p_texturestreamer(),
+    p_texturepager()
 {
     for (size_t n = 0; n < GS_MAX_PARAMETER_SETS; ++n) {
         p_parameters[n] = nullptr;
@@ -756,5 +1038,8 @@ GS_ADD_REMOVE_OBJECT_IMPL(p_framebufferlist, IxGSFrameBufferImpl)
 GS_ADD_REMOVE_OBJECT_IMPL(p_statelist, IxGSStateImpl)
 GS_ADD_REMOVE_OBJECT_IMPL(p_inputlist, IxGSInputImpl)
 GS_ADD_REMOVE_OBJECT_IMPL(p_parameterslist, IxGSParametersImpl)
+GS_ADD_REMOVE_OBJECT_IMPL(p_querylist, IxGSQueryImpl)
+GS_ADD_REMOVE_OBJECT_IMPL(p_computestatelist, IxGSComputeStateImpl)
+GS_ADD_REMOVE_OBJECT_IMPL(p_atlaslist, IxGSAtlasImpl)
 
 #undef GS_ADD_REMOVE_OBJECT_IMPL
@@ -16,9 +16,15 @@
 
 #include "xGS/xGS.h"
 #include "xGSutil.h"
+#include "xGStexturestreaming.h"
+#include "xGStexturepaging.h"
+#include "xGSatlas.h"
+#include "xGSworkers.h"
 #include "IUnknownImpl.h"
 #include <vector>
+#include <string>
 #include <unordered_set>
+#include <unordered_map>
 
 
 namespace xGS
@@ -30,6 +36,8 @@ namespace xGS
     class xGSTextureImpl;
     class xGSStateImpl;
     class xGSParametersImpl;
+    class xGSQueryImpl;
+    class xGSComputeStateImpl;
 
     class IxGSGeometryImpl;
     class IxGSGeometryBufferImpl;
@@ -39,6 +47,9 @@ namespace xGS
     class IxGSStateImpl;
     class IxGSInputImpl;
     class IxGSParametersImpl;
+    class IxGSQueryImpl;
+    class IxGSComputeStateImpl;
+    class IxGSAtlasImpl;
 
 
     class xGSBase : public xGSIUnknownImpl<xGSSystem>
@@ -68,6 +79,10 @@ namespace xGS
         template <typename T> void AddObject(T *object);
         template <typename T> void RemoveObject(T *object);
 
+        // streamed and paged textures
+        TextureStreamer& textureStreamer() { return p_texturestreamer; }
+        TexturePager& texturePager() { return p_texturepager; }
+
     protected:
         enum SystemState
         {
@@ -85,6 +100,9 @@ namespace xGS
         typedef std::unordered_set<IxGSStateImpl*>          StateList;
         typedef std::unordered_set<IxGSInputImpl*>          InputList;
         typedef std::unordered_set<IxGSParametersImpl*>     ParametersList;
+        typedef std::unordered_set<IxGSQueryImpl*>          QueryList;
+        typedef std::unordered_set<IxGSComputeStateImpl*>   ComputeStateList;
+        typedef std::unordered_set<IxGSAtlasImpl*>          AtlasList;
 
         static IxGS            gs;
 
@@ -99,6 +117,9 @@ namespace xGS
         StateList              p_statelist;
         InputList              p_inputlist;
         ParametersList         p_parameterslist;
+        QueryList              p_querylist;
+        ComputeStateList       p_computestatelist;
+        AtlasList              p_atlaslist;
 
         xGSFrameBufferImpl    *p_rendertarget;
         GSenum                 p_colorformats[GS_MAX_FB_COLORTARGETS];
@@ -112,6 +133,13 @@ namespace xGS
 
         xGSGeometryBufferImpl *p_immediatebuffer;
 
+        xGSQueryImpl          *p_query;
+        xGSQueryImpl          *p_conditionquery;
+
+        TextureStreamer        p_texturestreamer;
+        TexturePager           p_texturepager;
+        WorkerPool             p_workers;
+
 #ifdef _DEBUG
         GSuint                 dbg_memory_allocs;
 #endif
@@ -134,6 +162,7 @@ namespace xGS
             GSuint onepastlastuniform; // one past last uniform index in uniforms array
         };
 
+        GSuint size() const { return p_size; }
         GSuint blockCount() const { return GSuint(p_blocks.size()); }
         const UniformBlock& block(size_t index) const { return p_blocks[index]; }
 
@@ -148,8 +177,16 @@ namespace xGS
             GSuint count;     // array count
         };
 
+        struct DirtyRange
+        {
+            GSuint offset;    // offset of written data
+            GSuint size;      // size of written data
+        };
+
         typedef std::vector<UniformBlock> UniformBlockList;
         typedef std::vector<Uniform> UniformList;
+        typedef std::vector<char> ShadowMemory;
+        typedef std::vector<DirtyRange> DirtyRangeList;
 
     protected:
         GSuint           p_size;
@@ -158,6 +195,11 @@ namespace xGS
         UniformList      p_uniforms;
 
         GSenum           p_locktype;
+
+        // batched update data
+        bool             p_updating;
+        ShadowMemory     p_shadow;
+        DirtyRangeList   p_dirty;
     };
 
     // framebuffer object
@@ -172,6 +214,9 @@ namespace xGS
         void getformats(GSenum *colorformats, GSenum &depthstencilformat) const;
         bool srgb() const { return p_srgb; }
 
+        xGSTextureImpl* depthTexture() const { return p_depthtexture.p_texture; }
+        GSuint depthLevel() const { return p_depthtexture.p_level; }
+
     protected:
         struct Attachment
         {
@@ -230,8 +275,26 @@ namespace xGS
 
         bool EmitPrimitive(GSenum type, GSuint vertexcount, GSuint indexcount, GSuint flags, GSimmediateprimitive *primitive);
 
-        GSbool allocateGeometry(GSuint vertexcount, GSuint indexcount, GSptr &vertexmemory, GSptr &indexmemory, GSuint &basevertex);
-        void freeGeometry(GSuint vertexcount, GSuint indexcount, GSptr vertexmemory, GSptr indexmemory);
+        // format in which index data of geometry is stored inside buffer
+        GSenum geometryIndexFormat(GSuint vertexcount, GSbool restart, GSuint restartindex) const;
+
+        GSbool allocateGeometry(GSuint vertexcount, GSuint indexcount, GSenum indexformat, GSptr &vertexmemory, GSptr &indexmemory, GSuint &basevertex);
+        void freeGeometry(GSuint vertexcount, GSuint indexcount, GSenum indexformat, GSptr vertexmemory, GSptr indexmemory);
+
+        // sparse heap residency
+        struct PageRange
+        {
+            GSuint first;
+            GSuint count;
+        };
+
+        bool sparse() const { return p_pagesize != 0; }
+        GSuint pageSize() const { return p_pagesize; }
+        GSuint committedPages() const { return p_committedpages; }
+
+        // updates reference counts of vertex or index data pages in given range,
+        // returns range of pages which should be committed or released
+        PageRange referencePages(GSenum locktype, GSptr memory, GSuint size, bool reference);
 
     protected:
         enum
@@ -248,10 +311,23 @@ namespace xGS
         };
 
         typedef std::vector<FreeBlock> FreeBlockList;
+        typedef std::vector<GSuint> PageReferenceList;
 
-        bool allocateBlock(GSuint count, GSuint elementsize, GSuint maxcount, GSptr &memory, GSuint &current, FreeBlockList &list, size_t &block);
+        // blocks are allocated from start of the space, or downwards from end
+        // when end is defined, current is amount of allocated elements in both cases
+        bool allocateBlock(GSuint count, GSuint elementsize, GSuint maxcount, GSptr &memory, GSuint &current, FreeBlockList &list, size_t &block, GSuint end = GS_UNDEFINED);
         void commitFreeBlock(size_t block, FreeBlockList &list);
-        void freeBlock(GSptr memory, GSuint count, GSuint elementsize, GSuint &current, FreeBlockList &list);
+        void freeBlock(GSptr memory, GSuint count, GSuint elementsize, GSuint &current, FreeBlockList &list, GSuint end = GS_UNDEFINED);
+
+        // heap index space is counted in 16-bit units when narrowing is enabled,
+        // so 16 and 32-bit index blocks share the same index buffer, 32-bit blocks
+        // grow from buffer start and 16-bit blocks grow from buffer end
+        GSuint indexUnitSize() const { return p_narrowindices ? 2 : index_buffer_size(p_indexformat); }
+        GSuint indexUnits(GSuint indexcount, GSenum indexformat) const
+        {
+            GSuint unitsize = indexUnitSize();
+            return unitsize ? index_buffer_size(indexformat, indexcount) / unitsize : 0;
+        }
 
     protected:
         GSenum        p_type;
@@ -261,11 +337,19 @@ namespace xGS
         GSuint        p_indexcount;
         GSuint        p_currentvertex;
         GSuint        p_currentindex;
+        GSuint        p_currentindex16;  // 16-bit index units allocated from end of narrowing heap
 
         GSuint        p_vertexgranularity;
         GSuint        p_indexgranularity;
         FreeBlockList p_freevertices;
         FreeBlockList p_freeindices;
+        FreeBlockList p_freeindices16;   // free 16-bit index blocks of narrowing heap
+        bool          p_narrowindices;   // heap stores indices of small geometries in 16-bit form
+
+        GSuint            p_pagesize;       // sparse heap page size, 0 for non sparse buffer
+        GSuint            p_committedpages; // number of committed vertex and index pages
+        PageReferenceList p_vertexpages;    // number of resident geometries using vertex page
+        PageReferenceList p_indexpages;     // number of resident geometries using index page
 
         GSenum        p_locktype;
 
@@ -305,7 +389,18 @@ namespace xGS
 
     public:
         GSuint samples() const { return p_multisample; }
+        GSenum type() const { return p_texturetype; }
         GSenum format() const { return p_format; }
+        GSuint width() const { return p_width; }
+        GSuint height() const { return p_height; }
+        GSuint layers() const { return p_layers; }
+        GSuint maxLevel() const { return p_maxlevel; }
+        bool sparse() const { return (p_flags & GS_TEXFLAG_SPARSE) != 0; }
+        GSuint sparseLevels() const { return p_sparselevels; }
+        GSuint pageWidth() const { return p_pagesize[0]; }
+        GSuint pageHeight() const { return p_pagesize[1]; }
+        GSuint pageDepth() const { return p_pagesize[2]; }
+        GSuint pageBytes() const { return p_pagebytes; }
 #ifdef _DEBUG
         bool boundAsRT() const { return p_boundasrt != 0; }
         void bindAsRT() { ++p_boundasrt; }
@@ -323,6 +418,10 @@ namespace xGS
         GSuint  p_multisample;  // multisample sample count
         GSuint  p_minlevel;     // minimum (base) defined MIP level
         GSuint  p_maxlevel;     // maximum defined MIP level
+        GSdword p_flags;        // GS_TEXFLAG_* flags
+        GSuint  p_sparselevels; // number of levels with separately committed memory
+        GSuint  p_pagesize[3];  // sparse page size in texels
+        GSuint  p_pagebytes;    // sparse page size in bytes
 
         GSenum  p_locktype;     // LOCK: locked texture part
         GSdword p_lockaccess;   // LOCK: lock access
@@ -364,6 +463,27 @@ namespace xGS
             GSuint index;    // array index for array uniforms
         };
 
+        // reflected uniform block layout, filled in by implementation
+        // if shader reflection is available
+        struct UniformLayout
+        {
+            std::string name;         // uniform name without block name prefix
+            GSenum      type;         // uniform type (GSU_ value)
+            GSuint      offset;       // offset inside block
+            GSuint      arraystride;  // array stride, 0 for non-array uniforms
+            GSuint      matrixstride; // matrix column stride, 0 for non-matrix uniforms
+            GSuint      count;        // array count, GS_UNDEFINED for runtime sized storage array
+        };
+
+        struct UniformBlockLayout
+        {
+            std::string name;               // block name
+            bool        storage;            // shader storage block, uniform block otherwise
+            GSuint      datasize;           // block data size
+            GSuint      firstuniform;       // first uniform index in uniform layouts array
+            GSuint      onepastlastuniform; // one past last uniform index in uniform layouts array
+        };
+
     public:
         GSuint inputCount() const { return GSuint(p_input.size()); }
         GSuint inputAvailable() const { return p_inputavail; }
@@ -374,12 +494,17 @@ namespace xGS
         const GSParameterSet& parameterSet(GSuint index) const { return p_parametersets[index]; }
         const ParameterSlot& parameterSlot(GSuint index) const { return p_parameterslots[index]; }
 
+        const UniformBlockLayout* uniformBlockLayout(const char *name, bool storage) const;
+        const UniformLayout* uniformLayout(const UniformBlockLayout &block, const char *name) const;
+
         bool validate(const GSenum *colorformats, GSenum depthstencilformat);
 
     protected:
         typedef std::vector<InputSlot> InputSlotList;
         typedef std::vector<GSParameterSet> ParamSetList;
         typedef std::vector<ParameterSlot> ParamSlotList;
+        typedef std::vector<UniformLayout> UniformLayoutList;
+        typedef std::vector<UniformBlockLayout> UniformBlockLayoutList;
 
     protected:
         InputSlotList     p_input;
@@ -389,6 +514,9 @@ namespace xGS
         ParamSetList      p_parametersets;
         ParamSlotList     p_parameterslots;
 
+        UniformLayoutList      p_uniformlayouts;
+        UniformBlockLayoutList p_uniformblocklayouts;
+
         // output RT formats
         GSenum            p_colorformats[GS_MAX_FB_COLORTARGETS];
         GSenum            p_depthstencilformat;
@@ -412,6 +540,76 @@ namespace xGS
         GSuint        p_setindex;
     };
 
+    // query object
+    class xGSQueryBase : public xGSQuery
+    {
+    public:
+        xGSQueryBase();
+
+    public:
+        GSenum queryType() const { return p_querytype; }
+        bool active() const { return p_active; }
+        bool issued() const { return p_issued; }
+
+    protected:
+        GSenum p_querytype;
+        bool   p_active; // query is between Begin/EndQuery
+        bool   p_issued; // query has been ended at least once, so it has result
+    };
+
+    // compute state object
+    class xGSComputeStateBase : public xGSComputeState
+    {
+    public:
+        xGSComputeStateBase();
+
+    public:
+        struct ParameterSlot
+        {
+            GSenum type;     // uniform block, storage block, image
+            GSint  location; // block index or image unit
+            GSuint index;    // array index for array uniforms
+        };
+
+    public:
+        GSuint parameterSlotCount() const { return GSuint(p_parameterslots.size()); }
+        const ParameterSlot& parameterSlot(GSuint index) const { return p_parameterslots[index]; }
+
+    protected:
+        typedef std::vector<ParameterSlot> ParamSlotList;
+
+    protected:
+        ParamSlotList p_parameterslots;
+    };
+
+    // atlas object
+    class xGSAtlasBase : public xGSAtlas
+    {
+    public:
+        xGSAtlasBase();
+
+    protected:
+        // image area in atlas, including padding
+        struct Entry
+        {
+            GSuint x;
+            GSuint y;
+            GSuint layer;
+            GSuint width;
+            GSuint height;
+        };
+
+        typedef std::unordered_map<GSuint, Entry> EntryList;
+
+    protected:
+        IxGSTextureImpl *p_texture; // atlas texture
+        AtlasPacker      p_packer;
+        EntryList        p_entries;
+        GSuint           p_padding; // padding texels on each side of image
+        GSuint           p_nextid;  // identifier for next added image
+        GSuint           p_unused;  // area of removed images
+    };
+
 
     // generic object base
     template <typename T, typename implT>
@@ -493,6 +691,9 @@ namespace xGS
         GSptr   xGSAPI Lock(GSenum locktype, GSdword access, void *lockdata) override;
         GSbool  xGSAPI Unlock() override;
 
+        GSbool  xGSAPI CompressVertices(const GSvertexcomponent *sourcedecl, const GSptr source) override;
+        GSbool  xGSAPI GetQuantization(GSvertexquantization &quantization) override;
+
         // internal public interface
     public:
         GSbool allocate(const GSgeometrydescription &desc);
@@ -502,6 +703,8 @@ namespace xGS
         GSbool                  restart() const { return p_restart; }
         GSuint                  restartindex() const { return p_restartindex; }
         GSenum                  indexFormat() const { return p_indexformat; }
+        GSenum                  storedIndexFormat() const { return p_storedindexformat; }
+        GSuint                  storedRestartIndex() const;
         GSint                   vertexCount() const { return p_vertexcount; }
         GSint                   indexCount() const { return p_indexcount; }
         GSuint                  patchVertices() const { return p_patch_vertices; }
@@ -509,6 +712,11 @@ namespace xGS
         const GSptr             indexPtr() const { return p_indexmemory; }
         xGSGeometryBufferImpl*  buffer() const { return p_buffer; }
         GSuint                  baseVertex() const { return p_basevertex; }
+        // shared geometry data is resident only when base geometry data is
+        bool                    resident() const { return p_resident && (!p_sharedgeometry || p_sharedgeometry->p_resident); }
+
+        // commits or releases geometry pages of sparse heap
+        void setResident(bool resident);
 
         void ReleaseRendererResources()
         {
@@ -520,10 +728,13 @@ namespace xGS
     protected:
         bool checkAlloc(GSenum indexformat/*, GSenum sharemode*/);
         void doUnlock();
+        void narrowIndices();
+        void referencePages(GSenum locktype, GSptr memory, GSuint size, bool reference);
 
     private:
         GSenum                  p_type;         // primitive type
         GSenum                  p_indexformat;  // index format
+        GSenum                  p_storedindexformat; // index format inside buffer, could be narrower
         GSint                   p_vertexcount;
         GSint                   p_indexcount;
         GSuint                  p_patch_vertices;
@@ -539,6 +750,9 @@ namespace xGS
 
         IxGSGeometryImpl       *p_sharedgeometry;
         xGSGeometryBufferImpl  *p_buffer;       // buffer in which geometry is allocated
+        bool                    p_resident;     // geometry data pages are committed
+
+        GSvertexquantization    p_quantization; // dequantization constants for compressed vertices
     };
 
 } // namespace xGS
@@ -24,10 +24,22 @@
 #include "xGSinput.cpp"
 #include "xGSgeometrybuffer.cpp"
 #include "xGSframebuffer.cpp"
+#include "xGSquery.cpp"
+#include "xGScomputestate.cpp"
 #include "xGSimpl.cpp"
 
 // "unity" build - common
 #include "xGSutil.cpp"
+#include "xGSvertexcompress.cpp"
+#include "xGSmesh.cpp"
+#include "xGSworkers.cpp"
+#include "xGSculling.cpp"
+#include "xGStexcompress.cpp"
+#include "xGSmipchain.cpp"
+#include "xGStextureloader.cpp"
+#include "xGStexturestreaming.cpp"
+#include "xGStexturepaging.cpp"
+#include "xGSatlas.cpp"
 #include "xGSimplbase.cpp"
 #include "IxGSimpl.cpp"
 
@@ -0,0 +1,731 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSmesh.cpp
+        Mesh optimization functions
+*/
+
+#include "xGSmesh.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+
+using namespace xGS;
+
+
+// cache size used for optimization, matches or exceeds post-transform
+// cache of most current hardware
+static const GSuint MESH_CACHE_SIZE = 32;
+
+static const GSuint NO_VERTEX = ~0u;
+
+
+// FIFO post-transform vertex cache simulation
+class MeshVertexCache
+{
+public:
+    MeshVertexCache(GSuint vertexcount, GSuint size) :
+        p_time(vertexcount, 0),
+        p_timestamp(size + 1),
+        p_size(size)
+    {}
+
+    // returns true if vertex was missed (transformed)
+    bool access(GSuint vertex)
+    {
+        if (p_timestamp - p_time[vertex] > p_size) {
+            p_time[vertex] = p_timestamp++;
+            return true;
+        }
+        return false;
+    }
+
+    GSuint access(const GSuint *triangle)
+    {
+        return GSuint(access(triangle[0])) + GSuint(access(triangle[1])) + GSuint(access(triangle[2]));
+    }
+
+    void reset()
+    {
+        p_timestamp += p_size + 1;
+    }
+
+private:
+    std::vector<GSuint> p_time;
+    GSuint              p_timestamp;
+    GSuint              p_size;
+};
+
+
+static inline GSuint restart_value(const GSmeshindices &mesh)
+{
+    return mesh.format == GS_INDEX_16 ? mesh.restartindex & 0xffff : mesh.restartindex;
+}
+
+static inline bool is_restart(const GSmeshindices &mesh, GSuint index)
+{
+    return mesh.restart && index == restart_value(mesh);
+}
+
+// reads index data expanded to 32 bit and validates it
+static bool read_indices(const GSmeshindices &mesh, std::vector<GSuint> &indices)
+{
+    if (!mesh.indices || mesh.count == 0) {
+        return false;
+    }
+
+    indices.resize(mesh.count);
+
+    switch (mesh.format) {
+        case GS_INDEX_16: {
+            const unsigned short *source = reinterpret_cast<const unsigned short*>(mesh.indices);
+            for (GSuint n = 0; n < mesh.count; ++n) {
+                indices[n] = source[n];
+            }
+            break;
+        }
+
+        case GS_INDEX_32:
+            memcpy(indices.data(), mesh.indices, mesh.count * sizeof(GSuint));
+            break;
+
+        default:
+            return false;
+    }
+
+    for (auto index : indices) {
+        if (index >= mesh.vertexcount && !is_restart(mesh, index)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void write_indices(const GSmeshindices &mesh, const std::vector<GSuint> &indices)
+{
+    if (mesh.format == GS_INDEX_16) {
+        unsigned short *dest = reinterpret_cast<unsigned short*>(mesh.indices);
+        for (GSuint n = 0; n < mesh.count; ++n) {
+            dest[n] = static_cast<unsigned short>(indices[n]);
+        }
+    } else {
+        memcpy(mesh.indices, indices.data(), mesh.count * sizeof(GSuint));
+    }
+}
+
+// calls func for every triangle range between restart indices,
+// incomplete triangles at the end of range are left untouched
+template <typename T>
+static void for_each_range(const GSmeshindices &mesh, std::vector<GSuint> &indices, T func)
+{
+    GSuint start = 0;
+    for (GSuint n = 0; n <= mesh.count; ++n) {
+        if (n == mesh.count || is_restart(mesh, indices[n])) {
+            GSuint count = (n - start) / 3 * 3;
+            if (count) {
+                func(indices.data() + start, count);
+            }
+            start = n + 1;
+        }
+    }
+}
+
+
+float xGS::mesh_acmr(const GSmeshindices &mesh, GSuint cachesize)
+{
+    std::vector<GSuint> indices;
+    if (!read_indices(mesh, indices)) {
+        return 0;
+    }
+
+    MeshVertexCache cache(mesh.vertexcount, cachesize);
+    GSuint misses = 0;
+    GSuint triangles = 0;
+
+    for_each_range(mesh, indices, [&](const GSuint *range, GSuint count) {
+        for (GSuint n = 0; n < count; n += 3) {
+            misses += cache.access(range + n);
+        }
+        triangles += count / 3;
+    });
+
+    return triangles ? float(misses) / float(triangles) : 0;
+}
+
+
+// Forsyth vertex score, see "Linear-Speed Vertex Cache Optimisation"
+static float vertex_score(int cacheposition, GSuint livetriangles)
+{
+    const float CacheDecayPower = 1.5f;
+    const float LastTriangleScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    if (livetriangles == 0) {
+        // no triangles left, vertex is not needed
+        return -1.0f;
+    }
+
+    float score = 0;
+    if (cacheposition >= 0) {
+        if (cacheposition < 3) {
+            // vertices of last triangle get fixed score so
+            // triangle strips don't get preferred too much
+            score = LastTriangleScore;
+        } else {
+            const float scaler = 1.0f / float(MESH_CACHE_SIZE - 3);
+            score = powf(1.0f - float(cacheposition - 3) * scaler, CacheDecayPower);
+        }
+    }
+
+    // boost vertices with few triangles left, so lone triangles are not left behind
+    return score + ValenceBoostScale * powf(float(livetriangles), -ValenceBoostPower);
+}
+
+static void optimize_vertexcache_range(GSuint *indices, GSuint count, GSuint vertexcount)
+{
+    GSuint tricount = count / 3;
+
+    std::vector<GSuint> live(vertexcount, 0);
+    for (GSuint n = 0; n < count; ++n) {
+        ++live[indices[n]];
+    }
+
+    // triangles adjacent to every vertex, first live[v] entries are not emitted yet
+    std::vector<GSuint> offsets(vertexcount + 1, 0);
+    for (GSuint v = 0; v < vertexcount; ++v) {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+
+    std::vector<GSuint> adjacency(count);
+    std::vector<GSuint> fill(offsets.begin(), offsets.end() - 1);
+    for (GSuint n = 0; n < count; ++n) {
+        adjacency[fill[indices[n]]++] = n / 3;
+    }
+
+    std::vector<int> cacheposition(vertexcount, -1);
+    std::vector<float> score(vertexcount);
+    for (GSuint v = 0; v < vertexcount; ++v) {
+        score[v] = vertex_score(-1, live[v]);
+    }
+
+    auto triangle_score = [&](GSuint triangle) {
+        const GSuint *t = indices + triangle * 3;
+        return score[t[0]] + score[t[1]] + score[t[2]];
+    };
+
+    std::vector<bool> emitted(tricount, false);
+    std::vector<GSuint> result;
+    result.reserve(count);
+
+    std::vector<GSuint> cache;
+    std::vector<GSuint> newcache;
+    cache.reserve(MESH_CACHE_SIZE + 3);
+    newcache.reserve(MESH_CACHE_SIZE + 3);
+
+    GSuint best = 0;
+    float bestscore = -1.0f;
+    for (GSuint t = 0; t < tricount; ++t) {
+        float s = triangle_score(t);
+        if (s > bestscore) {
+            bestscore = s;
+            best = t;
+        }
+    }
+
+    GSuint scan = 0;
+
+    for (GSuint n = 0; n < tricount; ++n) {
+        emitted[best] = true;
+
+        newcache.clear();
+
+        const GSuint *triangle = indices + best * 3;
+        for (int c = 0; c < 3; ++c) {
+            GSuint v = triangle[c];
+            result.push_back(v);
+
+            GSuint *list = adjacency.data() + offsets[v];
+            for (GSuint i = 0; i < live[v]; ++i) {
+                if (list[i] == best) {
+                    list[i] = list[live[v] - 1];
+                    --live[v];
+                    break;
+                }
+            }
+
+            if (std::find(newcache.begin(), newcache.end(), v) == newcache.end()) {
+                newcache.push_back(v);
+            }
+        }
+
+        for (auto v : cache) {
+            if (std::find(newcache.begin(), newcache.end(), v) == newcache.end()) {
+                newcache.push_back(v);
+            }
+        }
+
+        // vertices pushed out of cache
+        for (size_t i = MESH_CACHE_SIZE; i < newcache.size(); ++i) {
+            GSuint v = newcache[i];
+            cacheposition[v] = -1;
+            score[v] = vertex_score(-1, live[v]);
+        }
+
+        if (newcache.size() > MESH_CACHE_SIZE) {
+            newcache.resize(MESH_CACHE_SIZE);
+        }
+
+        for (size_t i = 0; i < newcache.size(); ++i) {
+            GSuint v = newcache[i];
+            cacheposition[v] = int(i);
+            score[v] = vertex_score(int(i), live[v]);
+        }
+
+        cache.swap(newcache);
+
+        // next triangle is the best one using cached vertices
+        bestscore = -1.0f;
+        for (auto v : cache) {
+            const GSuint *list = adjacency.data() + offsets[v];
+            for (GSuint i = 0; i < live[v]; ++i) {
+                float s = triangle_score(list[i]);
+                if (s > bestscore) {
+                    bestscore = s;
+                    best = list[i];
+                }
+            }
+        }
+
+        // nothing is adjacent to cache, continue with first not emitted triangle
+        if (bestscore < 0) {
+            while (scan < tricount && emitted[scan]) {
+                ++scan;
+            }
+            best = scan;
+        }
+    }
+
+    memcpy(indices, result.data(), count * sizeof(GSuint));
+}
+
+bool xGS::mesh_optimize_vertexcache(const GSmeshindices &mesh)
+{
+    std::vector<GSuint> indices;
+    if (!read_indices(mesh, indices)) {
+        return false;
+    }
+
+    for_each_range(mesh, indices, [&](GSuint *range, GSuint count) {
+        optimize_vertexcache_range(range, count, mesh.vertexcount);
+    });
+
+    write_indices(mesh, indices);
+
+    return true;
+}
+
+
+static inline const float* vertex_position(const void *positions, GSuint stride, GSuint vertex)
+{
+    return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + size_t(vertex) * stride);
+}
+
+// triangle centroid and normal, normal length is twice the triangle area
+static void triangle_geometry(const GSuint *triangle, const void *positions, GSuint stride, float *centroid, float *normal)
+{
+    const float *p0 = vertex_position(positions, stride, triangle[0]);
+    const float *p1 = vertex_position(positions, stride, triangle[1]);
+    const float *p2 = vertex_position(positions, stride, triangle[2]);
+
+    float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+    for (int c = 0; c < 3; ++c) {
+        centroid[c] = (p0[c] + p1[c] + p2[c]) / 3.0f;
+    }
+}
+
+// see Sander, Nehab, Barczak "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+static void optimize_overdraw_range(
+    GSuint *indices, GSuint count, GSuint vertexcount,
+    const void *positions, GSuint stride, float threshold
+)
+{
+    GSuint tricount = count / 3;
+
+    MeshVertexCache cache(vertexcount, MESH_CACHE_SIZE);
+
+    // hard cluster boundaries are where cache was fully missed
+    std::vector<GSuint> hard;
+    for (GSuint t = 0; t < tricount; ++t) {
+        if (cache.access(indices + t * 3) == 3 || t == 0) {
+            hard.push_back(t);
+        }
+    }
+    hard.push_back(tricount);
+
+    // hard clusters are further split while ACMR of split part stays
+    // within threshold from ACMR of whole cluster
+    std::vector<GSuint> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h) {
+        GSuint start = hard[h];
+        GSuint end = hard[h + 1];
+
+        cache.reset();
+        GSuint misses = 0;
+        for (GSuint t = start; t < end; ++t) {
+            misses += cache.access(indices + t * 3);
+        }
+
+        float clusterthreshold = threshold * float(misses) / float(end - start);
+
+        cache.reset();
+        clusters.push_back(start);
+
+        GSuint substart = start;
+        GSuint accumulated = 0;
+        for (GSuint t = start; t < end; ++t) {
+            accumulated += cache.access(indices + t * 3);
+
+            if (t + 1 < end && float(accumulated) <= float(t + 1 - substart) * clusterthreshold) {
+                clusters.push_back(t + 1);
+                substart = t + 1;
+                accumulated = 0;
+                cache.reset();
+            }
+        }
+    }
+    clusters.push_back(tricount);
+
+    GSuint clustercount = GSuint(clusters.size() - 1);
+
+    // area weighted mesh and cluster centroids, cluster average normals
+    float meshcentroid[3] = { 0, 0, 0 };
+    float mesharea = 0;
+
+    std::vector<float> clusterdata(clustercount * 6, 0.0f);
+
+    for (GSuint c = 0; c < clustercount; ++c) {
+        float *centroid = clusterdata.data() + c * 6;
+        float *normal = centroid + 3;
+        float area = 0;
+
+        for (GSuint t = clusters[c]; t < clusters[c + 1]; ++t) {
+            float tc[3];
+            float tn[3];
+            triangle_geometry(indices + t * 3, positions, stride, tc, tn);
+
+            float ta = sqrtf(tn[0] * tn[0] + tn[1] * tn[1] + tn[2] * tn[2]);
+
+            for (int i = 0; i < 3; ++i) {
+                centroid[i] += tc[i] * ta;
+                normal[i] += tn[i];
+                meshcentroid[i] += tc[i] * ta;
+            }
+
+            area += ta;
+        }
+
+        if (area > 0) {
+            for (int i = 0; i < 3; ++i) {
+                centroid[i] /= area;
+            }
+        }
+
+        mesharea += area;
+    }
+
+    if (mesharea > 0) {
+        for (int i = 0; i < 3; ++i) {
+            meshcentroid[i] /= mesharea;
+        }
+    }
+
+    // clusters facing outwards from mesh center are drawn first, they are
+    // most likely to occlude others
+    std::vector<float> sortkey(clustercount);
+    for (GSuint c = 0; c < clustercount; ++c) {
+        const float *centroid = clusterdata.data() + c * 6;
+        const float *normal = centroid + 3;
+
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float scale = length > 0 ? 1.0f / length : 0.0f;
+
+        sortkey[c] =
+            ((centroid[0] - meshcentroid[0]) * normal[0] +
+             (centroid[1] - meshcentroid[1]) * normal[1] +
+             (centroid[2] - meshcentroid[2]) * normal[2]) * scale;
+    }
+
+    std::vector<GSuint> order(clustercount);
+    for (GSuint c = 0; c < clustercount; ++c) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](GSuint a, GSuint b) {
+        return sortkey[a] > sortkey[b];
+    });
+
+    std::vector<GSuint> result;
+    result.reserve(count);
+    for (auto c : order) {
+        result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+    }
+
+    memcpy(indices, result.data(), count * sizeof(GSuint));
+}
+
+bool xGS::mesh_optimize_overdraw(
+    const GSmeshindices &mesh, const void *positions, GSuint stride, float threshold
+)
+{
+    if (!positions || stride < sizeof(float) * 3) {
+        return false;
+    }
+
+    std::vector<GSuint> indices;
+    if (!read_indices(mesh, indices)) {
+        return false;
+    }
+
+    for_each_range(mesh, indices, [&](GSuint *range, GSuint count) {
+        optimize_overdraw_range(range, count, mesh.vertexcount, positions, stride, threshold);
+    });
+
+    write_indices(mesh, indices);
+
+    return true;
+}
+
+
+bool xGS::mesh_optimize_vertexfetch(const GSmeshindices &mesh, GSptr vertices, GSuint vertexsize)
+{
+    if (!vertices || vertexsize == 0) {
+        return false;
+    }
+
+    // remapped vertex could get restart value otherwise
+    if (mesh.restart && restart_value(mesh) < mesh.vertexcount) {
+        return false;
+    }
+
+    std::vector<GSuint> indices;
+    if (!read_indices(mesh, indices)) {
+        return false;
+    }
+
+    std::vector<GSuint> remap(mesh.vertexcount, NO_VERTEX);
+    GSuint next = 0;
+
+    for (auto index : indices) {
+        if (!is_restart(mesh, index) && remap[index] == NO_VERTEX) {
+            remap[index] = next++;
+        }
+    }
+
+    for (auto &r : remap) {
+        if (r == NO_VERTEX) {
+            r = next++;
+        }
+    }
+
+    std::vector<char> source(size_t(mesh.vertexcount) * vertexsize);
+    memcpy(source.data(), vertices, source.size());
+
+    char *dest = reinterpret_cast<char*>(vertices);
+    for (GSuint v = 0; v < mesh.vertexcount; ++v) {
+        memcpy(dest + size_t(remap[v]) * vertexsize, source.data() + size_t(v) * vertexsize, vertexsize);
+    }
+
+    for (auto &index : indices) {
+        if (!is_restart(mesh, index)) {
+            index = remap[index];
+        }
+    }
+
+    write_indices(mesh, indices);
+
+    return true;
+}
+
+
+// bounding sphere and normal cone of meshlet
+static void meshlet_bounds(
+    GSmeshlet &meshlet, const GSuint *vertices, const GSuint *triangles,
+    const void *positions, GSuint stride
+)
+{
+    // sphere is centered at bounding box center
+    float bmin[3];
+    float bmax[3];
+    for (GSuint v = 0; v < meshlet.vertexcount; ++v) {
+        const float *p = vertex_position(positions, stride, vertices[v]);
+        for (int c = 0; c < 3; ++c) {
+            if (v == 0 || p[c] < bmin[c]) {
+                bmin[c] = p[c];
+            }
+            if (v == 0 || p[c] > bmax[c]) {
+                bmax[c] = p[c];
+            }
+        }
+    }
+
+    float radius = 0;
+    for (int c = 0; c < 3; ++c) {
+        meshlet.center[c] = (bmin[c] + bmax[c]) * 0.5f;
+    }
+    for (GSuint v = 0; v < meshlet.vertexcount; ++v) {
+        const float *p = vertex_position(positions, stride, vertices[v]);
+        float d[3] = { p[0] - meshlet.center[0], p[1] - meshlet.center[1], p[2] - meshlet.center[2] };
+        float distance = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        if (distance > radius) {
+            radius = distance;
+        }
+    }
+    meshlet.radius = sqrtf(radius);
+
+    // cone axis is average of triangle normals, spread is defined by
+    // normal which deviates from axis the most
+    std::vector<float> normals(meshlet.trianglecount * 3);
+    float axis[3] = { 0, 0, 0 };
+
+    for (GSuint t = 0; t < meshlet.trianglecount; ++t) {
+        GSuint packed = triangles[t];
+        GSuint triangle[3] = {
+            vertices[packed & 0xff],
+            vertices[(packed >> 8) & 0xff],
+            vertices[(packed >> 16) & 0xff]
+        };
+
+        float centroid[3];
+        float *normal = normals.data() + t * 3;
+        triangle_geometry(triangle, positions, stride, centroid, normal);
+
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float scale = length > 0 ? 1.0f / length : 0.0f;
+        for (int c = 0; c < 3; ++c) {
+            normal[c] *= scale;
+            axis[c] += normal[c];
+        }
+    }
+
+    float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float scale = length > 0 ? 1.0f / length : 0.0f;
+
+    float mindot = 1.0f;
+    for (int c = 0; c < 3; ++c) {
+        meshlet.coneaxis[c] = axis[c] * scale;
+    }
+    for (GSuint t = 0; t < meshlet.trianglecount; ++t) {
+        const float *normal = normals.data() + t * 3;
+        float d =
+            normal[0] * meshlet.coneaxis[0] +
+            normal[1] * meshlet.coneaxis[1] +
+            normal[2] * meshlet.coneaxis[2];
+        if (d < mindot) {
+            mindot = d;
+        }
+    }
+
+    // cone wider than hemisphere can't be used for culling
+    meshlet.conecutoff = length > 0 && mindot > 0 ? sqrtf(1.0f - mindot * mindot) : 1.0f;
+}
+
+bool xGS::mesh_build_meshlets(
+    const GSmeshindices &mesh, const void *positions, GSuint stride,
+    GSuint maxvertices, GSuint maxtriangles,
+    std::vector<GSmeshlet> &meshlets, std::vector<GSuint> &vertices, std::vector<GSuint> &triangles
+)
+{
+    if (!positions || stride < sizeof(float) * 3) {
+        return false;
+    }
+
+    // local indices are 8-bit
+    if (maxvertices < 3 || maxvertices > 256 || maxtriangles == 0) {
+        return false;
+    }
+
+    std::vector<GSuint> indices;
+    if (!read_indices(mesh, indices)) {
+        return false;
+    }
+
+    meshlets.clear();
+    vertices.clear();
+    triangles.clear();
+
+    // local index of vertex in current meshlet, valid only if stamp matches meshlet
+    std::vector<GSuint> localindex(mesh.vertexcount);
+    std::vector<GSuint> stamp(mesh.vertexcount, NO_VERTEX);
+
+    GSmeshlet current = {};
+
+    auto flush = [&]() {
+        if (current.trianglecount) {
+            meshlet_bounds(
+                current, vertices.data() + current.vertexoffset,
+                triangles.data() + current.triangleoffset, positions, stride
+            );
+            meshlets.push_back(current);
+        }
+
+        current = GSmeshlet();
+        current.vertexoffset = GSuint(vertices.size());
+        current.triangleoffset = GSuint(triangles.size());
+    };
+
+    flush();
+
+    for_each_range(mesh, indices, [&](const GSuint *range, GSuint count) {
+        for (GSuint n = 0; n < count; n += 3) {
+            const GSuint *triangle = range + n;
+            GSuint meshletindex = GSuint(meshlets.size());
+
+            GSuint newvertices = 0;
+            for (int c = 0; c < 3; ++c) {
+                GSuint v = triangle[c];
+                bool duplicate = (c > 0 && triangle[0] == v) || (c > 1 && triangle[1] == v);
+                if (stamp[v] != meshletindex && !duplicate) {
+                    ++newvertices;
+                }
+            }
+
+            if (current.vertexcount + newvertices > maxvertices || current.trianglecount == maxtriangles) {
+                flush();
+                meshletindex = GSuint(meshlets.size());
+            }
+
+            GSuint packed = 0;
+            for (int c = 0; c < 3; ++c) {
+                GSuint v = triangle[c];
+                if (stamp[v] != meshletindex) {
+                    stamp[v] = meshletindex;
+                    localindex[v] = current.vertexcount++;
+                    vertices.push_back(v);
+                }
+                packed |= localindex[v] << (c * 8);
+            }
+
+            triangles.push_back(packed);
+            ++current.trianglecount;
+        }
+    });
+
+    flush();
+
+    return true;
+}
@@ -0,0 +1,65 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSmesh.h
+        Mesh optimization functions
+            reorder triangle list index data for post-transform vertex cache
+            and overdraw, reorder vertex data for fetch locality
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include <vector>
+
+
+namespace xGS
+{
+
+    // index data of triangle list mesh, index data could be either CPU array
+    // or locked geometry memory, all functions work in place
+    //      if restart is set, restartindex values split index data into ranges,
+    //      every range is optimized separately and restart values keep their positions
+    struct GSmeshindices
+    {
+        GSptr  indices;
+        GSenum format;      // GS_INDEX_16 or GS_INDEX_32
+        GSuint count;
+        GSuint vertexcount;
+        bool   restart;
+        GSuint restartindex;
+    };
+
+    // average cache miss ratio (transformed vertices per triangle)
+    // for FIFO cache of given size
+    float mesh_acmr(const GSmeshindices &mesh, GSuint cachesize);
+
+    // reorder triangles for post-transform vertex cache (Forsyth)
+    bool mesh_optimize_vertexcache(const GSmeshindices &mesh);
+
+    // reorder clusters of triangles to reduce overdraw, should be done after
+    // vertex cache optimization, clusters are split while their ACMR stays
+    // within threshold from original (1.05 is good default)
+    bool mesh_optimize_overdraw(
+        const GSmeshindices &mesh, const void *positions, GSuint stride, float threshold
+    );
+
+    // reorder vertices in order of first use and remap indices,
+    // unreferenced vertices are moved to the end
+    bool mesh_optimize_vertexfetch(const GSmeshindices &mesh, GSptr vertices, GSuint vertexsize);
+
+    // split triangles into meshlets with bounded vertex (up to 256) and triangle count,
+    // compute meshlet bounding spheres and normal cones
+    bool mesh_build_meshlets(
+        const GSmeshindices &mesh, const void *positions, GSuint stride,
+        GSuint maxvertices, GSuint maxtriangles,
+        std::vector<GSmeshlet> &meshlets, std::vector<GSuint> &vertices, std::vector<GSuint> &triangles
+    );
+
+} // namespace xGS
@@ -0,0 +1,401 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSmipchain.cpp
+        CPU MIP chain builder class
+*/
+
+#include "xGSmipchain.h"
+#include "xGSvertexcompress.h"
+#include <cstring>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #define GS_MIPCHAIN_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+using namespace xGS;
+
+
+// minimal number of image rows worth running on separate thread
+static const GSuint MIP_THREAD_ROWS = 16;
+
+// Kaiser window half width in source texels and window shape
+static const float MIP_KAISER_RADIUS = 3.0f;
+static const float MIP_KAISER_BETA = 4.0f;
+
+// linear value steps of sRGB encoding table
+static const GSuint MIP_SRGB_STEPS = 4096;
+
+
+// sRGB conversion tables
+struct MipSRGBTables
+{
+    float         decode[256];
+    unsigned char encode[MIP_SRGB_STEPS];
+
+    MipSRGBTables()
+    {
+        for (int n = 0; n < 256; ++n) {
+            float c = n / 255.0f;
+            decode[n] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        for (GSuint n = 0; n < MIP_SRGB_STEPS; ++n) {
+            float c = n / float(MIP_SRGB_STEPS - 1);
+            float s = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+            encode[n] = (unsigned char)(s * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const MipSRGBTables& mip_srgb()
+{
+    static MipSRGBTables tables;
+    return tables;
+}
+
+static inline bool mip_srgb_format(GSenum format)
+{
+    return format == GS_COLOR_S_RGBA || format == GS_COLOR_S_RGBX;
+}
+
+static inline bool mip_alpha_format(GSenum format)
+{
+    return format != GS_COLOR_RGBX && format != GS_COLOR_S_RGBX;
+}
+
+static inline float mip_saturate(float value)
+{
+    return value < 0 ? 0 : (value > 1.0f ? 1.0f : value);
+}
+
+static float half_to_float(unsigned short value)
+{
+    GSuint sign = GSuint(value & 0x8000) << 16;
+    GSuint exponent = (value >> 10) & 0x1f;
+    GSuint mantissa = value & 0x3ff;
+
+    GSuint result;
+    if (exponent == 0x1f) {
+        // inf or nan
+        result = sign | 0x7f800000u | (mantissa << 13);
+    } else if (exponent == 0) {
+        // subnormal or zero, scaled by 2^-24
+        float f = mantissa * (1.0f / 16777216.0f);
+        memcpy(&result, &f, sizeof(result));
+        result |= sign;
+    } else {
+        result = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float f;
+    memcpy(&f, &result, sizeof(f));
+    return f;
+}
+
+static float mip_bessel0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k < 8; ++k) {
+        float t = x / (2.0f * k);
+        term *= t * t;
+        sum += term;
+    }
+    return sum;
+}
+
+// Kaiser windowed sinc for 2x downsampling, x is offset in source texels
+static float mip_kaiser(float x)
+{
+    float r = x / MIP_KAISER_RADIUS;
+    if (fabsf(r) >= 1.0f) {
+        return 0;
+    }
+
+    float window = mip_bessel0(MIP_KAISER_BETA * sqrtf(1.0f - r * r)) / mip_bessel0(MIP_KAISER_BETA);
+    float s = 1.5707963f * x;
+
+    return (fabsf(s) < 1e-4f ? 1.0f : sinf(s) / s) * window;
+}
+
+// runs work for rows range split between pool threads and calling thread
+template <typename T>
+static void mip_rows(GSuint rows, GSuint threads, WorkerPool &workers, const T &work)
+{
+    GSuint maxthreads = rows / MIP_THREAD_ROWS;
+    if (threads > maxthreads) {
+        threads = maxthreads;
+    }
+
+    if (threads <= 1) {
+        work(0, rows);
+        return;
+    }
+
+    GSuint batch = (rows + threads - 1) / threads;
+    GSuint batches = (rows + batch - 1) / batch;
+
+    workers.run(batches, [&work, batch, rows](GSuint index) {
+        GSuint first = index * batch;
+        work(first, first + batch < rows ? first + batch : rows);
+    });
+}
+
+
+ImageMipChain::ImageMipChain(GSenum filter, GSuint threads, WorkerPool &workers) :
+    p_filter(filter),
+    p_threads(threads),
+    p_workers(workers),
+    p_width(0),
+    p_height(0)
+{}
+
+GSuint ImageMipChain::texelSize(GSenum format)
+{
+    switch (format) {
+        case GS_COLOR_RGBA:
+        case GS_COLOR_RGBX:
+        case GS_COLOR_S_RGBA:
+        case GS_COLOR_S_RGBX:
+            return 4;
+
+        case GS_COLOR_RGBA_HALFFLOAT:
+            return 8;
+
+        case GS_COLOR_RGBA_FLOAT:
+            return 16;
+    }
+
+    return 0;
+}
+
+void ImageMipChain::load(GSenum format, bool rgborder, GSuint width, GSuint height, const void *source, GSuint pitch)
+{
+    p_width = width;
+    p_height = height;
+    p_image.resize(size_t(width) * height * 4);
+
+    const MipSRGBTables &srgb = mip_srgb();
+
+    bool decode = mip_srgb_format(format);
+    bool alpha = mip_alpha_format(format);
+    int red = rgborder ? 0 : 2;
+    int blue = rgborder ? 2 : 0;
+
+    const unsigned char *data = reinterpret_cast<const unsigned char*>(source);
+
+    mip_rows(height, p_threads, p_workers, [&](GSuint first, GSuint last) {
+        for (GSuint y = first; y < last; ++y) {
+            const unsigned char *row = data + size_t(y) * pitch;
+            float *texel = p_image.data() + size_t(y) * width * 4;
+
+            switch (format) {
+                case GS_COLOR_RGBA_FLOAT:
+                    memcpy(texel, row, width * sizeof(float) * 4);
+                    break;
+
+                case GS_COLOR_RGBA_HALFFLOAT:
+                    for (GSuint x = 0; x < width * 4; ++x) {
+                        unsigned short h;
+                        memcpy(&h, row + x * 2, sizeof(h));
+                        texel[x] = half_to_float(h);
+                    }
+                    break;
+
+                default:
+                    for (GSuint x = 0; x < width; ++x, row += 4, texel += 4) {
+                        if (decode) {
+                            texel[0] = srgb.decode[row[red]];
+                            texel[1] = srgb.decode[row[1]];
+                            texel[2] = srgb.decode[row[blue]];
+                        } else {
+                            texel[0] = row[red] / 255.0f;
+                            texel[1] = row[1] / 255.0f;
+                            texel[2] = row[blue] / 255.0f;
+                        }
+                        texel[3] = alpha ? row[3] / 255.0f : 1.0f;
+                    }
+                    break;
+            }
+        }
+    });
+}
+
+// filters single texel from taps of source texels, stride is distance between
+// neighbour source texels in floats, negative lobes could give negative values
+static inline void mip_filter_texel(float *dest, const float *source, size_t stride, const GSuint *index, const float *weight, GSuint count, bool clamp)
+{
+#ifdef GS_MIPCHAIN_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (GSuint k = 0; k < count; ++k) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + index[k] * stride), _mm_set1_ps(weight[k])));
+    }
+    if (clamp) {
+        sum = _mm_max_ps(sum, _mm_setzero_ps());
+    }
+    _mm_storeu_ps(dest, sum);
+#else
+    float sum[4] = { 0, 0, 0, 0 };
+    for (GSuint k = 0; k < count; ++k) {
+        const float *texel = source + index[k] * stride;
+        for (int c = 0; c < 4; ++c) {
+            sum[c] += texel[c] * weight[k];
+        }
+    }
+    for (int c = 0; c < 4; ++c) {
+        dest[c] = clamp && sum[c] < 0 ? 0 : sum[c];
+    }
+#endif
+}
+
+void ImageMipChain::next()
+{
+    GSuint width = p_width > 1 ? p_width >> 1 : 1;
+    GSuint height = p_height > 1 ? p_height >> 1 : 1;
+
+    buildTaps(p_tapsx, p_width, width);
+    buildTaps(p_tapsy, p_height, height);
+
+    p_filtered.resize(size_t(width) * p_height * 4);
+    p_next.resize(size_t(width) * height * 4);
+
+    bool clamp = p_filter == GS_MIPFILTER_KAISER;
+
+    // filter is separable, rows are filtered horizontally first
+    mip_rows(p_height, p_threads, p_workers, [&](GSuint first, GSuint last) {
+        for (GSuint y = first; y < last; ++y) {
+            const float *source = p_image.data() + size_t(y) * p_width * 4;
+            float *dest = p_filtered.data() + size_t(y) * width * 4;
+
+            for (GSuint x = 0; x < width; ++x, dest += 4) {
+                const Taps &t = p_tapsx[x];
+                mip_filter_texel(dest, source, 4, t.index, t.weight, t.count, false);
+            }
+        }
+    });
+
+    mip_rows(height, p_threads, p_workers, [&](GSuint first, GSuint last) {
+        for (GSuint y = first; y < last; ++y) {
+            const Taps &t = p_tapsy[y];
+            float *dest = p_next.data() + size_t(y) * width * 4;
+
+            for (GSuint x = 0; x < width; ++x, dest += 4) {
+                const float *source = p_filtered.data() + size_t(x) * 4;
+                mip_filter_texel(dest, source, size_t(width) * 4, t.index, t.weight, t.count, clamp);
+            }
+        }
+    });
+
+    p_image.swap(p_next);
+    p_width = width;
+    p_height = height;
+}
+
+void ImageMipChain::store(GSenum format, GSptr destination, GSuint pitch)
+{
+    const MipSRGBTables &srgb = mip_srgb();
+
+    bool encode = mip_srgb_format(format);
+    bool alpha = mip_alpha_format(format);
+
+    unsigned char *data = reinterpret_cast<unsigned char*>(destination);
+
+    mip_rows(p_height, p_threads, p_workers, [&](GSuint first, GSuint last) {
+        for (GSuint y = first; y < last; ++y) {
+            const float *texel = p_image.data() + size_t(y) * p_width * 4;
+            unsigned char *row = data + size_t(y) * pitch;
+
+            switch (format) {
+                case GS_COLOR_RGBA_FLOAT:
+                    memcpy(row, texel, p_width * sizeof(float) * 4);
+                    break;
+
+                case GS_COLOR_RGBA_HALFFLOAT:
+                    for (GSuint x = 0; x < p_width * 4; ++x) {
+                        unsigned short h = float_to_half(texel[x]);
+                        memcpy(row + x * 2, &h, sizeof(h));
+                    }
+                    break;
+
+                default:
+                    for (GSuint x = 0; x < p_width; ++x, row += 4, texel += 4) {
+                        if (encode) {
+                            const GSuint steps = MIP_SRGB_STEPS - 1;
+                            row[0] = srgb.encode[GSuint(mip_saturate(texel[2]) * steps + 0.5f)];
+                            row[1] = srgb.encode[GSuint(mip_saturate(texel[1]) * steps + 0.5f)];
+                            row[2] = srgb.encode[GSuint(mip_saturate(texel[0]) * steps + 0.5f)];
+                            row[3] = alpha ? (unsigned char)(mip_saturate(texel[3]) * 255.0f + 0.5f) : 255;
+                        } else {
+#ifdef GS_MIPCHAIN_SSE2
+                            // R, G, B, A -> B, G, R, A bytes
+                            __m128 c = _mm_loadu_ps(texel);
+                            c = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 1, 2));
+                            c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                            __m128i b = _mm_cvtps_epi32(_mm_mul_ps(c, _mm_set1_ps(255.0f)));
+                            b = _mm_packs_epi32(b, b);
+                            b = _mm_packus_epi16(b, b);
+                            int bgra = _mm_cvtsi128_si32(b);
+                            memcpy(row, &bgra, sizeof(bgra));
+#else
+                            row[0] = (unsigned char)(mip_saturate(texel[2]) * 255.0f + 0.5f);
+                            row[1] = (unsigned char)(mip_saturate(texel[1]) * 255.0f + 0.5f);
+                            row[2] = (unsigned char)(mip_saturate(texel[0]) * 255.0f + 0.5f);
+                            row[3] = (unsigned char)(mip_saturate(texel[3]) * 255.0f + 0.5f);
+#endif
+                            if (!alpha) {
+                                row[3] = 255;
+                            }
+                        }
+                    }
+                    break;
+            }
+        }
+    });
+}
+
+void ImageMipChain::buildTaps(TapsList &taps, GSuint source, GSuint dest) const
+{
+    taps.resize(dest);
+
+    GSint last = GSint(source) - 1;
+
+    for (GSuint n = 0; n < dest; ++n) {
+        Taps &t = taps[n];
+
+        if (p_filter == GS_MIPFILTER_KAISER) {
+            float center = (n + 0.5f) * source / dest;
+            GSint first = GSint(floorf(center - 0.5f)) - 2;
+
+            float sum = 0;
+            for (GSuint k = 0; k < 6; ++k) {
+                GSint index = first + GSint(k);
+                t.weight[k] = mip_kaiser(index + 0.5f - center);
+                t.index[k] = GSuint(index < 0 ? 0 : (index > last ? last : index));
+                sum += t.weight[k];
+            }
+            for (GSuint k = 0; k < 6; ++k) {
+                t.weight[k] /= sum;
+            }
+            t.count = 6;
+        } else {
+            // odd sized source takes extra texel for last destination texel,
+            // so every source texel contributes
+            t.count = (source & 1) && source > 1 && n == dest - 1 ? 3 : 2;
+            for (GSuint k = 0; k < t.count; ++k) {
+                GSint index = GSint(n * 2 + k);
+                t.index[k] = GSuint(index > last ? last : index);
+                t.weight[k] = 1.0f / t.count;
+            }
+        }
+    }
+}
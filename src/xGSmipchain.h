@@ -0,0 +1,75 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSmipchain.h
+        CPU MIP chain builder class header
+            filters MIP levels and converts texels between color formats,
+            image rows could be split between several threads
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include "xGSworkers.h"
+#include <vector>
+
+
+namespace xGS
+{
+
+    // CPU MIP chain builder
+    //      current level is kept as linear R, G, B, A float image, sRGB texels are decoded
+    //      on load and encoded on store, so filtering is always done in linear space
+    //      8-bit formats are B, G, R, A ordered (R, G, B, A for loads with rgborder),
+    //      X component of RGBX formats is loaded as 1 and stored as 1
+    class ImageMipChain
+    {
+    public:
+        ImageMipChain(GSenum filter, GSuint threads, WorkerPool &workers);
+
+        // checks if format could be loaded and stored, returns texel size or 0
+        static GSuint texelSize(GSenum format);
+
+        GSuint width() const { return p_width; }
+        GSuint height() const { return p_height; }
+
+        // converts source image into current level
+        void load(GSenum format, bool rgborder, GSuint width, GSuint height, const void *source, GSuint pitch);
+        // filters next level from current one, level size is halved (down to 1)
+        void next();
+        // converts current level into destination image
+        void store(GSenum format, GSptr destination, GSuint pitch);
+
+    private:
+        // filter taps of single destination texel along one axis
+        struct Taps
+        {
+            GSuint index[6];
+            float  weight[6];
+            GSuint count;
+        };
+
+        typedef std::vector<Taps> TapsList;
+
+        void buildTaps(TapsList &taps, GSuint source, GSuint dest) const;
+
+    private:
+        GSenum             p_filter;   // GS_MIPFILTER_BOX or GS_MIPFILTER_KAISER
+        GSuint             p_threads;  // max number of threads
+        WorkerPool        &p_workers;  // threads row batches run on
+        GSuint             p_width;    // current level width
+        GSuint             p_height;   // current level height
+        std::vector<float> p_image;    // current level texels
+        std::vector<float> p_filtered; // next level width by current level height texels
+        std::vector<float> p_next;     // next level texels
+        TapsList           p_tapsx;    // next level horizontal taps
+        TapsList           p_tapsy;    // next level vertical taps
+    };
+
+} // namespace xGS
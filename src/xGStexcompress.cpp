@@ -0,0 +1,635 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStexcompress.cpp
+        Texture block compression functions
+*/
+
+#include "xGStexcompress.h"
+#include "xGSutil.h"
+#include <vector>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #define GS_TEXCOMPRESS_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+using namespace xGS;
+
+
+// minimal number of block rows worth running on separate thread
+static const GSuint COMPRESS_THREAD_ROWS = 8;
+
+// transparent texel threshold for BC1 3 color mode
+static const float BC1_ALPHA_THRESHOLD = 128.0f;
+
+// palette component value which is never selected as nearest
+static const float BC_EXCLUDED = 1e6f;
+
+// BC7 4-bit index interpolation weights
+static const GSuint BC7_WEIGHTS[16] = {
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+
+// 4x4 block of texels, components are in R, G, B, A order
+struct TexelBlock
+{
+    float texels[16][4];
+};
+
+// compression input shared between threads
+struct CompressImage
+{
+    GSenum               format;
+    GSuint               width;
+    GSuint               height;
+    const unsigned char *source;
+    GSuint               sourcepitch;
+    unsigned char       *destination;
+    GSuint               destinationpitch;
+    GSuint               blocksize;
+};
+
+// least significant bit first writer for BC7 blocks
+struct BlockBitWriter
+{
+    unsigned char *data;
+    GSuint         position;
+
+    void write(GSuint value, GSuint bits)
+    {
+        for (GSuint n = 0; n < bits; ++n, ++position) {
+            if ((value >> n) & 1) {
+                data[position >> 3] |= 1 << (position & 7);
+            }
+        }
+    }
+};
+
+
+static inline float clamp_component(float value)
+{
+    return value < 0 ? 0 : (value > 255.0f ? 255.0f : value);
+}
+
+static void fetch_block(const CompressImage &image, GSuint bx, GSuint by, TexelBlock &block)
+{
+    for (GSuint y = 0; y < 4; ++y) {
+        // edge texels are replicated for partial blocks
+        GSuint sy = by * 4 + y;
+        if (sy >= image.height) {
+            sy = image.height - 1;
+        }
+
+        const unsigned char *row = image.source + sy * image.sourcepitch;
+
+        for (GSuint x = 0; x < 4; ++x) {
+            GSuint sx = bx * 4 + x;
+            if (sx >= image.width) {
+                sx = image.width - 1;
+            }
+
+            const unsigned char *texel = row + sx * 4;
+            float *dest = block.texels[y * 4 + x];
+            dest[0] = texel[2];
+            dest[1] = texel[1];
+            dest[2] = texel[0];
+            dest[3] = texel[3];
+        }
+    }
+}
+
+// finds endpoints of block colors along principal axis,
+// e0 is at the positive end of axis, e1 at the negative end
+//      opaqueonly - texels with alpha below threshold are ignored
+static void fit_endpoints(const TexelBlock &block, int components, bool opaqueonly, float *e0, float *e1)
+{
+    float mean[4] = { 0, 0, 0, 0 };
+    GSuint count = 0;
+
+    for (int t = 0; t < 16; ++t) {
+        if (opaqueonly && block.texels[t][3] < BC1_ALPHA_THRESHOLD) {
+            continue;
+        }
+        for (int c = 0; c < components; ++c) {
+            mean[c] += block.texels[t][c];
+        }
+        ++count;
+    }
+
+    if (count == 0) {
+        for (int c = 0; c < 4; ++c) {
+            e0[c] = e1[c] = 0;
+        }
+        return;
+    }
+
+    for (int c = 0; c < components; ++c) {
+        mean[c] /= count;
+    }
+
+    float covariance[4][4] = {};
+    for (int t = 0; t < 16; ++t) {
+        if (opaqueonly && block.texels[t][3] < BC1_ALPHA_THRESHOLD) {
+            continue;
+        }
+        for (int i = 0; i < components; ++i) {
+            float di = block.texels[t][i] - mean[i];
+            for (int j = 0; j < components; ++j) {
+                covariance[i][j] += di * (block.texels[t][j] - mean[j]);
+            }
+        }
+    }
+
+    // power iteration, starting from row of component with largest variance
+    int start = 0;
+    for (int c = 1; c < components; ++c) {
+        if (covariance[c][c] > covariance[start][start]) {
+            start = c;
+        }
+    }
+
+    float axis[4] = { 0, 0, 0, 0 };
+    for (int c = 0; c < components; ++c) {
+        axis[c] = covariance[start][c];
+    }
+
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = { 0, 0, 0, 0 };
+        float largest = 0;
+        for (int i = 0; i < components; ++i) {
+            for (int j = 0; j < components; ++j) {
+                next[i] += covariance[i][j] * axis[j];
+            }
+            largest = fabsf(next[i]) > largest ? fabsf(next[i]) : largest;
+        }
+
+        if (largest == 0) {
+            break;
+        }
+
+        for (int c = 0; c < components; ++c) {
+            axis[c] = next[c] / largest;
+        }
+    }
+
+    float length = 0;
+    for (int c = 0; c < components; ++c) {
+        length += axis[c] * axis[c];
+    }
+    if (length > 0) {
+        length = sqrtf(length);
+        for (int c = 0; c < components; ++c) {
+            axis[c] /= length;
+        }
+    }
+
+    float tmin = FLT_MAX;
+    float tmax = -FLT_MAX;
+    for (int t = 0; t < 16; ++t) {
+        if (opaqueonly && block.texels[t][3] < BC1_ALPHA_THRESHOLD) {
+            continue;
+        }
+        float projection = 0;
+        for (int c = 0; c < components; ++c) {
+            projection += (block.texels[t][c] - mean[c]) * axis[c];
+        }
+        tmin = projection < tmin ? projection : tmin;
+        tmax = projection > tmax ? projection : tmax;
+    }
+
+    for (int c = 0; c < 4; ++c) {
+        e0[c] = c < components ? clamp_component(mean[c] + axis[c] * tmax) : 0;
+        e1[c] = c < components ? clamp_component(mean[c] + axis[c] * tmin) : 0;
+    }
+}
+
+// selects nearest palette entry for every texel, returns total squared error
+//      count - palette size, multiple of 4
+static float nearest_indices(const TexelBlock &block, const float (*palette)[4], GSuint count, int components, GSuint *indices)
+{
+    float error = 0;
+
+#ifdef GS_TEXCOMPRESS_SSE2
+    // palette is transposed, so 4 entries are tested at once
+    float transposed[4][16];
+    for (GSuint n = 0; n < count; ++n) {
+        for (int c = 0; c < components; ++c) {
+            transposed[c][n] = palette[n][c];
+        }
+    }
+
+    for (int t = 0; t < 16; ++t) {
+        __m128 bestdistance = _mm_set1_ps(FLT_MAX);
+        __m128 bestindex = _mm_setzero_ps();
+
+        for (GSuint n = 0; n < count; n += 4) {
+            __m128 distance = _mm_setzero_ps();
+            for (int c = 0; c < components; ++c) {
+                __m128 d = _mm_sub_ps(_mm_loadu_ps(transposed[c] + n), _mm_set1_ps(block.texels[t][c]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(d, d));
+            }
+
+            __m128 less = _mm_cmplt_ps(distance, bestdistance);
+            __m128 index = _mm_setr_ps(float(n), float(n + 1), float(n + 2), float(n + 3));
+            bestdistance = _mm_min_ps(distance, bestdistance);
+            bestindex = _mm_or_ps(_mm_and_ps(less, index), _mm_andnot_ps(less, bestindex));
+        }
+
+        float distances[4];
+        float lanes[4];
+        _mm_storeu_ps(distances, bestdistance);
+        _mm_storeu_ps(lanes, bestindex);
+
+        int best = 0;
+        for (int lane = 1; lane < 4; ++lane) {
+            if (distances[lane] < distances[best] || (distances[lane] == distances[best] && lanes[lane] < lanes[best])) {
+                best = lane;
+            }
+        }
+
+        indices[t] = GSuint(lanes[best]);
+        error += distances[best];
+    }
+#else
+    for (int t = 0; t < 16; ++t) {
+        float bestdistance = FLT_MAX;
+        GSuint bestindex = 0;
+
+        for (GSuint n = 0; n < count; ++n) {
+            float distance = 0;
+            for (int c = 0; c < components; ++c) {
+                float d = palette[n][c] - block.texels[t][c];
+                distance += d * d;
+            }
+
+            if (distance < bestdistance) {
+                bestdistance = distance;
+                bestindex = n;
+            }
+        }
+
+        indices[t] = bestindex;
+        error += bestdistance;
+    }
+#endif
+
+    return error;
+}
+
+static inline GSuint pack_565(const float *color)
+{
+    GSuint r = GSuint(clamp_component(color[0]) * (31.0f / 255.0f) + 0.5f);
+    GSuint g = GSuint(clamp_component(color[1]) * (63.0f / 255.0f) + 0.5f);
+    GSuint b = GSuint(clamp_component(color[2]) * (31.0f / 255.0f) + 0.5f);
+    return (r << 11) | (g << 5) | b;
+}
+
+static inline void unpack_565(GSuint color, float *result)
+{
+    GSuint r = (color >> 11) & 31;
+    GSuint g = (color >> 5) & 63;
+    GSuint b = color & 31;
+    result[0] = float((r << 3) | (r >> 2));
+    result[1] = float((g << 2) | (g >> 4));
+    result[2] = float((b << 3) | (b >> 2));
+    result[3] = 255.0f;
+}
+
+static float bc1_indices(const TexelBlock &block, GSuint c0, GSuint c1, bool transparent, GSuint *indices)
+{
+    float palette[4][4];
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+
+    for (int c = 0; c < 4; ++c) {
+        if (transparent) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) * 0.5f;
+            palette[3][c] = BC_EXCLUDED;
+        } else {
+            palette[2][c] = (palette[0][c] * 2 + palette[1][c]) * (1.0f / 3.0f);
+            palette[3][c] = (palette[0][c] + palette[1][c] * 2) * (1.0f / 3.0f);
+        }
+    }
+
+    float error = nearest_indices(block, palette, 4, 3, indices);
+
+    if (transparent) {
+        for (int t = 0; t < 16; ++t) {
+            if (block.texels[t][3] < BC1_ALPHA_THRESHOLD) {
+                indices[t] = 3;
+            }
+        }
+    }
+
+    return error;
+}
+
+// least squares endpoints for given 4 color mode indices
+static bool bc1_refine(const TexelBlock &block, const GSuint *indices, float *e0, float *e1)
+{
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    float aa = 0, ab = 0, bb = 0;
+    float ax[3] = { 0, 0, 0 };
+    float bx[3] = { 0, 0, 0 };
+
+    for (int t = 0; t < 16; ++t) {
+        float a = weights[indices[t]];
+        float b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += a * block.texels[t][c];
+            bx[c] += b * block.texels[t][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) < 1e-6f) {
+        return false;
+    }
+
+    float inverse = 1.0f / determinant;
+    for (int c = 0; c < 3; ++c) {
+        e0[c] = clamp_component((ax[c] * bb - bx[c] * ab) * inverse);
+        e1[c] = clamp_component((bx[c] * aa - ax[c] * ab) * inverse);
+    }
+
+    return true;
+}
+
+static void encode_bc1(const TexelBlock &block, bool transparency, unsigned char *output)
+{
+    bool transparent = false;
+    if (transparency) {
+        for (int t = 0; t < 16; ++t) {
+            if (block.texels[t][3] < BC1_ALPHA_THRESHOLD) {
+                transparent = true;
+                break;
+            }
+        }
+    }
+
+    float e0[4], e1[4];
+    fit_endpoints(block, 3, transparent, e0, e1);
+
+    GSuint c0 = pack_565(e0);
+    GSuint c1 = pack_565(e1);
+    GSuint indices[16] = {};
+
+    if (transparent) {
+        // c0 <= c1 selects 3 color mode with transparent black
+        if (c0 > c1) {
+            GSuint swap = c0; c0 = c1; c1 = swap;
+        }
+        bc1_indices(block, c0, c1, true, indices);
+    } else {
+        // c0 > c1 selects 4 color mode, equal endpoints give solid block
+        if (c0 < c1) {
+            GSuint swap = c0; c0 = c1; c1 = swap;
+        }
+
+        if (c0 != c1) {
+            float error = bc1_indices(block, c0, c1, false, indices);
+
+            float r0[4], r1[4];
+            if (bc1_refine(block, indices, r0, r1)) {
+                GSuint rc0 = pack_565(r0);
+                GSuint rc1 = pack_565(r1);
+                if (rc0 < rc1) {
+                    GSuint swap = rc0; rc0 = rc1; rc1 = swap;
+                }
+
+                if (rc0 != rc1) {
+                    GSuint refined[16];
+                    if (bc1_indices(block, rc0, rc1, false, refined) < error) {
+                        c0 = rc0;
+                        c1 = rc1;
+                        memcpy(indices, refined, sizeof(indices));
+                    }
+                }
+            }
+        }
+    }
+
+    GSuint bits = 0;
+    for (int t = 0; t < 16; ++t) {
+        bits |= indices[t] << (t * 2);
+    }
+
+    output[0] = (unsigned char)(c0);
+    output[1] = (unsigned char)(c0 >> 8);
+    output[2] = (unsigned char)(c1);
+    output[3] = (unsigned char)(c1 >> 8);
+    output[4] = (unsigned char)(bits);
+    output[5] = (unsigned char)(bits >> 8);
+    output[6] = (unsigned char)(bits >> 16);
+    output[7] = (unsigned char)(bits >> 24);
+}
+
+// single component block, always uses 8 value mode (r0 > r1)
+static void encode_bc4(const TexelBlock &block, int component, unsigned char *output)
+{
+    GSuint minvalue = 255;
+    GSuint maxvalue = 0;
+    GSuint values[16];
+
+    for (int t = 0; t < 16; ++t) {
+        values[t] = GSuint(block.texels[t][component]);
+        minvalue = values[t] < minvalue ? values[t] : minvalue;
+        maxvalue = values[t] > maxvalue ? values[t] : maxvalue;
+    }
+
+    output[0] = (unsigned char)(maxvalue);
+    output[1] = (unsigned char)(minvalue);
+
+    GSuint64 bits = 0;
+    GSuint range = maxvalue - minvalue;
+
+    if (range > 0) {
+        for (int t = 0; t < 16; ++t) {
+            // palette is evenly spaced, so nearest entry is rounded position
+            // between min (position 0) and max (position 7)
+            GSuint position = ((values[t] - minvalue) * 7 + range / 2) / range;
+
+            GSuint64 index = position == 7 ? 0 : (position == 0 ? 1 : 8 - position);
+            bits |= index << (t * 3);
+        }
+    }
+
+    for (int n = 0; n < 6; ++n) {
+        output[n + 2] = (unsigned char)(bits >> (n * 8));
+    }
+}
+
+// 7-bit endpoint with shared p-bit, p-bit is selected for lower error
+static void bc7_quantize(const float *endpoint, GSuint *quantized, GSuint &pbit)
+{
+    float besterror = FLT_MAX;
+
+    for (GSuint p = 0; p < 2; ++p) {
+        GSuint q[4];
+        float error = 0;
+        for (int c = 0; c < 4; ++c) {
+            int value = int(floorf((endpoint[c] - p) * 0.5f + 0.5f));
+            q[c] = GSuint(value < 0 ? 0 : (value > 127 ? 127 : value));
+            float d = float(q[c] * 2 + p) - endpoint[c];
+            error += d * d;
+        }
+
+        if (error < besterror) {
+            besterror = error;
+            pbit = p;
+            memcpy(quantized, q, sizeof(q));
+        }
+    }
+}
+
+// mode 6: single subset, RGBA 7.7.7.7 endpoints with p-bits, 4-bit indices
+static void encode_bc7(const TexelBlock &block, unsigned char *output)
+{
+    float e0[4], e1[4];
+    fit_endpoints(block, 4, false, e0, e1);
+
+    GSuint q0[4], q1[4];
+    GSuint p0, p1;
+    bc7_quantize(e0, q0, p0);
+    bc7_quantize(e1, q1, p1);
+
+    float palette[16][4];
+    for (int n = 0; n < 16; ++n) {
+        for (int c = 0; c < 4; ++c) {
+            GSuint a = q0[c] * 2 + p0;
+            GSuint b = q1[c] * 2 + p1;
+            palette[n][c] = float(((64 - BC7_WEIGHTS[n]) * a + BC7_WEIGHTS[n] * b + 32) >> 6);
+        }
+    }
+
+    GSuint indices[16];
+    nearest_indices(block, palette, 16, 4, indices);
+
+    // most significant bit of first index is implicit zero,
+    // swap endpoints and invert indices if it's set
+    if (indices[0] & 8) {
+        for (int c = 0; c < 4; ++c) {
+            GSuint swap = q0[c]; q0[c] = q1[c]; q1[c] = swap;
+        }
+        GSuint swap = p0; p0 = p1; p1 = swap;
+
+        for (int t = 0; t < 16; ++t) {
+            indices[t] = 15 - indices[t];
+        }
+    }
+
+    memset(output, 0, 16);
+    BlockBitWriter writer = { output, 0 };
+
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(q0[c], 7);
+        writer.write(q1[c], 7);
+    }
+    writer.write(p0, 1);
+    writer.write(p1, 1);
+
+    writer.write(indices[0], 3);
+    for (int t = 1; t < 16; ++t) {
+        writer.write(indices[t], 4);
+    }
+}
+
+static void compress_block(GSenum format, const TexelBlock &block, unsigned char *output)
+{
+    switch (format) {
+        case GS_COLOR_BC1:
+        case GS_COLOR_S_BC1:
+            encode_bc1(block, true, output);
+            break;
+
+        case GS_COLOR_BC3:
+        case GS_COLOR_S_BC3:
+            encode_bc4(block, 3, output);
+            encode_bc1(block, false, output + 8);
+            break;
+
+        case GS_COLOR_BC4:
+            encode_bc4(block, 0, output);
+            break;
+
+        case GS_COLOR_BC5:
+            encode_bc4(block, 0, output);
+            encode_bc4(block, 1, output + 8);
+            break;
+
+        case GS_COLOR_BC7:
+        case GS_COLOR_S_BC7:
+            encode_bc7(block, output);
+            break;
+    }
+}
+
+static void compress_rows(const CompressImage &image, GSuint first, GSuint last)
+{
+    GSuint blocks = (image.width + 3) / 4;
+
+    for (GSuint by = first; by < last; ++by) {
+        unsigned char *output = image.destination + by * image.destinationpitch;
+
+        for (GSuint bx = 0; bx < blocks; ++bx, output += image.blocksize) {
+            TexelBlock block;
+            fetch_block(image, bx, by, block);
+            compress_block(image.format, block, output);
+        }
+    }
+}
+
+
+void xGS::image_compress(
+    GSenum format, GSuint width, GSuint height,
+    const void *source, GSuint sourcepitch,
+    GSptr destination, GSuint destinationpitch,
+    GSuint threads, WorkerPool &workers
+)
+{
+    CompressImage image = {
+        format, width, height,
+        reinterpret_cast<const unsigned char*>(source), sourcepitch,
+        reinterpret_cast<unsigned char*>(destination), destinationpitch,
+        texture_block_size(format)
+    };
+
+    GSuint rows = (height + 3) / 4;
+
+    // split block rows between threads
+    GSuint maxthreads = rows / COMPRESS_THREAD_ROWS;
+    if (threads > maxthreads) {
+        threads = maxthreads;
+    }
+
+    if (threads <= 1) {
+        compress_rows(image, 0, rows);
+        return;
+    }
+
+    GSuint batch = (rows + threads - 1) / threads;
+    GSuint batches = (rows + batch - 1) / batch;
+
+    workers.run(batches, [&image, batch, rows](GSuint index) {
+        GSuint first = index * batch;
+        GSuint last = first + batch < rows ? first + batch : rows;
+        compress_rows(image, first, last);
+    });
+}
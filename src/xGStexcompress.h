@@ -0,0 +1,37 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStexcompress.h
+        Texture block compression functions
+            encodes RGBA8 images into BC1/BC3/BC4/BC5/BC7 blocks,
+            block rows could be split between several threads
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include "xGSworkers.h"
+
+
+namespace xGS
+{
+
+    // compresses GS_COLOR_RGBA image (B, G, R, A bytes per texel) into
+    // blocks of given block compressed format
+    //      BC1 uses 3 color mode with transparent texels for blocks with alpha below 128
+    //      BC4 and BC5 take R and RG components of source
+    //      BC7 blocks are encoded with mode 6 (single subset RGBA, 4-bit indices)
+    void image_compress(
+        GSenum format, GSuint width, GSuint height,
+        const void *source, GSuint sourcepitch,
+        GSptr destination, GSuint destinationpitch,
+        GSuint threads, WorkerPool &workers
+    );
+
+} // namespace xGS
@@ -0,0 +1,597 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStextureloader.cpp
+        Texture container loading functions
+*/
+
+#include "xGStextureloader.h"
+#include "xGSutil.h"
+#include <cstring>
+
+#ifdef WIN32
+    #include <Windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+using namespace xGS;
+
+
+// container format code to texture format mapping
+struct ContainerFormat
+{
+    GSuint code;
+    GSenum format;
+    GSuint bpp;
+    bool   swizzle;
+};
+
+static const GSuint DDS_MAGIC             = 0x20534444; // "DDS "
+static const GSuint DDS_HEADER_SIZE       = 124;
+static const GSuint DDS_HEADER_DX10_SIZE  = 20;
+
+static const GSuint DDSD_MIPMAPCOUNT      = 0x20000;
+static const GSuint DDPF_ALPHAPIXELS      = 0x1;
+static const GSuint DDPF_FOURCC           = 0x4;
+static const GSuint DDPF_RGB              = 0x40;
+static const GSuint DDPF_LUMINANCE        = 0x20000;
+static const GSuint DDSCAPS2_CUBEMAP      = 0x200;
+static const GSuint DDSCAPS2_CUBEMAP_ALL  = 0xFC00;
+static const GSuint DDSCAPS2_VOLUME       = 0x200000;
+static const GSuint DDS_DIMENSION_1D      = 2;
+static const GSuint DDS_DIMENSION_3D      = 4;
+static const GSuint DDS_MISC_TEXTURECUBE  = 0x4;
+
+static const unsigned char KTX2_IDENTIFIER[12] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+static const GSuint KTX2_HEADER_SIZE      = 80;
+static const GSuint KTX2_LEVEL_SIZE       = 24;
+
+// images are locked with 32-bit size
+static const GSuint64 MAX_IMAGE_SIZE      = 0xFFFFFFFF;
+
+#define GS_FOURCC(a, b, c, d) (GSuint(a) | (GSuint(b) << 8) | (GSuint(c) << 16) | (GSuint(d) << 24))
+
+// legacy DDS FourCC codes, including D3DFMT float formats
+static const ContainerFormat DDS_FOURCC_FORMATS[] = {
+    { GS_FOURCC('D', 'X', 'T', '1'), GS_COLOR_BC1,            0,  false },
+    { GS_FOURCC('D', 'X', 'T', '5'), GS_COLOR_BC3,            0,  false },
+    { GS_FOURCC('A', 'T', 'I', '1'), GS_COLOR_BC4,            0,  false },
+    { GS_FOURCC('B', 'C', '4', 'U'), GS_COLOR_BC4,            0,  false },
+    { GS_FOURCC('A', 'T', 'I', '2'), GS_COLOR_BC5,            0,  false },
+    { GS_FOURCC('B', 'C', '5', 'U'), GS_COLOR_BC5,            0,  false },
+    { 111,                           GS_COLOR_R_HALFFLOAT,    2,  false },
+    { 112,                           GS_COLOR_RG_HALFFLOAT,   4,  false },
+    { 113,                           GS_COLOR_RGBA_HALFFLOAT, 8,  false },
+    { 114,                           GS_COLOR_R_FLOAT,        4,  false },
+    { 115,                           GS_COLOR_RG_FLOAT,       8,  false },
+    { 116,                           GS_COLOR_RGBA_FLOAT,     16, false }
+};
+
+static const GSuint DDS_FOURCC_DX10 = GS_FOURCC('D', 'X', '1', '0');
+
+#undef GS_FOURCC
+
+// DXGI_FORMAT codes of DX10 DDS header
+static const ContainerFormat DDS_DXGI_FORMATS[] = {
+    { 2,  GS_COLOR_RGBA_FLOAT,     16, false },
+    { 10, GS_COLOR_RGBA_HALFFLOAT, 8,  false },
+    { 16, GS_COLOR_RG_FLOAT,       8,  false },
+    { 28, GS_COLOR_RGBA,           4,  true  },
+    { 29, GS_COLOR_S_RGBA,         4,  true  },
+    { 34, GS_COLOR_RG_HALFFLOAT,   4,  false },
+    { 41, GS_COLOR_R_FLOAT,        4,  false },
+    { 49, GS_COLOR_RG,             2,  false },
+    { 54, GS_COLOR_R_HALFFLOAT,    2,  false },
+    { 61, GS_COLOR_R,              1,  false },
+    { 71, GS_COLOR_BC1,            0,  false },
+    { 72, GS_COLOR_S_BC1,          0,  false },
+    { 77, GS_COLOR_BC3,            0,  false },
+    { 78, GS_COLOR_S_BC3,          0,  false },
+    { 80, GS_COLOR_BC4,            0,  false },
+    { 83, GS_COLOR_BC5,            0,  false },
+    { 87, GS_COLOR_RGBA,           4,  false },
+    { 88, GS_COLOR_RGBX,           4,  false },
+    { 91, GS_COLOR_S_RGBA,         4,  false },
+    { 93, GS_COLOR_S_RGBX,         4,  false },
+    { 98, GS_COLOR_BC7,            0,  false },
+    { 99, GS_COLOR_S_BC7,          0,  false }
+};
+
+// VkFormat codes of KTX2 header
+static const ContainerFormat KTX2_VK_FORMATS[] = {
+    { 9,   GS_COLOR_R,              1,  false },
+    { 16,  GS_COLOR_RG,             2,  false },
+    { 37,  GS_COLOR_RGBA,           4,  true  },
+    { 43,  GS_COLOR_S_RGBA,         4,  true  },
+    { 44,  GS_COLOR_RGBA,           4,  false },
+    { 50,  GS_COLOR_S_RGBA,         4,  false },
+    { 76,  GS_COLOR_R_HALFFLOAT,    2,  false },
+    { 83,  GS_COLOR_RG_HALFFLOAT,   4,  false },
+    { 97,  GS_COLOR_RGBA_HALFFLOAT, 8,  false },
+    { 100, GS_COLOR_R_FLOAT,        4,  false },
+    { 103, GS_COLOR_RG_FLOAT,       8,  false },
+    { 109, GS_COLOR_RGBA_FLOAT,     16, false },
+    { 131, GS_COLOR_BC1,            0,  false },
+    { 132, GS_COLOR_S_BC1,          0,  false },
+    { 133, GS_COLOR_BC1,            0,  false },
+    { 134, GS_COLOR_S_BC1,          0,  false },
+    { 137, GS_COLOR_BC3,            0,  false },
+    { 138, GS_COLOR_S_BC3,          0,  false },
+    { 139, GS_COLOR_BC4,            0,  false },
+    { 141, GS_COLOR_BC5,            0,  false },
+    { 145, GS_COLOR_BC7,            0,  false },
+    { 146, GS_COLOR_S_BC7,          0,  false }
+};
+
+
+template <size_t N>
+static inline const ContainerFormat* find_container_format(const ContainerFormat (&formats)[N], GSuint code)
+{
+    for (size_t n = 0; n < N; ++n) {
+        if (formats[n].code == code) {
+            return formats + n;
+        }
+    }
+    return nullptr;
+}
+
+static inline GSuint read_u32(const unsigned char *data)
+{
+    GSuint result;
+    memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+static inline GSuint64 read_u64(const unsigned char *data)
+{
+    GSuint64 result;
+    memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+static inline GSuint level_dimension(GSuint size, GSuint level)
+{
+    size >>= level;
+    return size ? size : 1;
+}
+
+// dimensions are limited by container_supported, so row size fits 32 bits,
+// but whole image could be larger
+static GSuint64 container_image_size(const TextureContainer &container, GSuint level)
+{
+    const GStexturedescription &desc = container.description;
+
+    GSuint width = level_dimension(desc.width, level);
+    GSuint height = desc.type == GS_TEXTYPE_1D ? 1 : level_dimension(desc.height, level);
+    GSuint depth = desc.type == GS_TEXTYPE_3D ? level_dimension(desc.depth, level) : 1;
+
+    return
+        GSuint64(texture_image_pitch(desc.format, container.bpp, width)) *
+        texture_image_rows(desc.format, height) * depth;
+}
+
+// sums image sizes of complete MIP chain, fails if any image doesn't fit lock size
+static bool container_chain_size(const TextureContainer &container, GSuint64 &chainsize)
+{
+    chainsize = 0;
+    for (GSuint level = 0; level < container.levels; ++level) {
+        GSuint64 imagesize = container_image_size(container, level);
+        if (imagesize > MAX_IMAGE_SIZE) {
+            return false;
+        }
+        chainsize += imagesize;
+    }
+    return true;
+}
+
+static void container_setup(TextureContainer &container, GSuint width, GSuint height, GSuint depth, const ContainerFormat &format)
+{
+    GStexturedescription &desc = container.description;
+
+    desc = GStexturedescription::construct();
+    desc.format = format.format;
+    desc.width = width;
+    desc.height = height;
+    desc.depth = depth;
+    desc.layers = container.layers > 1 ? container.layers : 0;
+    desc.minlevel = 0;
+    desc.maxlevel = container.levels - 1;
+
+    if (container.faces == 6) {
+        desc.type = GS_TEXTYPE_CUBEMAP;
+    } else if (depth > 1) {
+        desc.type = GS_TEXTYPE_3D;
+    } else if (height == 0) {
+        desc.type = GS_TEXTYPE_1D;
+        desc.height = 1;
+    } else {
+        desc.type = GS_TEXTYPE_2D;
+    }
+
+    container.bpp = format.bpp;
+    container.swizzle = format.swizzle;
+}
+
+// only layouts which textures could be created with are accepted
+static bool container_supported(const TextureContainer &container, const TextureLimits &limits)
+{
+    const GStexturedescription &desc = container.description;
+
+    if (desc.width == 0 || desc.height == 0 || container.levels > TextureContainer::MAX_LEVELS) {
+        return false;
+    }
+
+    // 1D and cubemap arrays are not supported by textures
+    if (desc.layers && desc.type != GS_TEXTYPE_2D) {
+        return false;
+    }
+
+    GSuint maxsize =
+        desc.type == GS_TEXTYPE_3D ? limits.size3d :
+        desc.type == GS_TEXTYPE_CUBEMAP ? limits.cubemapsize : limits.size;
+
+    if (desc.width > maxsize || desc.height > maxsize || desc.depth > maxsize || desc.layers > limits.layers) {
+        return false;
+    }
+
+    // levels below 1x1x1 image are invalid
+    GSuint largest = desc.width > desc.height ? desc.width : desc.height;
+    if (desc.depth > largest) {
+        largest = desc.depth;
+    }
+
+    GSuint chainlevels = 1;
+    while (largest >>= 1) {
+        ++chainlevels;
+    }
+
+    if (container.levels > chainlevels) {
+        return false;
+    }
+
+    return texture_block_size(desc.format) == 0 || desc.type == GS_TEXTYPE_2D || desc.type == GS_TEXTYPE_CUBEMAP;
+}
+
+static bool parse_dds(const unsigned char *data, size_t size, const TextureLimits &limits, TextureContainer &container)
+{
+    if (size < 4 + DDS_HEADER_SIZE || read_u32(data) != DDS_MAGIC) {
+        return false;
+    }
+
+    const unsigned char *header = data + 4;
+    if (read_u32(header) != DDS_HEADER_SIZE) {
+        return false;
+    }
+
+    GSuint flags = read_u32(header + 4);
+    GSuint height = read_u32(header + 8);
+    GSuint width = read_u32(header + 12);
+    GSuint depth = read_u32(header + 20);
+    GSuint mipcount = read_u32(header + 24);
+    GSuint pfflags = read_u32(header + 76);
+    GSuint fourcc = read_u32(header + 80);
+    GSuint bitcount = read_u32(header + 84);
+    GSuint rmask = read_u32(header + 88);
+    GSuint gmask = read_u32(header + 92);
+    GSuint bmask = read_u32(header + 96);
+    GSuint amask = read_u32(header + 100);
+    GSuint caps2 = read_u32(header + 108);
+
+    container.type = TextureContainer::DDS;
+    container.levels = (flags & DDSD_MIPMAPCOUNT) && mipcount ? mipcount : 1;
+    container.layers = 1;
+    container.faces = 1;
+    container.data = header + DDS_HEADER_SIZE;
+
+    if (!(caps2 & DDSCAPS2_VOLUME)) {
+        depth = 1;
+    }
+
+    if (caps2 & DDSCAPS2_CUBEMAP) {
+        // partial cubemaps are not supported
+        if ((caps2 & DDSCAPS2_CUBEMAP_ALL) != DDSCAPS2_CUBEMAP_ALL) {
+            return false;
+        }
+        container.faces = 6;
+    }
+
+    ContainerFormat legacy = { 0, GS_NONE, 0, false };
+    const ContainerFormat *format = nullptr;
+
+    if ((pfflags & DDPF_FOURCC) && fourcc == DDS_FOURCC_DX10) {
+        if (size < 4 + DDS_HEADER_SIZE + DDS_HEADER_DX10_SIZE) {
+            return false;
+        }
+
+        const unsigned char *dx10 = container.data;
+        format = find_container_format(DDS_DXGI_FORMATS, read_u32(dx10));
+
+        GSuint dimension = read_u32(dx10 + 4);
+        GSuint misc = read_u32(dx10 + 8);
+        GSuint arraysize = read_u32(dx10 + 12);
+
+        if (dimension == DDS_DIMENSION_1D) {
+            height = 0;
+        }
+        if (dimension != DDS_DIMENSION_3D) {
+            depth = 1;
+        }
+
+        container.faces = (misc & DDS_MISC_TEXTURECUBE) ? 6 : 1;
+        container.layers = arraysize ? arraysize : 1;
+        container.data += DDS_HEADER_DX10_SIZE;
+    } else if (pfflags & DDPF_FOURCC) {
+        format = find_container_format(DDS_FOURCC_FORMATS, fourcc);
+    } else if ((pfflags & DDPF_RGB) && bitcount == 32 && gmask == 0x0000FF00) {
+        // 8 bit per component formats, either BGRA or RGBA byte order
+        bool alpha = (pfflags & DDPF_ALPHAPIXELS) && amask == 0xFF000000;
+        if (rmask == 0x00FF0000 && bmask == 0x000000FF) {
+            legacy.format = alpha ? GS_COLOR_RGBA : GS_COLOR_RGBX;
+        } else if (rmask == 0x000000FF && bmask == 0x00FF0000) {
+            legacy.format = alpha ? GS_COLOR_RGBA : GS_COLOR_RGBX;
+            legacy.swizzle = true;
+        }
+        legacy.bpp = 4;
+        format = legacy.format ? &legacy : nullptr;
+    } else if ((pfflags & DDPF_LUMINANCE) && bitcount == 8) {
+        legacy.format = GS_COLOR_R;
+        legacy.bpp = 1;
+        format = &legacy;
+    }
+
+    if (!format) {
+        return false;
+    }
+
+    container_setup(container, width, height, depth, *format);
+    if (!container_supported(container, limits)) {
+        return false;
+    }
+
+    // every layer and face holds complete MIP chain
+    GSuint64 chainsize;
+    if (!container_chain_size(container, chainsize)) {
+        return false;
+    }
+
+    GSuint64 available = size - size_t(container.data - data);
+    GSuint64 elements = GSuint64(container.layers) * container.faces;
+    return chainsize <= available / elements;
+}
+
+static bool parse_ktx2(const unsigned char *data, size_t size, const TextureLimits &limits, TextureContainer &container)
+{
+    if (size < KTX2_HEADER_SIZE || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        return false;
+    }
+
+    GSuint vkformat = read_u32(data + 12);
+    GSuint width = read_u32(data + 20);
+    GSuint height = read_u32(data + 24);
+    GSuint depth = read_u32(data + 28);
+    GSuint layers = read_u32(data + 32);
+    GSuint faces = read_u32(data + 36);
+    GSuint levels = read_u32(data + 40);
+    GSuint supercompression = read_u32(data + 44);
+
+    // supercompressed data can't be uploaded in place
+    if (supercompression != 0 || (faces != 1 && faces != 6)) {
+        return false;
+    }
+
+    const ContainerFormat *format = find_container_format(KTX2_VK_FORMATS, vkformat);
+    if (!format) {
+        return false;
+    }
+
+    container.type = TextureContainer::KTX2;
+    container.levels = levels ? levels : 1;
+    container.layers = layers ? layers : 1;
+    container.faces = faces;
+    container.data = data;
+
+    container_setup(container, width, height, depth ? depth : 1, *format);
+    if (!container_supported(container, limits)) {
+        return false;
+    }
+
+    if (size < KTX2_HEADER_SIZE + size_t(container.levels) * KTX2_LEVEL_SIZE) {
+        return false;
+    }
+
+    // level index starts with base level, every level holds all layers,
+    // faces and depth slices of that level
+    const unsigned char *index = data + KTX2_HEADER_SIZE;
+    for (GSuint level = 0; level < container.levels; ++level, index += KTX2_LEVEL_SIZE) {
+        GSuint64 offset = read_u64(index);
+        GSuint64 length = read_u64(index + 8);
+        GSuint64 imagesize = container_image_size(container, level);
+        if (imagesize > MAX_IMAGE_SIZE) {
+            return false;
+        }
+
+        // layer count is limited, so required size can't overflow
+        GSuint64 required = imagesize * container.layers * container.faces;
+
+        if (length < required || offset > size || length > size - offset) {
+            return false;
+        }
+
+        container.offsets[level] = size_t(offset);
+    }
+
+    return true;
+}
+
+
+FileMapping::FileMapping() :
+    p_data(nullptr),
+    p_size(0)
+#ifdef WIN32
+    ,
+    p_file(INVALID_HANDLE_VALUE),
+    p_mapping(nullptr)
+#endif
+{}
+
+FileMapping::~FileMapping()
+{
+    close();
+}
+
+bool FileMapping::open(const char *filename)
+{
+    close();
+
+#ifdef WIN32
+    p_file = CreateFileA(
+        filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+    );
+    if (p_file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER filesize;
+    if (!GetFileSizeEx(p_file, &filesize) || filesize.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    p_mapping = CreateFileMappingA(p_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!p_mapping) {
+        close();
+        return false;
+    }
+
+    p_data = reinterpret_cast<const unsigned char*>(MapViewOfFile(p_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!p_data) {
+        close();
+        return false;
+    }
+
+    p_size = size_t(filesize.QuadPart);
+#else
+    int file = ::open(filename, O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat filestat;
+    if (fstat(file, &filestat) != 0 || filestat.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    // mapping stays valid after file descriptor is closed
+    void *mapping = mmap(nullptr, size_t(filestat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    // images are read once in order
+    madvise(mapping, size_t(filestat.st_size), MADV_SEQUENTIAL);
+
+    p_data = reinterpret_cast<const unsigned char*>(mapping);
+    p_size = size_t(filestat.st_size);
+#endif
+
+    return true;
+}
+
+void FileMapping::close()
+{
+#ifdef WIN32
+    if (p_data) {
+        UnmapViewOfFile(p_data);
+    }
+    if (p_mapping) {
+        CloseHandle(p_mapping);
+        p_mapping = nullptr;
+    }
+    if (p_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(p_file);
+        p_file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (p_data) {
+        munmap(const_cast<unsigned char*>(p_data), p_size);
+    }
+#endif
+
+    p_data = nullptr;
+    p_size = 0;
+}
+
+
+bool xGS::texture_container_parse(const unsigned char *data, size_t size, const TextureLimits &limits, TextureContainer &container)
+{
+    return parse_dds(data, size, limits, container) || parse_ktx2(data, size, limits, container);
+}
+
+const unsigned char* xGS::texture_container_image(const TextureContainer &container, GSuint level, GSuint layer, GSuint face, GSuint &size)
+{
+    // image sizes are checked to fit 32 bits while parsing
+    size = GSuint(container_image_size(container, level));
+    GSuint element = layer * container.faces + face;
+
+    if (container.type == TextureContainer::KTX2) {
+        return container.data + container.offsets[level] + size_t(element) * size;
+    }
+
+    // DDS stores complete MIP chain of every element one after another
+    size_t chainsize = 0;
+    size_t leveloffset = 0;
+    for (GSuint n = 0; n < container.levels; ++n) {
+        size_t levelsize = size_t(container_image_size(container, n));
+        if (n < level) {
+            leveloffset += levelsize;
+        }
+        chainsize += levelsize;
+    }
+
+    return container.data + chainsize * element + leveloffset;
+}
+
+GSenum xGS::texture_container_locktype(const TextureContainer &container, GSuint face)
+{
+    static const GSenum cubemapfaces[6] = {
+        GS_LOCK_CUBEMAPPX, GS_LOCK_CUBEMAPNX,
+        GS_LOCK_CUBEMAPPY, GS_LOCK_CUBEMAPNY,
+        GS_LOCK_CUBEMAPPZ, GS_LOCK_CUBEMAPNZ
+    };
+
+    return container.faces == 6 ? cubemapfaces[face] : GS_LOCK_TEXTURE;
+}
+
+void xGS::texture_image_copy(GSptr destination, const unsigned char *source, GSuint size, bool swizzle)
+{
+    if (!swizzle) {
+        memcpy(destination, source, size);
+        return;
+    }
+
+    // RGBA to BGRA byte order
+    unsigned char *dest = reinterpret_cast<unsigned char*>(destination);
+    for (GSuint n = 0; n < size; n += 4) {
+        dest[n + 0] = source[n + 2];
+        dest[n + 1] = source[n + 1];
+        dest[n + 2] = source[n + 0];
+        dest[n + 3] = source[n + 3];
+    }
+}
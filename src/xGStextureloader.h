@@ -0,0 +1,104 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStextureloader.h
+        Texture container loading functions
+            KTX2 and DDS files are memory mapped and parsed in place,
+            image data is referenced directly from file mapping
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include <cstddef>
+
+
+namespace xGS
+{
+
+    // read only memory mapped file
+    class FileMapping
+    {
+    public:
+        FileMapping();
+        ~FileMapping();
+
+        bool open(const char *filename);
+        void close();
+
+        const unsigned char* data() const { return p_data; }
+        size_t size() const { return p_size; }
+
+    private:
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+
+    private:
+        const unsigned char *p_data;
+        size_t               p_size;
+#ifdef WIN32
+        void                *p_file;
+        void                *p_mapping;
+#endif
+    };
+
+
+    // texture images stored in container file
+    struct TextureContainer
+    {
+        enum Type
+        {
+            DDS,
+            KTX2
+        };
+
+        enum
+        {
+            MAX_LEVELS = 32
+        };
+
+        Type                 type;
+        GStexturedescription description; // description of texture to hold all images
+        GSuint               levels;      // number of stored MIP levels
+        GSuint               layers;      // number of stored array layers, at least 1
+        GSuint               faces;       // 6 for cubemaps, 1 otherwise
+        GSuint               bpp;         // bytes per texel, 0 for block compressed formats
+        bool                 swizzle;     // R and B should be swapped to get BGRA texel layout
+        const unsigned char *data;        // first image data
+        size_t               offsets[MAX_LEVELS]; // KTX2: level data offsets relative to data
+    };
+
+    // renderer texture limits, containers exceeding them are rejected
+    struct TextureLimits
+    {
+        GSuint size;        // max width and height of 1D, 2D and 2D array textures
+        GSuint size3d;      // max dimension of 3D textures
+        GSuint cubemapsize; // max cubemap face size
+        GSuint layers;      // max number of array layers
+    };
+
+    // parses container header, supported container formats are:
+    //      DDS  - legacy and DX10 headers, 2D, 3D, cubemap and 2D array textures
+    //      KTX2 - without supercompression, 2D, 3D, cubemap and 2D array textures
+    //      images could be uncompressed or BC1/BC3/BC4/BC5/BC7 compressed
+    //      texture dimensions are checked against limits before image data size,
+    //      every image should fit 32-bit lock size
+    bool texture_container_parse(const unsigned char *data, size_t size, const TextureLimits &limits, TextureContainer &container);
+
+    // returns image data of given MIP level, array layer and cubemap face,
+    // image layout is the same as texture lock layout
+    const unsigned char* texture_container_image(const TextureContainer &container, GSuint level, GSuint layer, GSuint face, GSuint &size);
+
+    // returns texture lock type for given face, faces follow container order +X, -X, +Y, -Y, +Z, -Z
+    GSenum texture_container_locktype(const TextureContainer &container, GSuint face);
+
+    // copies image into locked texture memory
+    void texture_image_copy(GSptr destination, const unsigned char *source, GSuint size, bool swizzle);
+
+} // namespace xGS
@@ -0,0 +1,272 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStexturepaging.cpp
+        Virtual texture page manager
+*/
+
+#include "xGStexturepaging.h"
+#include "xGStexture.h"
+#include "kcommon/c_util.h"
+#include <algorithm>
+
+
+using namespace xGS;
+using namespace c_util;
+
+
+static inline GSuint page_level(GSuint page)
+{
+    return page >> GS_TEXPAGE_LEVEL_SHIFT;
+}
+
+static inline GSuint page_x(GSuint page)
+{
+    return page & GS_TEXPAGE_COORD_MASK;
+}
+
+static inline GSuint page_y(GSuint page)
+{
+    return (page >> GS_TEXPAGE_Y_SHIFT) & GS_TEXPAGE_COORD_MASK;
+}
+
+static inline GSuint page_level_size(GSuint size, GSuint level)
+{
+    return umax(size >> level, 1u);
+}
+
+static inline GSuint page_count(GSuint size, GSuint pagesize)
+{
+    return (size + pagesize - 1) / pagesize;
+}
+
+static GSuint paged_texture_levels(const xGSTextureImpl *texture)
+{
+    GSuint levels = 1;
+    GSuint size = umax(texture->width(), texture->height());
+    while (size > 1 && levels <= texture->maxLevel()) {
+        size >>= 1;
+        ++levels;
+    }
+    return levels;
+}
+
+
+TexturePager::TexturePager() :
+    p_textures(),
+    p_lru(),
+    p_resident(0),
+    p_frame(0)
+{
+    configure(GStexturepagingdescription::construct());
+}
+
+void TexturePager::configure(const GStexturepagingdescription &desc)
+{
+    p_budget = desc.budget;
+}
+
+GSerror TexturePager::request(xGSTextureImpl *texture, const GSuint *pages, GSuint count)
+{
+    auto found = p_textures.find(texture);
+    if (found == p_textures.end()) {
+        GSerror result = add(texture);
+        if (result != GS_OK) {
+            return result;
+        }
+        found = p_textures.find(texture);
+    }
+
+    // whole request is rejected if any page is out of texture bounds
+    GSuint levels = paged_texture_levels(texture);
+    for (GSuint n = 0; n < count; ++n) {
+        GSuint level = page_level(pages[n]);
+        if (level >= levels) {
+            return GSE_INVALIDVALUE;
+        }
+        if (level < texture->sparseLevels() && (
+            page_x(pages[n]) >= page_count(page_level_size(texture->width(), level), texture->pageWidth()) ||
+            page_y(pages[n]) >= page_count(page_level_size(texture->height(), level), texture->pageHeight())
+        )) {
+            return GSE_INVALIDVALUE;
+        }
+    }
+
+    PagedTexture &entry = found->second;
+
+    for (GSuint n = 0; n < count; ++n) {
+        // MIP tail is always resident
+        if (page_level(pages[n]) >= texture->sparseLevels()) {
+            continue;
+        }
+
+        auto page = entry.resident.find(pages[n]);
+        if (page == entry.resident.end()) {
+            entry.missing.push_back(pages[n]);
+        } else {
+            page->second->frame = p_frame;
+            p_lru.splice(p_lru.begin(), p_lru, page->second);
+        }
+    }
+
+    return GS_OK;
+}
+
+void TexturePager::remove(xGSTextureImpl *texture)
+{
+    auto found = p_textures.find(texture);
+    if (found == p_textures.end()) {
+        return;
+    }
+
+    for (auto &page : found->second.resident) {
+        p_lru.erase(page.second);
+        p_resident -= texture->pageBytes();
+    }
+    p_resident -= found->second.tailsize;
+
+    p_textures.erase(found);
+}
+
+GSuint TexturePager::update(GStexturepage *committed, GSuint capacity)
+{
+    std::vector<Page> missing;
+    for (auto &t : p_textures) {
+        std::vector<GSuint> &pages = t.second.missing;
+        std::sort(pages.begin(), pages.end());
+        pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+        for (auto page : pages) {
+            Page p = { t.first, page, p_frame };
+            missing.push_back(p);
+        }
+
+        pages.clear();
+    }
+
+    // coarse levels go first, they cover larger area and serve as fallback for finer ones
+    std::stable_sort(
+        missing.begin(), missing.end(),
+        [](const Page &a, const Page &b) {
+            return page_level(a.page) > page_level(b.page);
+        }
+    );
+
+    std::vector<Page> commits;
+    std::vector<Page> releases;
+
+    for (const auto &page : missing) {
+        if (commits.size() >= capacity) {
+            break;
+        }
+
+        GSuint64 size = page.texture->pageBytes();
+
+        // pages used by current frame are never released
+        while (p_resident + size > p_budget && !p_lru.empty() && p_lru.back().frame != p_frame) {
+            const Page &last = p_lru.back();
+            p_textures[last.texture].resident.erase(last.page);
+            p_resident -= last.texture->pageBytes();
+            releases.push_back(last);
+            p_lru.pop_back();
+        }
+
+        if (p_resident + size > p_budget) {
+            break;
+        }
+
+        p_lru.push_front(page);
+        p_textures[page.texture].resident[page.page] = p_lru.begin();
+        p_resident += size;
+
+        commits.push_back(page);
+    }
+
+    // memory is released before new pages are committed
+    commitPages(releases, GS_FALSE);
+    commitPages(commits, GS_TRUE);
+
+    for (size_t n = 0; n < commits.size(); ++n) {
+        committed[n].texture = commits[n].texture;
+        committed[n].page = commits[n].page;
+    }
+
+    ++p_frame;
+
+    return GSuint(commits.size());
+}
+
+void TexturePager::clear()
+{
+    p_textures.clear();
+    p_lru.clear();
+    p_resident = 0;
+}
+
+GSerror TexturePager::add(xGSTextureImpl *texture)
+{
+    // pages are addressed by level, x and y only, so only non array 2D textures are paged
+    if (!texture->sparse() || texture->type() != GS_TEXTYPE_2D || texture->layers() != 0) {
+        return GSE_INVALIDOBJECT;
+    }
+
+    PagedTexture &entry = p_textures[texture];
+    entry.tailsize = 0;
+
+    // MIP tail levels are committed all together, tail is counted as single page
+    if (texture->sparseLevels() < paged_texture_levels(texture)) {
+        texture->CommitLevel(texture->sparseLevels(), GS_TRUE);
+        entry.tailsize = texture->pageBytes();
+        p_resident += entry.tailsize;
+    }
+
+    return GS_OK;
+}
+
+void TexturePager::commitPages(std::vector<Page> &pages, GSbool commit)
+{
+    // page identifiers order by level, row and column, so adjacent pages of
+    // the same row follow each other and are merged into single region
+    std::sort(
+        pages.begin(), pages.end(),
+        [](const Page &a, const Page &b) {
+            return a.texture != b.texture ? a.texture < b.texture : a.page < b.page;
+        }
+    );
+
+    size_t n = 0;
+    while (n < pages.size()) {
+        xGSTextureImpl *texture = pages[n].texture;
+        GSuint first = pages[n].page;
+
+        size_t run = 1;
+        while (
+            n + run < pages.size() &&
+            pages[n + run].texture == texture &&
+            pages[n + run].page == first + run &&
+            page_x(first) + run <= GS_TEXPAGE_COORD_MASK
+        ) {
+            ++run;
+        }
+
+        GSuint level = page_level(first);
+        GSuint width = page_level_size(texture->width(), level);
+        GSuint height = page_level_size(texture->height(), level);
+
+        // regions at level edge could be smaller than page
+        GSuint x = page_x(first) * texture->pageWidth();
+        GSuint y = page_y(first) * texture->pageHeight();
+        GSuint w = umin(GSuint(run) * texture->pageWidth(), width - x);
+        GSuint h = umin(texture->pageHeight(), height - y);
+
+        texture->CommitRegion(level, x, y, 0, w, h, 1, commit);
+
+        n += run;
+    }
+}
@@ -0,0 +1,82 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStexturepaging.h
+        Virtual texture page manager
+            tracks committed pages of sparse textures, commits pages
+            requested by usage feedback and releases least recently
+            used pages under residency budget
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include <unordered_map>
+#include <vector>
+#include <list>
+
+
+namespace xGS
+{
+
+    class xGSTextureImpl;
+
+
+    // sparse textures page table manager
+    //      pages are requested during frame and committed by update, all commitment
+    //      changes of single update are merged into runs of adjacent pages, so
+    //      driver gets as few commitment calls as possible
+    class TexturePager
+    {
+    public:
+        TexturePager();
+
+        void configure(const GStexturepagingdescription &desc);
+
+        // marks pages as used by current frame, texture is added on first request
+        GSerror request(xGSTextureImpl *texture, const GSuint *pages, GSuint count);
+        void remove(xGSTextureImpl *texture);
+        bool managed(xGSTextureImpl *texture) const { return p_textures.find(texture) != p_textures.end(); }
+
+        // applies batched commitment changes, returns number of newly committed pages
+        GSuint update(GStexturepage *committed, GSuint capacity);
+
+        void clear();
+
+    private:
+        struct Page
+        {
+            xGSTextureImpl *texture;
+            GSuint          page;  // packed page identifier
+            GSuint          frame; // frame of last request
+        };
+
+        typedef std::list<Page> PageList;
+
+        struct PagedTexture
+        {
+            std::unordered_map<GSuint, PageList::iterator> resident; // committed pages
+            std::vector<GSuint>                            missing;  // requested pages to commit
+            GSuint64                                       tailsize; // committed MIP tail size
+        };
+
+        typedef std::unordered_map<xGSTextureImpl*, PagedTexture> TextureList;
+
+        GSerror add(xGSTextureImpl *texture);
+        void commitPages(std::vector<Page> &pages, GSbool commit);
+
+    private:
+        TextureList p_textures;
+        PageList    p_lru;      // resident pages, most recently used first
+        GSuint64    p_budget;   // residency budget in bytes
+        GSuint64    p_resident; // size of all committed pages
+        GSuint      p_frame;    // update counter
+    };
+
+} // namespace xGS
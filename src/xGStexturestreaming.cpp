@@ -0,0 +1,290 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStexturestreaming.cpp
+        Texture streaming manager
+*/
+
+#include "xGStexturestreaming.h"
+#include "xGStexture.h"
+#include "kcommon/c_util.h"
+#include <vector>
+#include <algorithm>
+
+
+using namespace xGS;
+using namespace c_util;
+
+
+TextureStreamer::TextureStreamer() :
+    p_textures(),
+    p_resident(0),
+    p_frame(0)
+{
+    configure(GStexturestreamingdescription::construct());
+}
+
+void TextureStreamer::configure(const GStexturestreamingdescription &desc)
+{
+    p_budget = desc.budget;
+    p_uploadlimit = desc.uploadlimit;
+    p_tailsize = desc.tailsize;
+}
+
+GSerror TextureStreamer::add(xGSTextureImpl *texture, std::unique_ptr<FileMapping> &file, const TextureContainer &container)
+{
+    // tail starts from first level which fits into tail size
+    GSuint tail = 0;
+    while (
+        tail + 1 < container.levels &&
+        ((container.description.width >> tail) > p_tailsize || (container.description.height >> tail) > p_tailsize)
+    ) {
+        ++tail;
+    }
+
+    // levels past sparse levels share single commitment, so they're kept in tail
+    if (texture->sparse()) {
+        tail = umin(tail, texture->sparseLevels());
+    }
+
+    StreamedTexture &entry = p_textures[texture];
+    entry.file = std::move(file);
+    entry.container = container;
+    entry.taillevel = tail;
+    entry.residentlevel = container.levels;
+    entry.wantedlevel = tail;
+    entry.priority = 0;
+    entry.requestframe = p_frame - 1;
+
+    for (GSuint level = container.levels; level > tail; --level) {
+        GSerror result = uploadLevel(texture, entry, level - 1);
+        if (result != GS_OK) {
+            remove(texture);
+            return result;
+        }
+    }
+
+    return GS_OK;
+}
+
+void TextureStreamer::remove(xGSTextureImpl *texture)
+{
+    auto entry = p_textures.find(texture);
+    if (entry == p_textures.end()) {
+        return;
+    }
+
+    for (GSuint level = entry->second.residentlevel; level < entry->second.container.levels; ++level) {
+        p_resident -= levelSize(entry->second, level);
+    }
+
+    p_textures.erase(entry);
+}
+
+bool TextureStreamer::request(xGSTextureImpl *texture, GSuint level, GSfloat priority)
+{
+    auto found = p_textures.find(texture);
+    if (found == p_textures.end()) {
+        return false;
+    }
+
+    StreamedTexture &entry = found->second;
+    level = umin(level, entry.taillevel);
+
+    // several requests for the same texture are merged into finest level and highest priority
+    if (requested(entry)) {
+        entry.wantedlevel = umin(entry.wantedlevel, level);
+        if (priority > entry.priority) {
+            entry.priority = priority;
+        }
+    } else {
+        entry.wantedlevel = level;
+        entry.priority = priority;
+        entry.requestframe = p_frame;
+    }
+
+    return true;
+}
+
+GSerror TextureStreamer::update()
+{
+    std::vector<TextureList::value_type*> pending;
+    for (auto &t : p_textures) {
+        if (requested(t.second) && t.second.wantedlevel < t.second.residentlevel) {
+            pending.push_back(&t);
+        }
+    }
+
+    std::stable_sort(
+        pending.begin(), pending.end(),
+        [](const TextureList::value_type *a, const TextureList::value_type *b) {
+            return a->second.priority > b->second.priority;
+        }
+    );
+
+    GSerror result = GS_OK;
+    GSuint64 uploaded = 0;
+
+    // every pass uploads single level of each pending texture, so all requested
+    // textures get sharper evenly instead of highest priority ones getting all levels first
+    bool progress = true;
+    while (progress && uploaded < p_uploadlimit && result == GS_OK) {
+        progress = false;
+
+        for (auto t : pending) {
+            StreamedTexture &entry = t->second;
+            if (entry.residentlevel <= entry.wantedlevel) {
+                continue;
+            }
+
+            GSuint level = entry.residentlevel - 1;
+            GSuint64 size = levelSize(entry, level);
+
+            // first level is uploaded regardless of the limit, so large levels still make progress
+            if (uploaded > 0 && uploaded + size > p_uploadlimit) {
+                continue;
+            }
+
+            if (p_resident + size > p_budget && !makeRoom(size, entry)) {
+                continue;
+            }
+
+            result = uploadLevel(t->first, entry, level);
+            if (result != GS_OK) {
+                break;
+            }
+
+            uploaded += size;
+            progress = true;
+        }
+    }
+
+    ++p_frame;
+
+    return result;
+}
+
+void TextureStreamer::clear()
+{
+    p_textures.clear();
+    p_resident = 0;
+}
+
+GSuint64 TextureStreamer::levelSize(const StreamedTexture &entry, GSuint level) const
+{
+    GSuint size;
+    texture_container_image(entry.container, level, 0, 0, size);
+    return GSuint64(size) * entry.container.layers * entry.container.faces;
+}
+
+GSerror TextureStreamer::uploadLevel(xGSTextureImpl *texture, StreamedTexture &entry, GSuint level)
+{
+    const TextureContainer &container = entry.container;
+
+    if (texture->sparse()) {
+        texture->CommitLevel(level, GS_TRUE);
+    }
+
+    for (GSuint layer = 0; layer < container.layers; ++layer) {
+        for (GSuint face = 0; face < container.faces; ++face) {
+            GSuint size;
+            const unsigned char *image = texture_container_image(container, level, layer, face, size);
+
+            GStexturelockdata lockdata = { size, 0, 0 };
+            GSptr memory = texture->LockImpl(texture_container_locktype(container, face), GS_WRITE, level, layer, &lockdata);
+            bool valid = memory && lockdata.size == size;
+            if (valid) {
+                texture_image_copy(memory, image, size, container.swizzle);
+            }
+            texture->UnlockImpl();
+
+            if (!valid) {
+                return GSE_OUTOFRESOURCES;
+            }
+        }
+    }
+
+    texture->SetBaseLevel(level);
+
+    entry.residentlevel = level;
+    p_resident += levelSize(entry, level);
+
+    return GS_OK;
+}
+
+void TextureStreamer::evictLevel(xGSTextureImpl *texture, StreamedTexture &entry)
+{
+    GSuint level = entry.residentlevel;
+
+    // base level is moved first, so evicted level is never sampled
+    texture->SetBaseLevel(level + 1);
+
+    if (texture->sparse()) {
+        texture->CommitLevel(level, GS_FALSE);
+    }
+
+    entry.residentlevel = level + 1;
+    p_resident -= levelSize(entry, level);
+}
+
+bool TextureStreamer::makeRoom(GSuint64 size, const StreamedTexture &requester)
+{
+    // entry could give up all levels above its tail if it wasn't requested in current
+    // frame or has lower priority than requester, otherwise only levels finer than requested
+    auto limit = [this, &requester](const StreamedTexture &entry) {
+        if (&entry == &requester) {
+            return entry.residentlevel;
+        }
+        if (!requested(entry) || entry.priority < requester.priority) {
+            return entry.taillevel;
+        }
+        return umax(entry.residentlevel, entry.wantedlevel);
+    };
+
+    std::vector<TextureList::value_type*> candidates;
+    GSuint64 available = 0;
+    for (auto &t : p_textures) {
+        GSuint last = limit(t.second);
+        for (GSuint level = t.second.residentlevel; level < last; ++level) {
+            available += levelSize(t.second, level);
+        }
+        if (t.second.residentlevel < last) {
+            candidates.push_back(&t);
+        }
+    }
+
+    // nothing is evicted if it doesn't free enough memory anyway
+    if (p_resident + size > p_budget + available) {
+        return false;
+    }
+
+    // least recently requested textures go first, then lower priority ones
+    GSuint frame = p_frame;
+    std::sort(
+        candidates.begin(), candidates.end(),
+        [frame](const TextureList::value_type *a, const TextureList::value_type *b) {
+            GSuint agea = frame - a->second.requestframe;
+            GSuint ageb = frame - b->second.requestframe;
+            return agea != ageb ? agea > ageb : a->second.priority < b->second.priority;
+        }
+    );
+
+    for (auto t : candidates) {
+        GSuint last = limit(t->second);
+        while (p_resident + size > p_budget && t->second.residentlevel < last) {
+            evictLevel(t->first, t->second);
+        }
+
+        if (p_resident + size <= p_budget) {
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,87 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGStexturestreaming.h
+        Texture streaming manager
+            streamed textures are uploaded progressively from mapped container
+            files, finer MIP levels are made resident by usage feedback and
+            evicted under residency budget
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include "xGStextureloader.h"
+#include <unordered_map>
+#include <memory>
+
+
+namespace xGS
+{
+
+    class xGSTextureImpl;
+
+
+    // streamed textures residency manager
+    //      every streamed texture has all MIP levels defined, but only MIP tail
+    //      (levels not larger than tail size) is uploaded on creation, finer levels
+    //      are uploaded one by one from coarse to fine and texture base level is moved
+    //      to finest resident level, sparse textures have memory committed only for
+    //      resident levels
+    class TextureStreamer
+    {
+    public:
+        TextureStreamer();
+
+        void configure(const GStexturestreamingdescription &desc);
+
+        // starts texture streaming, file mapping is owned by streamer until texture is removed
+        GSerror add(xGSTextureImpl *texture, std::unique_ptr<FileMapping> &file, const TextureContainer &container);
+        void remove(xGSTextureImpl *texture);
+        bool streamed(xGSTextureImpl *texture) const { return p_textures.find(texture) != p_textures.end(); }
+
+        // usage feedback, requests are valid until next update
+        bool request(xGSTextureImpl *texture, GSuint level, GSfloat priority);
+
+        // uploads requested levels and evicts levels over the budget
+        GSerror update();
+
+        void clear();
+
+    private:
+        struct StreamedTexture
+        {
+            std::unique_ptr<FileMapping> file;
+            TextureContainer             container;
+            GSuint                       taillevel;     // first always resident level
+            GSuint                       residentlevel; // finest resident level
+            GSuint                       wantedlevel;   // finest requested level
+            GSfloat                      priority;      // request priority
+            GSuint                       requestframe;  // frame of last request
+        };
+
+        typedef std::unordered_map<xGSTextureImpl*, StreamedTexture> TextureList;
+
+        GSuint64 levelSize(const StreamedTexture &entry, GSuint level) const;
+        bool requested(const StreamedTexture &entry) const { return entry.requestframe == p_frame; }
+
+        GSerror uploadLevel(xGSTextureImpl *texture, StreamedTexture &entry, GSuint level);
+        void evictLevel(xGSTextureImpl *texture, StreamedTexture &entry);
+        bool makeRoom(GSuint64 size, const StreamedTexture &requester);
+
+    private:
+        TextureList p_textures;
+        GSuint64    p_budget;      // residency budget in bytes
+        GSuint64    p_resident;    // size of all resident levels
+        GSuint      p_uploadlimit; // upload limit per update in bytes
+        GSuint      p_tailsize;    // always resident levels size
+        GSuint      p_frame;       // update counter
+    };
+
+} // namespace xGS
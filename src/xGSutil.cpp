@@ -12,41 +12,220 @@
 */
 
 #include "xGSutil.h"
+#include <unordered_map>
+#include <cstring>
 
 
 using namespace xGS;
 
 
+typedef std::weak_ptr<const GSvertexlayout> LayoutRef;
+typedef std::unordered_multimap<size_t, LayoutRef> LayoutTable;
+
+// table of all currently used vertex layouts
+static LayoutTable layouttable;
+
+static inline void hash_combine(size_t &hash, size_t value)
+{
+    hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+static bool same_layout(const GSvertexlayout &a, const GSvertexlayout &b)
+{
+    if (a.decl.size() != b.decl.size()) {
+        return false;
+    }
+
+    for (size_t n = 0; n < a.decl.size(); ++n) {
+        if (a.decl[n].type != b.decl[n].type ||
+            a.decl[n].semantic != b.decl[n].semantic ||
+            a.decl[n].index != b.decl[n].index ||
+            (a.decl[n].name == nullptr) != (b.decl[n].name == nullptr) ||
+            a.names[n] != b.names[n])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 GSvertexdecl::GSvertexdecl() :
-    p_decl(),
-    p_dynamic(false)
-{}
+    p_layout()
+{
+    initialize(nullptr);
+}
 
 GSvertexdecl::GSvertexdecl(const GSvertexcomponent *decl) :
-    p_decl(),
-    p_dynamic(false)
+    p_layout()
 {
     initialize(decl);
 }
 
-GSuint GSvertexdecl::buffer_size(int count) const
+bool GSvertexdecl::compatible(const GSvertexdecl &decl) const
 {
-    GSuint result = 0;
-    for (auto const &i : p_decl) {
-        result += vertex_component_size(i);
+    if (p_layout == decl.p_layout) {
+        return true;
+    }
+
+    if (p_layout->format != decl.p_layout->format || p_layout->decl.size() != decl.p_layout->decl.size()) {
+        return false;
     }
-    return result * count;
+
+    for (size_t n = 0; n < p_layout->decl.size(); ++n) {
+        if (p_layout->decl[n].type != decl.p_layout->decl[n].type) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 void GSvertexdecl::initialize(const GSvertexcomponent *decl)
 {
-    p_decl.clear();
-    while (decl->type != GSVD_END) {
+    GSvertexlayout layout;
+    layout.stride = 0;
+    layout.hash = 0;
+    layout.format = 0;
+    layout.dynamic = false;
+
+    std::hash<std::string> stringhash;
+
+    while (decl && decl->type != GSVD_END) {
         if (decl->index == GS_DEFAULT) {
-            p_dynamic = true;
+            layout.dynamic = true;
         }
 
-        p_decl.push_back(*decl);
+        layout.decl.push_back(*decl);
+        layout.names.push_back(decl->name ? decl->name : "");
+        layout.offsets.push_back(layout.stride);
+
+        layout.stride += vertex_component_size(*decl);
+
+        hash_combine(layout.format, decl->type);
+        hash_combine(layout.hash, decl->type);
+        hash_combine(layout.hash, decl->semantic);
+        hash_combine(layout.hash, decl->index);
+        hash_combine(layout.hash, stringhash(layout.names.back()));
+
         ++decl;
     }
+
+    p_layout = intern(layout);
+}
+
+GSvertexdecl::LayoutPtr GSvertexdecl::intern(GSvertexlayout &layout)
+{
+    auto range = layouttable.equal_range(layout.hash);
+    for (auto it = range.first; it != range.second;) {
+        LayoutPtr existing = it->second.lock();
+        if (!existing) {
+            // layout isn't referenced anymore
+            it = layouttable.erase(it);
+            continue;
+        }
+
+        if (same_layout(*existing, layout)) {
+            return existing;
+        }
+
+        ++it;
+    }
+
+    LayoutPtr result = std::make_shared<GSvertexlayout>(std::move(layout));
+
+    // component names should point to layout own strings
+    GSvertexlayout &stored = const_cast<GSvertexlayout&>(*result);
+    for (size_t n = 0; n < stored.decl.size(); ++n) {
+        if (stored.decl[n].name) {
+            stored.decl[n].name = stored.names[n].c_str();
+        }
+    }
+
+    layouttable.insert(std::make_pair(stored.hash, LayoutRef(result)));
+
+    return result;
+}
+
+void xGS::texture_region_copy(GSptr destination, GSuint pitch, const GStextureregion &region, GSuint bpp)
+{
+    const unsigned char *source = reinterpret_cast<const unsigned char*>(region.source);
+    unsigned char *dest = reinterpret_cast<unsigned char*>(destination);
+
+    GSuint rowsize = region.width * bpp;
+    GSuint sourcepitch = region.pitch ? region.pitch : rowsize;
+    GSuint border = region.border;
+    GSuint height = region.height + border * 2;
+
+    for (GSuint y = 0; y < height; ++y) {
+        // border rows repeat first and last image rows
+        GSuint sy = y < border ? 0 : y - border;
+        if (sy >= region.height) {
+            sy = region.height - 1;
+        }
+
+        const unsigned char *src = source + size_t(sy) * sourcepitch;
+        unsigned char *row = dest + size_t(y) * pitch;
+
+        for (GSuint b = 0; b < border; ++b) {
+            memcpy(row + b * bpp, src, bpp);
+            memcpy(row + (border + region.width + b) * bpp, src + rowsize - bpp, bpp);
+        }
+
+        memcpy(row + border * bpp, src, rowsize);
+    }
+}
+
+// border color matters only when some wrap mode uses it
+static inline bool sampler_border(const GSsamplerdescription &desc)
+{
+    return
+        desc.wrapu == GS_WRAP_BORDER || desc.wrapv == GS_WRAP_BORDER ||
+        desc.wrapw == GS_WRAP_BORDER;
+}
+
+// anisotropy of 0 and 1 both mean no anisotropic filtering
+static inline GSuint sampler_anisotropy(const GSsamplerdescription &desc)
+{
+    return desc.anisotropy > 1 ? desc.anisotropy : 1;
+}
+
+size_t xGS::sampler_hash(const GSsamplerdescription &desc)
+{
+    std::hash<GSfloat> floathash;
+
+    size_t hash = 0;
+    hash_combine(hash, size_t(desc.wrapu));
+    hash_combine(hash, size_t(desc.wrapv));
+    hash_combine(hash, size_t(desc.wrapw));
+    hash_combine(hash, size_t(desc.filter));
+    hash_combine(hash, size_t(desc.minlod));
+    hash_combine(hash, size_t(desc.maxlod));
+    hash_combine(hash, floathash(desc.bias));
+    hash_combine(hash, size_t(desc.depthcompare));
+    hash_combine(hash, size_t(sampler_anisotropy(desc)));
+    if (sampler_border(desc)) {
+        hash_combine(hash, floathash(desc.border.r));
+        hash_combine(hash, floathash(desc.border.g));
+        hash_combine(hash, floathash(desc.border.b));
+        hash_combine(hash, floathash(desc.border.a));
+    }
+
+    return hash;
+}
+
+bool xGS::sampler_equal(const GSsamplerdescription &a, const GSsamplerdescription &b)
+{
+    return
+        a.wrapu == b.wrapu && a.wrapv == b.wrapv && a.wrapw == b.wrapw &&
+        a.filter == b.filter &&
+        a.minlod == b.minlod && a.maxlod == b.maxlod && a.bias == b.bias &&
+        a.depthcompare == b.depthcompare &&
+        sampler_anisotropy(a) == sampler_anisotropy(b) && (
+            !sampler_border(a) || (
+                a.border.r == b.border.r && a.border.g == b.border.g &&
+                a.border.b == b.border.b && a.border.a == b.border.a
+            )
+        );
 }
@@ -15,6 +15,8 @@
 
 #include "xGS/xGS.h"
 #include <vector>
+#include <string>
+#include <memory>
 
 
 namespace xGS
@@ -102,6 +104,29 @@ namespace xGS
             case GSVD_VECTOR3:   return 3;
             case GSVD_VECTOR4:   return 4;
 
+            case GSVD_HALF2:     return 2;
+            case GSVD_HALF4:     return 4;
+            case GSVD_UBYTE4N:   return 4;
+            case GSVD_BYTE4N:    return 4;
+            case GSVD_USHORT2N:  return 2;
+            case GSVD_USHORT4N:  return 4;
+            case GSVD_SHORT2N:   return 2;
+            case GSVD_SHORT4N:   return 4;
+            case GSVD_UDEC4N:    return 4;
+            case GSVD_DEC4N:     return 4;
+
+            case GSVD_INT1:      return 1;
+            case GSVD_INT2:      return 2;
+            case GSVD_INT3:      return 3;
+            case GSVD_INT4:      return 4;
+            case GSVD_UINT1:     return 1;
+            case GSVD_UINT2:     return 2;
+            case GSVD_UINT3:     return 3;
+            case GSVD_UINT4:     return 4;
+            case GSVD_UBYTE4:    return 4;
+            case GSVD_USHORT2:   return 2;
+            case GSVD_USHORT4:   return 4;
+
             default:
                 return 0;
         }
@@ -117,11 +142,40 @@ namespace xGS
             case GSVD_VECTOR3:   return sizeof(float) * 3;
             case GSVD_VECTOR4:   return sizeof(float) * 4;
 
+            case GSVD_HALF2:     return 2 * 2;
+            case GSVD_HALF4:     return 2 * 4;
+            case GSVD_UBYTE4N:   return 1 * 4;
+            case GSVD_BYTE4N:    return 1 * 4;
+            case GSVD_USHORT2N:  return 2 * 2;
+            case GSVD_USHORT4N:  return 2 * 4;
+            case GSVD_SHORT2N:   return 2 * 2;
+            case GSVD_SHORT4N:   return 2 * 4;
+            case GSVD_UDEC4N:    return 4;
+            case GSVD_DEC4N:     return 4;
+
+            case GSVD_INT1:      return sizeof(GSint) * 1;
+            case GSVD_INT2:      return sizeof(GSint) * 2;
+            case GSVD_INT3:      return sizeof(GSint) * 3;
+            case GSVD_INT4:      return sizeof(GSint) * 4;
+            case GSVD_UINT1:     return sizeof(GSuint) * 1;
+            case GSVD_UINT2:     return sizeof(GSuint) * 2;
+            case GSVD_UINT3:     return sizeof(GSuint) * 3;
+            case GSVD_UINT4:     return sizeof(GSuint) * 4;
+            case GSVD_UBYTE4:    return 1 * 4;
+            case GSVD_USHORT2:   return 2 * 2;
+            case GSVD_USHORT4:   return 2 * 4;
+
             default:
                 return 0;
         }
     }
 
+    // component is passed to shader as integer value, without conversion to float
+    inline bool vertex_component_integer(const GSvertexcomponent &c)
+    {
+        return c.type >= GSVD_INT1 && c.type <= GSVD_USHORT4;
+    }
+
     inline GSuint index_buffer_size(GSenum format, int count = 1)
     {
         int result = 0;
@@ -134,6 +188,62 @@ namespace xGS
         return result * count;
     }
 
+    // size of 4x4 texel block in bytes for block compressed formats,
+    // 0 for uncompressed formats
+    inline GSuint texture_block_size(GSenum format)
+    {
+        switch (format) {
+            case GS_COLOR_BC1:
+            case GS_COLOR_S_BC1:
+            case GS_COLOR_BC4:
+                return 8;
+
+            case GS_COLOR_BC3:
+            case GS_COLOR_S_BC3:
+            case GS_COLOR_BC5:
+            case GS_COLOR_BC7:
+            case GS_COLOR_S_BC7:
+                return 16;
+        }
+
+        return 0;
+    }
+
+    // texture image row size and row count, for block compressed
+    // formats rows are rows of blocks
+    inline GSuint texture_image_pitch(GSenum format, GSuint bpp, GSuint width)
+    {
+        GSuint blocksize = texture_block_size(format);
+        return blocksize ? (width + 3) / 4 * blocksize : width * bpp;
+    }
+
+    inline GSuint texture_image_rows(GSenum format, GSuint height)
+    {
+        return texture_block_size(format) ? (height + 3) / 4 : height;
+    }
+
+    // uncompressed texture sub image for region uploads, destination area
+    // includes border texels which replicate source image edges
+    struct GStextureregion
+    {
+        GSuint      x;      // destination area left
+        GSuint      y;      // destination area top
+        GSuint      layer;  // destination array layer
+        GSuint      width;  // source image width
+        GSuint      height; // source image height
+        GSuint      border; // border texels on each side of source image
+        const void *source; // source image texels
+        GSuint      pitch;  // source row size in bytes, 0 for tightly packed rows
+    };
+
+    // copies region source image with its border to destination rows of given pitch
+    void texture_region_copy(GSptr destination, GSuint pitch, const GStextureregion &region, GSuint bpp);
+
+    // sampler description hash and comparison for sampler caches, border color
+    // is ignored when no wrap mode uses it, anisotropy of 0 and 1 are the same
+    size_t sampler_hash(const GSsamplerdescription &desc);
+    bool sampler_equal(const GSsamplerdescription &a, const GSsamplerdescription &b);
+
     inline GSuint align(GSuint value, GSuint align)
     {
         GSuint result = value / align;
@@ -143,6 +253,61 @@ namespace xGS
         return result * align;
     }
 
+    // uniform element layout
+    //      alignment - base alignment of uniform (or array when count > 1)
+    //      size      - size of a single element
+    //      stride    - array element stride
+    //      columns   - number of matrix columns, 1 for scalars and vectors
+    struct GSuniformlayout
+    {
+        GSuint alignment;
+        GSuint size;
+        GSuint stride;
+        GSuint columns;
+    };
+
+    // computes uniform layout according to std140 or std430 rules
+    //      matrices are column-major and laid out as arrays of column vectors,
+    //      std140 rounds array and matrix column strides up to vec4 alignment, std430 doesn't
+    inline bool uniform_layout(GSenum type, GSuint count, bool std430, GSuniformlayout &layout)
+    {
+        GSuint components = 0;
+        GSuint columns = 1;
+
+        switch (type) {
+            case GSU_SCALAR: components = 1; break;
+            case GSU_VEC2:   components = 2; break;
+            case GSU_VEC3:   components = 3; break;
+            case GSU_VEC4:   components = 4; break;
+            case GSU_MAT2:   components = 2; columns = 2; break;
+            case GSU_MAT3:   components = 3; columns = 3; break;
+            case GSU_MAT4:   components = 4; columns = 4; break;
+            case GSU_HANDLE: components = 2; break;
+            default:
+                return false;
+        }
+
+        // vec3 has same alignment as vec4
+        GSuint alignment = (components == 3 ? 4 : components) * sizeof(float);
+        GSuint size = components * sizeof(float);
+
+        bool isarray = columns > 1 || count > 1;
+        if (isarray && !std430) {
+            alignment = align(alignment, 16);
+        }
+
+        if (columns > 1) {
+            size = align(size, alignment) * columns;
+        }
+
+        layout.alignment = alignment;
+        layout.size = size;
+        layout.stride = align(size, alignment);
+        layout.columns = columns;
+
+        return true;
+    }
+
     inline GSptr buffercast(GSuint addr)
     {
         return GSptr(reinterpret_cast<char*>(0) + addr);
@@ -155,21 +320,45 @@ namespace xGS
         return *ints;
     }
 
+    // vertex layout precomputed from vertex declaration
+    //      layouts are interned, identical declarations share the same
+    //      layout object, so layouts could be compared by pointer
+    struct GSvertexlayout
+    {
+        std::vector<GSvertexcomponent> decl;    // components, names point into names list
+        std::vector<std::string>       names;   // component names storage
+        std::vector<GSuint>            offsets; // component offsets inside vertex
+        GSuint                         stride;  // vertex size
+        size_t                         hash;    // hash of the whole declaration
+        size_t                         format;  // hash of component types only
+        bool                           dynamic; // some components have GS_DEFAULT index
+    };
+
     class GSvertexdecl
     {
     public:
         GSvertexdecl();
         GSvertexdecl(const GSvertexcomponent *decl);
 
-        GSuint buffer_size(int count = 1) const;
-        GSbool dynamic() const { return p_dynamic; }
-        const std::vector<GSvertexcomponent>& declaration() const { return p_decl; }
+        GSuint buffer_size(int count = 1) const { return p_layout->stride * count; }
+        GSuint offset(size_t index) const { return p_layout->offsets[index]; }
+        size_t hash() const { return p_layout->hash; }
+        GSbool dynamic() const { return p_layout->dynamic; }
+        const std::vector<GSvertexcomponent>& declaration() const { return p_layout->decl; }
+
+        // checks if vertex data of both declarations has same memory layout,
+        // component names and indices aren't taken into account
+        bool compatible(const GSvertexdecl &decl) const;
 
         void initialize(const GSvertexcomponent *decl);
 
     protected:
-        std::vector<GSvertexcomponent> p_decl;
-        bool                           p_dynamic;
+        typedef std::shared_ptr<const GSvertexlayout> LayoutPtr;
+
+        static LayoutPtr intern(GSvertexlayout &layout);
+
+    protected:
+        LayoutPtr p_layout;
     };
 
 
@@ -0,0 +1,341 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSvertexcompress.cpp
+        Vertex data compression functions
+*/
+
+#include "xGSvertexcompress.h"
+#include <cstring>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+    #define GS_VERTEXCOMPRESS_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+using namespace xGS;
+
+
+enum VertexConversion
+{
+    CONVERT_NONE,
+    CONVERT_COPY,
+    CONVERT_POSITION,
+    CONVERT_OCTAHEDRAL,
+    CONVERT_HALF
+};
+
+static VertexConversion vertex_conversion(const GSvertexcomponent &source, const GSvertexcomponent &dest)
+{
+    if (source.type == dest.type) {
+        return CONVERT_COPY;
+    }
+
+    switch (source.type) {
+        case GSVD_POSITION:
+            return dest.type == GSVD_USHORT4N ? CONVERT_POSITION : CONVERT_NONE;
+
+        case GSVD_VECTOR2:
+            return dest.type == GSVD_HALF2 ? CONVERT_HALF : CONVERT_NONE;
+
+        case GSVD_VECTOR3:
+            switch (dest.type) {
+                case GSVD_USHORT4N: return CONVERT_POSITION;
+                case GSVD_SHORT2N:  return CONVERT_OCTAHEDRAL;
+            }
+            return CONVERT_NONE;
+
+        case GSVD_VECTOR4:
+            switch (dest.type) {
+                case GSVD_SHORT2N: return CONVERT_OCTAHEDRAL;
+                case GSVD_HALF4:   return CONVERT_HALF;
+            }
+            return CONVERT_NONE;
+    }
+
+    return CONVERT_NONE;
+}
+
+static inline short float_to_snorm16(float value)
+{
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return short(floorf(value * 32767.0f + (value < 0 ? -0.5f : 0.5f)));
+}
+
+static inline void octahedral_encode(const float *v, short *result)
+{
+    float x = v[0];
+    float y = v[1];
+    float z = v[2];
+
+    float sum = fabsf(x) + fabsf(y) + fabsf(z);
+    if (sum > 0) {
+        x /= sum;
+        y /= sum;
+    }
+
+    // fold lower hemisphere over diagonals
+    if (z < 0) {
+        float fx = (1.0f - fabsf(y)) * (x < 0 ? -1.0f : 1.0f);
+        float fy = (1.0f - fabsf(x)) * (y < 0 ? -1.0f : 1.0f);
+        x = fx;
+        y = fy;
+    }
+
+    result[0] = float_to_snorm16(x);
+    result[1] = float_to_snorm16(y);
+}
+
+#ifdef GS_VERTEXCOMPRESS_SSE2
+// converts 4 floats into 4 halfs with round to nearest even,
+// results are in low 16 bits of each 32-bit lane
+static inline __m128i float_to_half4(__m128 f)
+{
+    const __m128i c_f16max = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i c_nanbit = _mm_set1_epi32(0x200);
+    const __m128i c_infty = _mm_set1_epi32(0x7c00);
+    const __m128i c_minnormal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i c_subnormmagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i c_normalbias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128 justsign = _mm_and_ps(_mm_set1_ps(-0.0f), f);
+    __m128 absf = _mm_xor_ps(f, justsign);
+    __m128i absfint = _mm_castps_si128(absf);
+
+    __m128 isnan = _mm_cmpunord_ps(absf, absf);
+    __m128i isregular = _mm_cmpgt_epi32(c_f16max, absfint);
+    __m128i infornan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(isnan), c_nanbit), c_infty);
+
+    __m128i issub = _mm_cmpgt_epi32(c_minnormal, absfint);
+
+    // subnormal result
+    __m128 subnorm1 = _mm_add_ps(absf, _mm_castsi128_ps(c_subnormmagic));
+    __m128i subnorm = _mm_sub_epi32(_mm_castps_si128(subnorm1), c_subnormmagic);
+
+    // normal result
+    __m128i mantodd = _mm_srai_epi32(_mm_slli_epi32(absfint, 31 - 13), 31);
+    __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absfint, c_normalbias), mantodd), 13);
+
+    __m128i nonspecial = _mm_or_si128(_mm_and_si128(subnorm, issub), _mm_andnot_si128(issub, normal));
+    __m128i joined = _mm_or_si128(_mm_and_si128(nonspecial, isregular), _mm_andnot_si128(isregular, infornan));
+
+    return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(justsign), 16));
+}
+#endif
+
+unsigned short xGS::float_to_half(float value)
+{
+    GSuint f;
+    memcpy(&f, &value, sizeof(f));
+
+    GSuint sign = f & 0x80000000u;
+    f ^= sign;
+
+    GSuint result;
+    if (f >= 0x47800000u) {
+        // overflow, inf or nan
+        result = f > 0x7f800000u ? 0x7e00 : 0x7c00;
+    } else if (f < 0x38800000u) {
+        // subnormal or zero
+        const GSuint magic = ((127 - 15) + (23 - 10) + 1) << 23;
+        float fm, ff;
+        memcpy(&fm, &magic, sizeof(fm));
+        memcpy(&ff, &f, sizeof(ff));
+        ff += fm;
+        memcpy(&result, &ff, sizeof(result));
+        result -= magic;
+    } else {
+        GSuint mantodd = (f >> 13) & 1;
+        f = f - (GSuint(127 - 15) << 23) + 0xfff + mantodd;
+        result = f >> 13;
+    }
+
+    return (unsigned short)(result | (sign >> 16));
+}
+
+static inline void quantize_position(const float *source, unsigned short *dest, const float *bias, const float *invscale)
+{
+#ifdef GS_VERTEXCOMPRESS_SSE2
+    __m128 p = _mm_setr_ps(source[0], source[1], source[2], 0.0f);
+    __m128 q = _mm_mul_ps(
+        _mm_sub_ps(p, _mm_setr_ps(bias[0], bias[1], bias[2], 0.0f)),
+        _mm_setr_ps(invscale[0], invscale[1], invscale[2], 0.0f)
+    );
+    q = _mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    // w is always 1
+    q = _mm_or_ps(q, _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, 0x3f800000)));
+
+    // shift into signed range before signed saturating pack and flip sign bit back
+    __m128i qi = _mm_cvtps_epi32(_mm_mul_ps(q, _mm_set1_ps(65535.0f)));
+    qi = _mm_sub_epi32(qi, _mm_set1_epi32(0x8000));
+    qi = _mm_xor_si128(_mm_packs_epi32(qi, qi), _mm_set1_epi16(short(0x8000)));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dest), qi);
+#else
+    for (int n = 0; n < 3; ++n) {
+        float q = (source[n] - bias[n]) * invscale[n];
+        q = q < 0 ? 0 : (q > 1.0f ? 1.0f : q);
+        dest[n] = (unsigned short)(q * 65535.0f + 0.5f);
+    }
+    dest[3] = 0xffff;
+#endif
+}
+
+static inline void convert_half(const float *source, unsigned short *dest, GSuint count)
+{
+#ifdef GS_VERTEXCOMPRESS_SSE2
+    __m128 f = count == 4 ?
+        _mm_loadu_ps(source) :
+        _mm_setr_ps(source[0], source[1], 0.0f, 0.0f);
+    __m128i h = float_to_half4(f);
+    h = _mm_packs_epi32(h, h);
+    if (count == 4) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest), h);
+    } else {
+        int lo = _mm_cvtsi128_si32(h);
+        memcpy(dest, &lo, sizeof(lo));
+    }
+#else
+    for (GSuint n = 0; n < count; ++n) {
+        dest[n] = float_to_half(source[n]);
+    }
+#endif
+}
+
+
+bool xGS::vertex_compression_supported(const GSvertexdecl &source, const GSvertexdecl &dest)
+{
+    const std::vector<GSvertexcomponent> &src = source.declaration();
+    const std::vector<GSvertexcomponent> &dst = dest.declaration();
+
+    if (src.size() != dst.size()) {
+        return false;
+    }
+
+    for (size_t n = 0; n < src.size(); ++n) {
+        if (vertex_conversion(src[n], dst[n]) == CONVERT_NONE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void xGS::vertex_quantization(
+    const GSvertexdecl &source, const GSvertexdecl &dest,
+    const void *data, GSuint count, GSvertexquantization &quantization
+)
+{
+    const std::vector<GSvertexcomponent> &src = source.declaration();
+    const std::vector<GSvertexcomponent> &dst = dest.declaration();
+
+    float bmin[3] = { 0, 0, 0 };
+    float bmax[3] = { 0, 0, 0 };
+    bool empty = true;
+
+    GSuint stride = source.buffer_size();
+
+    for (size_t n = 0; n < src.size(); ++n) {
+        if (vertex_conversion(src[n], dst[n]) != CONVERT_POSITION) {
+            continue;
+        }
+
+        const char *vertex = reinterpret_cast<const char*>(data) + source.offset(n);
+        for (GSuint v = 0; v < count; ++v, vertex += stride) {
+            const float *p = reinterpret_cast<const float*>(vertex);
+            for (int c = 0; c < 3; ++c) {
+                if (empty || p[c] < bmin[c]) {
+                    bmin[c] = p[c];
+                }
+                if (empty || p[c] > bmax[c]) {
+                    bmax[c] = p[c];
+                }
+            }
+            empty = false;
+        }
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        quantization.scale[c] = bmax[c] - bmin[c];
+        quantization.bias[c] = bmin[c];
+    }
+}
+
+void xGS::vertex_compress(
+    const GSvertexdecl &source, const GSvertexdecl &dest,
+    const void *data, GSptr destination, GSuint count,
+    const GSvertexquantization &quantization
+)
+{
+    const std::vector<GSvertexcomponent> &src = source.declaration();
+    const std::vector<GSvertexcomponent> &dst = dest.declaration();
+
+    float invscale[3];
+    for (int c = 0; c < 3; ++c) {
+        invscale[c] = quantization.scale[c] > 0 ? 1.0f / quantization.scale[c] : 0.0f;
+    }
+
+    GSuint sourcestride = source.buffer_size();
+    GSuint deststride = dest.buffer_size();
+
+    // every component converted in separate pass over all vertices,
+    // so conversion kind is resolved once per component
+    for (size_t n = 0; n < src.size(); ++n) {
+        VertexConversion conversion = vertex_conversion(src[n], dst[n]);
+
+        const char *input = reinterpret_cast<const char*>(data) + source.offset(n);
+        char *output = reinterpret_cast<char*>(destination) + dest.offset(n);
+
+        switch (conversion) {
+            case CONVERT_NONE:
+                // declarations were checked by vertex_compression_supported
+                break;
+
+            case CONVERT_COPY: {
+                GSuint size = vertex_component_size(src[n]);
+                for (GSuint v = 0; v < count; ++v, input += sourcestride, output += deststride) {
+                    memcpy(output, input, size);
+                }
+                break;
+            }
+
+            case CONVERT_POSITION:
+                for (GSuint v = 0; v < count; ++v, input += sourcestride, output += deststride) {
+                    quantize_position(
+                        reinterpret_cast<const float*>(input),
+                        reinterpret_cast<unsigned short*>(output),
+                        quantization.bias, invscale
+                    );
+                }
+                break;
+
+            case CONVERT_OCTAHEDRAL:
+                for (GSuint v = 0; v < count; ++v, input += sourcestride, output += deststride) {
+                    octahedral_encode(
+                        reinterpret_cast<const float*>(input),
+                        reinterpret_cast<short*>(output)
+                    );
+                }
+                break;
+
+            case CONVERT_HALF: {
+                GSuint components = vertex_component_count(src[n]);
+                for (GSuint v = 0; v < count; ++v, input += sourcestride, output += deststride) {
+                    convert_half(
+                        reinterpret_cast<const float*>(input),
+                        reinterpret_cast<unsigned short*>(output),
+                        components
+                    );
+                }
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSvertexcompress.h
+        Vertex data compression functions
+            converts float vertex data into packed vertex formats
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include "xGSutil.h"
+
+
+namespace xGS
+{
+
+    // source to destination component conversions:
+    //      same type                   - data copied as is
+    //      POSITION/VECTOR3 -> USHORT4N - position quantized against bounding box, w = 1
+    //      VECTOR3/VECTOR4 -> SHORT2N   - direction (normal, tangent) octahedral encoded,
+    //                                    w component of VECTOR4 is ignored
+    //      VECTOR2 -> HALF2, VECTOR4 -> HALF4 - converted to half floats
+
+    // checks if source declaration could be converted into destination declaration
+    bool vertex_compression_supported(const GSvertexdecl &source, const GSvertexdecl &dest);
+
+    // computes dequantization constants for quantized position components
+    void vertex_quantization(
+        const GSvertexdecl &source, const GSvertexdecl &dest,
+        const void *data, GSuint count, GSvertexquantization &quantization
+    );
+
+    // converts source vertex data into destination format
+    void vertex_compress(
+        const GSvertexdecl &source, const GSvertexdecl &dest,
+        const void *data, GSptr destination, GSuint count,
+        const GSvertexquantization &quantization
+    );
+
+    unsigned short float_to_half(float value);
+
+} // namespace xGS
@@ -0,0 +1,115 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSworkers.cpp
+        Worker thread pool class implementation
+*/
+
+#include "xGSworkers.h"
+
+
+using namespace xGS;
+
+
+WorkerPool::WorkerPool() :
+    p_work(nullptr),
+    p_count(0),
+    p_next(0),
+    p_pending(0),
+    p_quit(false)
+{}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(p_lock);
+        p_quit = true;
+    }
+    p_wake.notify_all();
+
+    for (auto &thread : p_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(GSuint count, const Work &work)
+{
+    if (count == 0) {
+        return;
+    }
+
+    if (count == 1) {
+        work(0);
+        return;
+    }
+
+    start(count - 1);
+
+    {
+        std::lock_guard<std::mutex> lock(p_lock);
+        p_work = &work;
+        p_count = count;
+        p_next = 0;
+        p_pending = count;
+    }
+    p_wake.notify_all();
+
+    execute();
+
+    std::unique_lock<std::mutex> lock(p_lock);
+    p_done.wait(lock, [this]() { return p_pending == 0; });
+    p_work = nullptr;
+}
+
+void WorkerPool::start(GSuint threads)
+{
+    while (p_threads.size() < threads) {
+        p_threads.emplace_back(&WorkerPool::worker, this);
+    }
+}
+
+void WorkerPool::execute()
+{
+    for (;;) {
+        const Work *work = nullptr;
+        GSuint index = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(p_lock);
+            if (p_work == nullptr || p_next >= p_count) {
+                return;
+            }
+            work = p_work;
+            index = p_next++;
+        }
+
+        // work can't be reset by run until this item is done
+        (*work)(index);
+
+        std::lock_guard<std::mutex> lock(p_lock);
+        if (--p_pending == 0) {
+            p_done.notify_all();
+        }
+    }
+}
+
+void WorkerPool::worker()
+{
+    std::unique_lock<std::mutex> lock(p_lock);
+    for (;;) {
+        p_wake.wait(lock, [this]() { return p_quit || (p_work && p_next < p_count); });
+        if (p_quit) {
+            return;
+        }
+
+        lock.unlock();
+        execute();
+        lock.lock();
+    }
+}
@@ -0,0 +1,61 @@
+﻿/*
+        xGS 3D Low-level rendering API
+
+    Low-level 3D rendering wrapper API with multiple back-end support
+
+    (c) livingcreative, 2015 - 2018
+
+    https://github.com/livingcreative/xgs
+
+    xGSworkers.h
+        Worker thread pool class header
+            keeps worker threads between calls for work which is done every frame
+*/
+
+#pragma once
+
+#include "xGS/xGS.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+namespace xGS
+{
+
+    // pool of worker threads
+    //      threads are started on first use and wait for work until pool
+    //      is destroyed, work items are taken by workers and calling thread
+    //      in order, run returns when all items are done
+    class WorkerPool
+    {
+    public:
+        typedef std::function<void(GSuint)> Work;
+
+        WorkerPool();
+        ~WorkerPool();
+
+        // runs work(index) for every index in [0, count) on up to
+        // count - 1 worker threads and calling thread
+        void run(GSuint count, const Work &work);
+
+    private:
+        void start(GSuint threads);
+        void execute();
+        void worker();
+
+    private:
+        std::vector<std::thread> p_threads;
+        std::mutex               p_lock;
+        std::condition_variable  p_wake;    // signalled when new work is available or pool stops
+        std::condition_variable  p_done;    // signalled when last work item is done
+        const Work              *p_work;    // current work, nullptr when there's no work
+        GSuint                   p_count;   // number of current work items
+        GSuint                   p_next;    // next work item to be taken
+        GSuint                   p_pending; // number of work items which are not done yet
+        bool                     p_quit;
+    };
+
+} // namespace xGS